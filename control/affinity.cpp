@@ -13,6 +13,255 @@
 #include "affinity.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// Location of one logical CPU, from /sys/devices/system/cpu/cpuN.
+struct magma_cpu_info
+{
+    int cpu;
+    int domain;     // NUMA node, or package (socket) if NUMA node is unknown
+    int package;    // physical_package_id
+    int core;       // core_id, unique within package
+    int smt;        // rank among SMT siblings of its physical core
+    int core_rank;  // rank of its physical core within its domain
+};
+
+
+// -----------------------------------------------------------------------------
+// Reads a single integer from a sysfs file; returns def if not available.
+static int read_sysfs_int( const char* path, int def )
+{
+    int value = def;
+    FILE* f = fopen( path, "r" );
+    if ( f != NULL ) {
+        if ( fscanf( f, "%d", &value ) != 1 )
+            value = def;
+        fclose( f );
+    }
+    return value;
+}
+
+
+// -----------------------------------------------------------------------------
+// Returns NUMA node of cpu, from its nodeM link in sysfs, or -1 if unknown.
+static int read_sysfs_node( int cpu )
+{
+    char path[ 256 ];
+    snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu );
+    int node = -1;
+    DIR* dir = opendir( path );
+    if ( dir != NULL ) {
+        struct dirent* entry;
+        while ( (entry = readdir( dir )) != NULL ) {
+            int n;
+            char c;
+            if ( sscanf( entry->d_name, "node%d%c", &n, &c ) == 1 ) {
+                node = n;
+                break;
+            }
+        }
+        closedir( dir );
+    }
+    return node;
+}
+
+
+// -----------------------------------------------------------------------------
+// CPUs the process may run on, with their socket and core layout, and the
+// order in which each policy assigns them to threads.
+// Discovered once, on first use, from the process's affinity mask
+// (which reflects its cgroup cpuset, taskset, numactl, etc.) and sysfs.
+class magma_cpu_topology
+{
+public:
+    magma_cpu_topology();
+
+    std::vector< int > compact, scatter, core;
+    int ncores;
+};
+
+magma_cpu_topology::magma_cpu_topology():
+    ncores( 0 )
+{
+    // allowed CPUs; use the main thread's mask, since the calling thread
+    // may already be bound to a single CPU.
+    cpu_set_t allowed;
+    CPU_ZERO( &allowed );
+    if ( sched_getaffinity( getpid(), sizeof(allowed), &allowed ) != 0 ) {
+        long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+        for (int cpu = 0; cpu < ncpu && cpu < CPU_SETSIZE; ++cpu)
+            CPU_SET( cpu, &allowed );
+    }
+
+    std::vector< magma_cpu_info > cpus;
+    char path[ 256 ];
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if ( ! CPU_ISSET( cpu, &allowed ))
+            continue;
+        magma_cpu_info info;
+        info.cpu = cpu;
+        snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu );
+        info.package = read_sysfs_int( path, 0 );
+        snprintf( path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu );
+        info.core = read_sysfs_int( path, cpu );
+        info.domain = read_sysfs_node( cpu );
+        if ( info.domain < 0 )
+            info.domain = info.package;
+        info.smt = 0;
+        info.core_rank = 0;
+        cpus.push_back( info );
+    }
+
+    // compact: socket by socket, core by core, SMT siblings adjacent
+    std::sort( cpus.begin(), cpus.end(),
+        []( const magma_cpu_info& a, const magma_cpu_info& b ) {
+            if ( a.domain  != b.domain  ) return a.domain  < b.domain;
+            if ( a.package != b.package ) return a.package < b.package;
+            if ( a.core    != b.core    ) return a.core    < b.core;
+            return a.cpu < b.cpu;
+        });
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        if ( i > 0 && cpus[i].package == cpus[i-1].package
+                   && cpus[i].core    == cpus[i-1].core ) {
+            cpus[i].smt       = cpus[i-1].smt + 1;
+            cpus[i].core_rank = cpus[i-1].core_rank;
+        }
+        else {
+            ncores += 1;
+            if ( i > 0 && cpus[i].domain == cpus[i-1].domain )
+                cpus[i].core_rank = cpus[i-1].core_rank + 1;
+        }
+        compact.push_back( cpus[i].cpu );
+    }
+
+    // core: first SMT sibling of every core, then second siblings, etc.
+    std::stable_sort( cpus.begin(), cpus.end(),
+        []( const magma_cpu_info& a, const magma_cpu_info& b ) {
+            return a.smt < b.smt;
+        });
+    for (size_t i = 0; i < cpus.size(); ++i)
+        core.push_back( cpus[i].cpu );
+
+    // scatter: like core, but alternating sockets
+    std::stable_sort( cpus.begin(), cpus.end(),
+        []( const magma_cpu_info& a, const magma_cpu_info& b ) {
+            if ( a.smt       != b.smt       ) return a.smt       < b.smt;
+            if ( a.core_rank != b.core_rank ) return a.core_rank < b.core_rank;
+            return a.domain < b.domain;
+        });
+    for (size_t i = 0; i < cpus.size(); ++i)
+        scatter.push_back( cpus[i].cpu );
+}
+
+
+// -----------------------------------------------------------------------------
+static const magma_cpu_topology& magma_get_cpu_topology()
+{
+    static magma_cpu_topology topology;  // thread-safe initialization in C++11
+    return topology;
+}
+
+
+// -----------------------------------------------------------------------------
+// -1 until first queried; then a magma_affinity_policy_t.
+static std::atomic<int> g_affinity_policy( -1 );
+
+
+/***************************************************************************//**
+    @return Policy for placing threads of parallel sections on CPUs.
+    Initially set by the environment variable MAGMA_AFFINITY, which can be
+    "compact", "scatter", "core", or "none"; the default is "core".
+
+    @sa magma_set_affinity_policy
+    @ingroup magma_thread
+*******************************************************************************/
+magma_affinity_policy_t magma_get_affinity_policy()
+{
+    int policy = g_affinity_policy.load();
+    if ( policy < 0 ) {
+        policy = MagmaAffinityCore;
+        const char* str = getenv( "MAGMA_AFFINITY" );
+        if ( str != NULL ) {
+            if      ( strcasecmp( str, "none"    ) == 0 ) policy = MagmaAffinityNone;
+            else if ( strcasecmp( str, "compact" ) == 0 ) policy = MagmaAffinityCompact;
+            else if ( strcasecmp( str, "scatter" ) == 0 ) policy = MagmaAffinityScatter;
+            else if ( strcasecmp( str, "core"    ) == 0 ) policy = MagmaAffinityCore;
+            else {
+                fprintf( stderr, "$MAGMA_AFFINITY='%s' is invalid; using 'core'.\n", str );
+            }
+        }
+        g_affinity_policy.store( policy );
+    }
+    return (magma_affinity_policy_t) policy;
+}
+
+
+/***************************************************************************//**
+    Sets policy for placing threads of parallel sections on CPUs,
+    overriding the environment variable MAGMA_AFFINITY.
+
+    @sa magma_get_affinity_policy
+    @ingroup magma_thread
+*******************************************************************************/
+void magma_set_affinity_policy( magma_affinity_policy_t policy )
+{
+    g_affinity_policy.store( policy );
+}
+
+
+/***************************************************************************//**
+    @return CPU to bind thread id of a parallel section to, under the current
+    policy, or -1 if threads should not be bound. If there are more threads
+    than allowed CPUs, CPUs are reused cyclically.
+
+    @ingroup magma_thread
+*******************************************************************************/
+int magma_affinity_cpu( int id )
+{
+    const magma_cpu_topology& topo = magma_get_cpu_topology();
+    const std::vector< int >* order;
+    switch ( magma_get_affinity_policy() ) {
+        case MagmaAffinityCompact: order = &topo.compact; break;
+        case MagmaAffinityScatter: order = &topo.scatter; break;
+        case MagmaAffinityCore:    order = &topo.core;    break;
+        default: return -1;
+    }
+    if ( order->empty() || id < 0 )
+        return -1;
+    return (*order)[ id % order->size() ];
+}
+
+
+/***************************************************************************//**
+    @return Number of logical CPUs the process may run on.
+
+    @ingroup magma_thread
+*******************************************************************************/
+int magma_affinity_ncpus()
+{
+    return (int) magma_get_cpu_topology().compact.size();
+}
+
+
+/***************************************************************************//**
+    @return Number of physical cores the process may run on.
+
+    @ingroup magma_thread
+*******************************************************************************/
+int magma_affinity_ncores()
+{
+    return magma_get_cpu_topology().ncores;
+}
 
 affinity_set::affinity_set()
 {
@@ -33,6 +282,20 @@ void affinity_set::add(int cpu)
 }
 
 
+// Sets to the single CPU for thread id of a parallel section,
+// under the current policy. Returns false, leaving the set empty,
+// if the policy is to not bind threads.
+bool affinity_set::place_thread(int id)
+{
+    CPU_ZERO(&set);
+    int cpu = magma_affinity_cpu(id);
+    if (cpu < 0)
+        return false;
+    CPU_SET(cpu, &set);
+    return true;
+}
+
+
 int affinity_set::get_affinity()
 {
     return sched_getaffinity( 0, sizeof(set), &set);
@@ -21,6 +21,25 @@
 
 #if __GLIBC_PREREQ(2,3)
 
+// Policies for placing threads of parallel sections on CPUs.
+// Only CPUs in the process's affinity mask (e.g., its cgroup cpuset) are used.
+typedef enum {
+    MagmaAffinityNone    = 0,  // do not bind threads
+    MagmaAffinityCompact = 1,  // fill each socket's cores, SMT siblings adjacent
+    MagmaAffinityScatter = 2,  // round-robin across sockets, one thread per core first
+    MagmaAffinityCore    = 3   // one thread per physical core, socket by socket
+} magma_affinity_policy_t;
+
+magma_affinity_policy_t magma_get_affinity_policy();
+
+void magma_set_affinity_policy( magma_affinity_policy_t policy );
+
+int magma_affinity_cpu( int id );
+
+int magma_affinity_ncpus();
+
+int magma_affinity_ncores();
+
 class affinity_set
 {
 public:
@@ -31,6 +50,8 @@ public:
 
     void add(int cpu);
 
+    bool place_thread(int id);
+
     int get_affinity();
 
     int set_affinity();
@@ -506,10 +506,12 @@ magma_int_t magma_get_sgeqr2_fused_sm_batched_nthreads(magma_int_t m, magma_int_
 }
 
 /***************************************************************************//**
-    @return the crossover point between the _lg or the kernel directly
+    @return the crossover point between the _lg or the kernel directly,
+    or the value in the tuning table, if set; see magma_tune_set.
 *******************************************************************************/
 magma_int_t magma_get_zpotrf_batched_crossover()
 {
+    MAGMA_TUNED_RETURN( "zpotrf_batched_crossover", 0 );
     magma_int_t arch = magma_getdevice_arch();
     if(arch >= 700){
         return 352;
@@ -525,6 +527,7 @@ magma_int_t magma_get_zpotrf_batched_crossover()
 /// @see magma_get_zpotrf_batched_crossover
 magma_int_t magma_get_cpotrf_batched_crossover()
 {
+    MAGMA_TUNED_RETURN( "cpotrf_batched_crossover", 0 );
     magma_int_t arch = magma_getdevice_arch();
     if(arch >= 700){
         return 576;
@@ -540,6 +543,7 @@ magma_int_t magma_get_cpotrf_batched_crossover()
 /// @see magma_get_zpotrf_batched_crossover
 magma_int_t magma_get_dpotrf_batched_crossover()
 {
+    MAGMA_TUNED_RETURN( "dpotrf_batched_crossover", 0 );
     magma_int_t arch = magma_getdevice_arch();
     if(arch >= 700){
         return 640;
@@ -555,6 +559,7 @@ magma_int_t magma_get_dpotrf_batched_crossover()
 /// @see magma_get_zpotrf_batched_crossover
 magma_int_t magma_get_spotrf_batched_crossover()
 {
+    MAGMA_TUNED_RETURN( "spotrf_batched_crossover", 0 );
     magma_int_t arch = magma_getdevice_arch();
     if(arch >= 700){
         return 608;
@@ -567,28 +572,33 @@ magma_int_t magma_get_spotrf_batched_crossover()
     }
 }
 /***************************************************************************//**
-    @return the crossover point between the _lg or the kernel directly
+    @return the crossover point between the _lg or the kernel directly,
+    or the value in the tuning table, if set; see magma_tune_set.
 *******************************************************************************/
 magma_int_t magma_get_zpotrf_vbatched_crossover()
 {
+    MAGMA_TUNED_RETURN( "zpotrf_vbatched_crossover", 0 );
     return ZPOTRF_VBATCHED_SWITCH;
 }
 
 /// @see magma_get_zpotrf_vbatched_crossover
 magma_int_t magma_get_cpotrf_vbatched_crossover()
 {
+    MAGMA_TUNED_RETURN( "cpotrf_vbatched_crossover", 0 );
     return CPOTRF_VBATCHED_SWITCH;
 }
 
 /// @see magma_get_zpotrf_vbatched_crossover
 magma_int_t magma_get_dpotrf_vbatched_crossover()
 {
+    MAGMA_TUNED_RETURN( "dpotrf_vbatched_crossover", 0 );
     return DPOTRF_VBATCHED_SWITCH;
 }
 
 /// @see magma_get_zpotrf_vbatched_crossover
 magma_int_t magma_get_spotrf_vbatched_crossover()
 {
+    MAGMA_TUNED_RETURN( "spotrf_vbatched_crossover", 0 );
     return SPOTRF_VBATCHED_SWITCH;
 }
 
@@ -25,13 +25,15 @@ extern "C" {
 /// Optimal block sizes vary with GPU and, to a lesser extent, CPU.
 /// Kepler tuning was on K20c   705 MHz with SandyBridge 2.6 GHz host (bunsen).
 /// Fermi  tuning was on S2050 1147 MHz with AMD Opteron 2.4 GHz host (romulus).
+/// Values tuned on this host by magma_tune_run, loaded from $MAGMA_TUNE_FILE,
+/// take precedence. Routines taking m and n are tuned by min( m, n ).
 /// @{
 
-
 /******************************************************************************/
 /// @return nb for spotrf based on n
 magma_int_t magma_get_spotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "spotrf_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -53,6 +55,7 @@ magma_int_t magma_get_spotrf_nb( magma_int_t n )
 /// @return nb for dpotrf based on n
 magma_int_t magma_get_dpotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dpotrf_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -74,6 +77,7 @@ magma_int_t magma_get_dpotrf_nb( magma_int_t n )
 /// @return nb for cpotrf based on n
 magma_int_t magma_get_cpotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cpotrf_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -92,6 +96,7 @@ magma_int_t magma_get_cpotrf_nb( magma_int_t n )
 /// @return nb for zpotrf based on n
 magma_int_t magma_get_zpotrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zpotrf_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -112,24 +117,28 @@ magma_int_t magma_get_zpotrf_nb( magma_int_t n )
 /// @return nb for zpotrf_right based on n
 magma_int_t magma_get_zpotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zpotrf_right_nb", n );
     return 128;
 }
 
 /// @return nb for cpotrf_right based on n
 magma_int_t magma_get_cpotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cpotrf_right_nb", n );
     return 128;
 }
 
 /// @return nb for dpotrf_right based on n
 magma_int_t magma_get_dpotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dpotrf_right_nb", n );
     return 320;
 }
 
 /// @return nb for spotrf_right based on n
 magma_int_t magma_get_spotrf_right_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "spotrf_right_nb", n );
     return 128;
 }
 
@@ -138,24 +147,28 @@ magma_int_t magma_get_spotrf_right_nb( magma_int_t n )
 /// @return nb for sgeqp3 based on m, n
 magma_int_t magma_get_sgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgeqp3_nb", min( m, n ) );
     return 32;
 }
 
 /// @return nb for dgeqp3 based on m, n
 magma_int_t magma_get_dgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgeqp3_nb", min( m, n ) );
     return 32;
 }
 
 /// @return nb for cgeqp3 based on m, n
 magma_int_t magma_get_cgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgeqp3_nb", min( m, n ) );
     return 32;
 }
 
 /// @return nb for zgeqp3 based on m, n
 magma_int_t magma_get_zgeqp3_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgeqp3_nb", min( m, n ) );
     return 32;
 }
 
@@ -164,6 +177,7 @@ magma_int_t magma_get_zgeqp3_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgeqrf based on m, n
 magma_int_t magma_get_sgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgeqrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -192,6 +206,7 @@ magma_int_t magma_get_sgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for dgeqrf based on m, n
 magma_int_t magma_get_dgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgeqrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -214,6 +229,7 @@ magma_int_t magma_get_dgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgeqrf based on m, n
 magma_int_t magma_get_cgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgeqrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -235,6 +251,7 @@ magma_int_t magma_get_cgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgeqrf based on m, n
 magma_int_t magma_get_zgeqrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgeqrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -262,6 +279,7 @@ magma_int_t magma_get_zgeqrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgeqlf based on m, n
 magma_int_t magma_get_sgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgeqlf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -279,6 +297,7 @@ magma_int_t magma_get_sgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for dgeqlf based on m, n
 magma_int_t magma_get_dgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgeqlf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -296,6 +315,7 @@ magma_int_t magma_get_dgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgeqlf based on m, n
 magma_int_t magma_get_cgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgeqlf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  2048) nb = 32;
@@ -307,6 +327,7 @@ magma_int_t magma_get_cgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgeqlf based on m, n
 magma_int_t magma_get_zgeqlf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgeqlf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  1024) nb = 64;
@@ -319,12 +340,14 @@ magma_int_t magma_get_zgeqlf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgelqf based on m, n
 magma_int_t magma_get_sgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgelqf_nb", min( m, n ) );
     return magma_get_sgeqrf_nb( m, n );
 }
 
 /// @return nb for dgelqf based on m, n
 magma_int_t magma_get_dgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgelqf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -342,6 +365,7 @@ magma_int_t magma_get_dgelqf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgelqf based on m, n
 magma_int_t magma_get_cgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgelqf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  2048) nb = 32;
@@ -353,6 +377,7 @@ magma_int_t magma_get_cgelqf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgelqf based on m, n
 magma_int_t magma_get_zgelqf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgelqf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     if      (minmn <  1024) nb = 64;
@@ -410,6 +435,8 @@ double magma_get_gemex_rankk_time( magma_int_t m, magma_int_t k, magma_mp_type_t
                 {
                     perf = 9e12;
                 }
+                // measured rate, if calibrated; see magma_perfmodel_calibrate
+                magma_perfmodel_hgemmx_rate( m, k, &perf );
             }
             break;
         case Magma_MP_GEMEX_I16_O16_C32:
@@ -442,10 +469,15 @@ double magma_get_cpu_sgetrf_time( magma_int_t m, magma_int_t n)
 {
     double sgetrf_perf=0;
     double pci_bandwidth = 12e9;
+    magma_perfmodel_h2d_bandwidth( &pci_bandwidth );  // measured, if calibrated
     double time_data_transfer = 2*(m*n*4)/pci_bandwidth;
     double time_sgetrf        = 0;
 
-    if(n >= 1024)
+    if ( magma_perfmodel_sgetrf_cpu_rate( m, n, &sgetrf_perf ))
+    {
+        // measured rate of this host; see magma_perfmodel_calibrate
+    }
+    else if(n >= 1024)
     {
         sgetrf_perf = 587e9;
     }else if( n >= 512)
@@ -515,6 +547,7 @@ magma_int_t magma_get_xgetrf_nb(
         magma_int_t m, magma_int_t n, magma_int_t prev_nb,
         magma_mp_type_t enable_tc, magma_mp_type_t mp_algo_type)
 {
+    MAGMA_TUNED_RETURN( "xgetrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     //magma_int_t arch = magma_getdevice_arch();
@@ -577,6 +610,7 @@ magma_int_t magma_get_xgetrf_nb(
 //-------------------------------------------------------------------------------
 magma_int_t magma_get_hgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "hgetrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     //magma_int_t arch = magma_getdevice_arch();
@@ -642,6 +676,7 @@ magma_int_t magma_get_hgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgetrf based on m, n
 magma_int_t magma_get_sgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgetrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -671,6 +706,7 @@ magma_int_t magma_get_sgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for dgetrf based on m, n
 magma_int_t magma_get_dgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgetrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -701,6 +737,7 @@ magma_int_t magma_get_dgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for cgetrf based on m, n
 magma_int_t magma_get_cgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgetrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -727,6 +764,7 @@ magma_int_t magma_get_cgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for zgetrf based on m, n
 magma_int_t magma_get_zgetrf_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgetrf_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -754,6 +792,7 @@ magma_int_t magma_get_zgetrf_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native sgetrf based on m, n
 magma_int_t magma_get_sgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgetrf_native_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -782,6 +821,7 @@ magma_int_t magma_get_sgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native dgetrf based on m, n
 magma_int_t magma_get_dgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgetrf_native_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -811,6 +851,7 @@ magma_int_t magma_get_dgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native cgetrf based on m, n
 magma_int_t magma_get_cgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgetrf_native_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -837,6 +878,7 @@ magma_int_t magma_get_cgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for native zgetrf based on m, n
 magma_int_t magma_get_zgetrf_native_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgetrf_native_nb", min( m, n ) );
     magma_int_t nb;
     magma_int_t minmn = min( m, n );
     magma_int_t arch = magma_getdevice_arch();
@@ -867,6 +909,7 @@ magma_int_t magma_get_zgetrf_native_nb( magma_int_t m, magma_int_t n )
 /// @return nb for sgehrd based on n
 magma_int_t magma_get_sgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgehrd_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 200 ) {       // 2.x Fermi
@@ -883,6 +926,7 @@ magma_int_t magma_get_sgehrd_nb( magma_int_t n )
 /// @return nb for dgehrd based on n
 magma_int_t magma_get_dgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgehrd_nb", n );
     magma_int_t nb;
     if      (n <  2048) nb = 32;
     else                nb = 64;
@@ -892,6 +936,7 @@ magma_int_t magma_get_dgehrd_nb( magma_int_t n )
 /// @return nb for cgehrd based on n
 magma_int_t magma_get_cgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgehrd_nb", n );
     magma_int_t nb;
     if      (n <  1024) nb = 32;
     else                nb = 64;
@@ -901,6 +946,7 @@ magma_int_t magma_get_cgehrd_nb( magma_int_t n )
 /// @return nb for zgehrd based on n
 magma_int_t magma_get_zgehrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgehrd_nb", n );
     magma_int_t nb;
     if      (n <  2048) nb = 32;
     else                nb = 64;
@@ -914,24 +960,28 @@ magma_int_t magma_get_zgehrd_nb( magma_int_t n )
 /// @return nb for ssytrd based on n
 magma_int_t magma_get_ssytrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "ssytrd_nb", n );
     return 64;
 }
 
 /// @return nb for dsytrd based on n
 magma_int_t magma_get_dsytrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dsytrd_nb", n );
     return 64;
 }
 
 /// @return nb for chetrd based on n
 magma_int_t magma_get_chetrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "chetrd_nb", n );
     return 64;
 }
 
 /// @return nb for zhetrd based on n
 magma_int_t magma_get_zhetrd_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zhetrd_nb", n );
     return 64;
 }
 
@@ -940,24 +990,28 @@ magma_int_t magma_get_zhetrd_nb( magma_int_t n )
 /// @return nb for zhetrf based on n
 magma_int_t magma_get_zhetrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zhetrf_nb", n );
     return 256;
 }
 
 /// @return nb for chetrf based on n
 magma_int_t magma_get_chetrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "chetrf_nb", n );
     return 256;
 }
 
 /// @return nb for dsytrf based on n
 magma_int_t magma_get_dsytrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dsytrf_nb", n );
     return 96;
 }
 
 /// @return nb for ssytrf based on n
 magma_int_t magma_get_ssytrf_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "ssytrf_nb", n );
     return 256;
 }
 
@@ -966,24 +1020,28 @@ magma_int_t magma_get_ssytrf_nb( magma_int_t n )
 /// @return nb for zhetrf_aasen based on n
 magma_int_t magma_get_zhetrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zhetrf_aasen_nb", n );
     return 256;
 }
 
 /// @return nb for chetrf_aasen based on n
 magma_int_t magma_get_chetrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "chetrf_aasen_nb", n );
     return 256;
 }
 
 /// @return nb for dsytrf_aasen based on n
 magma_int_t magma_get_dsytrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dsytrf_aasen_nb", n );
     return 256;
 }
 
 /// @return nb for ssytrf_aasen based on n
 magma_int_t magma_get_ssytrf_aasen_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "ssytrf_aasen_nb", n );
     return 256;
 }
 
@@ -992,24 +1050,28 @@ magma_int_t magma_get_ssytrf_aasen_nb( magma_int_t n )
 /// @return nb for zhetrf_nopiv based on n
 magma_int_t magma_get_zhetrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zhetrf_nopiv_nb", n );
     return 320;
 }
 
 /// @return nb for chetrf_nopiv based on n
 magma_int_t magma_get_chetrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "chetrf_nopiv_nb", n );
     return 320;
 }
 
 /// @return nb for dsytrf_nopiv based on n
 magma_int_t magma_get_dsytrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dsytrf_nopiv_nb", n );
     return 320;
 }
 
 /// @return nb for ssytrf_nopiv based on n
 magma_int_t magma_get_ssytrf_nopiv_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "ssytrf_nopiv_nb", n );
     return 320;
 }
 
@@ -1018,24 +1080,28 @@ magma_int_t magma_get_ssytrf_nopiv_nb( magma_int_t n )
 /// @return nb for sgebrd based on m, n
 magma_int_t magma_get_sgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgebrd_nb", min( m, n ) );
     return 32;
 }
 
 /// @return nb for dgebrd based on m, n
 magma_int_t magma_get_dgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgebrd_nb", min( m, n ) );
     return 32;
 }
 
 /// @return nb for cgebrd based on m, n
 magma_int_t magma_get_cgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgebrd_nb", min( m, n ) );
     return 32;
 }
 
 /// @return nb for zgebrd based on m, n
 magma_int_t magma_get_zgebrd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgebrd_nb", min( m, n ) );
     return 32;
 }
 
@@ -1044,6 +1110,7 @@ magma_int_t magma_get_zgebrd_nb( magma_int_t m, magma_int_t n )
 /// @return nb for ssygst based on n
 magma_int_t magma_get_ssygst_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "ssygst_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1063,6 +1130,7 @@ magma_int_t magma_get_ssygst_nb( magma_int_t n )
 /// @return nb for dsygst based on n
 magma_int_t magma_get_dsygst_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dsygst_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1081,6 +1149,7 @@ magma_int_t magma_get_dsygst_nb( magma_int_t n )
 /// @return nb for chegst based on n
 magma_int_t magma_get_chegst_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "chegst_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1099,6 +1168,7 @@ magma_int_t magma_get_chegst_nb( magma_int_t n )
 /// @return nb for zhegst based on n
 magma_int_t magma_get_zhegst_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zhegst_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler
@@ -1118,24 +1188,28 @@ magma_int_t magma_get_zhegst_nb( magma_int_t n )
 /// @return nb for sgetri based on n
 magma_int_t magma_get_sgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgetri_nb", n );
     return 64;
 }
 
 /// @return nb for dgetri based on n
 magma_int_t magma_get_dgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgetri_nb", n );
     return 64;
 }
 
 /// @return nb for cgetri based on n
 magma_int_t magma_get_cgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgetri_nb", n );
     return 64;
 }
 
 /// @return nb for zgetri based on n
 magma_int_t magma_get_zgetri_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgetri_nb", n );
     return 64;
 }
 
@@ -1144,24 +1218,28 @@ magma_int_t magma_get_zgetri_nb( magma_int_t n )
 /// @return nb for sgesvd based on m, n
 magma_int_t magma_get_sgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sgesvd_nb", min( m, n ) );
     return magma_get_sgebrd_nb( m, n );
 }
 
 /// @return nb for dgesvd based on m, n
 magma_int_t magma_get_dgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dgesvd_nb", min( m, n ) );
     return magma_get_dgebrd_nb( m, n );
 }
 
 /// @return nb for cgesvd based on m, n
 magma_int_t magma_get_cgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cgesvd_nb", min( m, n ) );
     return magma_get_cgebrd_nb( m, n );
 }
 
 /// @return nb for zgesvd based on m, n
 magma_int_t magma_get_zgesvd_nb( magma_int_t m, magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zgesvd_nb", min( m, n ) );
     return magma_get_zgebrd_nb( m, n );
 }
 
@@ -1170,6 +1248,7 @@ magma_int_t magma_get_zgesvd_nb( magma_int_t m, magma_int_t n )
 /// @return nb for ssygst_m based on n
 magma_int_t magma_get_ssygst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "ssygst_m_nb", n );
     return 256; //to be updated
 
     /*
@@ -1193,6 +1272,7 @@ magma_int_t magma_get_ssygst_m_nb( magma_int_t n )
 /// @return nb for dsygst_m based on n
 magma_int_t magma_get_dsygst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dsygst_m_nb", n );
     return 256; //to be updated
 
     /*
@@ -1215,6 +1295,7 @@ magma_int_t magma_get_dsygst_m_nb( magma_int_t n )
 /// @return nb for chegst_m based on n
 magma_int_t magma_get_chegst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "chegst_m_nb", n );
     return 256; //to be updated
 
     /*
@@ -1237,6 +1318,7 @@ magma_int_t magma_get_chegst_m_nb( magma_int_t n )
 /// @return nb for zhegst_m based on n
 magma_int_t magma_get_zhegst_m_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zhegst_m_nb", n );
     return 256; //to be updated
 
     /*
@@ -1342,6 +1424,7 @@ magma_int_t magma_get_smlsize_divideconquer()
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_sbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED_RETURN( "sbulge_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1359,6 +1442,7 @@ magma_int_t magma_get_sbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_dbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED_RETURN( "dbulge_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1376,6 +1460,7 @@ magma_int_t magma_get_dbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_cbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 {
+    MAGMA_TUNED_RETURN( "cbulge_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1396,6 +1481,7 @@ magma_int_t magma_get_cbulge_nb( magma_int_t n, magma_int_t nbthreads  )
 /// @return nb for 2 stage TRD
 magma_int_t magma_get_zbulge_nb( magma_int_t n, magma_int_t nbthreads )
 {
+    MAGMA_TUNED_RETURN( "zbulge_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1418,6 +1504,9 @@ magma_int_t magma_get_zbulge_nb( magma_int_t n, magma_int_t nbthreads )
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_sbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads  )
 {
+    magma_int_t tuned;
+    if ( magma_tune_lookup( "sbulge_vblksiz", n, &tuned ))
+        return min( tuned, nb );  // Vblksiz <= nb
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1432,6 +1521,9 @@ magma_int_t magma_get_sbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_dbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads  )
 {
+    magma_int_t tuned;
+    if ( magma_tune_lookup( "dbulge_vblksiz", n, &tuned ))
+        return min( tuned, nb );  // Vblksiz <= nb
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1446,6 +1538,9 @@ magma_int_t magma_get_dbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_cbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads )
 {
+    magma_int_t tuned;
+    if ( magma_tune_lookup( "cbulge_vblksiz", n, &tuned ))
+        return min( tuned, nb );  // Vblksiz <= nb
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1463,6 +1558,9 @@ magma_int_t magma_get_cbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return Vblksiz for 2 stage TRD
 magma_int_t magma_get_zbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t nbthreads )
 {
+    magma_int_t tuned;
+    if ( magma_tune_lookup( "zbulge_vblksiz", n, &tuned ))
+        return min( tuned, nb );  // Vblksiz <= nb
     magma_int_t size;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1482,6 +1580,7 @@ magma_int_t magma_get_zbulge_vblksiz( magma_int_t n, magma_int_t nb, magma_int_t
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_sbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "sbulge_mgpu_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1499,6 +1598,7 @@ magma_int_t magma_get_sbulge_mgpu_nb( magma_int_t n )
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_dbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "dbulge_mgpu_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1516,6 +1616,7 @@ magma_int_t magma_get_dbulge_mgpu_nb( magma_int_t n )
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_cbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "cbulge_mgpu_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -1533,6 +1634,7 @@ magma_int_t magma_get_cbulge_mgpu_nb( magma_int_t n )
 /// @return nb for 2 stage TRD_MGPU
 magma_int_t magma_get_zbulge_mgpu_nb( magma_int_t n )
 {
+    MAGMA_TUNED_RETURN( "zbulge_mgpu_nb", n );
     magma_int_t nb;
     magma_int_t arch = magma_getdevice_arch();
     if ( arch >= 300 ) {       // 3.x Kepler + SB
@@ -0,0 +1,692 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <atomic>
+
+#include "magma_internal.h"
+
+#if ! (defined( _WIN32 ) || defined( _WIN64 ))
+    #include <sys/mman.h>
+#endif
+
+
+/*
+    Caching allocator behind magma_malloc_cpu, enabled by $MAGMA_CPU_POOL or
+    magma_cpu_pool_config.
+
+    Small blocks (up to c_max_small bytes) are rounded up to one of about 50
+    size classes (4 per power of 2) and carved from 2 MiB chunks. Freed small
+    blocks go to a per-thread free list for their class, overflowing in
+    batches to a global list, and are never returned to the system.
+    Large blocks are separate spans from the system, rounded similarly;
+    freed spans are cached in global lists, up to c_large_cache bytes,
+    until magma_cpu_pool_trim or magma_finalize.
+
+    Each block is preceded by one alignment unit holding its header, so the
+    user pointer is aligned. magma_free_cpu identifies pool blocks, even
+    after the pool is disabled, using a lock-free bitmap of the 64 KiB
+    granules that the pool owns (like tcmalloc's pagemap); other pointers
+    go to the system free().
+*/
+
+// -----------------------------------------------------------------------------
+static const int      c_granule_bits = 16;     // pagemap granule, 64 KiB
+static const size_t   c_granule      = size_t(1) << c_granule_bits;
+static const int      c_leaf_bits    = 34;     // each pagemap leaf covers 16 GiB
+static const int      c_addr_bits    = 48;     // pool memory beyond this is not used
+static const size_t   c_top_size     = size_t(1) << (c_addr_bits - c_leaf_bits);
+static const size_t   c_leaf_words   = (size_t(1) << (c_leaf_bits - c_granule_bits)) / 64;
+
+static const size_t   c_hugepage     = size_t(2) << 20;    // 2 MiB
+static const size_t   c_chunk_size   = size_t(2) << 20;    // small block chunks
+static const size_t   c_max_small    = size_t(256) << 10;  // largest small block
+static const size_t   c_tcache_bytes = size_t(1) << 20;    // per thread, per class
+static const size_t   c_large_cache  = size_t(1) << 30;    // cached large spans
+
+static const int      c_max_class    = 64;
+static const int      c_large_lists  = 4*64;
+static const uint32_t c_magic        = 0x6d676d61;
+
+// -----------------------------------------------------------------------------
+// Header in the last 16 bytes of the alignment unit before each user pointer.
+struct magma_cpu_pool_header
+{
+    size_t   size;    // block size, including the alignment unit
+    uint32_t magic;
+    int32_t  cls;     // small size class, or -1 for a large span
+};
+
+// -----------------------------------------------------------------------------
+// Per-thread cache of free small blocks, linked through their first word.
+// Has no constructor, so is zero initialized.
+struct magma_cpu_pool_tcache
+{
+    void*  head [ c_max_class ];
+    size_t count[ c_max_class ];
+    char*  bump;      // unused part of this thread's current chunk
+    char*  bump_end;
+    bool   dead;      // thread is exiting; use global lists
+
+    ~magma_cpu_pool_tcache();
+};
+
+// -----------------------------------------------------------------------------
+// Configuration; fixed once the pool reserves memory (g_pool_started).
+static std::atomic<int> g_pool_on( 0 );
+static size_t g_pool_align     = 64;
+static bool   g_pool_hugepages = false;
+static std::atomic<bool> g_pool_started( false );
+
+static size_t g_class_size[ c_max_class ];  // block sizes, increasing
+static int    g_nclass = 0;
+
+// g_pool_mutex protects the global free lists.
+static pthread_mutex_t g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void*  g_free_head [ c_max_class ];
+static size_t g_free_count[ c_max_class ];
+static void*  g_large_head[ c_large_lists ];
+static size_t g_large_cached = 0;
+
+// pagemap: one bit per granule owned by the pool
+static std::atomic< std::atomic<uint64_t>* > g_pagemap[ c_top_size ];
+
+// statistics
+static std::atomic<size_t>    g_bytes_in_use( 0 );
+static std::atomic<size_t>    g_peak_in_use( 0 );
+static std::atomic<size_t>    g_bytes_reserved( 0 );
+static std::atomic<size_t>    g_peak_reserved( 0 );
+static std::atomic<long long> g_nalloc( 0 );
+static std::atomic<long long> g_nhit( 0 );
+
+static thread_local magma_cpu_pool_tcache t_cache;
+
+
+/******************************************************************************/
+static size_t round_up( size_t x, size_t align )
+{
+    return (x + align - 1) & ~(align - 1);
+}
+
+/******************************************************************************/
+// floor( log2( x ) ), for x > 0
+static int floor_log2( size_t x )
+{
+    int k = 0;
+    while ( x >>= 1 )
+        k += 1;
+    return k;
+}
+
+/******************************************************************************/
+static void update_max( std::atomic<size_t>& peak, size_t value )
+{
+    size_t old = peak.load( std::memory_order_relaxed );
+    while ( value > old
+            && ! peak.compare_exchange_weak( old, value, std::memory_order_relaxed )) {
+        // old updated by compare_exchange
+    }
+}
+
+
+/******************************************************************************/
+// Sets bits for [ptr, ptr + size) in pagemap; ptr and size are multiples of
+// the granule. Returns false if memory is outside the pagemap.
+static bool pagemap_set( char* ptr, size_t size, bool value )
+{
+    uintptr_t first = uintptr_t( ptr ) >> c_granule_bits;
+    uintptr_t last  = (uintptr_t( ptr ) + size - 1) >> c_granule_bits;
+    if ( (last >> (c_addr_bits - c_granule_bits)) != 0 )
+        return false;
+    for ( uintptr_t g = first; g <= last; ++g ) {
+        size_t top = g >> (c_leaf_bits - c_granule_bits);
+        size_t bit = g & ((size_t(1) << (c_leaf_bits - c_granule_bits)) - 1);
+        std::atomic<uint64_t>* leaf = g_pagemap[ top ].load( std::memory_order_acquire );
+        if ( leaf == NULL ) {
+            // leaves are never freed; lose the race gracefully
+            std::atomic<uint64_t>* fresh = new std::atomic<uint64_t>[ c_leaf_words ];
+            for ( size_t i = 0; i < c_leaf_words; ++i )
+                fresh[ i ].store( 0, std::memory_order_relaxed );
+            if ( g_pagemap[ top ].compare_exchange_strong( leaf, fresh ))
+                leaf = fresh;
+            else
+                delete[] fresh;
+        }
+        uint64_t mask = uint64_t(1) << (bit % 64);
+        if ( value )
+            leaf[ bit / 64 ].fetch_or( mask, std::memory_order_release );
+        else
+            leaf[ bit / 64 ].fetch_and( ~mask, std::memory_order_release );
+    }
+    return true;
+}
+
+/******************************************************************************/
+static bool pagemap_get( const void* ptr )
+{
+    uintptr_t g = uintptr_t( ptr ) >> c_granule_bits;
+    if ( (g >> (c_addr_bits - c_granule_bits)) != 0 )
+        return false;
+    size_t top = g >> (c_leaf_bits - c_granule_bits);
+    size_t bit = g & ((size_t(1) << (c_leaf_bits - c_granule_bits)) - 1);
+    std::atomic<uint64_t>* leaf = g_pagemap[ top ].load( std::memory_order_acquire );
+    if ( leaf == NULL )
+        return false;
+    return (leaf[ bit / 64 ].load( std::memory_order_acquire ) >> (bit % 64)) & 1;
+}
+
+
+/******************************************************************************/
+// Gets size bytes aligned to align (>= granule) from the system, and marks
+// them in the pagemap. Large aligned regions are advised to use transparent
+// huge pages, if enabled.
+static char* pool_sys_alloc( size_t size, size_t align )
+{
+    char* ptr = NULL;
+#if defined( _WIN32 ) || defined( _WIN64 )
+    ptr = (char*) _aligned_malloc( size, align );
+    if ( ptr == NULL )
+        return NULL;
+#else
+    size_t extra = align;
+    char* raw = (char*) mmap( NULL, size + extra, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( raw == (char*) MAP_FAILED )
+        return NULL;
+    ptr = (char*) round_up( uintptr_t( raw ), align );
+    if ( ptr > raw )
+        munmap( raw, ptr - raw );
+    if ( raw + size + extra > ptr + size )
+        munmap( ptr + size, (raw + size + extra) - (ptr + size) );
+    #ifdef MADV_HUGEPAGE
+    if ( g_pool_hugepages && size >= c_hugepage )
+        madvise( ptr, size, MADV_HUGEPAGE );
+    #endif
+#endif
+
+    if ( ! pagemap_set( ptr, size, true )) {
+        #if defined( _WIN32 ) || defined( _WIN64 )
+        _aligned_free( ptr );
+        #else
+        munmap( ptr, size );
+        #endif
+        return NULL;
+    }
+    size_t reserved = g_bytes_reserved.fetch_add( size, std::memory_order_relaxed ) + size;
+    update_max( g_peak_reserved, reserved );
+    return ptr;
+}
+
+/******************************************************************************/
+static void pool_sys_free( char* ptr, size_t size )
+{
+    pagemap_set( ptr, size, false );
+    g_bytes_reserved.fetch_sub( size, std::memory_order_relaxed );
+#if defined( _WIN32 ) || defined( _WIN64 )
+    _aligned_free( ptr );
+#else
+    munmap( ptr, size );
+#endif
+}
+
+
+/******************************************************************************/
+// Size classes are multiples of the alignment, from 2 units (header + data)
+// up to c_max_small, with 4 classes per power of 2.
+static void pool_init_classes()
+{
+    g_nclass = 0;
+    size_t size = 2*g_pool_align;
+    while ( size <= c_max_small && g_nclass < c_max_class ) {
+        g_class_size[ g_nclass++ ] = size;
+        size_t step = (size_t(1) << floor_log2( size )) / 4;
+        size += (step > g_pool_align ? step : g_pool_align);
+    }
+}
+
+/******************************************************************************/
+static int pool_find_class( size_t block )
+{
+    int lo = 0, hi = g_nclass - 1;
+    while ( lo < hi ) {
+        int mid = (lo + hi) / 2;
+        if ( g_class_size[ mid ] < block )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/******************************************************************************/
+// Max number of free blocks of class cls kept in each thread's cache.
+static size_t pool_tcache_limit( int cls )
+{
+    size_t limit = c_tcache_bytes / g_class_size[ cls ];
+    return (limit < 2 ? 2 : (limit > 128 ? 128 : limit));
+}
+
+/******************************************************************************/
+// Rounds span size to 4 classes per power of 2, in multiples of the granule
+// (or huge page); sets list to its large free list.
+static size_t pool_large_size( size_t block, int* list )
+{
+    size_t unit = (g_pool_hugepages && block >= c_hugepage) ? c_hugepage : c_granule;
+    int    k    = floor_log2( block );
+    size_t step = (size_t(1) << k) / 4;
+    if ( step < unit )
+        step = unit;
+    size_t size = round_up( block, step );
+    // rounding may reach the next power of 2
+    k = floor_log2( size );
+    step = (size_t(1) << k) / 4;
+    if ( step < unit )
+        step = unit;
+    *list = 4*k + int( (size - (size_t(1) << k)) / step );
+    return size;
+}
+
+
+/******************************************************************************/
+static void* pool_block_to_user( char* block, size_t size, int cls )
+{
+    char* user = block + g_pool_align;
+    magma_cpu_pool_header* hdr = (magma_cpu_pool_header*) user - 1;
+    hdr->size  = size;
+    hdr->magic = c_magic;
+    hdr->cls   = cls;
+    return user;
+}
+
+
+/******************************************************************************/
+// Moves up to n blocks of class cls from src list to dst list.
+static void pool_move_blocks(
+    void** src_head, size_t* src_count,
+    void** dst_head, size_t* dst_count, size_t n )
+{
+    while ( n > 0 && *src_head != NULL ) {
+        void* user = *src_head;
+        *src_head = *(void**) user;
+        *(void**) user = *dst_head;
+        *dst_head = user;
+        *src_count -= 1;
+        *dst_count += 1;
+        n -= 1;
+    }
+}
+
+
+/******************************************************************************/
+magma_cpu_pool_tcache::~magma_cpu_pool_tcache()
+{
+    // return free blocks to global lists; the rest of the chunk is lost
+    dead = true;
+    pthread_mutex_lock( &g_pool_mutex );
+    for ( int cls = 0; cls < g_nclass; ++cls ) {
+        pool_move_blocks( &head[ cls ], &count[ cls ],
+                          &g_free_head[ cls ], &g_free_count[ cls ], count[ cls ] );
+    }
+    pthread_mutex_unlock( &g_pool_mutex );
+}
+
+
+/******************************************************************************/
+static void* pool_malloc_small( size_t block )
+{
+    magma_cpu_pool_tcache* tc = &t_cache;
+    int cls = pool_find_class( block );
+    size_t size = g_class_size[ cls ];
+    void* user = NULL;
+
+    // from this thread's cache, or a batch from the global list
+    if ( tc->dead ) {
+        pthread_mutex_lock( &g_pool_mutex );
+        if ( g_free_head[ cls ] != NULL ) {
+            user = g_free_head[ cls ];
+            g_free_head[ cls ] = *(void**) user;
+            g_free_count[ cls ] -= 1;
+        }
+        pthread_mutex_unlock( &g_pool_mutex );
+        if ( user == NULL )
+            return NULL;  // system allocator
+    }
+    else {
+        if ( tc->head[ cls ] == NULL ) {
+            pthread_mutex_lock( &g_pool_mutex );
+            pool_move_blocks( &g_free_head[ cls ], &g_free_count[ cls ],
+                              &tc->head[ cls ], &tc->count[ cls ],
+                              pool_tcache_limit( cls ) / 2 + 1 );
+            pthread_mutex_unlock( &g_pool_mutex );
+        }
+        if ( tc->head[ cls ] != NULL ) {
+            user = tc->head[ cls ];
+            tc->head[ cls ] = *(void**) user;
+            tc->count[ cls ] -= 1;
+        }
+    }
+
+    if ( user != NULL ) {
+        g_nhit.fetch_add( 1, std::memory_order_relaxed );
+    }
+    else {
+        // carve from this thread's chunk
+        if ( tc->bump == NULL || size_t( tc->bump_end - tc->bump ) < size ) {
+            char* chunk = pool_sys_alloc( c_chunk_size, c_chunk_size );
+            if ( chunk == NULL )
+                return NULL;
+            tc->bump     = chunk;
+            tc->bump_end = chunk + c_chunk_size;
+        }
+        user = pool_block_to_user( tc->bump, size, cls );
+        tc->bump += size;
+    }
+    return user;
+}
+
+
+/******************************************************************************/
+static void* pool_malloc_large( size_t block )
+{
+    int list;
+    size_t size = pool_large_size( block, &list );
+    if ( list >= c_large_lists )
+        return NULL;
+
+    void* user = NULL;
+    pthread_mutex_lock( &g_pool_mutex );
+    if ( g_large_head[ list ] != NULL ) {
+        user = g_large_head[ list ];
+        g_large_head[ list ] = *(void**) user;
+        g_large_cached -= size;
+    }
+    pthread_mutex_unlock( &g_pool_mutex );
+
+    if ( user != NULL ) {
+        g_nhit.fetch_add( 1, std::memory_order_relaxed );
+    }
+    else {
+        size_t align = (g_pool_hugepages && size >= c_hugepage) ? c_hugepage : c_granule;
+        char* span = pool_sys_alloc( size, align );
+        if ( span == NULL )
+            return NULL;
+        user = pool_block_to_user( span, size, -1 );
+    }
+    return user;
+}
+
+
+/******************************************************************************/
+extern "C"
+void* magma_cpu_pool_malloc( size_t size )
+{
+    if ( size > SIZE_MAX - c_hugepage - g_pool_align )
+        return NULL;
+    g_pool_started.store( true, std::memory_order_relaxed );
+
+    size_t block = g_pool_align + round_up( size, g_pool_align );
+    void* user;
+    if ( block <= c_max_small )
+        user = pool_malloc_small( block );
+    else
+        user = pool_malloc_large( block );
+    if ( user == NULL )
+        return NULL;
+
+    size_t bsize = ((magma_cpu_pool_header*) user - 1)->size;
+    g_nalloc.fetch_add( 1, std::memory_order_relaxed );
+    size_t in_use = g_bytes_in_use.fetch_add( bsize, std::memory_order_relaxed ) + bsize;
+    update_max( g_peak_in_use, in_use );
+    return user;
+}
+
+
+/******************************************************************************/
+extern "C"
+int magma_cpu_pool_free( void* ptr )
+{
+    if ( ptr == NULL || ! pagemap_get( ptr ))
+        return 0;
+
+    magma_cpu_pool_header* hdr = (magma_cpu_pool_header*) ptr - 1;
+    if ( hdr->magic != c_magic || (uintptr_t( ptr ) & (g_pool_align - 1)) != 0 )
+        return -1;
+    size_t size = hdr->size;
+    int    cls  = hdr->cls;
+    g_bytes_in_use.fetch_sub( size, std::memory_order_relaxed );
+
+    if ( cls >= 0 ) {
+        magma_cpu_pool_tcache* tc = &t_cache;
+        if ( tc->dead ) {
+            pthread_mutex_lock( &g_pool_mutex );
+            *(void**) ptr = g_free_head[ cls ];
+            g_free_head[ cls ] = ptr;
+            g_free_count[ cls ] += 1;
+            pthread_mutex_unlock( &g_pool_mutex );
+        }
+        else {
+            *(void**) ptr = tc->head[ cls ];
+            tc->head[ cls ] = ptr;
+            tc->count[ cls ] += 1;
+            size_t limit = pool_tcache_limit( cls );
+            if ( tc->count[ cls ] > limit ) {
+                pthread_mutex_lock( &g_pool_mutex );
+                pool_move_blocks( &tc->head[ cls ], &tc->count[ cls ],
+                                  &g_free_head[ cls ], &g_free_count[ cls ],
+                                  limit / 2 );
+                pthread_mutex_unlock( &g_pool_mutex );
+            }
+        }
+    }
+    else {
+        int list;
+        pool_large_size( size, &list );
+        bool cached = false;
+        pthread_mutex_lock( &g_pool_mutex );
+        if ( g_large_cached + size <= c_large_cache ) {
+            *(void**) ptr = g_large_head[ list ];
+            g_large_head[ list ] = ptr;
+            g_large_cached += size;
+            cached = true;
+        }
+        pthread_mutex_unlock( &g_pool_mutex );
+        if ( ! cached )
+            pool_sys_free( (char*) ptr - g_pool_align, size );
+    }
+    return 1;
+}
+
+
+/******************************************************************************/
+extern "C"
+int magma_cpu_pool_enabled()
+{
+    return g_pool_on.load( std::memory_order_relaxed );
+}
+
+
+/******************************************************************************/
+extern "C"
+size_t magma_cpu_pool_alignment()
+{
+    return g_pool_align;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Configures the caching allocator used by magma_malloc_cpu.
+    When enabled, magma_malloc_cpu returns blocks rounded up to a size class
+    and magma_free_cpu keeps them for reuse: small blocks in per-thread
+    caches, large blocks in a global cache. This avoids system calls and
+    page faults when routines, such as the sparse conversions and ParILUT,
+    repeatedly allocate and free arrays of similar sizes.
+
+    Blocks from the pool are freed correctly by magma_free_cpu even after the
+    pool is disabled. They must not be freed with the system free().
+
+    Also set by magma_init from environment variables
+    $MAGMA_CPU_POOL (0 or 1), $MAGMA_CPU_POOL_ALIGN, and
+    $MAGMA_CPU_POOL_HUGEPAGES (0 or 1), if they are set.
+    Not thread safe; call before other threads allocate memory.
+
+    Arguments
+    ---------
+    @param[in]
+    enable      Non-zero to allocate from the pool, zero for the system
+                allocator.
+
+    @param[in]
+    alignment   Alignment in bytes of all magma_malloc_cpu memory, pooled or
+                not. Power of 2, 16 <= alignment <= 4096. Default 64.
+                Cannot change after the pool has allocated memory.
+
+    @param[in]
+    hugepages   Non-zero to advise the OS to back pool memory with
+                transparent huge pages, where available (Linux).
+                Cannot change after the pool has allocated memory.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if alignment is invalid, or alignment or
+            hugepages differ from the current values after the pool has
+            allocated memory.
+
+    @ingroup magma_malloc_cpu
+*******************************************************************************/
+extern "C"
+magma_int_t magma_cpu_pool_config(
+    magma_int_t enable, size_t alignment, magma_int_t hugepages )
+{
+    if ( alignment < 16 || alignment > 4096 || (alignment & (alignment - 1)) != 0 )
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    if ( g_pool_started ) {
+        if ( alignment != g_pool_align || (hugepages != 0) != g_pool_hugepages )
+            return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    else {
+        g_pool_align     = alignment;
+        g_pool_hugepages = (hugepages != 0);
+        pool_init_classes();
+    }
+    g_pool_on.store( enable != 0, std::memory_order_relaxed );
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Returns statistics of the caching allocator behind magma_malloc_cpu.
+    Sizes count whole blocks, including rounding up to size classes and
+    alignment, so bytes_in_use may exceed the bytes requested.
+
+    @param[out]
+    stats   On output:
+            bytes_in_use:        pool blocks allocated and not yet freed;
+            peak_bytes_in_use:   maximum of bytes_in_use;
+            bytes_reserved:      memory obtained from the system, including
+                                 cached blocks;
+            peak_bytes_reserved: maximum of bytes_reserved;
+            nalloc:              number of allocations from the pool;
+            nhit:                number of those reusing a cached block.
+
+    @ingroup magma_malloc_cpu
+*******************************************************************************/
+extern "C"
+void magma_cpu_pool_get_stats( magma_cpu_pool_stats_t* stats )
+{
+    stats->bytes_in_use        = g_bytes_in_use     .load( std::memory_order_relaxed );
+    stats->peak_bytes_in_use   = g_peak_in_use      .load( std::memory_order_relaxed );
+    stats->bytes_reserved      = g_bytes_reserved   .load( std::memory_order_relaxed );
+    stats->peak_bytes_reserved = g_peak_reserved    .load( std::memory_order_relaxed );
+    stats->nalloc              = g_nalloc           .load( std::memory_order_relaxed );
+    stats->nhit                = g_nhit             .load( std::memory_order_relaxed );
+}
+
+
+/***************************************************************************//**
+    Resets peak_bytes_in_use and peak_bytes_reserved to their current values,
+    and nalloc and nhit to zero, e.g., before timing one routine.
+
+    @ingroup magma_malloc_cpu
+*******************************************************************************/
+extern "C"
+void magma_cpu_pool_reset_stats()
+{
+    g_peak_in_use  .store( g_bytes_in_use  .load( std::memory_order_relaxed ));
+    g_peak_reserved.store( g_bytes_reserved.load( std::memory_order_relaxed ));
+    g_nalloc.store( 0 );
+    g_nhit  .store( 0 );
+}
+
+
+/***************************************************************************//**
+    Returns cached large blocks to the system. Small blocks stay cached,
+    to be reused by later allocations. Called by magma_finalize.
+
+    @ingroup magma_malloc_cpu
+*******************************************************************************/
+extern "C"
+void magma_cpu_pool_trim()
+{
+    void* lists[ c_large_lists ];
+    pthread_mutex_lock( &g_pool_mutex );
+    for ( int i = 0; i < c_large_lists; ++i ) {
+        lists[ i ] = g_large_head[ i ];
+        g_large_head[ i ] = NULL;
+    }
+    g_large_cached = 0;
+    pthread_mutex_unlock( &g_pool_mutex );
+
+    for ( int i = 0; i < c_large_lists; ++i ) {
+        while ( lists[ i ] != NULL ) {
+            void* user = lists[ i ];
+            lists[ i ] = *(void**) user;
+            size_t size = ((magma_cpu_pool_header*) user - 1)->size;
+            pool_sys_free( (char*) user - g_pool_align, size );
+        }
+    }
+}
+
+
+/******************************************************************************/
+// Configures the pool from $MAGMA_CPU_POOL, $MAGMA_CPU_POOL_ALIGN, and
+// $MAGMA_CPU_POOL_HUGEPAGES, where set. Called by magma_init.
+extern "C"
+magma_int_t magma_cpu_pool_init()
+{
+    const char* env_on    = getenv( "MAGMA_CPU_POOL" );
+    const char* env_align = getenv( "MAGMA_CPU_POOL_ALIGN" );
+    const char* env_huge  = getenv( "MAGMA_CPU_POOL_HUGEPAGES" );
+    if ( env_on == NULL && env_align == NULL && env_huge == NULL )
+        return MAGMA_SUCCESS;
+
+    magma_int_t enable    = magma_cpu_pool_enabled();
+    size_t      alignment = g_pool_align;
+    magma_int_t hugepages = g_pool_hugepages;
+    if ( env_on != NULL )
+        enable = atoi( env_on );
+    if ( env_align != NULL )
+        alignment = (size_t) atol( env_align );
+    if ( env_huge != NULL )
+        hugepages = atoi( env_huge );
+
+    magma_int_t info = magma_cpu_pool_config( enable, alignment, hugepages );
+    if ( info != 0 ) {
+        fprintf( stderr, "MAGMA: ignoring invalid or changed $MAGMA_CPU_POOL_ALIGN"
+                 " or $MAGMA_CPU_POOL_HUGEPAGES\n" );
+        magma_cpu_pool_config( enable, g_pool_align, g_pool_hugepages );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+// Called by magma_finalize.
+extern "C"
+void magma_cpu_pool_finalize()
+{
+    magma_cpu_pool_trim();
+}
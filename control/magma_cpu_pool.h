@@ -0,0 +1,38 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#ifndef MAGMA_CPU_POOL_H
+#define MAGMA_CPU_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// Internal routines, used by magma_malloc_cpu and magma_free_cpu.
+// User-visible routines (magma_cpu_pool_config, etc.) are in magma_auxiliary.h.
+
+magma_int_t magma_cpu_pool_init();
+void        magma_cpu_pool_finalize();
+
+int    magma_cpu_pool_enabled();
+size_t magma_cpu_pool_alignment();
+
+// returns NULL if the block cannot come from the pool; caller then uses
+// the system allocator.
+void* magma_cpu_pool_malloc( size_t size );
+
+// returns 0 if ptr is not from the pool, 1 if it was freed to the pool,
+// -1 if ptr is inside the pool but not the start of a block.
+int   magma_cpu_pool_free( void* ptr );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MAGMA_CPU_POOL_H
@@ -64,6 +64,9 @@
 #include "magma_lapack.h"
 #include "magma_operators.h"
 #include "magma_threadsetting.h"
+#include "magma_threadpool.h"
+#include "magma_cpu_pool.h"
+#include "magma_tune.h"
 
 /***************************************************************************//**
     Define magma_queue structure, which wraps around CUDA and OpenCL queues.
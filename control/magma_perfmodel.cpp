@@ -0,0 +1,314 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <limits>
+#include <mutex>
+#include <string>
+
+#include "magma_internal.h"
+
+
+/*
+    Performance model of this host, measured by short benchmarks, used by
+    magma_get_cpu_sgetrf_time and magma_get_gemex_rankk_time instead of
+    their built-in rates. Measurements are stored in the tuning table
+    (see magma_tune.cpp), so magma_tune_save makes them persistent:
+
+        sgetrf_cpu_mflops_<n>   CPU sgetrf rate of m x n panel, by m
+        hgemmx_mflops_<k>       GPU fp16 GEMM rate of m x m x k update, by m
+        h2d_mbytes              host <-> device bandwidth, MB/s
+
+    Panel widths n and k are rounded down to the nearest calibrated width.
+*/
+
+static const magma_int_t g_getrf_m[] = { 1024, 2048, 4096, 8192 };
+static const magma_int_t g_getrf_n[] = { 128, 256, 384, 512 };
+static const magma_int_t g_gemm_m[]  = { 2048, 4096, 8192 };
+static const magma_int_t g_gemm_k[]  = { 128, 256, 384, 512, 1024 };
+
+#define NSIZE( array ) ((magma_int_t) (sizeof(array) / sizeof(array[0])))
+
+#define FMULS_GETRF(m_, n_) ( ((m_) < (n_)) \
+    ? (0.5 * (m_) * ((m_) * ((n_) - (1./3.) * (m_) - 1. ) + (n_)) + (2. / 3.) * (m_)) \
+    : (0.5 * (n_) * ((n_) * ((m_) - (1./3.) * (n_) - 1. ) + (m_)) + (2. / 3.) * (n_)) )
+#define FADDS_GETRF(m_, n_) ( ((m_) < (n_)) \
+    ? (0.5 * (m_) * ((m_) * ((n_) - (1./3.) * (m_)      ) - (n_)) + (1. / 6.) * (m_)) \
+    : (0.5 * (n_) * ((n_) * ((m_) - (1./3.) * (n_)      ) - (m_)) + (1. / 6.) * (n_)) )
+#define FLOPS_SGETRF(m_, n_) (     FMULS_GETRF((double)(m_), (double)(n_)) +       FADDS_GETRF((double)(m_), (double)(n_)) )
+
+// g_perfmodel_mutex serializes calibration.
+static std::mutex g_perfmodel_mutex;
+static bool g_perfmodel_checked = false;
+
+
+/******************************************************************************/
+// Sets routine's values at sizes, each covering sizes up to the midpoints
+// with its neighbors, as magma_tune_run does.
+static void magma_perfmodel_set(
+    const std::string& routine, magma_int_t nsize, const magma_int_t* sizes,
+    const double* values )
+{
+    const magma_int_t imax = (std::numeric_limits<magma_int_t>::max)();
+    for( magma_int_t i=0; i < nsize; ++i ) {
+        // skip invalid values, e.g., from a timer too coarse for the run
+        if ( ! (values[i] > 0 && values[i] < imax) )
+            continue;
+        magma_int_t nmin = (i == 0 ? 0 : (sizes[i-1] + sizes[i]) / 2 + 1);
+        magma_int_t nmax = (i == nsize-1 ? imax : (sizes[i] + sizes[i+1]) / 2);
+        magma_tune_set( routine.c_str(), nmin, nmax, magma_int_t( values[i] ));
+    }
+}
+
+
+/******************************************************************************/
+// Returns largest width in widths <= n, or the smallest width.
+static magma_int_t magma_perfmodel_width(
+    magma_int_t n, magma_int_t nwidth, const magma_int_t* widths )
+{
+    magma_int_t w = widths[0];
+    for( magma_int_t i=1; i < nwidth && widths[i] <= n; ++i ) {
+        w = widths[i];
+    }
+    return w;
+}
+
+
+/******************************************************************************/
+// Times lapackf77_sgetrf on m x n panels; best of 2 runs.
+static magma_int_t magma_perfmodel_calibrate_cpu()
+{
+    magma_int_t ldda = g_getrf_m[ NSIZE( g_getrf_m )-1 ];
+    magma_int_t maxn = g_getrf_n[ NSIZE( g_getrf_n )-1 ];
+    magma_int_t size = ldda*maxn, ione = 1, info;
+    magma_int_t ISEED[4] = { 0, 0, 0, 1 };
+    float *A = NULL, *Aref = NULL;
+    magma_int_t *ipiv = NULL;
+    if ( MAGMA_SUCCESS != magma_smalloc_cpu( &A,    size ) ||
+         MAGMA_SUCCESS != magma_smalloc_cpu( &Aref, size ) ||
+         MAGMA_SUCCESS != magma_imalloc_cpu( &ipiv, maxn )) {
+        magma_free_cpu( A );
+        magma_free_cpu( Aref );
+        magma_free_cpu( ipiv );
+        return MAGMA_ERR_HOST_ALLOC;
+    }
+    lapackf77_slarnv( &ione, ISEED, &size, Aref );
+
+    for( magma_int_t j=0; j < NSIZE( g_getrf_n ); ++j ) {
+        magma_int_t n = g_getrf_n[j];
+        double rate[ NSIZE( g_getrf_m ) ];
+        for( magma_int_t i=0; i < NSIZE( g_getrf_m ); ++i ) {
+            magma_int_t m = g_getrf_m[i];
+            double time = 0;
+            for( magma_int_t trial=0; trial < 2; ++trial ) {
+                lapackf77_slacpy( MagmaFullStr, &m, &n, Aref, &ldda, A, &ldda );
+                double t = magma_wtime();
+                lapackf77_sgetrf( &m, &n, A, &ldda, ipiv, &info );
+                t = magma_wtime() - t;
+                time = (trial == 0 ? t : min( time, t ));
+            }
+            rate[i] = FLOPS_SGETRF( m, n ) / time / 1e6;
+        }
+        magma_perfmodel_set( "sgetrf_cpu_mflops_" + std::to_string( (long long) n ),
+                             NSIZE( g_getrf_m ), g_getrf_m, rate );
+    }
+
+    magma_free_cpu( A );
+    magma_free_cpu( Aref );
+    magma_free_cpu( ipiv );
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+// Times host <-> device copies of a 32 MiB pinned matrix, and magma_hgemmx
+// m x m x k updates, on queue's device; best of 2 runs after a warmup.
+static magma_int_t magma_perfmodel_calibrate_gpu( magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_SUCCESS;
+    magma_int_t maxm = g_gemm_m[ NSIZE( g_gemm_m )-1 ];
+    magma_int_t maxk = g_gemm_k[ NSIZE( g_gemm_k )-1 ];
+
+    // host <-> device bandwidth
+    magma_int_t m = 8192, n = 1024;
+    float *hA = NULL, *dA = NULL;
+    if ( MAGMA_SUCCESS != magma_smalloc_pinned( &hA, m*n ) ||
+         MAGMA_SUCCESS != magma_smalloc( &dA, m*n )) {
+        info = MAGMA_ERR_DEVICE_ALLOC;
+        goto cleanup;
+    }
+    {
+        memset( hA, 0, m*n*sizeof(float) );
+        double time = 0;
+        for( magma_int_t trial=0; trial < 3; ++trial ) {
+            double t = magma_sync_wtime( queue );
+            magma_ssetmatrix( m, n, hA, m, dA, m, queue );
+            magma_sgetmatrix( m, n, dA, m, hA, m, queue );
+            t = magma_sync_wtime( queue ) - t;
+            if ( trial > 0 )
+                time = (trial == 1 ? t : min( time, t ));
+        }
+        double bandwidth = 2. * m * n * sizeof(float) / time / 1e6;
+        magma_perfmodel_set( "h2d_mbytes", 1, &m, &bandwidth );
+    }
+    magma_free( dA );
+    dA = NULL;
+
+    // fp16 GEMM, fp32 output, as in xshgetrf_gpu
+    {
+        magmaHalf *dX = NULL, *dY = NULL;
+        float *dC = NULL;
+        if ( MAGMA_SUCCESS != magma_malloc( (magma_ptr*) &dX, maxm*maxk*sizeof(magmaHalf) ) ||
+             MAGMA_SUCCESS != magma_malloc( (magma_ptr*) &dY, maxm*maxk*sizeof(magmaHalf) ) ||
+             MAGMA_SUCCESS != magma_smalloc( &dC, maxm*maxm )) {
+            info = MAGMA_ERR_DEVICE_ALLOC;
+        }
+        else {
+            // zero inputs and output once, on queue, so the timed updates
+            // with beta = 1 never read uninitialized memory
+            magma_memset_async( dX, 0, maxm*maxk*sizeof(magmaHalf), queue );
+            magma_memset_async( dY, 0, maxm*maxk*sizeof(magmaHalf), queue );
+            magmablas_slaset( MagmaFull, maxm, maxm, 0.f, 0.f, dC, maxm, queue );
+            magma_queue_sync( queue );
+            for( magma_int_t j=0; j < NSIZE( g_gemm_k ); ++j ) {
+                magma_int_t k = g_gemm_k[j];
+                double rate[ NSIZE( g_gemm_m ) ];
+                for( magma_int_t i=0; i < NSIZE( g_gemm_m ); ++i ) {
+                    magma_int_t mm = g_gemm_m[i];
+                    double time = 0;
+                    for( magma_int_t trial=0; trial < 3; ++trial ) {
+                        double t = magma_sync_wtime( queue );
+                        magma_hgemmx( MagmaNoTrans, MagmaNoTrans, mm, mm, k,
+                                      -1.f, dX, mm, dY, k, 1.f, dC, mm, queue );
+                        t = magma_sync_wtime( queue ) - t;
+                        if ( trial > 0 )
+                            time = (trial == 1 ? t : min( time, t ));
+                    }
+                    rate[i] = 2. * mm * mm * k / time / 1e6;
+                }
+                magma_perfmodel_set( "hgemmx_mflops_" + std::to_string( (long long) k ),
+                                     NSIZE( g_gemm_m ), g_gemm_m, rate );
+            }
+        }
+        magma_free( dX );
+        magma_free( dY );
+        magma_free( dC );
+    }
+
+cleanup:
+    magma_free_pinned( hA );
+    magma_free( dA );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Measures this host's performance model: CPU sgetrf panel rates for
+    several m x n shapes, and, if queue is not NULL, host <-> device
+    bandwidth and fp16 GEMM rates on queue's device. The fitted rates are
+    stored in the tuning table, where they replace the built-in constants
+    of magma_get_cpu_sgetrf_time and magma_get_gemex_rankk_time, which
+    magma_get_xgetrf_nb uses to choose the mixed-precision LU block size.
+    Use magma_tune_save to make them persistent.
+
+    Calibration takes a few seconds. Alternatively, set $MAGMA_CALIBRATE
+    to calibrate on first use, with a queue on the current device.
+
+    Arguments
+    ---------
+    @param[in]
+    queue   magma_queue_t
+            Queue to calibrate GPU rates with, or NULL for CPU rates only.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_HOST_ALLOC or MAGMA_ERR_DEVICE_ALLOC
+            if workspace cannot be allocated; rates measured so far are kept.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+magma_int_t magma_perfmodel_calibrate( magma_queue_t queue )
+{
+    std::lock_guard< std::mutex > lock( g_perfmodel_mutex );
+    g_perfmodel_checked = true;
+    magma_int_t info = magma_perfmodel_calibrate_cpu();
+    if ( info == MAGMA_SUCCESS && queue != NULL ) {
+        info = magma_perfmodel_calibrate_gpu( queue );
+    }
+    return info;
+}
+
+
+/******************************************************************************/
+// On first call, if $MAGMA_CALIBRATE is set and the model was not loaded
+// from $MAGMA_TUNE_FILE, calibrates it and saves the file.
+static void magma_perfmodel_check()
+{
+    {
+        std::lock_guard< std::mutex > lock( g_perfmodel_mutex );
+        if ( g_perfmodel_checked )
+            return;
+        g_perfmodel_checked = true;
+    }
+    const char* env = getenv( "MAGMA_CALIBRATE" );
+    magma_int_t value;
+    if ( env == NULL || env[0] == '\0' || strcmp( env, "0" ) == 0
+         || magma_tune_lookup( "sgetrf_cpu_mflops_128", 0, &value ))
+        return;
+
+    magma_queue_t queue = NULL;
+    magma_device_t dev;
+    magma_getdevice( &dev );
+    magma_queue_create( dev, &queue );
+    magma_perfmodel_calibrate( queue );
+    magma_queue_destroy( queue );
+    if ( getenv( "MAGMA_TUNE_FILE" ) != NULL ) {
+        magma_tune_save( NULL );
+    }
+}
+
+
+/******************************************************************************/
+extern "C"
+int magma_perfmodel_sgetrf_cpu_rate( magma_int_t m, magma_int_t n, double* rate )
+{
+    magma_perfmodel_check();
+    n = magma_perfmodel_width( n, NSIZE( g_getrf_n ), g_getrf_n );
+    magma_int_t mflops;
+    if ( ! magma_tune_lookup( ("sgetrf_cpu_mflops_" + std::to_string( (long long) n )).c_str(),
+                              m, &mflops ))
+        return false;
+    *rate = mflops * 1e6;
+    return true;
+}
+
+
+/******************************************************************************/
+extern "C"
+int magma_perfmodel_h2d_bandwidth( double* bandwidth )
+{
+    magma_perfmodel_check();
+    magma_int_t mbytes;
+    if ( ! magma_tune_lookup( "h2d_mbytes", 0, &mbytes ))
+        return false;
+    *bandwidth = mbytes * 1e6;
+    return true;
+}
+
+
+/******************************************************************************/
+extern "C"
+int magma_perfmodel_hgemmx_rate( magma_int_t m, magma_int_t k, double* rate )
+{
+    magma_perfmodel_check();
+    k = magma_perfmodel_width( k, NSIZE( g_gemm_k ), g_gemm_k );
+    magma_int_t mflops;
+    if ( ! magma_tune_lookup( ("hgemmx_mflops_" + std::to_string( (long long) k )).c_str(),
+                              m, &mflops ))
+        return false;
+    *rate = mflops * 1e6;
+    return true;
+}
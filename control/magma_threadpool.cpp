@@ -0,0 +1,410 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <vector>
+
+#include "magma_internal.h"
+
+
+// -----------------------------------------------------------------------------
+// One persistent worker. Worker with rank r executes argument r of each
+// parallel section that has more than r threads; rank 0 is always the caller.
+struct magma_threadpool_worker
+{
+    pthread_t   thread;
+    magma_int_t rank;
+    magma_int_t generation;  // last parallel section seen by this worker
+};
+
+// -----------------------------------------------------------------------------
+// Process-wide pool state. g_pool_mutex protects everything below it.
+// Mutex is statically initialized; condition variables are initialized by
+// magma_threadpool_init, since magma_winthread has no static initializer.
+static pthread_mutex_t g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_pool_cond_work;  // signals new section or quit
+static pthread_cond_t  g_pool_cond_done;  // signals all workers finished
+static bool            g_pool_init = false;
+static bool            g_pool_busy = false;  // a section is running
+static bool            g_pool_quit = false;
+static std::vector< magma_threadpool_worker* > g_pool_workers;
+
+// current parallel section
+static magma_int_t             g_pool_generation = 0;
+static magma_int_t             g_pool_nthread    = 0;
+static magma_int_t             g_pool_nremain    = 0;
+static magma_threadpool_func_t g_pool_func       = NULL;
+static char*                   g_pool_args       = NULL;
+static size_t                  g_pool_arg_size   = 0;
+static magma_int_t             g_pool_budget     = 0;  // cores per worker
+
+
+/******************************************************************************/
+// Main loop for each worker: sleep until a new parallel section is posted;
+// run its part if its rank is in the section; report completion.
+static void* magma_threadpool_main( void* arg )
+{
+    magma_threadpool_worker* worker = (magma_threadpool_worker*) arg;
+
+    pthread_mutex_lock( &g_pool_mutex );
+    while (true) {
+        while ( ! g_pool_quit && worker->generation == g_pool_generation ) {
+            pthread_cond_wait( &g_pool_cond_work, &g_pool_mutex );
+        }
+        if ( g_pool_quit ) {
+            break;
+        }
+        worker->generation = g_pool_generation;
+        if ( worker->rank < g_pool_nthread ) {
+            magma_threadpool_func_t func = g_pool_func;
+            void* my_arg = g_pool_args + worker->rank * g_pool_arg_size;
+            magma_int_t budget = g_pool_budget;
+            pthread_mutex_unlock( &g_pool_mutex );
+
+            {
+                magma_thread_limit limit( budget );
+                func( my_arg );
+            }
+
+            pthread_mutex_lock( &g_pool_mutex );
+            g_pool_nremain -= 1;
+            if ( g_pool_nremain == 0 ) {
+                pthread_cond_broadcast( &g_pool_cond_done );
+            }
+        }
+    }
+    pthread_mutex_unlock( &g_pool_mutex );
+    return NULL;
+}
+
+
+/******************************************************************************/
+// Start gate shared by threads created by magma_threadpool_run_spawn.
+// Threads wait until every thread was created, so a section never runs
+// with fewer threads than requested; if creation failed, they exit.
+struct magma_threadpool_spawn_gate
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    bool            open;
+    bool            cancel;
+};
+
+// Argument for threads created by magma_threadpool_run_spawn.
+struct magma_threadpool_spawn_arg
+{
+    magma_threadpool_func_t func;
+    void*       arg;
+    magma_int_t budget;
+    magma_threadpool_spawn_gate* gate;
+};
+
+static void* magma_threadpool_spawn_main( void* arg )
+{
+    magma_threadpool_spawn_arg* spawn = (magma_threadpool_spawn_arg*) arg;
+    magma_threadpool_spawn_gate* gate = spawn->gate;
+    pthread_mutex_lock( &gate->mutex );
+    while ( ! gate->open ) {
+        pthread_cond_wait( &gate->cond, &gate->mutex );
+    }
+    bool cancel = gate->cancel;
+    pthread_mutex_unlock( &gate->mutex );
+    if ( cancel ) {
+        return NULL;
+    }
+    magma_thread_limit limit( spawn->budget );
+    return spawn->func( spawn->arg );
+}
+
+
+/******************************************************************************/
+// Fallback when the pool is not available: creates and joins threads,
+// as parallel sections did before the pool existed.
+// If any thread cannot be created, func is not run on any thread.
+static magma_int_t magma_threadpool_run_spawn(
+    magma_int_t nthread, magma_threadpool_func_t func,
+    char* args, size_t arg_size, magma_int_t budget )
+{
+    magma_int_t info = 0;
+    magma_threadpool_spawn_gate gate;
+    gate.open   = false;
+    gate.cancel = false;
+    if ( pthread_mutex_init( &gate.mutex, NULL ) != 0 ) {
+        return MAGMA_ERR_UNKNOWN;
+    }
+    if ( pthread_cond_init( &gate.cond, NULL ) != 0 ) {
+        pthread_mutex_destroy( &gate.mutex );
+        return MAGMA_ERR_UNKNOWN;
+    }
+
+    std::vector< pthread_t > threads( nthread );
+    std::vector< bool > created( nthread, false );
+    std::vector< magma_threadpool_spawn_arg > spawn( nthread );
+    for (magma_int_t t = 0; t < nthread; ++t) {
+        spawn[t].func   = func;
+        spawn[t].arg    = args + t*arg_size;
+        spawn[t].budget = budget;
+        spawn[t].gate   = &gate;
+    }
+    for (magma_int_t t = 1; t < nthread && info == 0; ++t) {
+        if ( pthread_create( &threads[t], NULL, magma_threadpool_spawn_main, &spawn[t] ) == 0 )
+            created[t] = true;
+        else
+            info = MAGMA_ERR_UNKNOWN;
+    }
+
+    // release created threads; cancel them if any creation failed
+    pthread_mutex_lock( &gate.mutex );
+    gate.open   = true;
+    gate.cancel = (info != 0);
+    pthread_cond_broadcast( &gate.cond );
+    pthread_mutex_unlock( &gate.mutex );
+
+    if ( info == 0 ) {
+        magma_thread_limit limit( budget );
+        func( spawn[0].arg );
+    }
+    for (magma_int_t t = 1; t < nthread; ++t) {
+        if ( created[t] ) {
+            void* exitcodep;
+            pthread_join( threads[t], &exitcodep );
+        }
+    }
+    pthread_cond_destroy( &gate.cond );
+    pthread_mutex_destroy( &gate.mutex );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Initializes the process-wide CPU thread pool used by magma_threadpool_run.
+    No threads are created here; workers are started lazily by the first
+    parallel section that needs them, and then persist until
+    magma_threadpool_finalize.
+
+    Called by magma_init; users need not call it directly.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_UNKNOWN if the condition variables cannot be created.
+
+    @sa magma_threadpool_finalize
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_threadpool_init()
+{
+    magma_int_t info = 0;
+    pthread_mutex_lock( &g_pool_mutex );
+    if ( ! g_pool_init ) {
+        if ( pthread_cond_init( &g_pool_cond_work, NULL ) != 0 ) {
+            info = MAGMA_ERR_UNKNOWN;
+        }
+        else if ( pthread_cond_init( &g_pool_cond_done, NULL ) != 0 ) {
+            pthread_cond_destroy( &g_pool_cond_work );
+            info = MAGMA_ERR_UNKNOWN;
+        }
+        else {
+            g_pool_init = true;
+            g_pool_quit = false;
+        }
+    }
+    pthread_mutex_unlock( &g_pool_mutex );
+    return info;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Tells all workers in the thread pool to exit, joins them, and releases the
+    pool's resources. Must not be called while a parallel section is running.
+    After this, magma_threadpool_run creates threads per call until
+    magma_threadpool_init is called again.
+
+    Called by magma_finalize; users need not call it directly.
+
+    @retval MAGMA_SUCCESS
+
+    @sa magma_threadpool_init
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_threadpool_finalize()
+{
+    std::vector< magma_threadpool_worker* > workers;
+
+    pthread_mutex_lock( &g_pool_mutex );
+    if ( ! g_pool_init ) {
+        pthread_mutex_unlock( &g_pool_mutex );
+        return MAGMA_SUCCESS;
+    }
+    g_pool_init = false;  // new sections fall back to creating threads
+    g_pool_quit = true;
+    workers.swap( g_pool_workers );
+    pthread_cond_broadcast( &g_pool_cond_work );
+    pthread_mutex_unlock( &g_pool_mutex );
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        void* exitcodep;
+        pthread_join( workers[i]->thread, &exitcodep );
+        delete workers[i];
+    }
+
+    pthread_mutex_lock( &g_pool_mutex );
+    pthread_cond_destroy( &g_pool_cond_work );
+    pthread_cond_destroy( &g_pool_cond_done );
+    pthread_mutex_unlock( &g_pool_mutex );
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Runs a parallel section: calls func on nthread threads concurrently,
+    thread t getting the argument at address (char*) args + t*arg_size.
+    The calling thread executes t = 0; threads 1, ..., nthread-1 are
+    persistent workers from the process-wide pool, which grows as needed.
+    Returns when all nthread calls have returned.
+
+    All nthread calls are guaranteed to run at the same time, so func may
+    synchronize using barriers or spin-waits on other threads' progress,
+    as the bulge chasing and applyQ parallel sections do.
+
+    If the caller has a magma_thread_budget, each thread runs limited to
+    its blas() cores, via magma_thread_limit.
+
+    This replaces creating and joining threads (pthread_create, pthread_join)
+    in every call to a routine: idle workers sleep on a condition variable,
+    and waking them is much cheaper than starting new threads.
+
+    If the pool is not initialized (magma_init was not called), or it is
+    already running a parallel section (e.g., routines called concurrently
+    from several user threads, or a nested parallel section), this falls back
+    to creating and joining nthread-1 threads for this call.
+
+    Arguments
+    ---------
+    @param[in]
+    nthread     Number of threads, including the calling thread. nthread >= 1.
+
+    @param[in]
+    func        Function to execute on each thread.
+
+    @param[in,out]
+    args        Array of nthread arguments, each arg_size bytes.
+
+    @param[in]
+    arg_size    Size in bytes of each argument.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if nthread < 1.
+    @retval MAGMA_ERR_UNKNOWN if worker threads cannot be created.
+            Then func was not run on any thread; the caller should
+            run the section with fewer threads, e.g., nthread = 1.
+
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_threadpool_run(
+    magma_int_t nthread, magma_threadpool_func_t func,
+    void* args, size_t arg_size )
+{
+    if ( nthread < 1 ) {
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+
+    // each thread, including this one, runs within the caller's
+    // magma_thread_budget, if any
+    magma_int_t budget = magma_get_worker_budget();
+    if ( nthread == 1 ) {
+        magma_thread_limit limit( budget );
+        func( args );
+        return MAGMA_SUCCESS;
+    }
+
+    pthread_mutex_lock( &g_pool_mutex );
+    if ( ! g_pool_init || g_pool_busy ) {
+        pthread_mutex_unlock( &g_pool_mutex );
+        return magma_threadpool_run_spawn( nthread, func, (char*) args, arg_size, budget );
+    }
+
+    // grow pool to nthread-1 workers; new workers start at the current
+    // generation, so they pick up the section posted below.
+    magma_int_t info = 0;
+    magma_int_t nworkers = (magma_int_t) g_pool_workers.size();
+    if ( nworkers < nthread-1 ) {
+        pthread_attr_t thread_attr;
+        pthread_attr_init( &thread_attr );
+        pthread_attr_setscope( &thread_attr, PTHREAD_SCOPE_SYSTEM );
+        pthread_setconcurrency( (unsigned) nthread );
+        while ( nworkers < nthread-1 ) {
+            magma_threadpool_worker* worker = new magma_threadpool_worker;
+            worker->rank       = nworkers + 1;
+            worker->generation = g_pool_generation;
+            if ( pthread_create( &worker->thread, &thread_attr,
+                                 magma_threadpool_main, worker ) != 0 ) {
+                delete worker;
+                info = MAGMA_ERR_UNKNOWN;
+                break;
+            }
+            g_pool_workers.push_back( worker );
+            nworkers += 1;
+        }
+        pthread_attr_destroy( &thread_attr );
+    }
+    if ( info != 0 ) {
+        // all threads must run concurrently; cannot run with fewer.
+        pthread_mutex_unlock( &g_pool_mutex );
+        return info;
+    }
+
+    // post section and wake workers
+    g_pool_busy       = true;
+    g_pool_func       = func;
+    g_pool_args       = (char*) args;
+    g_pool_arg_size   = arg_size;
+    g_pool_nthread    = nthread;
+    g_pool_nremain    = nthread - 1;
+    g_pool_budget     = budget;
+    g_pool_generation += 1;
+    pthread_cond_broadcast( &g_pool_cond_work );
+    pthread_mutex_unlock( &g_pool_mutex );
+
+    {
+        magma_thread_limit limit( budget );
+        func( args );
+    }
+
+    // wait for workers
+    pthread_mutex_lock( &g_pool_mutex );
+    while ( g_pool_nremain > 0 ) {
+        pthread_cond_wait( &g_pool_cond_done, &g_pool_mutex );
+    }
+    g_pool_busy = false;
+    g_pool_func = NULL;
+    g_pool_args = NULL;
+    pthread_mutex_unlock( &g_pool_mutex );
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    @return Number of persistent worker threads currently in the pool,
+    not counting calling threads. Mainly for testing.
+
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_threadpool_get_numworkers()
+{
+    pthread_mutex_lock( &g_pool_mutex );
+    magma_int_t nworkers = (magma_int_t) g_pool_workers.size();
+    pthread_mutex_unlock( &g_pool_mutex );
+    return nworkers;
+}
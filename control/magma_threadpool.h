@@ -0,0 +1,36 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#ifndef MAGMA_THREADPOOL_H
+#define MAGMA_THREADPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// Internal routines
+
+// function executed by each thread of a parallel section; same signature as
+// a pthread start routine, so existing parallel sections can be used as is.
+typedef void* (*magma_threadpool_func_t)( void* arg );
+
+magma_int_t magma_threadpool_init();
+magma_int_t magma_threadpool_finalize();
+
+magma_int_t magma_threadpool_run(
+    magma_int_t nthread, magma_threadpool_func_t func,
+    void* args, size_t arg_size );
+
+magma_int_t magma_threadpool_get_numworkers();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MAGMA_THREADPOOL_H
@@ -22,6 +22,50 @@
 #include <hwloc.h>
 #endif
 
+#ifndef MAGMA_NOAFFINITY
+#include "affinity.h"
+#endif
+
+
+// Per-thread budgets. t_thread_budget caps magma_get_parallel_numthreads on
+// this thread (0 means no cap); t_worker_budget is cores per worker for this
+// thread's parallel sections, set by magma_thread_budget (0 means none).
+static thread_local magma_int_t t_thread_budget = 0;
+static thread_local magma_int_t t_worker_budget = 0;
+
+
+/******************************************************************************/
+// Sets BLAS and OpenMP threads for the calling thread only, unlike
+// magma_set_lapack_numthreads, which with MKL sets them process-wide.
+// Saves previous values in blas_save (MKL thread-local setting; 0 means
+// MKL's global setting) and omp_save, for magma_restore_local_numthreads.
+static void magma_set_local_numthreads(
+    magma_int_t threads, int* blas_save, int* omp_save )
+{
+    *blas_save = 0;
+    *omp_save  = 0;
+#if defined(MAGMA_WITH_MKL)
+    *blas_save = mkl_set_num_threads_local( int(threads) );
+#endif
+#if defined(_OPENMP)
+    *omp_save = omp_get_max_threads();
+    omp_set_num_threads( int(threads) );
+#endif
+    MAGMA_UNUSED( threads );
+}
+
+static void magma_restore_local_numthreads( int blas_save, int omp_save )
+{
+#if defined(MAGMA_WITH_MKL)
+    mkl_set_num_threads_local( blas_save );
+#endif
+#if defined(_OPENMP)
+    omp_set_num_threads( omp_save );
+#endif
+    MAGMA_UNUSED( blas_save );
+    MAGMA_UNUSED( omp_save );
+}
+
 
 /***************************************************************************//**
     Purpose
@@ -38,6 +82,9 @@
 
     For the number of cores, if MAGMA is compiled with hwloc, this queries hwloc;
     else it queries sysconf (on Unix) or GetSystemInfo (on Windows).
+    On Linux, this is limited to the CPUs in the process's affinity mask.
+    It is also limited by the calling thread's budget; see
+    magma_set_thread_budget.
 
     @sa magma_get_lapack_numthreads
     @sa magma_set_lapack_numthreads
@@ -72,6 +119,11 @@ magma_int_t magma_get_parallel_numthreads()
         #endif
     }
 
+    #ifndef MAGMA_NOAFFINITY
+    // exclude CPUs outside the process's affinity mask (e.g., cgroup cpuset)
+    ncores = max( 1, min( ncores, magma_affinity_ncpus() ));
+    #endif
+
     // query MAGMA_NUM_THREADS or OpenMP
     const char *threads_str = getenv("MAGMA_NUM_THREADS");
     magma_int_t threads = 0;
@@ -95,8 +147,11 @@ magma_int_t magma_get_parallel_numthreads()
         #endif
     }
 
-    // limit to range [1, number of cores]
+    // limit to range [1, number of cores], and calling thread's budget
     threads = max( 1, min( ncores, threads ));
+    if ( t_thread_budget > 0 ) {
+        threads = min( threads, t_thread_budget );
+    }
     return threads;
 }
 
@@ -245,3 +300,110 @@ void magma_set_omp_numthreads(magma_int_t threads)
     omp_set_num_threads( threads );
 #endif
 }
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Limits MAGMA routines called from the calling thread to nthreads cores:
+    their parallel sections, OpenMP regions, and BLAS. Use this when the
+    application calls MAGMA concurrently from its own thread pool, to
+    avoid oversubscription, e.g., with 4 application threads on 16 cores:
+
+        // in each application thread
+        magma_set_thread_budget( 4 );
+        magma_zheevdx_2stage( ... );
+
+    BLAS and OpenMP thread counts are set for the calling thread only.
+    With MKL, this uses mkl_set_num_threads_local.
+
+    Arguments
+    ---------
+    @param[in]
+    nthreads INTEGER
+            Number of cores for the calling thread.
+            If nthreads <= 0, removes the limit on MAGMA's parallel sections;
+            BLAS and OpenMP thread counts are not changed.
+
+    @return Previous budget of the calling thread, 0 if none.
+
+    @sa magma_get_thread_budget
+    @sa magma_get_parallel_numthreads
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_set_thread_budget( magma_int_t nthreads )
+{
+    magma_int_t old = t_thread_budget;
+    t_thread_budget = max( 0, nthreads );
+    if ( nthreads > 0 ) {
+        int blas_save, omp_save;
+        magma_set_local_numthreads( nthreads, &blas_save, &omp_save );
+    }
+    return old;
+}
+
+
+/***************************************************************************//**
+    @return Budget of the calling thread, set by magma_set_thread_budget;
+    0 if none.
+
+    @sa magma_set_thread_budget
+    @ingroup magma_thread
+*******************************************************************************/
+extern "C"
+magma_int_t magma_get_thread_budget()
+{
+    return t_thread_budget;
+}
+
+
+/******************************************************************************/
+extern "C"
+magma_int_t magma_get_worker_budget()
+{
+    return t_worker_budget;
+}
+
+
+/******************************************************************************/
+magma_thread_budget::magma_thread_budget( magma_int_t nworker, magma_int_t max_blas )
+{
+    magma_int_t ncores = magma_get_parallel_numthreads();
+    m_workers = (nworker <= 0 ? ncores : max( 1, min( nworker, ncores )));
+    m_blas    = max( 1, ncores / m_workers );
+    if ( max_blas > 0 ) {
+        m_blas = min( m_blas, max_blas );
+    }
+    m_save_worker   = t_worker_budget;
+    t_worker_budget = m_blas;
+    magma_set_local_numthreads( m_blas, &m_save_blas, &m_save_omp );
+}
+
+magma_thread_budget::~magma_thread_budget()
+{
+    magma_restore_local_numthreads( m_save_blas, m_save_omp );
+    t_worker_budget = m_save_worker;
+}
+
+
+/******************************************************************************/
+magma_thread_limit::magma_thread_limit( magma_int_t ncores ):
+    m_ncores( ncores ),
+    m_save_budget( t_thread_budget ),
+    m_save_blas( 0 ),
+    m_save_omp( 0 )
+{
+    if ( m_ncores > 0 ) {
+        t_thread_budget = m_ncores;
+        magma_set_local_numthreads( m_ncores, &m_save_blas, &m_save_omp );
+    }
+}
+
+magma_thread_limit::~magma_thread_limit()
+{
+    if ( m_ncores > 0 ) {
+        magma_restore_local_numthreads( m_save_blas, m_save_omp );
+        t_thread_budget = m_save_budget;
+    }
+}
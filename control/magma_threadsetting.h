@@ -24,8 +24,70 @@ magma_int_t magma_get_lapack_numthreads();
 magma_int_t magma_get_parallel_numthreads();
 magma_int_t magma_get_omp_numthreads();
 
+// cores per worker for the caller's next magma_threadpool_run,
+// set by magma_thread_budget; 0 if none.
+magma_int_t magma_get_worker_budget();
+
 #ifdef __cplusplus
 }
 #endif
 
+
+#ifdef __cplusplus
+// -----------------------------------------------------------------------------
+// Scoped thread budget for a region of a routine. Divides the cores available
+// to the calling thread (magma_get_parallel_numthreads, which respects
+// magma_set_thread_budget) among nworker pthread workers, each running BLAS
+// and OpenMP with blas() threads. Use workers() for magma_threadpool_run;
+// each worker then runs limited to blas() cores, so nested BLAS, OpenMP, and
+// MAGMA calls inside it do not oversubscribe. Thread counts are set for the
+// calling thread and workers only, not process-wide, and are restored when
+// the budget is destroyed. Example, one core per worker with single-threaded
+// BLAS inside:
+//
+//     magma_thread_budget budget( 0 );
+//     magma_threadpool_run( budget.workers(), func, args, sizeof(arg_t) );
+//
+// nworker <= 0 means one worker per core; max_blas > 0 limits BLAS threads,
+// e.g., magma_thread_budget budget( 1, 16 ) runs BLAS on up to 16 threads.
+class magma_thread_budget
+{
+public:
+    explicit magma_thread_budget( magma_int_t nworker, magma_int_t max_blas=0 );
+    ~magma_thread_budget();
+
+    magma_int_t workers() const { return m_workers; }
+    magma_int_t blas()    const { return m_blas; }
+
+private:
+    // not copyable
+    magma_thread_budget( const magma_thread_budget& );
+    magma_thread_budget& operator = ( const magma_thread_budget& );
+
+    magma_int_t m_workers, m_blas;
+    magma_int_t m_save_worker;
+    int m_save_blas, m_save_omp;
+};
+
+// -----------------------------------------------------------------------------
+// Limits the calling thread to ncores: its BLAS and OpenMP threads, and
+// magma_get_parallel_numthreads for nested MAGMA calls. Restored when
+// destroyed. Used by thread pool workers for each parallel section.
+// ncores <= 0 does nothing.
+class magma_thread_limit
+{
+public:
+    explicit magma_thread_limit( magma_int_t ncores );
+    ~magma_thread_limit();
+
+private:
+    // not copyable
+    magma_thread_limit( const magma_thread_limit& );
+    magma_thread_limit& operator = ( const magma_thread_limit& );
+
+    magma_int_t m_ncores, m_save_budget;
+    int m_save_blas, m_save_omp;
+};
+#endif  // __cplusplus
+
 #endif  // MAGMA_THREADSETTING_H
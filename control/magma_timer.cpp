@@ -6,7 +6,17 @@
        @date
 */
 
+#include <errno.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "magma_internal.h"
+#include "magma_timer.h"
 
 #if defined( _WIN32 ) || defined( _WIN64 )
 #  include <time.h>
@@ -116,3 +126,432 @@ void magmaf_wtime(double *time)
 {
     *time = magma_wtime();
 }
+
+
+
+// =============================================================================
+// Phase profiler; see magma_timer.h.
+
+/******************************************************************************/
+struct magma_profile_node
+{
+    const char*         name;
+    magma_profile_node* parent;
+    std::vector< magma_profile_node* > children;
+    long long calls;
+    double    time;   // inclusive of children
+    double    flops;
+    double    bytes;
+};
+
+
+/******************************************************************************/
+// Phase tree of one thread. Written only by its own thread; kept for the life
+// of the process, so per-thread results survive the thread.
+struct magma_profile_thread
+{
+    int tid;
+    magma_profile_node  root;
+    magma_profile_node* current;
+
+    // phases opened by magma_profile_begin, with start times
+    std::vector< std::pair< magma_profile_node*, double > > open;
+};
+
+
+/******************************************************************************/
+int g_magma_profile_on = 0;
+
+static std::string g_profile_filename;  // from $MAGMA_PROFILE
+
+static std::mutex                            g_profile_mutex;  // protects g_profile_threads
+static std::vector< magma_profile_thread* >  g_profile_threads;
+
+static thread_local magma_profile_thread* t_profile = NULL;
+
+
+/******************************************************************************/
+static magma_profile_node* magma_profile_new_node(
+    const char* name, magma_profile_node* parent )
+{
+    magma_profile_node* node = new magma_profile_node;
+    node->name   = name;
+    node->parent = parent;
+    node->calls  = 0;
+    node->time   = 0;
+    node->flops  = 0;
+    node->bytes  = 0;
+    return node;
+}
+
+
+/******************************************************************************/
+// Returns this thread's tree, registering a new one on first use.
+static magma_profile_thread* magma_profile_get_thread()
+{
+    if ( t_profile == NULL ) {
+        magma_profile_thread* th = new magma_profile_thread;
+        th->root.name   = "";
+        th->root.parent = NULL;
+        th->root.calls  = 0;
+        th->root.time   = 0;
+        th->root.flops  = 0;
+        th->root.bytes  = 0;
+        th->current     = &th->root;
+        std::lock_guard< std::mutex > lock( g_profile_mutex );
+        th->tid = (int) g_profile_threads.size();
+        g_profile_threads.push_back( th );
+        t_profile = th;
+    }
+    return t_profile;
+}
+
+
+/******************************************************************************/
+/// @return time in seconds, from a monotonic high-resolution clock.
+double magma_profile_now()
+{
+    return std::chrono::duration< double >(
+               std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+/******************************************************************************/
+/// Opens phase name as a child of the calling thread's current phase.
+/// @return node to pass to magma_profile_pop.
+magma_profile_node* magma_profile_push( const char* name )
+{
+    magma_profile_thread* th = magma_profile_get_thread();
+    magma_profile_node* cur = th->current;
+    magma_profile_node* node = NULL;
+    for ( size_t i = 0; i < cur->children.size(); ++i ) {
+        magma_profile_node* child = cur->children[ i ];
+        if ( child->name == name || strcmp( child->name, name ) == 0 ) {
+            node = child;
+            break;
+        }
+    }
+    if ( node == NULL ) {
+        node = magma_profile_new_node( name, cur );
+        cur->children.push_back( node );
+    }
+    th->current = node;
+    return node;
+}
+
+
+/******************************************************************************/
+/// Closes phase node, opened by magma_profile_push on the calling thread,
+/// adding one call and the given time, flops, and bytes.
+/// Phases still open inside node (e.g., magma_profile_begin without
+/// magma_profile_end, due to an error) are closed without being counted.
+void magma_profile_pop( magma_profile_node* node, double time, double flops, double bytes )
+{
+    magma_profile_thread* th = magma_profile_get_thread();
+    node->calls += 1;
+    node->time  += time;
+    node->flops += flops;
+    node->bytes += bytes;
+    th->current = node->parent;
+
+    // discard begin/end phases at or inside node
+    while ( ! th->open.empty() ) {
+        magma_profile_node* p = th->open.back().first;
+        while ( p != NULL && p != node )
+            p = p->parent;
+        if ( p == NULL )
+            break;
+        th->open.pop_back();
+    }
+}
+
+
+/******************************************************************************/
+/// Opens phase name, to be closed by magma_profile_end on the same thread.
+/// Prefer magma_profile_scope when the phase is a C++ scope.
+void magma_profile_begin( const char* name )
+{
+    if ( ! magma_profile_enabled() )
+        return;
+    magma_profile_node* node = magma_profile_push( name );
+    t_profile->open.push_back( std::make_pair( node, magma_profile_now() ));
+}
+
+
+/******************************************************************************/
+/// Closes the most recent magma_profile_begin phase on the calling thread,
+/// adding flops and bytes to it.
+void magma_profile_end( double flops, double bytes )
+{
+    magma_profile_thread* th = t_profile;
+    if ( th == NULL || th->open.empty() )
+        return;
+    std::pair< magma_profile_node*, double > top = th->open.back();
+    th->open.pop_back();
+    magma_profile_pop( top.first, magma_profile_now() - top.second, flops, bytes );
+}
+
+
+/******************************************************************************/
+// Totals for dump.
+struct magma_profile_totals
+{
+    long long calls;
+    double time, self, flops, bytes;
+    int    nthreads;
+    int    last_tid;  // 1 + last thread counted in nthreads
+};
+
+
+/******************************************************************************/
+// Flattens tree under node into (path, node, self time) rows, depth first,
+// and accumulates totals per routine name. Skips phases with no completed
+// calls, e.g., after magma_profile_reset.
+static void magma_profile_flatten(
+    const magma_profile_node* node, const std::string& prefix, int tid,
+    std::vector< std::pair< std::string, const magma_profile_node* > >& rows,
+    std::vector< double >& selfs,
+    std::map< std::string, magma_profile_totals >& routines )
+{
+    for ( size_t i = 0; i < node->children.size(); ++i ) {
+        const magma_profile_node* child = node->children[ i ];
+        std::string path = prefix.empty() ? child->name : prefix + "/" + child->name;
+        if ( child->calls > 0 ) {
+            double self = child->time;
+            for ( size_t j = 0; j < child->children.size(); ++j )
+                self -= child->children[ j ]->time;
+            rows.push_back( std::make_pair( path, child ));
+            selfs.push_back( self );
+
+            magma_profile_totals& tot = routines[ child->name ];  // zero initialized
+            tot.calls += child->calls;
+            tot.time  += child->time;
+            tot.self  += self;
+            tot.flops += child->flops;
+            tot.bytes += child->bytes;
+            if ( tot.last_tid != tid + 1 ) {
+                tot.nthreads += 1;
+                tot.last_tid  = tid + 1;
+            }
+        }
+
+        magma_profile_flatten( child, path, tid, rows, selfs, routines );
+    }
+}
+
+
+/******************************************************************************/
+// Writes s as a quoted string, escaping quotes (and backslashes for JSON).
+static void magma_profile_quote( FILE* file, const std::string& s, bool json )
+{
+    fputc( '"', file );
+    for ( size_t i = 0; i < s.size(); ++i ) {
+        char c = s[ i ];
+        if ( c == '"' )
+            fputs( json ? "\\\"" : "\"\"", file );
+        else if ( c == '\\' && json )
+            fputs( "\\\\", file );
+        else
+            fputc( c, file );
+    }
+    fputc( '"', file );
+}
+
+
+/***************************************************************************//**
+    Enables or disables the phase profiler. Can be called at any time;
+    phases open when it is enabled are not counted.
+    Initially enabled if environment variable MAGMA_PROFILE is set.
+
+    @param[in]
+    enable  Non-zero to enable, zero to disable.
+
+    @see magma_profile_dump
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C"
+void magma_profile_enable( magma_int_t enable )
+{
+    g_magma_profile_on = (enable != 0);
+}
+
+
+/***************************************************************************//**
+    Zeros all accumulated profile counts, on all threads.
+    Call only when no profiled routines are running.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C"
+void magma_profile_reset()
+{
+    std::lock_guard< std::mutex > lock( g_profile_mutex );
+    for ( size_t t = 0; t < g_profile_threads.size(); ++t ) {
+        std::vector< magma_profile_node* > stack;
+        stack.push_back( &g_profile_threads[ t ]->root );
+        while ( ! stack.empty() ) {
+            magma_profile_node* node = stack.back();
+            stack.pop_back();
+            node->calls = 0;
+            node->time  = 0;
+            node->flops = 0;
+            node->bytes = 0;
+            stack.insert( stack.end(), node->children.begin(), node->children.end() );
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    Writes the accumulated profile. Call only when no profiled routines are
+    running.
+
+    Output has totals for each routine (phase name), summed over threads and
+    call paths, followed by each thread's phases, identified by their path
+    of nested names, e.g., "dstedx/dlaex0/dlaex3".
+    For each, it gives the number of calls, inclusive time (seconds),
+    self time excluding nested phases, and flop and byte counts, where
+    routines provide them. Inclusive times of recursive routines count
+    nested calls more than once; self times do not.
+
+    @param[in]
+    filename    File to write. If NULL or empty, writes to stdout.
+
+    @param[in]
+    format      "json" or "csv". If NULL, uses csv if filename ends in .csv,
+                otherwise json.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if format is invalid.
+    @retval MAGMA_ERR if the file cannot be written.
+
+    @ingroup magma_timer
+*******************************************************************************/
+extern "C"
+magma_int_t magma_profile_dump( const char* filename, const char* format )
+{
+    bool to_stdout = (filename == NULL || filename[0] == '\0');
+    bool csv;
+    if ( format != NULL ) {
+        if ( strcmp( format, "csv" ) == 0 )
+            csv = true;
+        else if ( strcmp( format, "json" ) == 0 )
+            csv = false;
+        else
+            return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    else {
+        size_t len = to_stdout ? 0 : strlen( filename );
+        csv = (len >= 4 && strcmp( filename + len - 4, ".csv" ) == 0);
+    }
+
+    FILE* file = stdout;
+    if ( ! to_stdout ) {
+        file = fopen( filename, "w" );
+        if ( file == NULL ) {
+            fprintf( stderr, "Can't open profile file '%s': %s (%d)\n",
+                     filename, strerror( errno ), errno );
+            return MAGMA_ERR;
+        }
+    }
+
+    std::lock_guard< std::mutex > lock( g_profile_mutex );
+
+    // flatten each thread's tree
+    std::map< std::string, magma_profile_totals > routines;
+    std::vector< std::vector< std::pair< std::string, const magma_profile_node* > > >
+        rows( g_profile_threads.size() );
+    std::vector< std::vector< double > > selfs( g_profile_threads.size() );
+    for ( size_t t = 0; t < g_profile_threads.size(); ++t ) {
+        magma_profile_flatten( &g_profile_threads[ t ]->root, "",
+                               g_profile_threads[ t ]->tid,
+                               rows[ t ], selfs[ t ], routines );
+    }
+
+    std::map< std::string, magma_profile_totals >::const_iterator it;
+    if ( csv ) {
+        fprintf( file, "thread,path,calls,time,self,flops,bytes\n" );
+        for ( it = routines.begin(); it != routines.end(); ++it ) {
+            fprintf( file, "all," );
+            magma_profile_quote( file, it->first, false );
+            fprintf( file, ",%lld,%.9g,%.9g,%.9g,%.9g\n",
+                     it->second.calls, it->second.time, it->second.self,
+                     it->second.flops, it->second.bytes );
+        }
+        for ( size_t t = 0; t < rows.size(); ++t ) {
+            for ( size_t i = 0; i < rows[ t ].size(); ++i ) {
+                const magma_profile_node* node = rows[ t ][ i ].second;
+                fprintf( file, "%d,", g_profile_threads[ t ]->tid );
+                magma_profile_quote( file, rows[ t ][ i ].first, false );
+                fprintf( file, ",%lld,%.9g,%.9g,%.9g,%.9g\n",
+                         node->calls, node->time, selfs[ t ][ i ],
+                         node->flops, node->bytes );
+            }
+        }
+    }
+    else {
+        fprintf( file, "{\n  \"routines\": [" );
+        const char* sep = "\n";
+        for ( it = routines.begin(); it != routines.end(); ++it ) {
+            fprintf( file, "%s    {\"name\": ", sep );
+            magma_profile_quote( file, it->first, true );
+            fprintf( file, ", \"calls\": %lld, \"time\": %.9g, \"self\": %.9g,"
+                     " \"flops\": %.9g, \"bytes\": %.9g, \"threads\": %d}",
+                     it->second.calls, it->second.time, it->second.self,
+                     it->second.flops, it->second.bytes, it->second.nthreads );
+            sep = ",\n";
+        }
+        fprintf( file, "\n  ],\n  \"threads\": [" );
+        sep = "\n";
+        for ( size_t t = 0; t < rows.size(); ++t ) {
+            fprintf( file, "%s    {\"thread\": %d, \"phases\": [",
+                     sep, g_profile_threads[ t ]->tid );
+            const char* sep2 = "\n";
+            for ( size_t i = 0; i < rows[ t ].size(); ++i ) {
+                const magma_profile_node* node = rows[ t ][ i ].second;
+                fprintf( file, "%s      {\"path\": ", sep2 );
+                magma_profile_quote( file, rows[ t ][ i ].first, true );
+                fprintf( file, ", \"calls\": %lld, \"time\": %.9g, \"self\": %.9g,"
+                         " \"flops\": %.9g, \"bytes\": %.9g}",
+                         node->calls, node->time, selfs[ t ][ i ],
+                         node->flops, node->bytes );
+                sep2 = ",\n";
+            }
+            fprintf( file, "\n    ]}" );
+            sep = ",\n";
+        }
+        fprintf( file, "\n  ]\n}\n" );
+    }
+
+    magma_int_t info = MAGMA_SUCCESS;
+    if ( ferror( file ))
+        info = MAGMA_ERR;
+    if ( ! to_stdout )
+        fclose( file );
+    return info;
+}
+
+
+/******************************************************************************/
+/// Enables profiling if $MAGMA_PROFILE is set. Called by magma_init.
+void magma_profile_init()
+{
+    const char* filename = getenv( "MAGMA_PROFILE" );
+    if ( filename != NULL && filename[0] != '\0' ) {
+        g_profile_filename = filename;
+        magma_profile_enable( true );
+    }
+}
+
+
+/******************************************************************************/
+/// If $MAGMA_PROFILE was set, writes the profile to it and disables
+/// profiling. Called by magma_finalize.
+void magma_profile_finalize()
+{
+    if ( ! g_profile_filename.empty() ) {
+        magma_profile_dump( g_profile_filename.c_str(), NULL );
+        g_profile_filename.clear();
+        magma_profile_enable( false );
+    }
+}
@@ -244,4 +244,91 @@ static inline int timer_snprintf( char* str, size_t size, const char* format, ..
     return len;
 }
 
+
+// =============================================================================
+// Phase profiler.
+// Unlike the timer_* functions above, this is compiled in always and enabled
+// at run time, by setting environment variable MAGMA_PROFILE to an output
+// file (*.json or *.csv) before magma_init, or by magma_profile_enable().
+// Nested magma_profile_scope objects form a tree of phases per thread,
+// each accumulating wall time, call count, and optional flop and byte counts.
+// magma_profile_dump() writes totals per routine (summed over threads and
+// call paths) and the tree for each thread. When disabled, a scope costs
+// one load and branch.
+//
+// Names are stored by pointer, so must be literals or otherwise outlive
+// the profile.
+
+extern int g_magma_profile_on;  // set by magma_profile_enable
+
+inline bool magma_profile_enabled()
+{
+    return g_magma_profile_on != 0;
+}
+
+struct magma_profile_node;
+
+magma_profile_node* magma_profile_push( const char* name );
+void   magma_profile_pop( magma_profile_node* node, double time, double flops, double bytes );
+double magma_profile_now();
+
+void magma_profile_begin( const char* name );
+void magma_profile_end( double flops=0, double bytes=0 );
+
+void magma_profile_init();
+void magma_profile_finalize();
+
+
+/***************************************************************************//**
+    Profiles the enclosing scope as a phase named name, nested inside the
+    phase that is open on the same thread, if any:
+
+        magma_profile_scope profile( "zhetrd_hb2st" );
+        ...
+        profile.add_flops( 4.*n*n*nb );
+
+    Because scopes are destroyed on any exit, this is safe with early returns
+    and the CHECK/goto cleanup pattern, if declared before the first goto.
+
+    @ingroup magma_timer
+*******************************************************************************/
+class magma_profile_scope
+{
+public:
+    magma_profile_scope( const char* name ):
+        m_node( NULL ),
+        m_start( 0 ),
+        m_flops( 0 ),
+        m_bytes( 0 )
+    {
+        if ( magma_profile_enabled() ) {
+            m_node  = magma_profile_push( name );
+            m_start = magma_profile_now();
+        }
+    }
+
+    ~magma_profile_scope()
+    {
+        if ( m_node != NULL ) {
+            magma_profile_pop( m_node, magma_profile_now() - m_start, m_flops, m_bytes );
+        }
+    }
+
+    /// Adds to the flop count of this call.
+    void add_flops( double flops ) { m_flops += flops; }
+
+    /// Adds to the bytes moved by this call.
+    void add_bytes( double bytes ) { m_bytes += bytes; }
+
+private:
+    // not copyable
+    magma_profile_scope( const magma_profile_scope& );
+    magma_profile_scope& operator = ( const magma_profile_scope& );
+
+    magma_profile_node* m_node;
+    double m_start;
+    double m_flops;
+    double m_bytes;
+};
+
 #endif        //  #ifndef MAGMA_TIMER_H
@@ -0,0 +1,504 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <errno.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __APPLE__
+    #include <sys/sysctl.h>
+#endif
+
+#include "magma_internal.h"
+
+
+/*
+    Tuning table: block sizes and similar parameters chosen by benchmarking
+    on this host, which the magma_get_*_nb functions consult before their
+    built-in defaults.
+
+    The tuning file is text, one entry per line, with tab-separated fields
+
+        host    routine    nmin    nmax    value
+
+    meaning routine uses value for sizes nmin <= n <= nmax on CPU model host.
+    Lines starting with # are comments. Entries for other hosts are kept,
+    so one file can be shared by several machines.
+*/
+
+// -----------------------------------------------------------------------------
+struct magma_tune_entry
+{
+    magma_int_t nmin, nmax, value;
+};
+
+typedef std::vector< magma_tune_entry > magma_tune_list;
+
+// g_tune_mutex protects everything below it.
+static std::mutex g_tune_mutex;
+static std::map< std::string, magma_tune_list > g_tune_table;  // this host, sorted by nmin
+static std::vector< std::string > g_tune_other;  // lines for other hosts
+static std::string g_tune_filename;              // from $MAGMA_TUNE_FILE
+
+// number of entries in g_tune_table, to skip locking when it is empty
+static std::atomic<int> g_tune_count( 0 );
+
+
+/******************************************************************************/
+// Returns s without leading and trailing white space; tabs inside become spaces.
+static std::string magma_tune_clean( const std::string& s )
+{
+    size_t begin = s.find_first_not_of( " \t\r\n" );
+    size_t end   = s.find_last_not_of ( " \t\r\n" );
+    if ( begin == std::string::npos )
+        return "";
+    std::string t = s.substr( begin, end - begin + 1 );
+    std::replace( t.begin(), t.end(), '\t', ' ' );
+    return t;
+}
+
+
+/***************************************************************************//**
+    @return CPU model of this host, which keys its entries in the tuning file,
+    e.g., "Intel(R) Xeon(R) Gold 6140 CPU @ 2.30GHz".
+    From /proc/cpuinfo on Linux and sysctl on MacOS; otherwise "unknown".
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+const char* magma_tune_host()
+{
+    static std::string host;
+    static std::once_flag once;
+    std::call_once( once, [] {
+        #if defined( __APPLE__ )
+            char buf[ 256 ];
+            size_t len = sizeof(buf);
+            if ( sysctlbyname( "machdep.cpu.brand_string", buf, &len, NULL, 0 ) == 0 )
+                host = magma_tune_clean( std::string( buf, strnlen( buf, len )));
+        #else
+            // x86 has "model name"; some ARM kernels have "Hardware" or "CPU part"
+            FILE* file = fopen( "/proc/cpuinfo", "r" );
+            if ( file != NULL ) {
+                char line[ 1024 ];
+                std::string part;
+                while ( host.empty() && fgets( line, sizeof(line), file ) != NULL ) {
+                    std::string s( line );
+                    size_t colon = s.find( ':' );
+                    if ( colon == std::string::npos )
+                        continue;
+                    std::string key = magma_tune_clean( s.substr( 0, colon ));
+                    std::string val = magma_tune_clean( s.substr( colon + 1 ));
+                    if ( key == "model name" || key == "Hardware" )
+                        host = val;
+                    else if ( key == "CPU part" && part.empty() )
+                        part = "CPU part " + val;
+                }
+                fclose( file );
+                if ( host.empty() )
+                    host = part;
+            }
+        #endif
+        if ( host.empty() )
+            host = "unknown";
+    });
+    return host.c_str();
+}
+
+
+/******************************************************************************/
+// Returns whether an entry is valid: values are used as block sizes and
+// similar, so must be positive, and sizes must form a nonempty range.
+static bool magma_tune_valid( magma_int_t nmin, magma_int_t nmax, magma_int_t value )
+{
+    return nmin >= 0 && nmin <= nmax && value > 0;
+}
+
+
+/******************************************************************************/
+// Parses s as a decimal integer, requiring the whole field to be a number.
+// Returns whether it succeeded.
+static bool magma_tune_parse( const std::string& s, magma_int_t* value )
+{
+    const char* begin = s.c_str();
+    char* end;
+    errno = 0;
+    long long v = strtoll( begin, &end, 10 );
+    if ( end == begin || *end != '\0' || errno == ERANGE
+         || v < (std::numeric_limits<magma_int_t>::min)()
+         || v > (std::numeric_limits<magma_int_t>::max)() )
+        return false;
+    *value = magma_int_t( v );
+    return true;
+}
+
+
+/******************************************************************************/
+// Sets value for [nmin, nmax] in list, trimming or splitting overlapping
+// entries. Returns change in number of entries. Caller holds g_tune_mutex.
+static int magma_tune_insert(
+    magma_tune_list& list, magma_int_t nmin, magma_int_t nmax, magma_int_t value )
+{
+    int old_size = (int) list.size();
+    magma_tune_list result;
+    for ( size_t i = 0; i < list.size(); ++i ) {
+        magma_tune_entry e = list[ i ];
+        if ( e.nmax < nmin || e.nmin > nmax ) {
+            result.push_back( e );
+            continue;
+        }
+        if ( e.nmin < nmin ) {
+            magma_tune_entry lo = { e.nmin, nmin - 1, e.value };
+            result.push_back( lo );
+        }
+        if ( e.nmax > nmax ) {
+            magma_tune_entry hi = { nmax + 1, e.nmax, e.value };
+            result.push_back( hi );
+        }
+    }
+    magma_tune_entry entry = { nmin, nmax, value };
+    result.push_back( entry );
+    std::sort( result.begin(), result.end(),
+               []( const magma_tune_entry& a, const magma_tune_entry& b )
+               { return a.nmin < b.nmin; } );
+    list.swap( result );
+    return (int) list.size() - old_size;
+}
+
+
+/***************************************************************************//**
+    Sets the tuned value for routine for sizes nmin <= n <= nmax on this host,
+    replacing any values it had for those sizes. Affects subsequent calls to
+    magma_get_*_nb; save it with magma_tune_save.
+
+    @param[in]
+    routine     Routine name, as in magma_get_<routine>, e.g., "zgeqrf_nb".
+    @param[in]
+    nmin        Smallest size.
+    @param[in]
+    nmax        Largest size.
+    @param[in]
+    value       Value, e.g., block size. value > 0.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if nmin < 0, nmin > nmax, or value <= 0;
+            the table is unchanged.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+magma_int_t magma_tune_set(
+    const char* routine, magma_int_t nmin, magma_int_t nmax, magma_int_t value )
+{
+    if ( routine == NULL || ! magma_tune_valid( nmin, nmax, value ))
+        return MAGMA_ERR_ILLEGAL_VALUE;
+
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    g_tune_count += magma_tune_insert( g_tune_table[ routine ], nmin, nmax, value );
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+extern "C"
+int magma_tune_lookup( const char* routine, magma_int_t n, magma_int_t* value )
+{
+    if ( g_tune_count.load( std::memory_order_relaxed ) == 0 )
+        return false;
+
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    std::map< std::string, magma_tune_list >::const_iterator it
+        = g_tune_table.find( routine );
+    if ( it == g_tune_table.end() )
+        return false;
+    const magma_tune_list& list = it->second;
+    for ( size_t i = 0; i < list.size(); ++i ) {
+        if ( list[ i ].nmin <= n && n <= list[ i ].nmax ) {
+            *value = list[ i ].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/***************************************************************************//**
+    @return Tuned value for routine at size n on this host, if the tuning
+    table has one, otherwise default_value.
+
+    @param[in]
+    routine         Routine name, e.g., "dtrevc3_mt_nb".
+    @param[in]
+    n               Size.
+    @param[in]
+    default_value   Value to use if routine has not been tuned.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+magma_int_t magma_tune_get(
+    const char* routine, magma_int_t n, magma_int_t default_value )
+{
+    magma_int_t value;
+    if ( magma_tune_lookup( routine, n, &value ))
+        return value;
+    return default_value;
+}
+
+
+/***************************************************************************//**
+    Reads a tuning file, replacing the current tuning table.
+    Entries for other hosts are kept, to be written back by magma_tune_save.
+    Lines for this host with non-numeric fields, nmin < 0, nmin > nmax,
+    or value <= 0 are ignored, with a warning.
+
+    @param[in]
+    filename    File to read.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR if the file cannot be read.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+magma_int_t magma_tune_load( const char* filename )
+{
+    FILE* file = fopen( filename, "r" );
+    if ( file == NULL )
+        return MAGMA_ERR;
+
+    std::string host = magma_tune_host();
+    std::map< std::string, magma_tune_list > table;
+    std::vector< std::string > other;
+    int count = 0;
+    char line[ 1024 ];
+    while ( fgets( line, sizeof(line), file ) != NULL ) {
+        std::string s( line );
+        if ( ! s.empty() && s[ s.size()-1 ] == '\n' )
+            s.erase( s.size()-1 );
+        if ( s.empty() || s[0] == '#' )
+            continue;
+
+        // split into 5 tab-separated fields
+        std::vector< std::string > fields;
+        size_t begin = 0, tab;
+        while ( (tab = s.find( '\t', begin )) != std::string::npos ) {
+            fields.push_back( s.substr( begin, tab - begin ));
+            begin = tab + 1;
+        }
+        fields.push_back( s.substr( begin ));
+        if ( fields.size() != 5 ) {
+            fprintf( stderr, "%s: ignoring invalid line: %s\n", filename, s.c_str() );
+            continue;
+        }
+        if ( fields[0] != host ) {
+            other.push_back( s );
+            continue;
+        }
+        magma_int_t nmin, nmax, value;
+        if ( ! magma_tune_parse( fields[2], &nmin )
+             || ! magma_tune_parse( fields[3], &nmax )
+             || ! magma_tune_parse( fields[4], &value )
+             || ! magma_tune_valid( nmin, nmax, value )) {
+            fprintf( stderr, "%s: ignoring invalid line: %s\n", filename, s.c_str() );
+            continue;
+        }
+        count += magma_tune_insert( table[ fields[1] ], nmin, nmax, value );
+    }
+    fclose( file );
+
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    g_tune_table.swap( table );
+    g_tune_other.swap( other );
+    g_tune_count = count;
+    return MAGMA_SUCCESS;
+}
+
+
+/***************************************************************************//**
+    Writes the tuning table to a tuning file, with entries read from it for
+    other hosts.
+
+    @param[in]
+    filename    File to write. If NULL, uses $MAGMA_TUNE_FILE.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if filename is NULL and $MAGMA_TUNE_FILE
+            was not set at magma_init.
+    @retval MAGMA_ERR if the file cannot be written.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+magma_int_t magma_tune_save( const char* filename )
+{
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    if ( filename == NULL ) {
+        if ( g_tune_filename.empty() )
+            return MAGMA_ERR_ILLEGAL_VALUE;
+        filename = g_tune_filename.c_str();
+    }
+    FILE* file = fopen( filename, "w" );
+    if ( file == NULL )
+        return MAGMA_ERR;
+
+    fprintf( file, "# MAGMA tuning file\n"
+                   "# host\troutine\tnmin\tnmax\tvalue\n" );
+    for ( size_t i = 0; i < g_tune_other.size(); ++i )
+        fprintf( file, "%s\n", g_tune_other[ i ].c_str() );
+
+    const char* host = magma_tune_host();
+    std::map< std::string, magma_tune_list >::const_iterator it;
+    for ( it = g_tune_table.begin(); it != g_tune_table.end(); ++it ) {
+        for ( size_t i = 0; i < it->second.size(); ++i ) {
+            const magma_tune_entry& e = it->second[ i ];
+            fprintf( file, "%s\t%s\t%lld\t%lld\t%lld\n", host, it->first.c_str(),
+                     (long long) e.nmin, (long long) e.nmax, (long long) e.value );
+        }
+    }
+    bool err = ferror( file );
+    fclose( file );
+    return (err ? MAGMA_ERR : MAGMA_SUCCESS);
+}
+
+
+/***************************************************************************//**
+    Purpose
+    -------
+    Autotunes a parameter of routine, such as its block size, by timing each
+    candidate value at each size, keeping the fastest. The winners are set
+    in the tuning table, each covering sizes up to halfway to the neighboring
+    sizes, replacing previous values for the routine, which are cleared while
+    benchmarking. Use magma_tune_save to make them persistent.
+
+    Arguments
+    ---------
+    @param[in]
+    routine     Routine name, as looked up by the code using the parameter,
+                e.g., "zhetrf_nopiv_ib".
+
+    @param[in]
+    nsize       Number of sizes.
+
+    @param[in]
+    sizes       Array of nsize sizes, in increasing order.
+
+    @param[in]
+    ncand       Number of candidate values.
+
+    @param[in]
+    candidates  Array of ncand candidate values, each > 0.
+
+    @param[in]
+    bench       Function bench( value, n, arg ) that runs the routine with
+                the given parameter value and size, returning its time in
+                seconds, or a negative number if value is invalid for n or
+                the result was wrong.
+
+    @param[in]
+    arg         Passed to bench.
+
+    @param[in]
+    ntrial      Number of times to run bench for each value and size;
+                the minimum time is used. ntrial >= 1.
+
+    @param[out]
+    best        Array of nsize values, set to the fastest candidate at each
+                size, or -1 if no candidate was valid.
+
+    @retval MAGMA_SUCCESS
+    @retval MAGMA_ERR_ILLEGAL_VALUE if an argument is invalid.
+
+    @ingroup magma_tuning
+*******************************************************************************/
+extern "C"
+magma_int_t magma_tune_run(
+    const char* routine,
+    magma_int_t nsize, const magma_int_t* sizes,
+    magma_int_t ncand, const magma_int_t* candidates,
+    magma_tune_bench_t bench, void* arg, magma_int_t ntrial,
+    magma_int_t* best )
+{
+    if ( routine == NULL || nsize < 0 || ncand < 1 || bench == NULL || ntrial < 1 )
+        return MAGMA_ERR_ILLEGAL_VALUE;
+    for ( magma_int_t i = 1; i < nsize; ++i ) {
+        if ( sizes[i] <= sizes[i-1] )
+            return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+    for ( magma_int_t c = 0; c < ncand; ++c ) {
+        if ( candidates[c] <= 0 )
+            return MAGMA_ERR_ILLEGAL_VALUE;
+    }
+
+    // clear routine's entries, so they don't affect the benchmarks
+    {
+        std::lock_guard< std::mutex > lock( g_tune_mutex );
+        magma_tune_list& list = g_tune_table[ routine ];
+        g_tune_count -= (int) list.size();
+        list.clear();
+    }
+
+    for ( magma_int_t i = 0; i < nsize; ++i ) {
+        double best_time = -1;
+        best[i] = -1;
+        for ( magma_int_t c = 0; c < ncand; ++c ) {
+            double time = -1;
+            for ( magma_int_t t = 0; t < ntrial; ++t ) {
+                double tt = bench( candidates[c], sizes[i], arg );
+                if ( tt < 0 ) {
+                    time = -1;
+                    break;
+                }
+                time = (t == 0 ? tt : min( time, tt ));
+            }
+            if ( time >= 0 && (best_time < 0 || time < best_time) ) {
+                best_time = time;
+                best[i] = candidates[c];
+            }
+        }
+    }
+
+    // set routine's entries; merge neighbors with the same winner
+    std::lock_guard< std::mutex > lock( g_tune_mutex );
+    magma_tune_list& list = g_tune_table[ routine ];
+    for ( magma_int_t i = 0; i < nsize; ++i ) {
+        if ( best[i] < 0 )
+            continue;
+        magma_int_t nmin = (i == 0 ? 0 : (sizes[i-1] + sizes[i]) / 2 + 1);
+        magma_int_t nmax = (i == nsize-1 ? (std::numeric_limits<magma_int_t>::max)()
+                                         : (sizes[i] + sizes[i+1]) / 2);
+        if ( ! list.empty() && list.back().value == best[i] && list.back().nmax == nmin - 1 )
+            list.back().nmax = nmax;
+        else
+            g_tune_count += magma_tune_insert( list, nmin, nmax, best[i] );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+// Loads $MAGMA_TUNE_FILE, if set. Called by magma_init.
+// A missing file is not an error; magma_tune_save(NULL) creates it.
+extern "C"
+magma_int_t magma_tune_init()
+{
+    const char* filename = getenv( "MAGMA_TUNE_FILE" );
+    if ( filename != NULL && filename[0] != '\0' ) {
+        {
+            std::lock_guard< std::mutex > lock( g_tune_mutex );
+            g_tune_filename = filename;
+        }
+        magma_tune_load( filename );
+    }
+    return MAGMA_SUCCESS;
+}
@@ -0,0 +1,46 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+
+#ifndef MAGMA_TUNE_H
+#define MAGMA_TUNE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// Internal routines. User-visible routines (magma_tune_run, etc.)
+// are in magma_auxiliary.h.
+
+magma_int_t magma_tune_init();
+
+// sets *value and returns true if the tuning table has a value for
+// routine at size n on this host.
+int magma_tune_lookup( const char* routine, magma_int_t n, magma_int_t* value );
+
+// Returns from the enclosing magma_get_* function with the value tuned for
+// routine at size n, if the tuning table has one.
+#define MAGMA_TUNED_RETURN( routine, n ) \
+    do { \
+        magma_int_t tuned_; \
+        if ( magma_tune_lookup( routine, n, &tuned_ )) \
+            return tuned_; \
+    } while (0)
+
+// Measured performance model of this host, stored in the tuning table;
+// see magma_perfmodel.cpp. Each sets *value and returns true if calibrated.
+// If $MAGMA_CALIBRATE is set, the first call calibrates the model.
+int magma_perfmodel_sgetrf_cpu_rate( magma_int_t m, magma_int_t n, double* rate );
+int magma_perfmodel_h2d_bandwidth( double* bandwidth );
+int magma_perfmodel_hgemmx_rate( magma_int_t m, magma_int_t k, double* rate );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MAGMA_TUNE_H
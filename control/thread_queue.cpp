@@ -39,6 +39,37 @@ static void check( int err )
     
     Tasks are sub-classes of magma_task. They must implement the run() function.
     
+    Two scheduling policies are available, selected by launch():
+    
+    - MagmaThreadCentral (default): a single FIFO queue protected by one mutex.
+      Simple, but all threads serialize on the mutex when tasks are short or
+      there are many threads.
+    
+    - MagmaThreadWorkStealing: each thread owns a deque. Tasks pushed by a worker
+      (e.g., from inside run()) go to that worker's deque; tasks pushed by the
+      main thread are distributed round-robin. A thread pops its own deque LIFO,
+      for cache locality, and when empty steals FIFO from other threads' deques,
+      taking the oldest (typically largest) work. Each deque has its own lock,
+      so contention is limited to a thread and its thieves. Idle threads sleep
+      on a condition variable only when no deque has work.
+    
+    Order of execution is not defined in either mode. Tasks that depend on
+    each other can be separated by sync(), or, without blocking the main thread,
+    by declaring dependencies before pushing a task:
+    
+    - task->depends_on( future ) where future = pred->get_future() was obtained
+      from a previously pushed task pred. The task is held back until pred
+      finishes.
+    
+    - task->reads( tag ) and task->writes( tag ), where a tag is any address
+      naming a piece of data, e.g., a column of a matrix. As in OpenMP depend
+      clauses, a task that reads a tag runs after the last task pushed earlier
+      that writes it; a task that writes a tag runs after all earlier tasks that
+      read or write it. Tasks that only read a tag may run concurrently.
+    
+    The main thread can wait for a single task with future->wait(), instead of
+    waiting for all tasks with sync().
+    
     Example
     -------
     @code
@@ -64,7 +95,8 @@ static void check( int err )
     
     void master( int n ) {
         magma_thread_queue queue;
-        queue.launch( 12 );  // 12 worker threads
+        queue.launch( 12 );  // 12 worker threads; or
+        // queue.launch( 12, MagmaThreadWorkStealing );
         for( int i=0; i < n; ++i ) {
             queue.push_task( new task1( i ));
         }
@@ -76,6 +108,26 @@ static void check( int err )
         }
         queue.quit();  // [optional] explicitly exit worker threads
     }
+    
+    void master_deps( int n, double* x ) {
+        magma_thread_queue queue;
+        queue.launch( 12 );
+        magma_future_t last;
+        for( int i=0; i < n; ++i ) {
+            magma_task* t = new task1( i );
+            t->writes( &x[i] );      // task1( i ) writes x[i]
+            last = t->get_future();
+            queue.push_task( t );
+        }
+        for( int i=1; i < n; ++i ) {
+            magma_task* t = new task2( i-1, i );
+            t->reads( &x[i-1] );     // task2( i-1, i ) runs after task1( i-1 ),
+            t->reads( &x[i] );       // and task1( i ), but not after other task1
+            queue.push_task( t );
+        }
+        last->wait();  // wait only for task1( n-1 )
+        queue.sync();  // wait for everything
+    }
     @endcode
     
     This is similar to python's queue class, but also implements worker threads
@@ -86,29 +138,138 @@ static void check( int err )
 *******************************************************************************/
 
 
+/***************************************************************************//**
+    Creates future in unfinished state.
+*******************************************************************************/
+magma_task_future::magma_task_future():
+    finished( false )
+{
+    check( pthread_mutex_init( &mutex, NULL ));
+    check( pthread_cond_init(  &cond,  NULL ));
+}
+
+
+/***************************************************************************//**
+    Deallocates data.
+*******************************************************************************/
+magma_task_future::~magma_task_future()
+{
+    check( pthread_mutex_destroy( &mutex ));
+    check( pthread_cond_destroy( &cond ));
+}
+
+
+/***************************************************************************//**
+    Block until the task has finished.
+    The task must have been pushed to a queue, else this waits forever.
+*******************************************************************************/
+void magma_task_future::wait()
+{
+    check( pthread_mutex_lock( &mutex ));
+    while( ! finished ) {
+        check( pthread_cond_wait( &cond, &mutex ));
+    }
+    check( pthread_mutex_unlock( &mutex ));
+}
+
+
+/***************************************************************************//**
+    @return true if the task has finished; does not block.
+*******************************************************************************/
+bool magma_task_future::is_done()
+{
+    check( pthread_mutex_lock( &mutex ));
+    bool result = finished;
+    check( pthread_mutex_unlock( &mutex ));
+    return result;
+}
+
+
+/***************************************************************************//**
+    @return future of this task, creating it on first call.
+    Call before push_task(), as the queue deletes the task when it finishes.
+*******************************************************************************/
+magma_future_t magma_task::get_future()
+{
+    if ( ! m_future ) {
+        m_future = std::make_shared< magma_task_future >();
+    }
+    return m_future;
+}
+
+
+/***************************************************************************//**
+    Declares that this task cannot start before pred finishes.
+    Call before push_task().
+    @param[in] pred    Future of a task pushed earlier.
+*******************************************************************************/
+void magma_task::depends_on( const magma_future_t& pred )
+{
+    if ( pred ) {
+        m_deps.push_back( pred );
+    }
+}
+
+
+/***************************************************************************//**
+    Declares that this task reads data named by tag.
+    Call before push_task().
+    @param[in] tag    Address identifying data, e.g., start of a column.
+*******************************************************************************/
+void magma_task::reads( const void* tag )
+{
+    m_reads.push_back( tag );
+}
+
+
+/***************************************************************************//**
+    Declares that this task writes (or reads and writes) data named by tag.
+    Call before push_task().
+    @param[in] tag    Address identifying data, e.g., start of a column.
+*******************************************************************************/
+void magma_task::writes( const void* tag )
+{
+    m_writes.push_back( tag );
+}
+
+
+// Worker thread's own argument (queue and index), or NULL for non-worker threads.
+// Used by push_task() to put tasks spawned by a worker on its own deque.
+static thread_local magma_thread_arg* g_thread_arg = NULL;
+
+
 /***************************************************************************//**
     Thread's main routine, executed by pthread_create.
     Executes tasks from queue (given as arg), until a NULL task is returned.
     Deletes each task when it is done.
-    @param[in,out] arg    magma_thread_queue to get tasks from.
+    @param[in,out] arg    magma_thread_arg with magma_thread_queue to get tasks
+                          from and this thread's index.
 *******************************************************************************/
 extern "C"
 void* magma_thread_main( void* arg )
 {
-    magma_thread_queue* queue = (magma_thread_queue*) arg;
+    magma_thread_arg*   targ  = (magma_thread_arg*) arg;
+    magma_thread_queue* queue = targ->queue;
     magma_task* task;
+    magma_thread_limit limit( targ->budget );
     
+    g_thread_arg = targ;
     while( true ) {
-        task = queue->pop_task();
+        if ( queue->mode == MagmaThreadWorkStealing )
+            task = queue->pop_task( targ->index );
+        else
+            task = queue->pop_task();
         if ( task == NULL ) {
             break;
         }
         
         task->run();
+        queue->release_successors( task );
         queue->task_done();
         delete task;
         task = NULL;
     }
+    g_thread_arg = NULL;
     
     return NULL;  // implicitly does pthread_exit
 }
@@ -122,11 +283,19 @@ magma_thread_queue::magma_thread_queue():
     quit_flag( false ),
     ntask    ( 0     ),
     threads  ( NULL  ),
-    nthread  ( 0     )
+    nthread  ( 0     ),
+    mode     ( MagmaThreadCentral ),
+    deques   ( NULL  ),
+    args     ( NULL  ),
+    nqueued  ( 0     ),
+    nrunning ( 0     ),
+    nsleep   ( 0     ),
+    next     ( 0     )
 {
     check( pthread_mutex_init( &mutex,      NULL ));
     check( pthread_cond_init(  &cond,       NULL ));
     check( pthread_cond_init(  &cond_ntask, NULL ));
+    check( pthread_mutex_init( &tag_mutex,  NULL ));
 }
 
 
@@ -139,23 +308,39 @@ magma_thread_queue::~magma_thread_queue()
     check( pthread_mutex_destroy( &mutex ));
     check( pthread_cond_destroy( &cond ));
     check( pthread_cond_destroy( &cond_ntask ));
+    check( pthread_mutex_destroy( &tag_mutex ));
 }
 
 
 /***************************************************************************//**
-    Creates threads.
+    Creates threads. If the caller has a magma_thread_budget, each thread
+    runs limited to its blas() cores.
     @param[in] in_nthread    Number of threads to launch.
+    @param[in] in_mode       Scheduling policy, MagmaThreadCentral (default)
+                             or MagmaThreadWorkStealing.
 *******************************************************************************/
-void magma_thread_queue::launch( magma_int_t in_nthread )
+void magma_thread_queue::launch( magma_int_t in_nthread, magma_thread_mode_t in_mode )
 {
     assert( threads == NULL );  // else launch was called previously
     nthread = in_nthread;
     if ( nthread < 1 ) {
         nthread = 1;
     }
+    mode = in_mode;
+    if ( mode == MagmaThreadWorkStealing ) {
+        deques = new magma_thread_deque[ nthread ];
+        for( magma_int_t i=0; i < nthread; ++i ) {
+            check( pthread_mutex_init( &deques[i].mutex, NULL ));
+        }
+    }
+    args    = new magma_thread_arg[ nthread ];
     threads = new pthread_t[ nthread ];
+    magma_int_t budget = magma_get_worker_budget();
     for( magma_int_t i=0; i < nthread; ++i ) {
-        check( pthread_create( &threads[i], NULL, magma_thread_main, this ));
+        args[i].queue  = this;
+        args[i].index  = i;
+        args[i].budget = budget;
+        check( pthread_create( &threads[i], NULL, magma_thread_main, &args[i] ));
         //printf( "launch %d (%lx)\n", i, (long) threads[i] );
     }
 }
@@ -164,24 +349,183 @@ void magma_thread_queue::launch( magma_int_t in_nthread )
 /***************************************************************************//**
     Add task to queue. Task must be allocated with C++ new.
     Increments number of outstanding tasks.
-    Signals threads that are waiting in pop_task().
+    If the task has dependencies (see magma_task::depends_on, reads, writes)
+    that have not finished, it is held back until they finish;
+    otherwise it is made available to threads immediately.
     @param[in] task    Task to queue.
 *******************************************************************************/
 void magma_thread_queue::push_task( magma_task* task )
 {
+    if ( ! task->m_reads.empty() || ! task->m_writes.empty() ) {
+        resolve_tags( task );
+    }
+    if ( task->m_deps.empty() ) {
+        enqueue( task, true );
+        return;
+    }
+    
+    // count task now, so sync() waits for it even before it is ready.
+    if ( mode == MagmaThreadWorkStealing ) {
+        nrunning += 1;
+    }
+    else {
+        check( pthread_mutex_lock( &mutex ));
+        ntask += 1;
+        check( pthread_mutex_unlock( &mutex ));
+    }
+    
+    // register with each unfinished predecessor. m_ndeps starts at 1 so the
+    // task can't be released by a predecessor finishing during this loop.
+    task->m_ndeps = 1;
+    for( size_t i=0; i < task->m_deps.size(); ++i ) {
+        magma_task_future* pred = task->m_deps[i].get();
+        check( pthread_mutex_lock( &pred->mutex ));
+        if ( ! pred->finished ) {
+            pred->successors.push_back( task );
+            task->m_ndeps += 1;
+        }
+        check( pthread_mutex_unlock( &pred->mutex ));
+    }
+    task->m_deps.clear();
+    if ( --task->m_ndeps == 0 ) {
+        enqueue( task, false );
+    }
+}
+
+
+/***************************************************************************//**
+    Makes task available to threads.
+    Signals threads that are waiting in pop_task().
+    @param[in] task     Task that is ready to run.
+    @param[in] count    If true, increments number of outstanding tasks;
+                        false if push_task() already counted it.
+*******************************************************************************/
+void magma_thread_queue::enqueue( magma_task* task, bool count )
+{
+    if ( mode == MagmaThreadWorkStealing ) {
+        if ( quit_flag ) {
+            fprintf( stderr, "Error: push_task() called after quit()\n" );
+            throw std::exception();
+        }
+        // worker threads push onto their own deque; others round-robin
+        magma_int_t i;
+        if ( g_thread_arg != NULL && g_thread_arg->queue == this ) {
+            i = g_thread_arg->index;
+        }
+        else {
+            i = next.fetch_add( 1 ) % nthread;
+        }
+        if ( count ) {
+            nrunning += 1;
+        }
+        check( pthread_mutex_lock( &deques[i].mutex ));
+        deques[i].tasks.push_back( task );
+        check( pthread_mutex_unlock( &deques[i].mutex ));
+        nqueued += 1;
+        
+        // wake a sleeping thread, if any. nqueued and nsleep are sequentially
+        // consistent, so either the sleeper sees nqueued > 0 before waiting,
+        // or we see nsleep > 0 here and signal while it waits.
+        if ( nsleep > 0 ) {
+            check( pthread_mutex_lock( &mutex ));
+            check( pthread_cond_signal( &cond ));
+            check( pthread_mutex_unlock( &mutex ));
+        }
+        return;
+    }
+    
     check( pthread_mutex_lock( &mutex ));
     if ( quit_flag ) {
         fprintf( stderr, "Error: push_task() called after quit()\n" );
         throw std::exception();
     }
     q.push( task );
-    ntask += 1;
+    if ( count ) {
+        ntask += 1;
+    }
     //printf( "push; ntask %d\n", ntask );
     check( pthread_cond_broadcast( &cond ));
     check( pthread_mutex_unlock( &mutex ));
 }
 
 
+/***************************************************************************//**
+    Converts task's reads() and writes() tags into depends_on() predecessors,
+    and records task as reader or writer of those tags.
+    A reader depends on the tag's last writer; a writer depends on the last
+    writer and all readers since then.
+    @param[in,out] task    Task about to be pushed.
+*******************************************************************************/
+void magma_thread_queue::resolve_tags( magma_task* task )
+{
+    magma_future_t self = task->get_future();
+    
+    check( pthread_mutex_lock( &tag_mutex ));
+    for( size_t i=0; i < task->m_reads.size(); ++i ) {
+        magma_tag_state& state = tags[ task->m_reads[i] ];
+        if ( state.writer && state.writer != self ) {
+            task->m_deps.push_back( state.writer );
+        }
+        // drop finished readers, so long read-only phases don't grow the list
+        if ( state.readers.size() >= 64 ) {
+            size_t k = 0;
+            for( size_t j=0; j < state.readers.size(); ++j ) {
+                if ( ! state.readers[j]->is_done() ) {
+                    state.readers[k++] = state.readers[j];
+                }
+            }
+            state.readers.resize( k );
+        }
+        state.readers.push_back( self );
+    }
+    for( size_t i=0; i < task->m_writes.size(); ++i ) {
+        magma_tag_state& state = tags[ task->m_writes[i] ];
+        if ( state.writer && state.writer != self ) {
+            task->m_deps.push_back( state.writer );
+        }
+        for( size_t j=0; j < state.readers.size(); ++j ) {
+            if ( state.readers[j] != self ) {
+                task->m_deps.push_back( state.readers[j] );
+            }
+        }
+        state.readers.clear();
+        state.writer = self;
+    }
+    check( pthread_mutex_unlock( &tag_mutex ));
+    
+    task->m_reads.clear();
+    task->m_writes.clear();
+}
+
+
+/***************************************************************************//**
+    Marks task's future as finished, waking threads in magma_task_future::wait(),
+    and enqueues successors whose last unfinished predecessor was this task.
+    Called by a worker after task->run(), before task_done().
+    @param[in] task    Task that has finished running.
+*******************************************************************************/
+void magma_thread_queue::release_successors( magma_task* task )
+{
+    magma_task_future* future = task->m_future.get();
+    if ( future == NULL ) {
+        return;
+    }
+    
+    std::vector< magma_task* > successors;
+    check( pthread_mutex_lock( &future->mutex ));
+    future->finished = true;
+    successors.swap( future->successors );
+    check( pthread_cond_broadcast( &future->cond ));
+    check( pthread_mutex_unlock( &future->mutex ));
+    
+    for( size_t i=0; i < successors.size(); ++i ) {
+        if ( --successors[i]->m_ndeps == 0 ) {
+            enqueue( successors[i], false );
+        }
+    }
+}
+
+
 /***************************************************************************//**
     Get next task from queue.
     @return next task, blocking until a task is inserted if necesary.
@@ -208,12 +552,106 @@ magma_task* magma_thread_queue::pop_task()
 }
 
 
+/***************************************************************************//**
+    Work-stealing version of pop_task, for thread with given index.
+    Pops newest task from own deque (LIFO); if empty, steals oldest task from
+    another thread's deque (FIFO).
+    @return next task, blocking until a task is inserted if necesary.
+    @return NULL if all deques are empty *and* quit() has been called.
+    
+    @param[in] index    Index of calling thread, 0 <= index < nthread.
+*******************************************************************************/
+magma_task* magma_thread_queue::pop_task( magma_int_t index )
+{
+    magma_task* task = NULL;
+    magma_thread_deque& own = deques[ index ];
+    
+    while( true ) {
+        // own deque, LIFO
+        if ( nqueued > 0 ) {
+            check( pthread_mutex_lock( &own.mutex ));
+            if ( ! own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+            }
+            check( pthread_mutex_unlock( &own.mutex ));
+            if ( task != NULL ) {
+                nqueued -= 1;
+                return task;
+            }
+            
+            // others' deques, FIFO; spin a few rounds before sleeping
+            for( int round=0; round < 4 && task == NULL && nqueued > 0; ++round ) {
+                task = steal_task( index );
+                if ( task == NULL ) {
+                    magma_yield();
+                }
+            }
+            if ( task != NULL ) {
+                nqueued -= 1;
+                return task;
+            }
+        }
+        
+        // nothing found; sleep until a push or quit
+        check( pthread_mutex_lock( &mutex ));
+        nsleep += 1;
+        while( nqueued == 0 && ! quit_flag ) {
+            check( pthread_cond_wait( &cond, &mutex ));
+        }
+        nsleep -= 1;
+        bool done = (nqueued == 0 && quit_flag);
+        check( pthread_mutex_unlock( &mutex ));
+        if ( done ) {
+            return NULL;
+        }
+    }
+}
+
+
+/***************************************************************************//**
+    Steals oldest task from another thread's deque, visiting threads
+    index+1, index+2, ..., cyclically.
+    Uses trylock so that thieves don't queue up behind a busy deque.
+    @return task, or NULL if no task was found.
+    
+    @param[in] index    Index of calling thread, 0 <= index < nthread.
+*******************************************************************************/
+magma_task* magma_thread_queue::steal_task( magma_int_t index )
+{
+    magma_task* task = NULL;
+    for( magma_int_t k=1; k < nthread && task == NULL; ++k ) {
+        magma_thread_deque& victim = deques[ (index + k) % nthread ];
+        if ( pthread_mutex_trylock( &victim.mutex ) != 0 ) {
+            continue;
+        }
+        if ( ! victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+        }
+        check( pthread_mutex_unlock( &victim.mutex ));
+    }
+    return task;
+}
+
+
 /***************************************************************************//**
     Marks task as finished, decrementing number of outstanding tasks.
     Signals threads that are waiting in sync().
 *******************************************************************************/
 void magma_thread_queue::task_done()
 {
+    if ( mode == MagmaThreadWorkStealing ) {
+        // only the last task needs to wake sync();
+        // broadcast under mutex so sync() can't miss it.
+        if ( --nrunning == 0 ) {
+            check( pthread_mutex_lock( &mutex ));
+            check( pthread_cond_broadcast( &cond_ntask ));
+            check( pthread_mutex_unlock( &mutex ));
+        }
+        return;
+    }
+    
     check( pthread_mutex_lock( &mutex ));
     ntask -= 1;
     //printf( "fini; ntask %d\n", ntask );
@@ -230,17 +668,23 @@ void magma_thread_queue::sync()
 {
     check( pthread_mutex_lock( &mutex ));
     //printf( "sync; ntask %d [start]\n", ntask );
-    while( ntask > 0 ) {
+    while( ntask > 0 || nrunning > 0 ) {
         check( pthread_cond_wait( &cond_ntask, &mutex ));
         //printf( "sync; ntask %d\n", ntask );
     }
     //printf( "sync; ntask %d [done]\n", ntask );
     check( pthread_mutex_unlock( &mutex ));
+    
+    // all tasks are done, so tags no longer imply any dependencies
+    check( pthread_mutex_lock( &tag_mutex ));
+    tags.clear();
+    check( pthread_mutex_unlock( &tag_mutex ));
 }
 
 
 /***************************************************************************//**
-    Sets quit_flag, so pop_task() will return NULL once queue is empty,
+    Waits for outstanding tasks, including those held back by dependencies,
+    then sets quit_flag, so pop_task() will return NULL once queue is empty,
     telling threads to exit.
     Signals all threads that are waiting in pop_task().
     Waits for all threads to exit (i.e., joins them).
@@ -250,7 +694,13 @@ void magma_thread_queue::sync()
 *******************************************************************************/
 void magma_thread_queue::quit()
 {
-    // first, set quit_flag and signal waiting threads
+    // tasks waiting on dependencies aren't in the queue yet,
+    // so threads must not exit before they run.
+    if ( threads != NULL ) {
+        sync();
+    }
+    
+    // then, set quit_flag and signal waiting threads
     bool join = true;
     check( pthread_mutex_lock( &mutex ));
     //printf( "quit %d\n", quit_flag );
@@ -272,6 +722,15 @@ void magma_thread_queue::quit()
         }
         delete[] threads;
         threads = NULL;
+        delete[] args;
+        args = NULL;
+        if ( deques != NULL ) {
+            for( magma_int_t i=0; i < nthread; ++i ) {
+                check( pthread_mutex_destroy( &deques[i].mutex ));
+            }
+            delete[] deques;
+            deques = NULL;
+        }
     }
 }
 
@@ -12,6 +12,11 @@
 #define MAGMA_THREAD_HPP
 
 #include <queue>
+#include <deque>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
 
 #include "magma_internal.h"
 
@@ -21,18 +26,106 @@ extern "C"
 void* magma_thread_main( void* arg );
 
 
+class magma_task;
+class magma_thread_queue;
+
+
+/***************************************************************************//**
+    Completion record of a task pushed to \ref magma_thread_queue.
+    Obtained from magma_task::get_future() before pushing the task;
+    it remains valid after the task finishes and is deleted.
+    @ingroup magma_thread
+*******************************************************************************/
+class magma_task_future
+{
+public:
+    magma_task_future();
+    ~magma_task_future();
+    
+    void wait();
+    bool is_done();
+    
+private:
+    friend class magma_thread_queue;
+    
+    pthread_mutex_t mutex;        ///<  mutex lock for finished, successors
+    pthread_cond_t  cond;         ///<  condition variable for changes to finished (see wait)
+    bool            finished;     ///<  set when task's run() has returned
+    std::vector< magma_task* > successors;  ///<  pushed tasks waiting on this one
+};
+
+typedef std::shared_ptr< magma_task_future > magma_future_t;
+
+
 /***************************************************************************//**
     Super class for tasks used with \ref magma_thread_queue.
     Each task should sub-class this and implement the run() method.
+    
+    Before pushing a task, its dependencies may be declared, either explicitly
+    with depends_on(), or implicitly with reads() and writes() data tags.
     @ingroup magma_thread
 *******************************************************************************/
 class magma_task
 {
 public:
-    magma_task() {}
+    magma_task(): m_ndeps( 0 ) {}
     virtual ~magma_task() {}
     
     virtual void run() = 0;  // pure virtual function to execute task
+    
+    magma_future_t get_future();
+    void depends_on( const magma_future_t& pred );
+    void reads ( const void* tag );
+    void writes( const void* tag );
+    
+private:
+    friend class magma_thread_queue;
+    
+    magma_future_t                m_future;  ///<  created on demand by get_future()
+    std::vector< magma_future_t > m_deps;    ///<  predecessors, until task is pushed
+    std::vector< const void* >    m_reads;   ///<  input  data tags, until task is pushed
+    std::vector< const void* >    m_writes;  ///<  output data tags, until task is pushed
+    std::atomic<int>              m_ndeps;   ///<  number of unfinished predecessors, after task is pushed
+};
+
+
+/***************************************************************************//**
+    Scheduling policy for \ref magma_thread_queue.
+    @ingroup magma_thread
+*******************************************************************************/
+enum magma_thread_mode_t {
+    MagmaThreadCentral      = 0,  ///< single FIFO queue shared by all threads
+    MagmaThreadWorkStealing = 1   ///< per-thread deques; pop own LIFO, steal others FIFO
+};
+
+
+/******************************************************************************/
+// Per-thread deque used in MagmaThreadWorkStealing mode.
+// Padded so deques of different threads don't share a cache line.
+struct magma_thread_deque
+{
+    pthread_mutex_t            mutex;  ///<  protects tasks
+    std::deque< magma_task* >  tasks;  ///<  owner pushes & pops back; thieves pop front
+    char pad[ 64 ];
+};
+
+
+/******************************************************************************/
+// Argument passed to each worker thread.
+struct magma_thread_arg
+{
+    magma_thread_queue* queue;
+    magma_int_t         index;
+    magma_int_t         budget;  // cores per worker; see magma_thread_budget
+};
+
+
+/******************************************************************************/
+// Last writer and readers since then of a data tag, for reads() and writes().
+struct magma_tag_state
+{
+    magma_future_t                writer;
+    std::vector< magma_future_t > readers;
 };
 
 
@@ -43,20 +136,28 @@ public:
     magma_thread_queue();
     ~magma_thread_queue();
     
-    void launch( magma_int_t in_nthread );
+    void launch( magma_int_t in_nthread,
+                 magma_thread_mode_t in_mode=MagmaThreadCentral );
     void push_task( magma_task* task );
     void sync();
     void quit();
     
+    magma_thread_mode_t get_mode() const { return mode; }
+    
 protected:
     friend void* magma_thread_main( void* arg );
     magma_task* pop_task();
+    magma_task* pop_task( magma_int_t index );
+    magma_task* steal_task( magma_int_t index );
+    void enqueue( magma_task* task, bool count );
+    void resolve_tags( magma_task* task );
+    void release_successors( magma_task* task );
     void task_done();
     
     magma_int_t get_thread_index( pthread_t thread ) const;
     
 private:
-    std::queue< magma_task* > q;  ///<  queue of tasks
+    std::queue< magma_task* > q;  ///<  queue of tasks (MagmaThreadCentral)
     bool            quit_flag;    ///<  quit() sets this to true; after this, pop returns NULL
     magma_int_t     ntask;        ///<  number of unfinished tasks (in queue or currently executing)
     pthread_mutex_t mutex;        ///<  mutex lock for queue, quit, ntask
@@ -64,6 +165,19 @@ private:
     pthread_cond_t  cond_ntask;   ///<  condition variable for changes to ntask (see sync, task_done)
     pthread_t*      threads;      ///<  array of threads
     magma_int_t     nthread;      ///<  number of threads
+    
+    // used only in MagmaThreadWorkStealing mode
+    magma_thread_mode_t       mode;      ///<  scheduling policy, set by launch()
+    magma_thread_deque*       deques;    ///<  array of nthread per-thread deques
+    magma_thread_arg*         args;      ///<  array of nthread thread arguments
+    std::atomic<magma_int_t>  nqueued;   ///<  number of tasks in all deques (not yet popped)
+    std::atomic<magma_int_t>  nrunning;  ///<  number of unfinished tasks; replaces ntask
+    std::atomic<magma_int_t>  nsleep;    ///<  number of threads waiting on cond
+    std::atomic<magma_int_t>  next;      ///<  round-robin target for pushes from outside workers
+    
+    // used only for tasks with reads() or writes() tags
+    std::map< const void*, magma_tag_state > tags;  ///<  state of each tag, cleared by sync()
+    pthread_mutex_t tag_mutex;    ///<  mutex lock for tags
 };
 
 #endif        //  #ifndef MAGMA_THREAD_HPP
@@ -3,8 +3,14 @@
 #include <errno.h>
 #include <string.h>      // strerror_r
 
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "trace.h"
 
@@ -340,3 +346,267 @@ void trace_finalize( const char* filename, const char* cssfile )
 }
 
 #endif // TRACING
+
+
+// =============================================================================
+// Runtime tracer; see trace.h.
+
+/******************************************************************************/
+struct magma_trace_event
+{
+    const char*        category;
+    const char*        name;
+    long long          arg;
+    unsigned long long start;  // ns since trace init
+    unsigned long long end;
+};
+
+
+/******************************************************************************/
+// Ring buffer written only by its own thread, so recording needs no lock.
+// count is atomic so magma_trace_write can read a consistent prefix.
+struct magma_trace_buffer
+{
+    static const int max_depth = 64;  // nesting of magma_trace_begin
+
+    int tid;
+    std::vector< magma_trace_event > events;  // size is power of 2
+    std::atomic< unsigned long long > count;  // total events recorded
+
+    // open magma_trace_begin regions
+    int depth;
+    magma_trace_event stack[ max_depth ];
+};
+
+
+/******************************************************************************/
+// global state; g_magma_trace_on and g_trace_epoch change only in
+// magma_trace_init and magma_trace_finalize, when no tracing is in progress.
+int g_magma_trace_on = 0;
+
+static int         g_trace_epoch = 0;  // invalidates thread-local buffers
+static std::string g_trace_filename;
+static size_t      g_trace_capacity = 0;
+static std::chrono::steady_clock::time_point g_trace_t0;
+
+static std::mutex                          g_trace_mutex;  // protects g_trace_buffers
+static std::vector< magma_trace_buffer* >  g_trace_buffers;
+
+struct magma_trace_thread
+{
+    magma_trace_buffer* buffer;
+    int epoch;
+};
+static thread_local magma_trace_thread t_trace = { NULL, 0 };
+
+
+/******************************************************************************/
+// Returns this thread's buffer, registering a new one on first use.
+static magma_trace_buffer* magma_trace_get_buffer()
+{
+    if ( t_trace.buffer == NULL || t_trace.epoch != g_trace_epoch ) {
+        magma_trace_buffer* buf = new magma_trace_buffer;
+        buf->events.resize( g_trace_capacity );
+        buf->count = 0;
+        buf->depth = 0;
+        std::lock_guard< std::mutex > lock( g_trace_mutex );
+        buf->tid = (int) g_trace_buffers.size();
+        g_trace_buffers.push_back( buf );
+        t_trace.buffer = buf;
+        t_trace.epoch  = g_trace_epoch;
+    }
+    return t_trace.buffer;
+}
+
+
+/******************************************************************************/
+/// @return current trace time in ns since magma_trace_init.
+unsigned long long magma_trace_now()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::steady_clock::now() - g_trace_t0 ).count();
+}
+
+
+/******************************************************************************/
+/// Records a completed event on the calling thread's track.
+void magma_trace_record(
+    const char* category, const char* name, long long arg,
+    unsigned long long start, unsigned long long end )
+{
+    if ( ! magma_trace_enabled() )
+        return;
+    magma_trace_buffer* buf = magma_trace_get_buffer();
+    unsigned long long n = buf->count.load( std::memory_order_relaxed );
+    magma_trace_event& ev = buf->events[ n & (buf->events.size() - 1) ];
+    ev.category = category;
+    ev.name     = name;
+    ev.arg      = arg;
+    ev.start    = start;
+    ev.end      = end;
+    buf->count.store( n+1, std::memory_order_release );
+}
+
+
+/******************************************************************************/
+/// Starts an event on the calling thread's track, ended by magma_trace_end.
+/// Prefer magma_trace_scope when the region is a C++ scope.
+void magma_trace_begin( const char* category, const char* name, long long arg )
+{
+    if ( ! magma_trace_enabled() )
+        return;
+    magma_trace_buffer* buf = magma_trace_get_buffer();
+    if ( buf->depth < magma_trace_buffer::max_depth ) {
+        magma_trace_event& ev = buf->stack[ buf->depth ];
+        ev.category = category;
+        ev.name     = name;
+        ev.arg      = arg;
+        ev.start    = magma_trace_now();
+    }
+    buf->depth += 1;
+}
+
+
+/******************************************************************************/
+/// Ends the most recent magma_trace_begin event on the calling thread.
+void magma_trace_end()
+{
+    if ( ! magma_trace_enabled() )
+        return;
+    magma_trace_buffer* buf = magma_trace_get_buffer();
+    if ( buf->depth <= 0 )
+        return;
+    buf->depth -= 1;
+    if ( buf->depth < magma_trace_buffer::max_depth ) {
+        const magma_trace_event& ev = buf->stack[ buf->depth ];
+        magma_trace_record( ev.category, ev.name, ev.arg, ev.start, magma_trace_now() );
+    }
+}
+
+
+/******************************************************************************/
+// Writes s as a JSON string, with quotes.
+static void magma_trace_json_string( FILE* file, const char* s )
+{
+    fputc( '"', file );
+    for ( ; s != NULL && *s != '\0'; ++s ) {
+        unsigned char c = (unsigned char) *s;
+        if ( c == '"' || c == '\\' )
+            fprintf( file, "\\%c", c );
+        else if ( c < 0x20 )
+            fprintf( file, "\\u%04x", c );
+        else
+            fputc( c, file );
+    }
+    fputc( '"', file );
+}
+
+
+/******************************************************************************/
+/// Writes events recorded so far, from all threads, to filename in Chrome
+/// trace-event JSON format. Threads should not be recording meanwhile.
+/// @return MAGMA_SUCCESS, or MAGMA_ERR if the file cannot be written.
+magma_int_t magma_trace_write( const char* filename )
+{
+    FILE* file = fopen( filename, "w" );
+    if ( file == NULL ) {
+        fprintf( stderr, "Can't open trace file '%s': %s (%d)\n",
+                 filename, strerror( errno ), errno );
+        return MAGMA_ERR;
+    }
+
+    std::lock_guard< std::mutex > lock( g_trace_mutex );
+    long long pid = 1;
+    fprintf( file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" );
+    const char* sep = "";
+    for ( size_t t = 0; t < g_trace_buffers.size(); ++t ) {
+        magma_trace_buffer* buf = g_trace_buffers[ t ];
+        unsigned long long count = buf->count.load( std::memory_order_acquire );
+        unsigned long long size  = buf->events.size();
+        unsigned long long first = (count > size ? count - size : 0);
+        if ( first > 0 ) {
+            fprintf( stderr, "WARNING: trace of thread %d dropped its oldest %llu of %llu events;"
+                     " increase $MAGMA_TRACE_EVENTS.\n", buf->tid, first, count );
+        }
+
+        fprintf( file, "%s{\"ph\": \"M\", \"pid\": %lld, \"tid\": %d, \"name\": \"thread_name\","
+                 " \"args\": {\"name\": \"CPU thread %d\"}}",
+                 sep, pid, buf->tid, buf->tid );
+        sep = ",\n";
+        for ( unsigned long long i = first; i < count; ++i ) {
+            const magma_trace_event& ev = buf->events[ i & (size - 1) ];
+            fprintf( file, "%s{\"ph\": \"X\", \"pid\": %lld, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"cat\": ",
+                     sep, pid, buf->tid, ev.start * 1e-3, (ev.end - ev.start) * 1e-3 );
+            magma_trace_json_string( file, ev.category );
+            fprintf( file, ", \"name\": " );
+            magma_trace_json_string( file, ev.name );
+            if ( ev.arg >= 0 ) {
+                fprintf( file, ", \"args\": {\"i\": %lld}", ev.arg );
+            }
+            fprintf( file, "}" );
+        }
+    }
+    fprintf( file, "\n]}\n" );
+
+    int err = ferror( file );
+    fclose( file );
+    if ( err ) {
+        fprintf( stderr, "Error writing trace file '%s'\n", filename );
+        return MAGMA_ERR;
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+/// Enables tracing if $MAGMA_TRACE is set to a file name.
+/// Called by magma_init.
+void magma_trace_init()
+{
+    const char* filename = getenv( "MAGMA_TRACE" );
+    if ( filename == NULL || filename[0] == '\0' || g_magma_trace_on )
+        return;
+
+    // per-thread capacity, rounded up to power of 2
+    size_t capacity = 65536;
+    const char* events_str = getenv( "MAGMA_TRACE_EVENTS" );
+    if ( events_str != NULL ) {
+        char* endptr;
+        long long n = strtoll( events_str, &endptr, 10 );
+        if ( n < 1 || *endptr != '\0' ) {
+            fprintf( stderr, "$MAGMA_TRACE_EVENTS='%s' is an invalid number; using %lld.\n",
+                     events_str, (long long) capacity );
+        }
+        else {
+            capacity = 1;
+            while ( capacity < (size_t) n )
+                capacity *= 2;
+        }
+    }
+
+    g_trace_filename = filename;
+    g_trace_capacity = capacity;
+    g_trace_t0       = std::chrono::steady_clock::now();
+    g_trace_epoch   += 1;
+    g_magma_trace_on = 1;
+}
+
+
+/******************************************************************************/
+/// If tracing is enabled, writes the trace to $MAGMA_TRACE,
+/// then disables tracing and frees buffers.
+/// Called by magma_finalize.
+void magma_trace_finalize()
+{
+    if ( ! g_magma_trace_on )
+        return;
+
+    magma_trace_write( g_trace_filename.c_str() );
+    g_magma_trace_on = 0;
+
+    std::lock_guard< std::mutex > lock( g_trace_mutex );
+    for ( size_t t = 0; t < g_trace_buffers.size(); ++t ) {
+        delete g_trace_buffers[ t ];
+    }
+    g_trace_buffers.clear();
+}
@@ -53,4 +53,76 @@ void trace_finalize ( const char* filename, const char* cssfile );
 
 #endif
 
+
+// =============================================================================
+// Runtime tracer of CPU phases, independent of TRACING above.
+// Enabled at magma_init by setting environment variable MAGMA_TRACE to an
+// output file name, e.g., MAGMA_TRACE=trace.json; magma_finalize writes the
+// trace in Chrome trace-event JSON format, viewable in chrome://tracing or
+// https://ui.perfetto.dev. Each thread records into its own ring buffer of
+// MAGMA_TRACE_EVENTS events (default 65536), keeping the most recent events.
+// When disabled, each traced region costs one load and branch.
+//
+// Category and name strings are stored by pointer, so must be literals
+// or otherwise outlive the trace.
+
+extern int g_magma_trace_on;  // set only by magma_trace_init and _finalize
+
+inline bool magma_trace_enabled()
+{
+    return g_magma_trace_on != 0;
+}
+
+void        magma_trace_init();
+void        magma_trace_finalize();
+magma_int_t magma_trace_write( const char* filename );
+
+unsigned long long magma_trace_now();
+void magma_trace_record( const char* category, const char* name, long long arg,
+                         unsigned long long start, unsigned long long end );
+
+void magma_trace_begin( const char* category, const char* name, long long arg=-1 );
+void magma_trace_end();
+
+
+// -----------------------------------------------------------------------------
+// Traces the enclosing scope, e.g.,
+//     {
+//         magma_trace_scope trace( "hb2st", "sweep", sweep );
+//         ...
+//     }
+// arg, if >= 0, is shown with the event, e.g., a sweep or block index.
+class magma_trace_scope
+{
+public:
+    magma_trace_scope( const char* category, const char* name, long long arg=-1 ):
+        m_category( category ),
+        m_name( NULL ),
+        m_arg( arg ),
+        m_start( 0 )
+    {
+        if ( magma_trace_enabled() ) {
+            m_name  = name;
+            m_start = magma_trace_now();
+        }
+    }
+
+    ~magma_trace_scope()
+    {
+        if ( m_name != NULL ) {
+            magma_trace_record( m_category, m_name, m_arg, m_start, magma_trace_now() );
+        }
+    }
+
+private:
+    // not copyable
+    magma_trace_scope( const magma_trace_scope& );
+    magma_trace_scope& operator = ( const magma_trace_scope& );
+
+    const char* m_category;
+    const char* m_name;
+    long long   m_arg;
+    unsigned long long m_start;
+};
+
 #endif        //  #ifndef TRACE_H
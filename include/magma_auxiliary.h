@@ -48,6 +48,11 @@ void magma_print_environment();
 real_Double_t magma_wtime( void );
 real_Double_t magma_sync_wtime( magma_queue_t queue );
 
+// phase profiler; see control/magma_timer.h
+void        magma_profile_enable( magma_int_t enable );
+void        magma_profile_reset( void );
+magma_int_t magma_profile_dump( const char* filename, const char* format );
+
 
 // =============================================================================
 // misc. functions
@@ -68,12 +73,39 @@ void magma_swp2pswp(
     magma_int_t *ipiv,
     magma_int_t *newipiv );
 
+// limits MAGMA on the calling thread to nthreads cores; see control/magma_threadsetting.cpp
+magma_int_t magma_set_thread_budget( magma_int_t nthreads );
+magma_int_t magma_get_thread_budget( void );
+
 
 // =============================================================================
 // get NB blocksize
 
 magma_int_t magma_get_smlsize_divideconquer();
 
+// autotuning of block sizes and similar parameters; see control/magma_tune.cpp
+typedef double (*magma_tune_bench_t)( magma_int_t value, magma_int_t n, void* arg );
+
+const char* magma_tune_host( void );
+
+magma_int_t magma_tune_load( const char* filename );
+magma_int_t magma_tune_save( const char* filename );
+
+magma_int_t magma_tune_set(
+    const char* routine, magma_int_t nmin, magma_int_t nmax, magma_int_t value );
+
+magma_int_t magma_tune_get(
+    const char* routine, magma_int_t n, magma_int_t default_value );
+
+magma_int_t magma_tune_run(
+    const char* routine,
+    magma_int_t nsize, const magma_int_t* sizes,
+    magma_int_t ncand, const magma_int_t* candidates,
+    magma_tune_bench_t bench, void* arg, magma_int_t ntrial,
+    magma_int_t* best );
+
+magma_int_t magma_perfmodel_calibrate( magma_queue_t queue );
+
 
 // =============================================================================
 // memory allocation
@@ -90,6 +122,29 @@ magma_malloc_pinned( void **ptr_ptr, size_t bytes );
 magma_int_t
 magma_free_cpu( void *ptr );
 
+// caching allocator behind magma_malloc_cpu; see control/magma_cpu_pool.cpp
+typedef struct magma_cpu_pool_stats
+{
+    size_t    bytes_in_use;
+    size_t    peak_bytes_in_use;
+    size_t    bytes_reserved;
+    size_t    peak_bytes_reserved;
+    long long nalloc;
+    long long nhit;
+} magma_cpu_pool_stats_t;
+
+magma_int_t
+magma_cpu_pool_config( magma_int_t enable, size_t alignment, magma_int_t hugepages );
+
+void
+magma_cpu_pool_get_stats( magma_cpu_pool_stats_t *stats );
+
+void
+magma_cpu_pool_reset_stats( void );
+
+void
+magma_cpu_pool_trim( void );
+
 #define magma_free( ptr ) \
         magma_free_internal( ptr, __func__, __FILE__, __LINE__ )
 
@@ -122,6 +122,10 @@ magma_free_internal( magma_ptr ptr,
     to align memory to a 64 byte boundary (typical cache line size).
     Use magma_free_cpu() to free this memory.
 
+    If enabled by magma_cpu_pool_config or $MAGMA_CPU_POOL, memory comes
+    from a caching allocator with size classes, which reuses freed blocks.
+    The alignment can also be set there.
+
     @param[out]
     ptrPtr  On output, set to the pointer that was allocated.
             NULL on failure.
@@ -148,25 +152,32 @@ magma_malloc_cpu( void** ptrPtr, size_t size )
     // malloc and free sometimes don't work for size=0, so allocate some minimal size
     if ( size == 0 )
         size = sizeof(magmaDoubleComplex);
+    *ptrPtr = NULL;
+    if ( magma_cpu_pool_enabled() ) {
+        // falls back to system allocator if NULL
+        *ptrPtr = magma_cpu_pool_malloc( size );
+    }
+    if ( *ptrPtr == NULL ) {
 #if 1
 #if defined( _WIN32 ) || defined( _WIN64 )
-    *ptrPtr = _aligned_malloc( size, 64 );
-    if ( *ptrPtr == NULL ) {
-        return MAGMA_ERR_HOST_ALLOC;
-    }
+        *ptrPtr = _aligned_malloc( size, magma_cpu_pool_alignment() );
+        if ( *ptrPtr == NULL ) {
+            return MAGMA_ERR_HOST_ALLOC;
+        }
 #else
-    int err = posix_memalign( ptrPtr, 64, size );
-    if ( err != 0 ) {
-        *ptrPtr = NULL;
-        return MAGMA_ERR_HOST_ALLOC;
-    }
+        int err = posix_memalign( ptrPtr, magma_cpu_pool_alignment(), size );
+        if ( err != 0 ) {
+            *ptrPtr = NULL;
+            return MAGMA_ERR_HOST_ALLOC;
+        }
 #endif
 #else
-    *ptrPtr = malloc( size );
-    if ( *ptrPtr == NULL ) {
-        return MAGMA_ERR_HOST_ALLOC;
-    }
+        *ptrPtr = malloc( size );
+        if ( *ptrPtr == NULL ) {
+            return MAGMA_ERR_HOST_ALLOC;
+        }
 #endif
+    }
 
     #ifdef DEBUG_MEMORY
     g_pointers_mutex.lock();
@@ -183,6 +194,8 @@ magma_malloc_cpu( void** ptrPtr, size_t size )
     The default implementation uses free(),
     which works for both malloc and posix_memalign.
     For Windows, _aligned_free() is used.
+    Blocks from the caching allocator (see magma_cpu_pool_config) are
+    returned to it, even if it has since been disabled.
 
     @param[in]
     ptr     Pointer to free.
@@ -206,6 +219,15 @@ magma_free_cpu( void* ptr )
     g_pointers_mutex.unlock();
     #endif
 
+    int pooled = magma_cpu_pool_free( ptr );
+    if ( pooled > 0 ) {
+        return MAGMA_SUCCESS;
+    }
+    else if ( pooled < 0 ) {
+        fprintf( stderr, "magma_free_cpu( %p ) inside a magma_malloc_cpu block.\n", ptr );
+        return MAGMA_ERR_INVALID_PTR;
+    }
+
 #if defined( _WIN32 ) || defined( _WIN64 )
     _aligned_free( ptr );
 #else
@@ -39,6 +39,8 @@
 
 #include "magma_internal.h"
 #include "error.h"
+#include "trace.h"
+#include "magma_timer.h"
 
 #define MAX_BATCHCOUNT    (65534)
 
@@ -157,7 +159,8 @@ struct magma_device_info* g_magma_devices = NULL;
 
 /***************************************************************************//**
     Initializes the MAGMA library.
-    Caches information about available CUDA devices.
+    Caches information about available CUDA devices,
+    and prepares the CPU thread pool used by parallel sections.
 
     Every magma_init call must be paired with a magma_finalize call.
     Only one thread needs to call magma_init and magma_finalize,
@@ -255,6 +258,24 @@ magma_init()
                 }
                 memset( g_null_queues, 0, size );
             #endif // MAGMA_NO_V1
+
+            // caching allocator for magma_malloc_cpu, if $MAGMA_CPU_POOL is set
+            magma_cpu_pool_init();
+
+            // tuned block sizes, if $MAGMA_TUNE_FILE is set
+            magma_tune_init();
+
+            // CPU worker pool for parallel sections; threads start lazily
+            info = magma_threadpool_init();
+            if ( info != 0 ) {
+                goto cleanup;
+            }
+
+            // CPU tracer, if $MAGMA_TRACE is set
+            magma_trace_init();
+
+            // phase profiler, if $MAGMA_PROFILE is set
+            magma_profile_init();
         }
 cleanup:
         g_init += 1;  // increment (init - finalize) count
@@ -286,6 +307,11 @@ magma_finalize()
             if ( g_init == 0 ) {
                 info = 0;
 
+                magma_profile_finalize();
+                magma_trace_finalize();
+                magma_threadpool_finalize();
+                magma_cpu_pool_finalize();
+
                 if ( g_magma_devices != NULL ) {
                     magma_free_cpu( g_magma_devices );
                     g_magma_devices = NULL;
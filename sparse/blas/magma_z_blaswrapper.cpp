@@ -100,6 +100,8 @@
     For a given input matrix A and vectors x, y and scalars alpha, beta
     the wrapper determines the suitable SpMV computing
               y = alpha * A * x + beta * y.
+    On the CPU, a CSR matrix prepared by magma_zcmixed_prec_setup_cpu
+    is applied with its values in single precision.
     Arguments
     ---------
 
@@ -213,6 +215,10 @@ magma_z_spmv(
                         beta, y.dval, A.alignment, A.blocksize, queue ));
                 //printf("done.\n");
             }
+            else if ( A.storage_type == Magma_SELLP && A.drowidx != NULL ) {
+                printf("error: SELL-C-sigma with sorted rows is only supported on the CPU.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
+            }
             else if ( A.storage_type == Magma_SELLP ) {
                 //printf("using SELLP kernel for SpMV: ");
                 CHECK( magma_zgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
@@ -301,6 +307,9 @@ magma_z_spmv(
                                         (cuDoubleComplex*)&alpha, descr, (cuDoubleComplex*)A.dval, A.drow, A.dcol,
                                         (cuDoubleComplex*)x.dval, A.num_cols, (cuDoubleComplex*)&beta, (cuDoubleComplex*)y.dval, A.num_cols);
                     }
+            } else if ( A.storage_type == Magma_SELLP && A.drowidx != NULL ) {
+                printf("error: SELL-C-sigma with sorted rows is only supported on the CPU.\n");
+                info = MAGMA_ERR_NOT_SUPPORTED;
             } else if ( A.storage_type == Magma_SELLP ) {
                 if ( x.major == MagmaRowMajor) {
                     CHECK( magma_zmgesellpmv( MagmaNoTrans, A.num_rows, A.num_cols,
@@ -327,19 +336,88 @@ magma_z_spmv(
             }
         }
     }
-    // CPU case missing!
+    // CPU case
     else {
-        CHECK( magma_zmtransfer( x, &dx, x.memory_location, Magma_DEV, queue ));
-        CHECK( magma_zmtransfer( y, &dy, y.memory_location, Magma_DEV, queue ));
-        CHECK( magma_zmtransfer( A, &dA, A.memory_location, Magma_DEV, queue ));
-        CHECK( magma_z_spmv( alpha, dA, dx, beta, dy, queue ) );
-        magma_zmfree(&x, queue );
-        magma_zmfree(&y, queue );
-        magma_zmfree(&A, queue );
-        CHECK( magma_zmtransfer( dx, &x, dx.memory_location, Magma_CPU, queue ));
-        CHECK( magma_zmtransfer( dy, &y, dy.memory_location, Magma_CPU, queue ));
-        CHECK( magma_zmtransfer( dA, &A, dA.memory_location, Magma_CPU, queue ));
-
+        #if defined(PRECISION_z) || defined(PRECISION_d)
+        if ( A.lval != NULL && A.num_cols == x.num_rows && x.num_cols == 1 &&
+             ( A.storage_type == Magma_CSR  ||
+               A.storage_type == Magma_CSRL ||
+               A.storage_type == Magma_CSRU ) )
+        {
+            // single-precision copy from magma_zcmixed_prec_setup_cpu
+            #if defined(PRECISION_z)
+            CHECK( magma_zcgecsrmv_mixed_prec_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.lval, A.row, A.col, A.lcol, A.lcolbase,
+                       x.val, beta, y.val, queue ));
+            #else
+            CHECK( magma_dsgecsrmv_mixed_prec_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.lval, A.row, A.col, A.lcol, A.lcolbase,
+                       x.val, beta, y.val, queue ));
+            #endif
+        }
+        else
+        #endif
+        if ( A.num_cols == x.num_rows && x.num_cols == 1 &&
+             ( A.storage_type == Magma_CSR  ||
+               A.storage_type == Magma_CSRL ||
+               A.storage_type == Magma_CSRU ) )
+        {
+            CHECK( magma_zgecsrmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       alpha, A.val, A.row, A.col, x.val, beta, y.val, queue ));
+        }
+        else if ( A.num_cols == x.num_rows && x.num_cols == 1 &&
+                  A.storage_type == Magma_CSC )
+        {
+            // col is the column pointer and row the row indices,
+            // i.e., the CSR arrays of A^T
+            CHECK( magma_zgecsrmv_cpu( MagmaTrans, A.num_cols, A.num_rows,
+                       alpha, A.val, A.col, A.row, x.val, beta, y.val, queue ));
+        }
+        else if ( A.num_cols == x.num_rows && x.num_cols == 1 &&
+                  A.storage_type == Magma_SELLP )
+        {
+            CHECK( magma_zgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       A.blocksize, A.numblocks, A.alignment, alpha,
+                       A.val, A.col, A.row, A.rowidx, x.val, beta, y.val, queue ));
+        }
+        else if ( A.num_cols == x.num_rows && x.num_cols == 1 &&
+                  A.storage_type == Magma_CSR5 )
+        {
+            CHECK( magma_zgecsr5mv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       A.csr5_p, alpha, A.csr5_sigma, A.csr5_bit_y_offset,
+                       A.csr5_bit_scansum_offset, A.csr5_num_packets,
+                       A.tile_ptr, A.tile_desc, A.tile_desc_offset_ptr, A.tile_desc_offset,
+                       A.calibrator, A.csr5_tail_tile_start,
+                       A.val, A.row, A.col, x.val, beta, y.val, queue ));
+        }
+        else if ( ( A.num_cols < x.num_rows || x.num_cols > 1 ) &&
+                  ( A.storage_type == Magma_CSR  ||
+                    A.storage_type == Magma_CSRL ||
+                    A.storage_type == Magma_CSRU ) )
+        {
+            // X in either order; no transpose needed
+            magma_int_t num_vecs = x.num_rows / A.num_cols * x.num_cols;
+            CHECK( magma_zmgecsrmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       num_vecs, alpha, A.val, A.row, A.col, x.major,
+                       x.val, beta, y.val, queue ));
+        }
+        else if ( ( A.num_cols < x.num_rows || x.num_cols > 1 ) &&
+                  A.storage_type == Magma_SELLP )
+        {
+            magma_int_t num_vecs = x.num_rows / A.num_cols * x.num_cols;
+            CHECK( magma_zmgesellpmv_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+                       num_vecs, A.blocksize, A.numblocks, A.alignment, alpha,
+                       A.val, A.col, A.row, A.rowidx, x.major,
+                       x.val, beta, y.val, queue ));
+        }
+        else {
+            // other formats run on the device; copy result back into y
+            CHECK( magma_zmtransfer( x, &dx, x.memory_location, Magma_DEV, queue ));
+            CHECK( magma_zmtransfer( y, &dy, y.memory_location, Magma_DEV, queue ));
+            CHECK( magma_zmtransfer( A, &dA, A.memory_location, Magma_DEV, queue ));
+            CHECK( magma_z_spmv( alpha, dA, dx, beta, dy, queue ) );
+            magma_zgetvector( y.num_rows*y.num_cols, dy.dval, 1, y.val, 1, queue );
+        }
     }
 
 cleanup:
@@ -466,10 +544,17 @@ magma_z_spmv_shift(
             info = MAGMA_ERR_NOT_SUPPORTED;
         }
     }
-    // CPU case missing!
+    // CPU case
     else {
-        printf("error: CPU not yet supported.\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
+        if ( A.storage_type == Magma_CSR ) {
+            CHECK( magma_zgecsrmv_shift_cpu( MagmaNoTrans, A.num_rows, A.num_cols,
+               alpha, lambda, A.val, A.row, A.col, x.val, beta, offset,
+               blocksize, add_rows, y.val, queue ));
+        }
+        else {
+            printf("error: format not supported.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
     }
 cleanup:
     return info;
@@ -484,6 +569,8 @@ cleanup:
     For a given input matrix A and B and scalar alpha,
     the wrapper determines the suitable SpMV computing
               C = alpha * A * B.
+    On the CPU, the product is computed by magma_zspmm_cpu; on the device,
+    by cuSPARSE, which ignores alpha.
     Arguments
     ---------
 
@@ -519,9 +606,6 @@ magma_z_spmm(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    magma_z_matrix dA = {Magma_CSR};
-    magma_z_matrix dB = {Magma_CSR};
-    magma_z_matrix dC = {Magma_CSR};
     
     if ( A.memory_location != B.memory_location ) {
         printf("error: linear algebra objects are not located in same memory!\n");
@@ -546,19 +630,24 @@ magma_z_spmm(
             }
         }
     }
-    // CPU case missing!
+    // CPU case
     else {
-        A.storage_type = Magma_CSR;
-        B.storage_type = Magma_CSR;
-        CHECK( magma_zmtransfer( A, &dA, Magma_CPU, Magma_DEV, queue ) );
-        CHECK( magma_zmtransfer( B, &dB, Magma_CPU, Magma_DEV, queue ) );
-        CHECK(  magma_zcuspmm( dA, dB, &dC, queue ) );
-        CHECK( magma_zmtransfer( dC, C, Magma_DEV, Magma_CPU, queue ) );
+        if ( ( A.storage_type == Magma_CSR  ||
+               A.storage_type == Magma_CSRL ||
+               A.storage_type == Magma_CSRU ||
+               A.storage_type == Magma_CSRCOO ) &&
+             ( B.storage_type == Magma_CSR  ||
+               B.storage_type == Magma_CSRL ||
+               B.storage_type == Magma_CSRU ||
+               B.storage_type == Magma_CSRCOO ) ) {
+            CHECK( magma_zspmm_cpu( alpha, A, B, C, queue ));
+        }
+        else {
+            printf("error: format not supported.\n");
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
     }
     
 cleanup:
-    magma_zmfree( &dA, queue );
-    magma_zmfree( &dB, queue );
-    magma_zmfree( &dC, queue );
     return info;
 }
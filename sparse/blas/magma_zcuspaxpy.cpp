@@ -64,6 +64,7 @@
 
         C = alpha * A + beta * B
 
+    For matrices on the CPU, the sum is computed by magma_zspaxpy_cpu.
 
     Arguments
     ---------
@@ -196,6 +197,9 @@ magma_zcuspaxpy(
 
         CHECK( magma_zmtransfer( C, AB, Magma_DEV, Magma_DEV, queue ));
     }
+    else if ( A.memory_location == Magma_CPU && B.memory_location == Magma_CPU ) {
+        CHECK( magma_zspaxpy_cpu( *alpha, A, *beta, B, AB, queue ));
+    }
     else {
         info = MAGMA_ERR_NOT_SUPPORTED; 
     }
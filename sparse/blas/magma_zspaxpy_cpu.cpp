@@ -0,0 +1,344 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+
+*/
+#include "magmasparse_internal.h"
+
+// rows per chunk of the dynamic schedule
+#define SPAXPY_CHUNK 256
+
+
+/**
+    Purpose
+    -------
+    Returns the number of distinct columns in row i of A and B, both with
+    sorted columns. The merge advances without branching on the order.
+*/
+static magma_index_t
+spaxpy_row_count(
+    magma_index_t i,
+    magma_z_matrix A,
+    magma_z_matrix B )
+{
+    magma_index_t a = A.row[i], enda = A.row[i+1];
+    magma_index_t b = B.row[i], endb = B.row[i+1];
+    magma_index_t nz = 0;
+    while ( a < enda && b < endb ) {
+        magma_index_t ca = A.col[a], cb = B.col[b];
+        a += (ca <= cb);
+        b += (cb <= ca);
+        ++nz;
+    }
+    return nz + (enda - a) + (endb - b);
+}
+
+
+/**
+    Purpose
+    -------
+    Merges row i of alpha*A and beta*B, both with sorted columns, into
+    col[0:nz-1], val[0:nz-1], nz from spaxpy_row_count.
+*/
+static void
+spaxpy_row_merge(
+    magma_index_t i,
+    magmaDoubleComplex alpha,
+    magma_z_matrix A,
+    magmaDoubleComplex beta,
+    magma_z_matrix B,
+    magma_index_t *col,
+    magmaDoubleComplex *val )
+{
+    magma_index_t a = A.row[i], enda = A.row[i+1];
+    magma_index_t b = B.row[i], endb = B.row[i+1];
+    magma_index_t k = 0;
+    while ( a < enda && b < endb ) {
+        magma_index_t ca = A.col[a], cb = B.col[b];
+        magma_index_t c = (ca < cb ? ca : cb);
+        magmaDoubleComplex va = (ca == c ? A.val[a] : MAGMA_Z_ZERO);
+        magmaDoubleComplex vb = (cb == c ? B.val[b] : MAGMA_Z_ZERO);
+        col[k] = c;
+        val[k] = MAGMA_Z_ADD( MAGMA_Z_MUL( alpha, va ), MAGMA_Z_MUL( beta, vb ));
+        a += (ca == c);
+        b += (cb == c);
+        ++k;
+    }
+    for (; a < enda; ++a, ++k) {
+        col[k] = A.col[a];
+        val[k] = MAGMA_Z_MUL( alpha, A.val[a] );
+    }
+    for (; b < endb; ++b, ++k) {
+        col[k] = B.col[b];
+        val[k] = MAGMA_Z_MUL( beta, B.val[b] );
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Returns nonzero if the union of the columns in row i of A and B, both
+    with sorted columns, is exactly col[0:nz-1].
+*/
+static int
+spaxpy_row_match(
+    magma_index_t i,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    const magma_index_t *col,
+    magma_index_t nz )
+{
+    magma_index_t a = A.row[i], enda = A.row[i+1];
+    magma_index_t b = B.row[i], endb = B.row[i+1];
+    magma_index_t k = 0;
+    while ( a < enda || b < endb ) {
+        magma_index_t ca = (a < enda ? A.col[a] : B.col[b]);
+        magma_index_t cb = (b < endb ? B.col[b] : ca);
+        magma_index_t c = (ca < cb ? ca : cb);
+        if ( k >= nz || col[k] != c ) {
+            return 0;
+        }
+        a += (a < enda && ca == c);
+        b += (b < endb && cb == c);
+        ++k;
+    }
+    return k == nz;
+}
+
+
+/**
+    Purpose
+    -------
+    Writes the values of row i of alpha*A + beta*B into val[0:nz-1], for
+    the pattern col[0:nz-1] checked by spaxpy_row_match. col is not
+    modified.
+*/
+static void
+spaxpy_row_values(
+    magma_index_t i,
+    magmaDoubleComplex alpha,
+    magma_z_matrix A,
+    magmaDoubleComplex beta,
+    magma_z_matrix B,
+    const magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_index_t nz )
+{
+    magma_index_t a = A.row[i], enda = A.row[i+1];
+    magma_index_t b = B.row[i], endb = B.row[i+1];
+    for (magma_index_t k = 0; k < nz; ++k) {
+        magmaDoubleComplex v = MAGMA_Z_ZERO;
+        if ( a < enda && A.col[a] == col[k] ) {
+            v = MAGMA_Z_MUL( alpha, A.val[a] );
+            ++a;
+        }
+        if ( b < endb && B.col[b] == col[k] ) {
+            v = MAGMA_Z_ADD( v, MAGMA_Z_MUL( beta, B.val[b] ));
+            ++b;
+        }
+        val[k] = v;
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Returns nonzero if A and B are CSR-type matrices on the CPU with the
+    same dimensions.
+*/
+static int
+spaxpy_supported(
+    magma_z_matrix A,
+    magma_z_matrix B )
+{
+    return A.memory_location == Magma_CPU && B.memory_location == Magma_CPU
+        && ( A.storage_type == Magma_CSR  || A.storage_type == Magma_CSRL ||
+             A.storage_type == Magma_CSRU || A.storage_type == Magma_CSRCOO )
+        && ( B.storage_type == Magma_CSR  || B.storage_type == Magma_CSRL ||
+             B.storage_type == Magma_CSRU || B.storage_type == Magma_CSRCOO )
+        && A.num_rows == B.num_rows && A.num_cols == B.num_cols;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the sum of two sparse matrices in CSR format on the CPU:
+
+        AB = alpha * A + beta * B
+
+    The columns in each row of A and B have to be sorted. A first pass
+    counts the entries of each row of AB and builds the row pointer by a
+    prefix sum, a second pass merges the rows. Both are parallelized over
+    the rows with OpenMP. The pattern of AB is exactly the union of the
+    patterns of A and B, with sorted columns; entries cancelling to zero
+    are kept. Use magma_zspaxpy_values_cpu to recompute the values when
+    only the values of A or B changed.
+
+    Arguments
+    ---------
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix in CSR on the CPU
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    B           magma_z_matrix
+                input matrix in CSR on the CPU
+
+    @param[out]
+    AB          magma_z_matrix*
+                output matrix AB = alpha * A + beta * B in CSR on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspaxpy_cpu(
+    magmaDoubleComplex alpha, magma_z_matrix A,
+    magmaDoubleComplex beta, magma_z_matrix B,
+    magma_z_matrix *AB,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix C={Magma_CSR};
+    C.num_rows = A.num_rows;
+    C.num_cols = A.num_cols;
+    C.storage_type = Magma_CSR;
+    C.memory_location = Magma_CPU;
+    C.fill_mode = MagmaFull;
+
+    if ( ! spaxpy_supported( A, B ) ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // symbolic: entries per row, then row pointer
+    CHECK( magma_index_malloc_cpu( &C.row, C.num_rows+1 ));
+    #pragma omp parallel for schedule(dynamic, SPAXPY_CHUNK)
+    for (magma_int_t i = 0; i < C.num_rows; ++i) {
+        C.row[i+1] = spaxpy_row_count( i, A, B );
+    }
+    C.row[0] = 0;
+    CHECK( magma_zmatrix_createrowptr( C.num_rows, C.row, queue ));
+    C.nnz = C.row[ C.num_rows ];
+    C.true_nnz = C.nnz;
+
+    // numeric
+    CHECK( magma_index_malloc_cpu( &C.col, C.nnz ));
+    CHECK( magma_zmalloc_cpu( &C.val, C.nnz ));
+    #pragma omp parallel for schedule(dynamic, SPAXPY_CHUNK)
+    for (magma_int_t i = 0; i < C.num_rows; ++i) {
+        spaxpy_row_merge( i, alpha, A, beta, B, C.col + C.row[i], C.val + C.row[i] );
+    }
+
+    *AB = C;
+    C.row = NULL;
+    C.col = NULL;
+    C.val = NULL;
+
+cleanup:
+    magma_zmfree( &C, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Recomputes the values of AB = alpha * A + beta * B on the CPU, where
+    AB was created by magma_zspaxpy_cpu from matrices with the same
+    patterns as A and B. The pattern of AB is reused, nothing is
+    allocated, and only the values of AB are written. If the union of
+    the patterns of A and B differs from the pattern of AB, AB is left
+    unchanged and MAGMA_ERR_NOT_SUPPORTED is returned; call
+    magma_zspaxpy_cpu for a new pattern.
+
+    Arguments
+    ---------
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix in CSR on the CPU
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar
+
+    @param[in]
+    B           magma_z_matrix
+                input matrix in CSR on the CPU
+
+    @param[in,out]
+    AB          magma_z_matrix*
+                matrix from magma_zspaxpy_cpu; on exit,
+                the values of alpha * A + beta * B
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspaxpy_values_cpu(
+    magmaDoubleComplex alpha, magma_z_matrix A,
+    magmaDoubleComplex beta, magma_z_matrix B,
+    magma_z_matrix *AB,
+    magma_queue_t queue )
+{
+    magma_z_matrix C = *AB;
+    magma_int_t mismatch = 0;
+
+    if ( ! spaxpy_supported( A, B ) ||
+         C.memory_location != Magma_CPU || C.storage_type != Magma_CSR ||
+         C.num_rows != A.num_rows || C.row == NULL || C.col == NULL ||
+         C.row[0] != 0 || C.row[ C.num_rows ] != C.nnz ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    // the pattern of AB has to be the union of the patterns of A and B,
+    // checked for all rows before any value is written
+    #pragma omp parallel for schedule(dynamic, SPAXPY_CHUNK) reduction(+:mismatch)
+    for (magma_int_t i = 0; i < C.num_rows; ++i) {
+        magma_index_t nz = C.row[i+1] - C.row[i];
+        mismatch += ( nz < 0 || ! spaxpy_row_match( i, A, B, C.col + C.row[i], nz ));
+    }
+    if ( mismatch != 0 ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    #pragma omp parallel for schedule(dynamic, SPAXPY_CHUNK)
+    for (magma_int_t i = 0; i < C.num_rows; ++i) {
+        spaxpy_row_values( i, alpha, A, beta, B, C.col + C.row[i], C.val + C.row[i],
+                           C.row[i+1] - C.row[i] );
+    }
+    return MAGMA_SUCCESS;
+}
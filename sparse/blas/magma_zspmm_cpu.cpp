@@ -0,0 +1,384 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+
+*/
+#include <algorithm>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+// rows with more than num_cols / SPMM_DENSE_RATIO candidate entries
+// accumulate into a dense row of length num_cols instead of a hash table
+#define SPMM_DENSE_RATIO 8
+
+// rows per chunk of the dynamic schedule
+#define SPMM_CHUNK 32
+
+
+/**
+    Purpose
+    -------
+    Returns the accumulator for row i of A*B: 0 if the row is empty,
+    -1 for a dense accumulator, otherwise the hash table size, the
+    smallest power of two of at least twice the number of products
+    flowing into the row (bounded by B.num_cols).
+*/
+static magma_index_t
+spmm_row_table(
+    magma_index_t i,
+    magma_z_matrix A,
+    magma_z_matrix B )
+{
+    int64_t bound = 0;
+    for (magma_index_t k = A.row[i]; k < A.row[i+1]; ++k) {
+        magma_index_t j = A.col[k];
+        bound += B.row[j+1] - B.row[j];
+    }
+    if ( bound > B.num_cols )
+        bound = B.num_cols;
+    if ( bound == 0 )
+        return 0;
+    if ( bound * SPMM_DENSE_RATIO > B.num_cols )
+        return -1;
+    magma_index_t size = 16;
+    while ( size < 2*bound )
+        size *= 2;
+    return size;
+}
+
+
+/**
+    Purpose
+    -------
+    Slot of column c in a hash table with size entries, size a power of two.
+*/
+static inline magma_index_t
+spmm_hash(
+    magma_index_t c,
+    magma_index_t size )
+{
+    return magma_index_t( (uint32_t( c ) * 2654435761u) & uint32_t( size - 1 ) );
+}
+
+
+/**
+    Purpose
+    -------
+    Symbolic phase: counts the distinct columns of row i of A*B.
+    key (hash table, all -1 on entry and exit) or mark (dense, entries
+    different from i on entry) track the columns seen.
+*/
+static magma_index_t
+spmm_row_count(
+    magma_index_t i,
+    magma_index_t table,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_index_t *key,
+    magma_index_t *mark )
+{
+    magma_index_t nz = 0;
+    if ( table < 0 ) {
+        for (magma_index_t k = A.row[i]; k < A.row[i+1]; ++k) {
+            magma_index_t j = A.col[k];
+            for (magma_index_t l = B.row[j]; l < B.row[j+1]; ++l) {
+                magma_index_t c = B.col[l];
+                if ( mark[c] != i ) {
+                    mark[c] = i;
+                    ++nz;
+                }
+            }
+        }
+    }
+    else if ( table > 0 ) {
+        for (magma_index_t k = A.row[i]; k < A.row[i+1]; ++k) {
+            magma_index_t j = A.col[k];
+            for (magma_index_t l = B.row[j]; l < B.row[j+1]; ++l) {
+                magma_index_t c = B.col[l];
+                magma_index_t h = spmm_hash( c, table );
+                while ( key[h] != c && key[h] != -1 )
+                    h = (h + 1) & (table - 1);
+                if ( key[h] == -1 ) {
+                    key[h] = c;
+                    ++nz;
+                }
+            }
+        }
+        for (magma_index_t h = 0; h < table; ++h)
+            key[h] = -1;
+    }
+    return nz;
+}
+
+
+/**
+    Purpose
+    -------
+    Numeric phase: computes row i of alpha*A*B into col[0:nz-1],
+    val[0:nz-1] with sorted column indices, nz from the symbolic phase.
+    Uses the hash table key/hval or the dense row mark/dval as in
+    spmm_row_count.
+*/
+static void
+spmm_row_compute(
+    magma_index_t i,
+    magma_index_t table,
+    magmaDoubleComplex alpha,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_index_t *key,
+    magmaDoubleComplex *hval,
+    magma_index_t *mark,
+    magmaDoubleComplex *dval,
+    magma_index_t *col,
+    magmaDoubleComplex *val )
+{
+    magma_index_t nz = 0;
+    if ( table < 0 ) {
+        for (magma_index_t k = A.row[i]; k < A.row[i+1]; ++k) {
+            magma_index_t j = A.col[k];
+            magmaDoubleComplex a = MAGMA_Z_MUL( alpha, A.val[k] );
+            for (magma_index_t l = B.row[j]; l < B.row[j+1]; ++l) {
+                magma_index_t c = B.col[l];
+                if ( mark[c] != i ) {
+                    mark[c] = i;
+                    dval[c] = MAGMA_Z_MUL( a, B.val[l] );
+                    col[nz++] = c;
+                }
+                else {
+                    dval[c] = MAGMA_Z_ADD( dval[c], MAGMA_Z_MUL( a, B.val[l] ));
+                }
+            }
+        }
+        std::sort( col, col + nz );
+        for (magma_index_t k = 0; k < nz; ++k)
+            val[k] = dval[ col[k] ];
+    }
+    else if ( table > 0 ) {
+        for (magma_index_t k = A.row[i]; k < A.row[i+1]; ++k) {
+            magma_index_t j = A.col[k];
+            magmaDoubleComplex a = MAGMA_Z_MUL( alpha, A.val[k] );
+            for (magma_index_t l = B.row[j]; l < B.row[j+1]; ++l) {
+                magma_index_t c = B.col[l];
+                magma_index_t h = spmm_hash( c, table );
+                while ( key[h] != c && key[h] != -1 )
+                    h = (h + 1) & (table - 1);
+                if ( key[h] == -1 ) {
+                    key[h] = c;
+                    hval[h] = MAGMA_Z_MUL( a, B.val[l] );
+                    col[nz++] = c;
+                }
+                else {
+                    hval[h] = MAGMA_Z_ADD( hval[h], MAGMA_Z_MUL( a, B.val[l] ));
+                }
+            }
+        }
+        std::sort( col, col + nz );
+        for (magma_index_t k = 0; k < nz; ++k) {
+            magma_index_t h = spmm_hash( col[k], table );
+            while ( key[h] != col[k] )
+                h = (h + 1) & (table - 1);
+            val[k] = hval[h];
+        }
+        for (magma_index_t h = 0; h < table; ++h)
+            key[h] = -1;
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Computes the product AB = alpha * A * B of two sparse matrices in CSR
+    format on the CPU.
+
+    The product is formed in two passes over the rows, split dynamically
+    among the OpenMP threads. The symbolic pass counts the nonzeros of
+    each row of AB, the numeric pass computes them. Each thread
+    accumulates a row either in a hash table sized by the number of
+    products flowing into the row, or, for rows that may fill more than
+    1/SPMM_DENSE_RATIO of the columns, in a dense row. The columns of AB
+    are sorted in each row.
+
+    Arguments
+    ---------
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar alpha
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix in CSR on the CPU
+
+    @param[in]
+    B           magma_z_matrix
+                input matrix in CSR on the CPU
+
+    @param[out]
+    AB          magma_z_matrix*
+                output matrix AB = alpha * A * B in CSR on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zspmm_cpu(
+    magmaDoubleComplex alpha,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *AB,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t failed = 0;
+    magma_index_t *table = NULL;
+    magma_index_t maxtable = 0;
+    int anydense = 0;
+
+    magma_z_matrix C={Magma_CSR};
+    C.num_rows = A.num_rows;
+    C.num_cols = B.num_cols;
+    C.storage_type = Magma_CSR;
+    C.memory_location = Magma_CPU;
+    C.fill_mode = MagmaFull;
+
+    if (    A.memory_location != Magma_CPU
+        || B.memory_location != Magma_CPU
+        || ( A.storage_type != Magma_CSR  && A.storage_type != Magma_CSRL &&
+             A.storage_type != Magma_CSRU && A.storage_type != Magma_CSRCOO )
+        || ( B.storage_type != Magma_CSR  && B.storage_type != Magma_CSRL &&
+             B.storage_type != Magma_CSRU && B.storage_type != Magma_CSRCOO ) )
+    {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    if ( A.num_cols != B.num_rows ) {
+        printf("%%  error: dimensions of A and B do not match.\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // accumulator of each row, from the number of products in the row
+    CHECK( magma_index_malloc_cpu( &table, A.num_rows+1 ));
+    CHECK( magma_index_malloc_cpu( &C.row, A.num_rows+1 ));
+    #pragma omp parallel for reduction(max:maxtable) reduction(|:anydense)
+    for (magma_int_t i = 0; i < A.num_rows; ++i) {
+        table[i] = spmm_row_table( i, A, B );
+        if ( table[i] > maxtable )
+            maxtable = table[i];
+        if ( table[i] < 0 )
+            anydense = 1;
+    }
+
+    // symbolic: nonzeros per row of AB
+    #pragma omp parallel
+    {
+        magma_index_t *key = NULL, *mark = NULL;
+        magma_int_t err = 0;
+        if ( maxtable > 0 )
+            err |= magma_index_malloc_cpu( &key, maxtable );
+        if ( anydense )
+            err |= magma_index_malloc_cpu( &mark, B.num_cols );
+        if ( err != 0 ) {
+            #pragma omp atomic write
+            failed = 1;
+        }
+        else {
+            for (magma_index_t h = 0; h < maxtable; ++h)
+                key[h] = -1;
+            if ( anydense ) {
+                for (magma_int_t c = 0; c < B.num_cols; ++c)
+                    mark[c] = -1;
+            }
+        }
+        #pragma omp barrier
+        if ( ! failed ) {
+            #pragma omp for schedule(dynamic, SPMM_CHUNK)
+            for (magma_int_t i = 0; i < A.num_rows; ++i) {
+                C.row[i+1] = spmm_row_count( i, table[i], A, B, key, mark );
+            }
+        }
+        magma_free_cpu( key );
+        magma_free_cpu( mark );
+    }
+    if ( failed ) {
+        info = MAGMA_ERR_HOST_ALLOC;
+        goto cleanup;
+    }
+
+    C.row[0] = 0;
+    CHECK( magma_zmatrix_createrowptr( C.num_rows, C.row, queue ));
+    C.nnz = C.row[ C.num_rows ];
+    C.true_nnz = C.nnz;
+    CHECK( magma_index_malloc_cpu( &C.col, C.nnz ));
+    CHECK( magma_zmalloc_cpu( &C.val, C.nnz ));
+
+    // numeric: rows of AB
+    #pragma omp parallel
+    {
+        magma_index_t *key = NULL, *mark = NULL;
+        magmaDoubleComplex *hval = NULL, *dval = NULL;
+        magma_int_t err = 0;
+        if ( maxtable > 0 ) {
+            err |= magma_index_malloc_cpu( &key, maxtable );
+            err |= magma_zmalloc_cpu( &hval, maxtable );
+        }
+        if ( anydense ) {
+            err |= magma_index_malloc_cpu( &mark, B.num_cols );
+            err |= magma_zmalloc_cpu( &dval, B.num_cols );
+        }
+        if ( err != 0 ) {
+            #pragma omp atomic write
+            failed = 1;
+        }
+        else {
+            for (magma_index_t h = 0; h < maxtable; ++h)
+                key[h] = -1;
+            if ( anydense ) {
+                for (magma_int_t c = 0; c < B.num_cols; ++c)
+                    mark[c] = -1;
+            }
+        }
+        #pragma omp barrier
+        if ( ! failed ) {
+            #pragma omp for schedule(dynamic, SPMM_CHUNK)
+            for (magma_int_t i = 0; i < A.num_rows; ++i) {
+                spmm_row_compute( i, table[i], alpha, A, B, key, hval, mark, dval,
+                                  C.col + C.row[i], C.val + C.row[i] );
+            }
+        }
+        magma_free_cpu( key );
+        magma_free_cpu( hval );
+        magma_free_cpu( mark );
+        magma_free_cpu( dval );
+    }
+    if ( failed ) {
+        info = MAGMA_ERR_HOST_ALLOC;
+        goto cleanup;
+    }
+
+    *AB = C;
+    C.row = NULL;
+    C.col = NULL;
+    C.val = NULL;
+
+cleanup:
+    magma_free_cpu( table );
+    magma_zmfree( &C, queue );
+    return info;
+}
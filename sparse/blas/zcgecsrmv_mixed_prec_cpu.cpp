@@ -0,0 +1,335 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions mixed zc -> ds
+
+*/
+#include "magmasparse_internal.h"
+
+#define PRECISION_z
+
+// rows per block sharing one column base in lcolbase
+#define MIXED_BLOCK_ROWS 64
+
+// largest column offset from the block base that fits in lcol
+#define MIXED_MAX_OFFSET 65535
+
+
+/**
+    Purpose
+    -------
+    Returns the dot product of row entries val[start:end-1], stored in
+    single precision, with x, gathered by col if lcol is NULL, else by
+    base + lcol. The products are accumulated in double precision.
+*/
+static inline magmaDoubleComplex
+mixed_row_dot(
+    magma_index_t start,
+    magma_index_t end,
+    const magmaFloatComplex *val,
+    const magma_index_t *col,
+    const unsigned short *lcol,
+    magma_index_t base,
+    const magmaDoubleComplex *x )
+{
+    #if defined(PRECISION_z)
+    double re = 0, im = 0;
+    if ( lcol != NULL ) {
+        const magmaDoubleComplex *xb = x + base;
+        #pragma omp simd reduction(+:re,im)
+        for (magma_index_t j = start; j < end; ++j) {
+            double ar = MAGMA_C_REAL( val[j] ), ai = MAGMA_C_IMAG( val[j] );
+            magmaDoubleComplex b = xb[ lcol[j] ];
+            re += ar*MAGMA_Z_REAL(b) - ai*MAGMA_Z_IMAG(b);
+            im += ar*MAGMA_Z_IMAG(b) + ai*MAGMA_Z_REAL(b);
+        }
+    }
+    else {
+        #pragma omp simd reduction(+:re,im)
+        for (magma_index_t j = start; j < end; ++j) {
+            double ar = MAGMA_C_REAL( val[j] ), ai = MAGMA_C_IMAG( val[j] );
+            magmaDoubleComplex b = x[ col[j] ];
+            re += ar*MAGMA_Z_REAL(b) - ai*MAGMA_Z_IMAG(b);
+            im += ar*MAGMA_Z_IMAG(b) + ai*MAGMA_Z_REAL(b);
+        }
+    }
+    return MAGMA_Z_MAKE( re, im );
+    #else
+    magmaDoubleComplex dot = MAGMA_Z_ZERO;
+    if ( lcol != NULL ) {
+        const magmaDoubleComplex *xb = x + base;
+        #pragma omp simd reduction(+:dot)
+        for (magma_index_t j = start; j < end; ++j) {
+            dot += magmaDoubleComplex( val[j] ) * xb[ lcol[j] ];
+        }
+    }
+    else {
+        #pragma omp simd reduction(+:dot)
+        for (magma_index_t j = start; j < end; ++j) {
+            dot += magmaDoubleComplex( val[j] ) * x[ col[j] ];
+        }
+    }
+    return dot;
+    #endif
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU, where
+    the values of the CSR matrix A are stored in single precision and the
+    products are accumulated in double precision. This halves the traffic
+    for the values compared to magma_zgecsrmv_cpu. Optionally, the column
+    indices of a block of 64 rows are stored as 16-bit offsets from a
+    column base per block, which halves the traffic for the indices of
+    that block. The arrays are built by magma_zcmixed_prec_setup_cpu.
+    Blocks of rows are distributed among OpenMP threads. If beta is zero,
+    y need not be initialized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaFloatComplex*
+                array containing values of A in CSR, in single precision
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in CSR
+
+    @param[in]
+    lcol        unsigned short*
+                column offsets from lcolbase, or NULL
+
+    @param[in]
+    lcolbase    magma_index_t*
+                column base for each block of 64 rows, or -1 if the block
+                uses col; NULL if lcol is NULL
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcgecsrmv_mixed_prec_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaFloatComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const unsigned short *lcol,
+    const magma_index_t *lcolbase,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+    magma_int_t blocks = magma_ceildiv( m, MIXED_BLOCK_ROWS );
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (magma_int_t b = 0; b < blocks; ++b) {
+        magma_index_t base = (lcol != NULL ? lcolbase[b] : -1);
+        const unsigned short *bcol = (base >= 0 ? lcol : NULL);
+        magma_int_t last = min( m, (b+1)*MIXED_BLOCK_ROWS );
+        for (magma_int_t i = b*MIXED_BLOCK_ROWS; i < last; ++i) {
+            magmaDoubleComplex dot = mixed_row_dot( row[i], row[i+1], val, col, bcol, base, x );
+            if ( beta_zero )
+                y[i] = alpha * dot;
+            else
+                y[i] = alpha * dot + beta * y[i];
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Prepares a CSR matrix on the CPU for magma_zcgecsrmv_mixed_prec_cpu:
+    stores a single-precision copy of the values in A->lval and, if
+    packcols is set, 16-bit column offsets in A->lcol with a column base
+    per block of 64 rows in A->lcolbase. A block whose columns span more
+    than 65536 keeps using A->col; its base is -1. magma_z_spmv then uses
+    the mixed-precision kernel for A. Arrays from an earlier call are
+    replaced. The copies have to be rebuilt when the values of A change;
+    free them with magma_zcmixed_prec_free_cpu, or magma_zmfree.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix in CSR on the CPU
+
+    @param[in]
+    packcols    magma_int_t
+                if nonzero, also store 16-bit column offsets
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcmixed_prec_setup_cpu(
+    magma_z_matrix *A,
+    magma_int_t packcols,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magmaFloatComplex *lval = NULL;
+    unsigned short *lcol = NULL;
+    magma_index_t *lcolbase = NULL;
+    magma_int_t blocks = magma_ceildiv( A->num_rows, MIXED_BLOCK_ROWS );
+    magma_int_t packed = 0;
+
+    if ( A->memory_location != Magma_CPU ||
+         ( A->storage_type != Magma_CSR  &&
+           A->storage_type != Magma_CSRL &&
+           A->storage_type != Magma_CSRU ) ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_cmalloc_cpu( &lval, A->nnz ));
+    #pragma omp parallel for
+    for (magma_int_t k = 0; k < A->nnz; ++k) {
+        lval[k] = MAGMA_C_MAKE( (float) MAGMA_Z_REAL( A->val[k] ),
+                                (float) MAGMA_Z_IMAG( A->val[k] ));
+    }
+
+    if ( packcols ) {
+        CHECK( magma_malloc_cpu( (void**) &lcol, A->nnz*sizeof(unsigned short) ));
+        CHECK( magma_index_malloc_cpu( &lcolbase, blocks ));
+        #pragma omp parallel for schedule(dynamic, 16) reduction(+:packed)
+        for (magma_int_t b = 0; b < blocks; ++b) {
+            magma_index_t start = A->row[ b*MIXED_BLOCK_ROWS ];
+            magma_index_t end = A->row[ min( A->num_rows, (b+1)*MIXED_BLOCK_ROWS ) ];
+            magma_index_t lo = A->num_cols, hi = 0;
+            for (magma_index_t k = start; k < end; ++k) {
+                lo = min( lo, A->col[k] );
+                hi = max( hi, A->col[k] );
+            }
+            if ( start < end && hi - lo <= MIXED_MAX_OFFSET ) {
+                for (magma_index_t k = start; k < end; ++k) {
+                    lcol[k] = (unsigned short) (A->col[k] - lo);
+                }
+                lcolbase[b] = lo;
+                packed++;
+            }
+            else {
+                lcolbase[b] = -1;
+            }
+        }
+        // nothing to gain if no block fits
+        if ( packed == 0 ) {
+            magma_free_cpu( lcol );
+            magma_free_cpu( lcolbase );
+            lcol = NULL;
+            lcolbase = NULL;
+        }
+    }
+
+    magma_zcmixed_prec_free_cpu( A, queue );
+    A->lval = lval;
+    A->lcol = lcol;
+    A->lcolbase = lcolbase;
+    lval = NULL;
+    lcol = NULL;
+    lcolbase = NULL;
+
+cleanup:
+    magma_free_cpu( lval );
+    magma_free_cpu( lcol );
+    magma_free_cpu( lcolbase );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Frees the arrays built by magma_zcmixed_prec_setup_cpu, so magma_z_spmv
+    uses the values of A in double precision again. The other arrays of A
+    are not touched.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    A           magma_z_matrix*
+                matrix in CSR on the CPU
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcmixed_prec_free_cpu(
+    magma_z_matrix *A,
+    magma_queue_t queue )
+{
+    magma_free_cpu( A->lval );
+    magma_free_cpu( A->lcol );
+    magma_free_cpu( A->lcolbase );
+    A->lval = NULL;
+    A->lcol = NULL;
+    A->lcolbase = NULL;
+    return MAGMA_SUCCESS;
+}
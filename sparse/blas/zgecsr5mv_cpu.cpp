@@ -0,0 +1,348 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+
+// CSR5 SpMV on the CPU, using the tiles built by magma_zmconvert.
+// see paper by W. Liu and B. Vinter. (2015).
+// "CSR5: An Efficient Storage Format for Cross-Platform
+//  Sparse Matrix-Vector Multiplication".
+// 29th ACM International Conference on Supercomputing (ICS15). pp. 339-350.
+
+#include "magmasparse_internal.h"
+
+#define COMPLEX
+
+#define OMEGA MAGMA_CSR5_OMEGA
+
+
+/**
+    Purpose
+    -------
+    Returns alpha times the sum of all entries of a tile lying in a single
+    row (fast track); the tile layout does not matter.
+*/
+static inline magmaDoubleComplex
+csr5_tile_sum(
+    magma_int_t count,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex alpha )
+{
+    #ifdef COMPLEX
+    double re = 0, im = 0;
+    #pragma omp simd reduction(+:re,im)
+    for (magma_int_t j = 0; j < count; ++j) {
+        magmaDoubleComplex a = val[j], b = x[ col[j] ];
+        re += MAGMA_Z_REAL(a)*MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a)*MAGMA_Z_IMAG(b);
+        im += MAGMA_Z_REAL(a)*MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a)*MAGMA_Z_REAL(b);
+    }
+    return alpha * MAGMA_Z_MAKE( re, im );
+    #else
+    magmaDoubleComplex sum = MAGMA_Z_ZERO;
+    #pragma omp simd reduction(+:sum)
+    for (magma_int_t j = 0; j < count; ++j) {
+        sum += val[j] * x[ col[j] ];
+    }
+    return alpha * sum;
+    #endif
+}
+
+
+/**
+    Purpose
+    -------
+    Adds alpha * A * x for one tile of a CSR5 matrix to y, as the GPU
+    kernel does with one warp. The OMEGA lanes of the tile are processed
+    together: entry i of every lane is contiguous (the tile is column-major),
+    and the bit flags of tile_desc mark where rows start. Each lane adds the
+    rows it completes to y directly; the partial rows a lane starts with are
+    collected by a segmented sum into the lane holding the row start. The
+    sum for the tile's first row, which may begin in an earlier tile, goes
+    to calibrator[par_id] instead.
+*/
+static void
+csr5_tile(
+    magma_index_t par_id,
+    magma_int_t sigma,
+    magma_int_t bit_y_offset,
+    magma_int_t bit_scansum_offset,
+    magma_int_t num_packet,
+    const magma_uindex_t *tile_ptr,
+    const magma_uindex_t *tile_desc,
+    const magma_index_t *tile_desc_offset_ptr,
+    const magma_index_t *tile_desc_offset,
+    magmaDoubleComplex *calibrator,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex *y )
+{
+    const magma_int_t tile = OMEGA * sigma;
+    const magma_int_t bit_all_offset = bit_y_offset + bit_scansum_offset;
+    val += par_id * tile;
+    col += par_id * tile;
+
+    magma_uindex_t row_start = tile_ptr[ par_id ];
+    magma_uindex_t row_stop  = tile_ptr[ par_id+1 ] & 0x7FFFFFFF;
+    if ( row_start == row_stop ) {
+        calibrator[ par_id ] = csr5_tile_sum( tile, val, col, x, alpha );
+        return;
+    }
+    bool empty_rows = (row_start >> 31) & 0x1;
+    row_start &= 0x7FFFFFFF;
+
+    // rows are numbered from row_start+1; with empty rows, through a map
+    magmaDoubleComplex *yt = y + row_start + 1;
+    const magma_index_t *row_map = (empty_rows
+                                    ? tile_desc_offset + tile_desc_offset_ptr[ par_id ]
+                                    : NULL);
+    const magma_uindex_t *desc = tile_desc + par_id * OMEGA * num_packet;
+
+    magmaDoubleComplex sum[OMEGA], first_sum[OMEGA], seg[OMEGA];
+    magma_index_t y_offset[OMEGA];
+    int scansum_offset[OMEGA], start[OMEGA], stop[OMEGA], direct[OMEGA];
+
+    // entry 0 of each lane; the tile's first entry always starts a row
+    #pragma omp simd
+    for (int lane = 0; lane < OMEGA; ++lane) {
+        magma_uindex_t d = desc[ lane ];
+        y_offset[lane]       = d >> (32 - bit_y_offset);
+        scansum_offset[lane] = (d << bit_y_offset) >> (32 - bit_scansum_offset);
+        int bit = (lane == 0 ? 1 : (d >> (31 - bit_all_offset)) & 0x1);
+        start[lane]     = ! bit;
+        direct[lane]    = bit && lane;
+        stop[lane]      = 0;
+        sum[lane]       = val[ lane ] * x[ col[ lane ] ];
+        first_sum[lane] = MAGMA_Z_ZERO;
+    }
+
+    // entries 1, ..., sigma-1: a set bit ends the lane's current segment
+    for (magma_int_t i = 1; i < sigma; ++i) {
+        const magma_int_t bit_pos = i + bit_all_offset;
+        const magma_uindex_t *packet = desc + (bit_pos / 32) * OMEGA;
+        const int shift = 31 - bit_pos % 32;
+        const magmaDoubleComplex *vi = val + i * OMEGA;
+        const magma_index_t      *ci = col + i * OMEGA;
+        #pragma omp simd
+        for (int lane = 0; lane < OMEGA; ++lane) {
+            int bit = (packet[ lane ] >> shift) & 0x1;
+            if ( bit ) {
+                if ( direct[lane] ) {
+                    magma_index_t r = y_offset[lane];
+                    yt[ row_map ? row_map[r] : r ] += alpha * sum[lane];
+                }
+                else {
+                    first_sum[lane] = sum[lane];
+                }
+                y_offset[lane] += direct[lane];
+                direct[lane] = 1;
+                sum[lane] = MAGMA_Z_ZERO;
+                stop[lane] += 1;
+            }
+            sum[lane] += vi[ lane ] * x[ ci[ lane ] ];
+        }
+    }
+
+    // a lane without row starts is one segment, continuing an earlier row
+    for (int lane = 0; lane < OMEGA; ++lane) {
+        if ( ! direct[lane] )
+            first_sum[lane] = sum[lane];
+        seg[lane] = (start[lane] ? first_sum[lane] : MAGMA_Z_ZERO);
+    }
+
+    // segmented sum: a lane's last row continues through the following
+    // scansum_offset lanes, and into the first segment of the next lane
+    for (int lane = 0; lane < OMEGA; ++lane) {
+        if ( start[lane] <= stop[lane] ) {
+            int last = lane + 1 + scansum_offset[lane];
+            last = (last < OMEGA ? last : OMEGA - 1);
+            for (int k = lane + 1; k <= last; ++k) {
+                sum[lane] += seg[k];
+            }
+        }
+        if ( direct[lane] ) {
+            magma_index_t r = y_offset[lane];
+            yt[ row_map ? row_map[r] : r ] += alpha * sum[lane];
+        }
+    }
+
+    calibrator[ par_id ] = alpha * (direct[0] ? first_sum[0] : sum[0]);
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    The input format is CSR5, as built by magma_zmconvert: val and col
+    are column-major within each tile of OMEGA * sigma nonzeros, and
+    tile_ptr, tile_desc give the rows of each tile.
+
+    Tiles have the same number of nonzeros, so they are split evenly among
+    OpenMP threads regardless of row lengths; each thread writes the rows
+    that start in its tiles. Then sums of rows spanning several tiles are
+    added from the calibrator, and the last tile is done by rows as in CSR.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    p           magma_int_t
+                number of tiles in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    sigma       magma_int_t
+                sigma in A in CSR5
+
+    @param[in]
+    bit_y_offset magma_int_t
+                 bit_y_offset in A in CSR5
+
+    @param[in]
+    bit_scansum_offset  magma_int_t
+                        bit_scansum_offset in A in CSR5
+
+    @param[in]
+    num_packet  magma_int_t
+                num_packet in A in CSR5
+
+    @param[in]
+    tile_ptr    magma_uindex_t*
+                tilepointer of A in CSR5
+
+    @param[in]
+    tile_desc   magma_uindex_t*
+                tiledescriptor of A in CSR5
+
+    @param[in]
+    tile_desc_offset_ptr   magma_index_t*
+                           tiledescriptor_offsetpointer of A in CSR5
+
+    @param[in]
+    tile_desc_offset       magma_index_t*
+                           tiledescriptor_offset of A in CSR5
+
+    @param[out]
+    calibrator  magmaDoubleComplex*
+                calibrator of A in CSR5, used as workspace
+
+    @param[in]
+    tail_tile_start   magma_int_t
+                      start of the last tile in A
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR5
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in CSR5
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsr5mv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t p,
+    magmaDoubleComplex alpha,
+    magma_int_t sigma,
+    magma_int_t bit_y_offset,
+    magma_int_t bit_scansum_offset,
+    magma_int_t num_packet,
+    const magma_uindex_t *tile_ptr,
+    const magma_uindex_t *tile_desc,
+    const magma_index_t *tile_desc_offset_ptr,
+    const magma_index_t *tile_desc_offset,
+    magmaDoubleComplex *calibrator,
+    magma_int_t tail_tile_start,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    // phase 1. y = beta * y
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+    #pragma omp parallel for
+    for (magma_int_t i = 0; i < m; ++i) {
+        y[i] = (beta_zero ? MAGMA_Z_ZERO : beta * y[i]);
+    }
+    if ( p < 1 ) {
+        return MAGMA_SUCCESS;
+    }
+
+    // phase 2. y += alpha * A * x for all but the last tile
+    #pragma omp parallel for schedule(static)
+    for (magma_int_t par_id = 0; par_id < p-1; ++par_id) {
+        csr5_tile( par_id, sigma, bit_y_offset, bit_scansum_offset, num_packet,
+                   tile_ptr, tile_desc, tile_desc_offset_ptr, tile_desc_offset,
+                   calibrator, val, col, x, alpha, y );
+    }
+
+    // phase 3. add the first row of each tile; O(p), so done sequentially
+    for (magma_int_t par_id = 0; par_id < p-1; ++par_id) {
+        y[ tile_ptr[ par_id ] & 0x7FFFFFFF ] += calibrator[ par_id ];
+    }
+
+    // phase 4. the last tile, by rows; its first row may begin earlier
+    for (magma_int_t i = tail_tile_start; i < m; ++i) {
+        magma_index_t first = (i == tail_tile_start
+                               ? magma_index_t( (p-1) * OMEGA * sigma ) : row[i]);
+        y[i] += csr5_tile_sum( row[i+1] - first, val + first, col + first, x, alpha );
+    }
+    return MAGMA_SUCCESS;
+}
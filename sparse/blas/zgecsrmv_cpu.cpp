@@ -0,0 +1,574 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+#define COMPLEX
+
+
+/**
+    Purpose
+    -------
+    Returns the first row of part p when rows of a CSR matrix are split
+    into nparts ranges with about the same work, counting each nonzero and
+    each row as one unit, so threads are balanced for matrices with very
+    uneven rows. Part p is rows start(p), ..., start(p+1)-1.
+*/
+static magma_index_t
+csr_part_start(
+    magma_int_t m,
+    const magma_index_t *row,
+    magma_int_t p,
+    magma_int_t nparts )
+{
+    if ( p >= nparts )
+        return magma_index_t( m );
+    // first row i with (row[i] - row[0]) + i >= target; binary search
+    int64_t target = (int64_t( row[m] - row[0] ) + m) * p / nparts;
+    magma_index_t lo = 0, hi = magma_index_t( m );
+    while ( lo < hi ) {
+        magma_index_t mid = lo + (hi - lo) / 2;
+        if ( int64_t( row[mid] - row[0] ) + mid < target )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+/**
+    Purpose
+    -------
+    Returns the dot product of row entries val[start:end-1] with x,
+    gathered by col. Real and imaginary parts are summed separately,
+    so the loop vectorizes.
+*/
+static inline magmaDoubleComplex
+csr_row_dot(
+    magma_index_t start,
+    magma_index_t end,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x )
+{
+    #ifdef COMPLEX
+    double re = 0, im = 0;
+    #pragma omp simd reduction(+:re,im)
+    for (magma_index_t j = start; j < end; ++j) {
+        magmaDoubleComplex a = val[j], b = x[ col[j] ];
+        re += MAGMA_Z_REAL(a)*MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a)*MAGMA_Z_IMAG(b);
+        im += MAGMA_Z_REAL(a)*MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a)*MAGMA_Z_REAL(b);
+    }
+    return MAGMA_Z_MAKE( re, im );
+    #else
+    magmaDoubleComplex dot = MAGMA_Z_ZERO;
+    #pragma omp simd reduction(+:dot)
+    for (magma_index_t j = start; j < end; ++j) {
+        dot += val[j] * x[ col[j] ];
+    }
+    return dot;
+    #endif
+}
+
+
+/**
+    Purpose
+    -------
+    Computes y = alpha * A^T * x + beta * y, or with A^H, for an m x n CSR
+    matrix A. Each thread accumulates its rows' contributions in its own
+    length n workspace; these are then summed by column.
+*/
+static magma_int_t
+csrmv_trans(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    magma_int_t info = 0;
+    magma_int_t nthreads = 1;
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    magmaDoubleComplex *work = NULL;
+    bool conjugate = (transA == MagmaConjTrans);
+
+    CHECK( magma_zmalloc_cpu( &work, n*nthreads ));
+
+    #pragma omp parallel num_threads( nthreads )
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        magma_index_t first = csr_part_start( m, row, t,   nt );
+        magma_index_t last  = csr_part_start( m, row, t+1, nt );
+
+        magmaDoubleComplex *w = work + t*n;
+        for (magma_int_t j = 0; j < n; ++j) {
+            w[j] = MAGMA_Z_ZERO;
+        }
+        for (magma_index_t i = first; i < last; ++i) {
+            magmaDoubleComplex xi = x[i];
+            for (magma_index_t k = row[i]; k < row[i+1]; ++k) {
+                w[ col[k] ] += (conjugate ? MAGMA_Z_CONJ( val[k] ) : val[k]) * xi;
+            }
+        }
+        #pragma omp barrier
+
+        #pragma omp for
+        for (magma_int_t j = 0; j < n; ++j) {
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            for (magma_int_t s = 0; s < nt; ++s) {
+                sum += work[ s*n + j ];
+            }
+            if ( MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO ))
+                y[j] = alpha * sum;
+            else
+                y[j] = alpha * sum + beta * y[j];
+        }
+    }
+
+cleanup:
+    magma_free_cpu( work );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    The input format is CSR (val, row, col).
+    Rows are split among OpenMP threads in ranges with about the same
+    number of nonzeros. If beta is zero, y need not be initialized.
+
+    For transA = MagmaTrans or MagmaConjTrans, computes
+    y = alpha * A^T * x + beta * y, or with A^H, where y has length n.
+    Used for CSC matrices, whose arrays are the CSR arrays of A^T.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans ) {
+        return csrmv_trans( transA, m, n, alpha, val, row, col, x, beta, y );
+    }
+
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+    #pragma omp parallel
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        // each thread finds its own range, without synchronization
+        magma_index_t first = csr_part_start( m, row, t,   nt );
+        magma_index_t last  = csr_part_start( m, row, t+1, nt );
+        for (magma_index_t i = first; i < last; ++i) {
+            magmaDoubleComplex dot = csr_row_dot( row[i], row[i+1], val, col, x );
+            if ( beta_zero )
+                y[i] = alpha * dot;
+            else
+                y[i] = alpha * dot + beta * y[i];
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+    Computes rows i of Y = alpha * A * X + beta * Y for vectors v0, ...,
+    v0+NV-1, keeping the NV sums in registers, so each entry of row i is
+    loaded once for all NV vectors. X is n x num_vecs, row-major if
+    row_major, else column-major; Y is m x num_vecs, column-major.
+*/
+template< int NV, bool row_major >
+static inline void
+csrmm_row(
+    magma_index_t i,
+    magma_int_t v0,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    bool beta_zero,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    magmaDoubleComplex sum[NV];
+    for (int v = 0; v < NV; ++v) {
+        sum[v] = MAGMA_Z_ZERO;
+    }
+    for (magma_index_t k = row[i]; k < row[i+1]; ++k) {
+        magmaDoubleComplex a = val[k];
+        const magmaDoubleComplex *xk = (row_major ? x + col[k]*num_vecs + v0
+                                                  : x + col[k] + v0*n);
+        #pragma omp simd
+        for (int v = 0; v < NV; ++v) {
+            sum[v] += a * xk[ row_major ? v : v*n ];
+        }
+    }
+    for (int v = 0; v < NV; ++v) {
+        magmaDoubleComplex *yv = y + i + (v0 + v)*m;
+        if ( beta_zero )
+            *yv = alpha * sum[v];
+        else
+            *yv = alpha * sum[v] + beta * (*yv);
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Computes rows first, ..., last-1 of Y = alpha * A * X + beta * Y for all
+    num_vecs vectors, in blocks of 16, 8, 4, then single vectors. The blocks
+    of one row are done together, while the row is in cache.
+*/
+template< bool row_major >
+static void
+csrmm_rows(
+    magma_index_t first, magma_index_t last,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+    for (magma_index_t i = first; i < last; ++i) {
+        magma_int_t v0 = 0;
+        for (; v0 + 16 <= num_vecs; v0 += 16) {
+            csrmm_row< 16, row_major >( i, v0, m, n, num_vecs, alpha, val, row, col, x, beta_zero, beta, y );
+        }
+        if ( v0 + 8 <= num_vecs ) {
+            csrmm_row<  8, row_major >( i, v0, m, n, num_vecs, alpha, val, row, col, x, beta_zero, beta, y );
+            v0 += 8;
+        }
+        if ( v0 + 4 <= num_vecs ) {
+            csrmm_row<  4, row_major >( i, v0, m, n, num_vecs, alpha, val, row, col, x, beta_zero, beta, y );
+            v0 += 4;
+        }
+        for (; v0 < num_vecs; ++v0) {
+            csrmm_row<  1, row_major >( i, v0, m, n, num_vecs, alpha, val, row, col, x, beta_zero, beta, y );
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes Y = alpha *  A *  X + beta * Y on the CPU for X
+    and Y sets of num_vecs vectors. The input format is CSR (val, row, col).
+    X is n x num_vecs, in either row-major or column-major order, so it is
+    not transposed first; Y is m x num_vecs, column-major, as in
+    magma_zmgecsrmv. Rows are split among OpenMP threads as in
+    magma_zgecsrmv_cpu, and vectors are done in register blocks of 16, 8,
+    and 4, so each entry of A is loaded once per block.
+    If beta is zero, Y need not be initialized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in CSR
+
+    @param[in]
+    major       magma_order_t
+                MagmaRowMajor or MagmaColMajor: order of X
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vectors X
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vectors Y, column-major
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    magma_order_t major,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    bool row_major = (major == MagmaRowMajor);
+    #pragma omp parallel
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        magma_index_t first = csr_part_start( m, row, t,   nt );
+        magma_index_t last  = csr_part_start( m, row, t+1, nt );
+        if ( row_major )
+            csrmm_rows< true  >( first, last, m, n, num_vecs, alpha, val, row, col, x, beta, y );
+        else
+            csrmm_rows< false >( first, last, m, n, num_vecs, alpha, val, row, col, x, beta, y );
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha * ( A - lambda I ) * x + beta * y
+    on the CPU. It is a shifted version of the CSR-SpMV, with the same
+    arguments as magma_zgecsrmv_shift.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    lambda      magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in CSR
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of A in CSR
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in CSR
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    offset      magma_int_t
+                in case not the main diagonal is scaled
+
+    @param[in]
+    blocksize   magma_int_t
+                in case of processing multiple vectors
+
+    @param[in]
+    addrows     magma_index_t*
+                in case the matrixpowerskernel is used
+
+    @param[in,out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgecsrmv_shift_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex lambda,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magma_int_t offset,
+    magma_int_t blocksize,
+    const magma_index_t *addrows,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+    #pragma omp parallel
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        magma_index_t first = csr_part_start( m, row, t,   nt );
+        magma_index_t last  = csr_part_start( m, row, t+1, nt );
+        for (magma_index_t i = first; i < last; ++i) {
+            magmaDoubleComplex dot = csr_row_dot( row[i], row[i+1], val, col, x );
+            magmaDoubleComplex xs = (i < blocksize ? x[ offset + i ]
+                                                   : x[ addrows[ i - blocksize ] ]);
+            dot = alpha * dot - lambda * xs;
+            if ( beta_zero )
+                y[i] = dot;
+            else
+                y[i] = dot + beta * y[i];
+        }
+    }
+    return MAGMA_SUCCESS;
+}
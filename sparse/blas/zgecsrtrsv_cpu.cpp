@@ -0,0 +1,470 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+// consecutive levels with fewer rows are solved by one thread, without
+// barriers, since a barrier costs more than solving a few rows
+#define SMALL_LEVEL 64
+
+// rows per chunk in the sync-free solve; a chunk goes to one thread
+#define SYNCFREE_CHUNK 8
+
+
+/**
+    Purpose
+    -------
+    Solves row i of a triangular system, x[i] = (b[i] - sum_j T(i,j) x[j])
+    / T(i,i), where the sum is over the off-diagonal entries of row i.
+    Without a stored diagonal entry, T(i,i) is taken as one.
+*/
+static inline void
+csrtrsv_row(
+    magma_index_t i,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *b,
+    magmaDoubleComplex *x )
+{
+    magmaDoubleComplex sum = b[i];
+    magmaDoubleComplex diag = MAGMA_Z_ONE;
+    for (magma_index_t k = row[i]; k < row[i+1]; ++k) {
+        magma_index_t j = col[k];
+        if ( j == i )
+            diag = val[k];
+        else
+            sum -= val[k] * x[j];
+    }
+    x[i] = sum / diag;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Analysis for the triangular solves of magma_zcsrtrsv_cpu.
+    Finds the level sets of the triangular CSR matrix T on the CPU:
+    rows without off-diagonal entries are in level 0, and every other row
+    is one level after the last row it depends on. The rows of one level
+    can be solved in parallel once all earlier levels are solved.
+
+    The analysis depends only on the sparsity pattern of T, so it is done
+    once, e.g., when an ILU preconditioner is set up, and reused for
+    every solve.
+
+    Arguments
+    ---------
+
+    @param[in]
+    uplo        magma_uplo_t
+                MagmaLower or MagmaUpper: T is lower or upper triangular
+
+    @param[in]
+    T           magma_z_matrix
+                triangular matrix in CSR on the CPU; the diagonal entries
+                may be missing, for a unit diagonal
+
+    @param[out]
+    num_levels  magma_int_t*
+                number of levels
+
+    @param[out]
+    levelptr    magma_index_t**
+                level l is levelrows[ levelptr[l] ], ...,
+                levelrows[ levelptr[l+1]-1 ]; array of num_levels+1
+                entries, to be freed with magma_free_cpu
+
+    @param[out]
+    levelrows   magma_index_t**
+                rows of T sorted by level, then in order of substitution;
+                array of T.num_rows entries, to be freed with magma_free_cpu
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcsrtrsv_analysis_cpu(
+    magma_uplo_t uplo,
+    magma_z_matrix T,
+    magma_int_t *num_levels,
+    magma_index_t **levelptr,
+    magma_index_t **levelrows,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t n = T.num_rows;
+    magma_int_t nlevels = 0;
+    magma_index_t *level = NULL, *ptr = NULL, *rows = NULL;
+    bool lower = (uplo == MagmaLower);
+    bool triangular = true;
+
+    if ( T.memory_location != Magma_CPU || T.num_rows != T.num_cols ||
+         ( T.storage_type != Magma_CSR  &&
+           T.storage_type != Magma_CSRL &&
+           T.storage_type != Magma_CSRU &&
+           T.storage_type != Magma_CSRCOO ) )
+    {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // visit rows in order of substitution, so the rows a row depends on
+    // already have their levels
+    CHECK( magma_index_malloc_cpu( &level, max( n, 1 )));
+    for (magma_int_t r = 0; r < n && triangular; ++r) {
+        magma_index_t i = (lower ? r : n-1-r);
+        magma_index_t lev = 0;
+        for (magma_index_t k = T.row[i]; k < T.row[i+1]; ++k) {
+            magma_index_t j = T.col[k];
+            if ( j == i )
+                continue;
+            if ( (j < i) != lower ) {
+                triangular = false;
+                break;
+            }
+            lev = max( lev, level[j] + 1 );
+        }
+        level[i] = lev;
+        nlevels = max( nlevels, lev + 1 );
+    }
+    if ( ! triangular ) {
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    // bucket sort rows by level; stable, so in order of substitution
+    CHECK( magma_index_malloc_cpu( &ptr, nlevels+1 ));
+    CHECK( magma_index_malloc_cpu( &rows, max( n, 1 )));
+    for (magma_int_t l = 0; l <= nlevels; ++l) {
+        ptr[l] = 0;
+    }
+    for (magma_int_t i = 0; i < n; ++i) {
+        ptr[ level[i] + 1 ]++;
+    }
+    for (magma_int_t l = 0; l < nlevels; ++l) {
+        ptr[l+1] += ptr[l];
+    }
+    for (magma_int_t r = 0; r < n; ++r) {
+        magma_index_t i = (lower ? r : n-1-r);
+        rows[ ptr[ level[i] ]++ ] = i;
+    }
+    for (magma_int_t l = nlevels; l > 0; --l) {
+        ptr[l] = ptr[l-1];
+    }
+    ptr[0] = 0;
+
+    *num_levels = nlevels;
+    *levelptr   = ptr;
+    *levelrows  = rows;
+    ptr  = NULL;
+    rows = NULL;
+
+cleanup:
+    magma_free_cpu( level );
+    magma_free_cpu( ptr );
+    magma_free_cpu( rows );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Solves T x = b on the CPU for a triangular CSR matrix T, using the
+    level sets from magma_zcsrtrsv_analysis_cpu.
+
+    With trisolver = Magma_SYNCFREESOLVE, the solve is sync-free: chunks
+    of rows, in level order, go round-robin to the OpenMP threads, and
+    a row waits only for the rows it depends on, flagged as solved in
+    done. Each thread solves its rows in order, so the first unsolved row
+    has all its dependencies solved, and no thread waits forever.
+    Otherwise, levels are solved one after another, with a barrier after
+    each; consecutive small levels are solved by one thread.
+
+    Arguments
+    ---------
+
+    @param[in]
+    trisolver   magma_solver_type
+                Magma_SYNCFREESOLVE for the sync-free solve, otherwise
+                level by level
+
+    @param[in]
+    T           magma_z_matrix
+                triangular matrix in CSR on the CPU
+
+    @param[in]
+    num_levels  magma_int_t
+                number of levels
+
+    @param[in]
+    levelptr    magma_index_t*
+                level pointer from magma_zcsrtrsv_analysis_cpu
+
+    @param[in]
+    levelrows   magma_index_t*
+                rows sorted by level from magma_zcsrtrsv_analysis_cpu
+
+    @param[in]
+    done        magma_index_t*
+                workspace of T.num_rows entries for the sync-free solve;
+                may be NULL otherwise
+
+    @param[in]
+    b           magma_z_matrix
+                right-hand side, on the CPU
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution, on the CPU; must not overlap b
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcsrtrsv_cpu(
+    magma_solver_type trisolver,
+    magma_z_matrix T,
+    magma_int_t num_levels,
+    const magma_index_t *levelptr,
+    const magma_index_t *levelrows,
+    magma_index_t *done,
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_queue_t queue )
+{
+    magma_int_t n = T.num_rows;
+    const magmaDoubleComplex *val = T.val;
+    const magma_index_t *row = T.row;
+    const magma_index_t *col = T.col;
+    const magmaDoubleComplex *bv = b.val;
+    magmaDoubleComplex *xv = x->val;
+
+    if ( T.memory_location != Magma_CPU || b.memory_location != Magma_CPU ||
+         x->memory_location != Magma_CPU ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    if ( trisolver == Magma_SYNCFREESOLVE ) {
+        if ( done == NULL ) {
+            return MAGMA_ERR_INVALID_PTR;
+        }
+        #pragma omp parallel
+        {
+            magma_int_t t = 0, nt = 1;
+            #ifdef _OPENMP
+            t  = omp_get_thread_num();
+            nt = omp_get_num_threads();
+            #endif
+            #pragma omp for
+            for (magma_int_t i = 0; i < n; ++i) {
+                done[i] = 0;
+            }
+
+            for (magma_int_t r0 = t*SYNCFREE_CHUNK; r0 < n; r0 += nt*SYNCFREE_CHUNK) {
+                magma_int_t r1 = min( r0 + SYNCFREE_CHUNK, n );
+                for (magma_int_t r = r0; r < r1; ++r) {
+                    magma_index_t i = levelrows[r];
+                    for (magma_index_t k = row[i]; k < row[i+1]; ++k) {
+                        magma_index_t j = col[k], ready;
+                        if ( j == i )
+                            continue;
+                        do {
+                            #pragma omp atomic read
+                            ready = done[j];
+                        } while ( ! ready );
+                    }
+                    // x[j] of the rows waited for is visible after the flush
+                    #pragma omp flush
+                    csrtrsv_row( i, val, row, col, bv, xv );
+                    #pragma omp flush
+                    #pragma omp atomic write
+                    done[i] = 1;
+                }
+            }
+        }
+    }
+    else {
+        #pragma omp parallel
+        {
+            magma_int_t l = 0;
+            while ( l < num_levels ) {
+                if ( levelptr[l+1] - levelptr[l] < SMALL_LEVEL ) {
+                    magma_int_t l2 = l + 1;
+                    while ( l2 < num_levels && levelptr[l2+1] - levelptr[l2] < SMALL_LEVEL ) {
+                        ++l2;
+                    }
+                    #pragma omp single
+                    for (magma_index_t r = levelptr[l]; r < levelptr[l2]; ++r) {
+                        csrtrsv_row( levelrows[r], val, row, col, bv, xv );
+                    }
+                    l = l2;
+                }
+                else {
+                    #pragma omp for schedule(static)
+                    for (magma_index_t r = levelptr[l]; r < levelptr[l+1]; ++r) {
+                        csrtrsv_row( levelrows[r], val, row, col, bv, xv );
+                    }
+                    l = l + 1;
+                }
+            }
+        }
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Prepares the host triangular solves of an ILU or IC preconditioner
+    whose factors precond->L and precond->U are in CSR on the CPU:
+    runs magma_zcsrtrsv_analysis_cpu for both factors and keeps the
+    level sets in the preconditioner, so applying it does no analysis.
+    For precond->trisolver = Magma_SYNCFREESOLVE, also allocates the
+    workspace of the sync-free solve.
+
+    Arguments
+    ---------
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zilugeneratesolverinfo_cpu(
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    CHECK( magma_zcsrtrsv_analysis_cpu( MagmaLower, precond->L,
+               &precond->L_num_levels, &precond->L_levelptr,
+               &precond->L_levelrows, queue ));
+    CHECK( magma_zcsrtrsv_analysis_cpu( MagmaUpper, precond->U,
+               &precond->U_num_levels, &precond->U_levelptr,
+               &precond->U_levelrows, queue ));
+    if ( precond->trisolver == Magma_SYNCFREESOLVE ) {
+        CHECK( magma_index_malloc_cpu( &precond->trisolve_done,
+                   max( precond->L.num_rows, 1 )));
+    }
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Performs the left triangular solve, with L, of an ILU or IC
+    preconditioner with factors on the CPU, set up by
+    magma_zilugeneratesolverinfo_cpu.
+
+    Arguments
+    ---------
+
+    @param[in]
+    b           magma_z_matrix
+                RHS
+
+    @param[in,out]
+    x           magma_z_matrix*
+                vector to precondition
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zapplyilu_l_cpu(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    return magma_zcsrtrsv_cpu( precond->trisolver, precond->L,
+               precond->L_num_levels, precond->L_levelptr, precond->L_levelrows,
+               precond->trisolve_done, b, x, queue );
+}
+
+
+/**
+    Purpose
+    -------
+
+    Performs the right triangular solve, with U, of an ILU or IC
+    preconditioner with factors on the CPU, set up by
+    magma_zilugeneratesolverinfo_cpu.
+
+    Arguments
+    ---------
+
+    @param[in]
+    b           magma_z_matrix
+                RHS
+
+    @param[in,out]
+    x           magma_z_matrix*
+                vector to precondition
+
+    @param[in,out]
+    precond     magma_z_preconditioner*
+                preconditioner parameters
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zgepr
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zapplyilu_r_cpu(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue )
+{
+    return magma_zcsrtrsv_cpu( precond->trisolver, precond->U,
+               precond->U_num_levels, precond->U_levelptr, precond->U_levelrows,
+               precond->trisolve_done, b, x, queue );
+}
@@ -0,0 +1,427 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> c d s
+
+*/
+#include "magmasparse_internal.h"
+
+#define COMPLEX
+
+// largest slice size supported by the SELLP conversion (256 % C == 0)
+#define MAX_SLICE 256
+
+
+/**
+    Purpose
+    -------
+    Computes y = alpha * A * x + beta * y for slices of a SELLP matrix.
+    The C rows of a slice are processed together, one SIMD lane per row,
+    stepping through the slice's columns (val, col are column-major in the
+    slice). C_ > 0 fixes the slice size at compile time, so the loop over
+    the slice maps onto whole vector registers; C_ = 0 takes it from
+    blocksize. Row i of the slice is written to y[ rowperm[i] ], or y[i]
+    if rowperm is NULL.
+*/
+template< int C_ >
+static void
+sellpmv_slices(
+    magma_int_t m,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    const magma_int_t C = (C_ > 0 ? C_ : blocksize);
+    const int N = (C_ > 0 ? C_ : MAX_SLICE);
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (magma_int_t s = 0; s < slices; ++s) {
+        magma_index_t offset = row[s];
+        magma_index_t len = (row[s+1] - offset) / C;
+        #ifdef COMPLEX
+        double re[N], im[N];
+        for (magma_int_t j = 0; j < C; ++j) {
+            re[j] = 0;
+            im[j] = 0;
+        }
+        for (magma_index_t k = 0; k < len; ++k) {
+            const magmaDoubleComplex *v = val + offset + k*C;
+            const magma_index_t      *c = col + offset + k*C;
+            #pragma omp simd
+            for (magma_int_t j = 0; j < C; ++j) {
+                magmaDoubleComplex a = v[j], b = x[ c[j] ];
+                re[j] += MAGMA_Z_REAL(a)*MAGMA_Z_REAL(b) - MAGMA_Z_IMAG(a)*MAGMA_Z_IMAG(b);
+                im[j] += MAGMA_Z_REAL(a)*MAGMA_Z_IMAG(b) + MAGMA_Z_IMAG(a)*MAGMA_Z_REAL(b);
+            }
+        }
+        #else
+        magmaDoubleComplex sum[N];
+        for (magma_int_t j = 0; j < C; ++j) {
+            sum[j] = MAGMA_Z_ZERO;
+        }
+        for (magma_index_t k = 0; k < len; ++k) {
+            const magmaDoubleComplex *v = val + offset + k*C;
+            const magma_index_t      *c = col + offset + k*C;
+            #pragma omp simd
+            for (magma_int_t j = 0; j < C; ++j) {
+                sum[j] += v[j] * x[ c[j] ];
+            }
+        }
+        #endif
+
+        // rows past m are padding
+        for (magma_int_t j = 0; j < C && s*C + j < m; ++j) {
+            #ifdef COMPLEX
+            magmaDoubleComplex dot = MAGMA_Z_MAKE( re[j], im[j] );
+            #else
+            magmaDoubleComplex dot = sum[j];
+            #endif
+            magma_int_t i = (rowperm != NULL ? rowperm[ s*C + j ] : s*C + j);
+            if ( beta_zero )
+                y[i] = alpha * dot;
+            else
+                y[i] = alpha * dot + beta * y[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Computes row j of slice s of Y = alpha * A * X + beta * Y for vectors
+    v0, ..., v0+NV-1, keeping the NV sums in registers, so each entry of the
+    row is loaded once for all NV vectors. X is n x num_vecs, row-major if
+    row_major, else column-major; Y is m x num_vecs, column-major.
+*/
+template< int NV, bool row_major >
+static inline void
+sellpmm_row(
+    magma_int_t s, magma_int_t j,
+    magma_int_t v0,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t C,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    const magmaDoubleComplex *x,
+    bool beta_zero,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    magma_index_t offset = row[s] + j;
+    magma_index_t len = (row[s+1] - row[s]) / C;
+    magmaDoubleComplex sum[NV];
+    for (int v = 0; v < NV; ++v) {
+        sum[v] = MAGMA_Z_ZERO;
+    }
+    for (magma_index_t k = 0; k < len; ++k) {
+        magmaDoubleComplex a = val[ offset + k*C ];
+        magma_index_t c = col[ offset + k*C ];
+        const magmaDoubleComplex *xk = (row_major ? x + c*num_vecs + v0
+                                                  : x + c + v0*n);
+        #pragma omp simd
+        for (int v = 0; v < NV; ++v) {
+            sum[v] += a * xk[ row_major ? v : v*n ];
+        }
+    }
+    magma_int_t i = (rowperm != NULL ? rowperm[ s*C + j ] : s*C + j);
+    for (int v = 0; v < NV; ++v) {
+        magmaDoubleComplex *yv = y + i + (v0 + v)*m;
+        if ( beta_zero )
+            *yv = alpha * sum[v];
+        else
+            *yv = alpha * sum[v] + beta * (*yv);
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Computes Y = alpha * A * X + beta * Y for all slices of a SELLP matrix
+    and num_vecs vectors, in blocks of 16, 8, 4, then single vectors. The
+    blocks of one row are done together, while the row is in cache.
+*/
+template< bool row_major >
+static void
+msellpmv_slices(
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t C,
+    magma_int_t slices,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y )
+{
+    bool beta_zero = MAGMA_Z_EQUAL( beta, MAGMA_Z_ZERO );
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (magma_int_t s = 0; s < slices; ++s) {
+        // rows past m are padding
+        for (magma_int_t j = 0; j < C && s*C + j < m; ++j) {
+            magma_int_t v0 = 0;
+            for (; v0 + 16 <= num_vecs; v0 += 16) {
+                sellpmm_row< 16, row_major >( s, j, v0, m, n, num_vecs, C, alpha, val, col, row, rowperm, x, beta_zero, beta, y );
+            }
+            if ( v0 + 8 <= num_vecs ) {
+                sellpmm_row<  8, row_major >( s, j, v0, m, n, num_vecs, C, alpha, val, col, row, rowperm, x, beta_zero, beta, y );
+                v0 += 8;
+            }
+            if ( v0 + 4 <= num_vecs ) {
+                sellpmm_row<  4, row_major >( s, j, v0, m, n, num_vecs, C, alpha, val, col, row, rowperm, x, beta_zero, beta, y );
+                v0 += 4;
+            }
+            for (; v0 < num_vecs; ++v0) {
+                sellpmm_row<  1, row_major >( s, j, v0, m, n, num_vecs, C, alpha, val, col, row, rowperm, x, beta_zero, beta, y );
+            }
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes y = alpha *  A *  x + beta * y on the CPU.
+    Input format is SELLP, as built by magma_zmconvert. Slice sizes of
+    4, 8, 16, and 32 use kernels specialized at compile time, so each
+    slice is processed in whole SIMD vectors; other sizes use a generic
+    kernel. For SELL-C-sigma, the rows are sorted and rowperm gives the
+    original row of each stored row. If beta is zero, y need not be
+    initialized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one SELLP slice
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in SELLP
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in SELLP
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of SELLP
+
+    @param[in]
+    rowperm     magma_index_t*
+                row permutation of SELL-C-sigma (A.rowidx), or NULL
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vector x
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex*
+                input/output vector y
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans || blocksize < 1 || blocksize > MAX_SLICE ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    switch ( blocksize ) {
+        case  4: sellpmv_slices<  4 >( m, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y ); break;
+        case  8: sellpmv_slices<  8 >( m, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y ); break;
+        case 16: sellpmv_slices< 16 >( m, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y ); break;
+        case 32: sellpmv_slices< 32 >( m, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y ); break;
+        default: sellpmv_slices<  0 >( m, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y ); break;
+    }
+    return MAGMA_SUCCESS;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine computes Y = alpha *  A *  X + beta * Y on the CPU for
+    num_vecs vectors. Input format is SELLP, as for magma_zgesellpmv_cpu.
+    X is n x num_vecs, either row-major, X[ j*num_vecs + v ] as in
+    magma_zmgesellpmv, or column-major, X[ j + v*n ], so it need not be
+    transposed first; Y is column-major, Y[ i + v*m ]. Vectors are done in
+    register blocks of 16, 8, and 4, so each entry of A is loaded once per
+    block. If beta is zero, Y need not be initialized.
+
+    Arguments
+    ---------
+
+    @param[in]
+    transA      magma_trans_t
+                transposition parameter for A; only MagmaNoTrans
+
+    @param[in]
+    m           magma_int_t
+                number of rows in A
+
+    @param[in]
+    n           magma_int_t
+                number of columns in A
+
+    @param[in]
+    num_vecs    magma_int_t
+                number of vectors
+
+    @param[in]
+    blocksize   magma_int_t
+                number of rows in one SELLP slice
+
+    @param[in]
+    slices      magma_int_t
+                number of slices in matrix
+
+    @param[in]
+    alignment   magma_int_t
+                number of threads assigned to one row
+
+    @param[in]
+    alpha       magmaDoubleComplex
+                scalar multiplier
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing values of A in SELLP
+
+    @param[in]
+    col         magma_index_t*
+                columnindices of A in SELLP
+
+    @param[in]
+    row         magma_index_t*
+                rowpointer of SELLP
+
+    @param[in]
+    rowperm     magma_index_t*
+                row permutation of SELL-C-sigma (A.rowidx), or NULL
+
+    @param[in]
+    major       magma_order_t
+                MagmaRowMajor or MagmaColMajor: order of X
+
+    @param[in]
+    x           magmaDoubleComplex*
+                input vectors X
+
+    @param[in]
+    beta        magmaDoubleComplex
+                scalar multiplier
+
+    @param[out]
+    y           magmaDoubleComplex*
+                input/output vectors Y, column-major
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zblas
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zmgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    magma_order_t major,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue )
+{
+    if ( transA != MagmaNoTrans || blocksize < 1 ) {
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+
+    if ( major == MagmaRowMajor )
+        msellpmv_slices< true  >( m, n, num_vecs, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y );
+    else
+        msellpmv_slices< false >( m, n, num_vecs, blocksize, slices, alpha, val, col, row, rowperm, x, beta, y );
+    return MAGMA_SUCCESS;
+}
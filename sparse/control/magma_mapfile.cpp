@@ -0,0 +1,579 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+#include <math.h>
+#include <stdio.h>
+
+#include <map>
+#include <mutex>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#include "magma_mapfile.h"
+
+
+// -----------------------------------------------------------------------------
+// Retained mappings, keyed by start address; value is size, and whether it is
+// mapped (else a malloc'd buffer). g_retained_mutex protects g_retained.
+struct magma_mapfile_region
+{
+    size_t size;
+    bool   mapped;
+};
+
+static std::mutex g_retained_mutex;
+static std::map< const char*, magma_mapfile_region > g_retained;
+
+
+/******************************************************************************/
+magma_mapfile::magma_mapfile():
+    m_data( NULL ),
+    m_size( 0 ),
+    m_mapped( false )
+{}
+
+magma_mapfile::~magma_mapfile()
+{
+    close();
+}
+
+
+/******************************************************************************/
+magma_int_t magma_mapfile::open( const char* filename, bool writable )
+{
+    close();
+#if defined( _WIN32 ) || defined( _WIN64 )
+    // no mmap; read whole file, which is always writable
+    MAGMA_UNUSED( writable );
+    FILE* fid = fopen( filename, "rb" );
+    if ( fid == NULL )
+        return MAGMA_ERR_NOT_FOUND;
+    _fseeki64( fid, 0, SEEK_END );
+    long long size = _ftelli64( fid );
+    _fseeki64( fid, 0, SEEK_SET );
+    if ( size > 0 ) {
+        m_data = (char*) malloc( size );
+        if ( m_data == NULL || fread( m_data, 1, size, fid ) != size_t( size )) {
+            fclose( fid );
+            free( m_data );
+            m_data = NULL;
+            return MAGMA_ERR_HOST_ALLOC;
+        }
+        m_size = size;
+    }
+    fclose( fid );
+#else
+    int fd = ::open( filename, O_RDONLY );
+    if ( fd < 0 )
+        return MAGMA_ERR_NOT_FOUND;
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 ) {
+        ::close( fd );
+        return MAGMA_ERR_NOT_FOUND;
+    }
+    if ( st.st_size > 0 ) {
+        int prot = (writable ? PROT_READ | PROT_WRITE : PROT_READ);
+        void* ptr = mmap( NULL, st.st_size, prot, MAP_PRIVATE, fd, 0 );
+        if ( ptr == MAP_FAILED ) {
+            ::close( fd );
+            return MAGMA_ERR_HOST_ALLOC;
+        }
+        #ifdef MADV_WILLNEED
+        // start read-ahead of the whole file; threads parse different parts
+        madvise( ptr, st.st_size, MADV_WILLNEED );
+        #endif
+        m_data   = (char*) ptr;
+        m_size   = st.st_size;
+        m_mapped = true;
+    }
+    // mapping stays valid after closing the descriptor
+    ::close( fd );
+#endif
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+void magma_mapfile::close()
+{
+#if ! (defined( _WIN32 ) || defined( _WIN64 ))
+    if ( m_mapped ) {
+        munmap( m_data, m_size );
+        m_data = NULL;
+    }
+#endif
+    free( m_data );
+    m_data   = NULL;
+    m_size   = 0;
+    m_mapped = false;
+}
+
+
+/******************************************************************************/
+void magma_mapfile::retain()
+{
+    if ( m_data != NULL ) {
+        std::lock_guard< std::mutex > lock( g_retained_mutex );
+        magma_mapfile_region region = { m_size, m_mapped };
+        g_retained[ m_data ] = region;
+    }
+    m_data   = NULL;
+    m_size   = 0;
+    m_mapped = false;
+}
+
+
+/******************************************************************************/
+bool magma_mapfile_release( const void* ptr )
+{
+    if ( ptr == NULL )
+        return false;
+
+    const char* p = (const char*) ptr;
+    char* data;
+    magma_mapfile_region region;
+    {
+        std::lock_guard< std::mutex > lock( g_retained_mutex );
+        if ( g_retained.empty() )
+            return false;
+        // last region starting at or before p
+        auto iter = g_retained.upper_bound( p );
+        if ( iter == g_retained.begin() )
+            return false;
+        --iter;
+        if ( p >= iter->first + iter->second.size )
+            return false;
+        data   = (char*) iter->first;
+        region = iter->second;
+        g_retained.erase( iter );
+    }
+#if ! (defined( _WIN32 ) || defined( _WIN64 ))
+    if ( region.mapped ) {
+        munmap( data, region.size );
+        return true;
+    }
+#endif
+    free( data );
+    return true;
+}
+
+
+/******************************************************************************/
+void magma_mapfile_split_lines(
+    const char* begin, const char* end, magma_int_t nchunk,
+    std::vector< const char* >& bounds )
+{
+    nchunk = (nchunk < 1 ? 1 : nchunk);
+    size_t len = end - begin;
+    bounds.resize( nchunk + 1 );
+    bounds[0] = begin;
+    for (magma_int_t k = 1; k < nchunk; ++k) {
+        const char* p = begin + size_t( double( len ) * k / nchunk );
+        // the line containing p belongs to the previous chunk,
+        // unless p is already at a line start
+        if ( p < bounds[k-1] )
+            p = bounds[k-1];
+        else if ( p > begin && p[-1] != '\n' )
+            p = magma_next_line( p, end );
+        bounds[k] = p;
+    }
+    bounds[nchunk] = end;
+}
+
+
+/******************************************************************************/
+magma_int_t magma_mapfile_count_lines( const char* begin, const char* end )
+{
+    magma_int_t count = 0;
+    const char* p = begin;
+    while ( p < end ) {
+        p = magma_skip_blanks( p, end );
+        if ( p < end && *p != '\n' )
+            ++count;
+        p = magma_next_line( p, end );
+    }
+    return count;
+}
+
+
+/******************************************************************************/
+const char* magma_parse_real_slow(
+    const char* p, const char* end, double* value )
+{
+    // copy token, since the mapped file is not nul terminated
+    char token[ 128 ];
+    size_t len = 0;
+    p = magma_skip_blanks( p, end );
+    while ( p + len < end && ! magma_is_token_end( p + len, end )) {
+        if ( len + 1 >= sizeof(token) )
+            return NULL;
+        token[ len ] = p[ len ];
+        ++len;
+    }
+    token[ len ] = '\0';
+    char* token_end;
+    *value = strtod( token, &token_end );
+    if ( len == 0 || token_end != token + len )
+        return NULL;
+    return p + len;
+}
+
+
+/******************************************************************************/
+char* magma_format_index( char* p, long long value )
+{
+    char digits[ c_format_index_len ];
+    unsigned long long v = value;
+    if ( value < 0 ) {
+        *p++ = '-';
+        v = 0 - v;
+    }
+    int n = 0;
+    do {
+        digits[ n++ ] = char( '0' + v % 10 );
+        v /= 10;
+    } while ( v > 0 );
+    while ( n > 0 )
+        *p++ = digits[ --n ];
+    return p;
+}
+
+
+/******************************************************************************/
+#ifdef __SIZEOF_INT128__
+
+// Returns a * 10^k, where a = m * 2^e exactly, rounded half to even if
+// round is true, else truncated.
+// Requires 0 <= k <= 19 and -127 < e <= 1, so m * 10^k * 2^e fits in 128 bits.
+static inline unsigned long long scale_round(
+    unsigned long long m, int e, int k, bool round )
+{
+    typedef unsigned __int128 uint128;
+    static const unsigned long long pow10[] = {
+        1ull,                 10ull,                 100ull,
+        1000ull,              10000ull,              100000ull,
+        1000000ull,           10000000ull,           100000000ull,
+        1000000000ull,        10000000000ull,        100000000000ull,
+        1000000000000ull,     10000000000000ull,     100000000000000ull,
+        1000000000000000ull,  10000000000000000ull,  100000000000000000ull,
+        1000000000000000000ull, 10000000000000000000ull
+    };
+    uint128 n = uint128( m ) * pow10[ k ];
+    if ( e >= 0 )
+        return (unsigned long long) (n << e);
+    int s = -e;
+    uint128 q = n >> s;
+    uint128 r = n - (q << s);
+    uint128 half = uint128( 1 ) << (s - 1);
+    if ( round && (r > half || (r == half && (q & 1))) )
+        q += 1;
+    return (unsigned long long) q;
+}
+
+#endif
+
+char* magma_format_real( char* p, double value )
+{
+#ifdef __SIZEOF_INT128__
+    const unsigned long long lo = 1000000000000000ull;  // 10^15
+    const unsigned long long hi = 10*lo;                // 10^16
+    double a = fabs( value );
+    if ( a == 0 ) {
+        if ( signbit( value ))
+            *p++ = '-';
+        *p++ = '0';
+        return p;
+    }
+    if ( a >= 1e-4 && a < 1e16 ) {
+        // a = m * 2^e, with 53-bit integer m
+        int e;
+        double f = frexp( a, &e );
+        unsigned long long m = (unsigned long long) ldexp( f, 53 );
+        e -= 53;
+
+        // find exponent x = floor( log10( a )), with 10^15 <= a * 10^(15-x) < 10^16;
+        // log10 may be off by one near powers of 10
+        int x = int( floor( log10( a )));
+        unsigned long long D = 0;
+        for (int iter = 0; iter < 3 && x >= -4 && x <= 15; ++iter) {
+            D = scale_round( m, e, 15 - x, false );
+            if ( D < lo )
+                x -= 1;
+            else if ( D >= hi )
+                x += 1;
+            else
+                break;
+        }
+        // 16 significant digits; rounding up to 10^16 increases the exponent
+        if ( x >= -4 && x <= 15 && D >= lo && D < hi ) {
+            D = scale_round( m, e, 15 - x, true );
+            if ( D == hi ) {
+                D = lo;
+                x += 1;
+            }
+        }
+        if ( x >= -4 && x <= 15 && D >= lo && D < hi ) {
+            // fixed notation with trailing zeros removed
+            char digits[ 16 ];
+            for (int i = 15; i >= 0; --i) {
+                digits[ i ] = char( '0' + D % 10 );
+                D /= 10;
+            }
+            int ndigit = 16;
+            while ( ndigit > 1 && digits[ ndigit-1 ] == '0' )
+                --ndigit;
+            if ( value < 0 )
+                *p++ = '-';
+            if ( x >= 0 ) {
+                for (int i = 0; i <= x; ++i)
+                    *p++ = digits[ i ];
+                if ( ndigit > x + 1 ) {
+                    *p++ = '.';
+                    for (int i = x + 1; i < ndigit; ++i)
+                        *p++ = digits[ i ];
+                }
+            }
+            else {
+                *p++ = '0';
+                *p++ = '.';
+                for (int i = -1; i > x; --i)
+                    *p++ = '0';
+                for (int i = 0; i < ndigit; ++i)
+                    *p++ = digits[ i ];
+            }
+            return p;
+        }
+    }
+#endif
+    char buf[ 32 ];
+    int len = snprintf( buf, sizeof(buf), "%.16g", value );
+    memcpy( p, buf, len );
+    return p + len;
+}
+
+
+/******************************************************************************/
+magma_int_t magma_write_chunks(
+    FILE* fp, magma_int_t nchunk, size_t max_bytes,
+    magma_format_chunk_t format, void* arg )
+{
+    magma_int_t info = 0;
+    magma_int_t nthreads = 1;
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    nthreads = (nthreads < nchunk ? nthreads : nchunk);
+    nthreads = (nthreads < 1 ? 1 : nthreads);
+
+    std::vector< char* > buf( nthreads, (char*) NULL ), buf_end( nthreads );
+    for (magma_int_t t = 0; t < nthreads; ++t) {
+        buf[t] = (char*) malloc( max_bytes );
+        if ( buf[t] == NULL )
+            info = MAGMA_ERR_HOST_ALLOC;
+    }
+
+    // format a batch of nthreads chunks in parallel, then write them in order
+    for (magma_int_t k0 = 0; k0 < nchunk && info == 0; k0 += nthreads) {
+        magma_int_t nk = (nchunk - k0 < nthreads ? nchunk - k0 : nthreads);
+        #pragma omp parallel for schedule(static,1)
+        for (magma_int_t t = 0; t < nk; ++t) {
+            buf_end[t] = format( k0 + t, buf[t], arg );
+        }
+        for (magma_int_t t = 0; t < nk; ++t) {
+            size_t len = buf_end[t] - buf[t];
+            if ( fwrite( buf[t], 1, len, fp ) != len ) {
+                info = MAGMA_ERR_UNKNOWN;
+                break;
+            }
+        }
+    }
+
+    for (magma_int_t t = 0; t < nthreads; ++t) {
+        free( buf[t] );
+    }
+    return info;
+}
+
+
+/******************************************************************************/
+// Like magma_roundup, but for file offsets, which may not fit in magma_int_t.
+static inline uint64_t roundup64( uint64_t x )
+{
+    return (x + c_csr_file_align - 1) / c_csr_file_align * c_csr_file_align;
+}
+
+void magma_csr_file_init(
+    magma_csr_file_header* header,
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t nnz,
+    size_t value_size, bool is_complex )
+{
+    memset( header, 0, sizeof(*header) );
+    memcpy( header->magic, c_csr_file_magic, sizeof(header->magic) );
+    header->version    = c_csr_file_version;
+    header->byte_order = c_csr_file_byte_order;
+    header->index_size = sizeof(magma_index_t);
+    header->value_size = uint32_t( value_size );
+    header->is_complex = is_complex;
+    header->num_rows   = num_rows;
+    header->num_cols   = num_cols;
+    header->nnz        = nnz;
+    header->row_offset = roundup64( sizeof(*header) );
+    header->col_offset = roundup64( header->row_offset + (num_rows + 1)*sizeof(magma_index_t) );
+    header->val_offset = roundup64( header->col_offset + nnz*sizeof(magma_index_t) );
+    header->file_size  = header->val_offset + nnz*value_size;
+}
+
+
+/******************************************************************************/
+magma_int_t magma_csr_file_check(
+    const char* data, size_t size, size_t value_size, bool is_complex,
+    magma_csr_file_header* header )
+{
+    const int64_t max_index = 2147483647;  // magma_index_t
+    if ( size < sizeof(*header) )
+        return MAGMA_ERR_UNKNOWN;
+    memcpy( header, data, sizeof(*header) );
+    if ( memcmp( header->magic, c_csr_file_magic, sizeof(header->magic) ) != 0 )
+        return MAGMA_ERR_UNKNOWN;
+    if ( header->byte_order != c_csr_file_byte_order ) {
+        printf( "\n%% Binary CSR file has different byte order.\n" );
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    if ( header->version != c_csr_file_version ) {
+        printf( "\n%% Binary CSR file has version %u; only version %u is supported.\n",
+                header->version, c_csr_file_version );
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    if ( header->index_size != sizeof(magma_index_t)
+         || header->value_size != value_size
+         || (header->is_complex != 0) != is_complex )
+    {
+        printf( "\n%% Binary CSR file has %u-byte indices and %u-byte %s values;"
+                " expected %u-byte indices and %u-byte %s values.\n",
+                header->index_size, header->value_size,
+                (header->is_complex ? "complex" : "real"),
+                unsigned( sizeof(magma_index_t) ), unsigned( value_size ),
+                (is_complex ? "complex" : "real") );
+        return MAGMA_ERR_NOT_SUPPORTED;
+    }
+    if ( header->num_rows < 0 || header->num_rows >= max_index
+         || header->num_cols < 0 || header->num_cols > max_index
+         || header->nnz < 0 || header->nnz > max_index )
+        return MAGMA_ERR_UNKNOWN;
+
+    // arrays must be aligned, in order, and within the file
+    uint64_t row_bytes = (header->num_rows + 1)*sizeof(magma_index_t);
+    uint64_t col_bytes = header->nnz*sizeof(magma_index_t);
+    uint64_t val_bytes = header->nnz*value_size;
+    if ( header->file_size != size
+         || header->row_offset % c_csr_file_align != 0
+         || header->col_offset % c_csr_file_align != 0
+         || header->val_offset % c_csr_file_align != 0
+         || header->row_offset < sizeof(*header)
+         || header->col_offset < header->row_offset + row_bytes
+         || header->val_offset < header->col_offset + col_bytes
+         || header->val_offset + val_bytes > size )
+        return MAGMA_ERR_UNKNOWN;
+
+    // row pointer must start at 0 and end at nnz
+    magma_index_t first, last;
+    memcpy( &first, data + header->row_offset, sizeof(first) );
+    memcpy( &last,  data + header->row_offset + header->num_rows*sizeof(last), sizeof(last) );
+    if ( first != 0 || last != header->nnz )
+        return MAGMA_ERR_UNKNOWN;
+    return MAGMA_SUCCESS;
+}
+
+
+/******************************************************************************/
+magma_int_t magma_csr_file_check_arrays(
+    const magma_index_t* row, const magma_index_t* col,
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t nnz )
+{
+    if ( row[0] != 0 || row[num_rows] != nnz )
+        return MAGMA_ERR_UNKNOWN;
+
+    // with row[0] = 0 and row[num_rows] = nnz, monotone rows keep every
+    // row's range within col[0:nnz-1]
+    magma_int_t nbad = 0;
+    #pragma omp parallel for schedule(static) reduction(+:nbad)
+    for (magma_int_t i = 0; i < num_rows; ++i) {
+        if ( row[i] > row[i+1] ) {
+            nbad += 1;
+            continue;
+        }
+        for (magma_index_t j = row[i]; j < row[i+1]; ++j) {
+            nbad += (col[j] < 0 || col[j] >= num_cols);
+        }
+    }
+    return (nbad == 0 ? MAGMA_SUCCESS : MAGMA_ERR_UNKNOWN);
+}
+
+
+/******************************************************************************/
+// Writes zeros from offset pos up to offset.
+static bool write_padding( FILE* fp, uint64_t& pos, uint64_t offset )
+{
+    static const char zeros[ c_csr_file_align ] = { 0 };
+    while ( pos < offset ) {
+        size_t n = size_t( offset - pos < c_csr_file_align ? offset - pos : c_csr_file_align );
+        if ( fwrite( zeros, 1, n, fp ) != n )
+            return false;
+        pos += n;
+    }
+    return true;
+}
+
+// Writes bytes of data at offset pos.
+static bool write_bytes( FILE* fp, uint64_t& pos, const void* data, uint64_t bytes )
+{
+    if ( bytes > 0 && fwrite( data, 1, bytes, fp ) != bytes )
+        return false;
+    pos += bytes;
+    return true;
+}
+
+magma_int_t magma_csr_file_write(
+    FILE* fp, const magma_csr_file_header* header,
+    const magma_index_t* row, const magma_index_t* col, const void* val )
+{
+    uint64_t pos = 0;
+    bool okay =
+           write_bytes( fp, pos, header, sizeof(*header) )
+        && write_padding( fp, pos, header->row_offset )
+        && write_bytes( fp, pos, row, (header->num_rows + 1)*sizeof(magma_index_t) )
+        && write_padding( fp, pos, header->col_offset )
+        && write_bytes( fp, pos, col, header->nnz*sizeof(magma_index_t) )
+        && write_padding( fp, pos, header->val_offset )
+        && write_bytes( fp, pos, val, header->nnz*header->value_size );
+    return (okay ? MAGMA_SUCCESS : MAGMA_ERR_UNKNOWN);
+}
+
+
+/******************************************************************************/
+bool magma_csr_file_is_binary( const char* filename )
+{
+    char magic[ sizeof(c_csr_file_magic) ];
+    FILE* fid = fopen( filename, "rb" );
+    if ( fid == NULL )
+        return false;
+    bool is_binary = (fread( magic, 1, sizeof(magic), fid ) == sizeof(magic)
+                      && memcmp( magic, c_csr_file_magic, sizeof(magic) ) == 0);
+    fclose( fid );
+    return is_binary;
+}
@@ -0,0 +1,300 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       Read-only file mapping, and text number parsing and formatting,
+       used by the Matrix Market readers and writers. Precision independent.
+*/
+
+#ifndef MAGMA_MAPFILE_H
+#define MAGMA_MAPFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "magma_v2.h"
+#include "magmasparse_types.h"
+
+
+// -----------------------------------------------------------------------------
+// Whole file mapped into memory, with mmap where available, else read into
+// a buffer. Unmapped when destroyed, unless retained. Example:
+//
+//     magma_mapfile file;
+//     CHECK( file.open( filename ));
+//     const char* p   = file.data();
+//     const char* end = file.data() + file.size();
+//
+class magma_mapfile
+{
+public:
+    magma_mapfile();
+    ~magma_mapfile();
+
+    // Maps read-only, or if writable, copy-on-write: writes change memory,
+    // not the file. Returns MAGMA_ERR_NOT_FOUND if the file cannot be
+    // opened, MAGMA_ERR_HOST_ALLOC if it cannot be mapped or read.
+    magma_int_t open( const char* filename, bool writable=false );
+    void close();
+
+    // Keeps the file mapped after this object is closed or destroyed,
+    // until magma_mapfile_release is called with a pointer into it.
+    void retain();
+
+    const char* data() const { return m_data; }
+    size_t      size() const { return m_size; }
+
+private:
+    // not copyable
+    magma_mapfile( const magma_mapfile& );
+    magma_mapfile& operator = ( const magma_mapfile& );
+
+    char*  m_data;
+    size_t m_size;
+    bool   m_mapped;
+};
+
+
+// Unmaps the retained mapping containing ptr.
+// Returns true if ptr was in a retained mapping, else false.
+bool magma_mapfile_release( const void* ptr );
+
+
+// -----------------------------------------------------------------------------
+// Splits [begin, end) into nchunk pieces at line starts, so each line is
+// parsed by exactly one thread. Sets bounds[0] = begin, bounds[nchunk] = end;
+// chunk k is [bounds[k], bounds[k+1]), possibly empty.
+void magma_mapfile_split_lines(
+    const char* begin, const char* end, magma_int_t nchunk,
+    std::vector< const char* >& bounds );
+
+// Returns number of non-blank lines in [begin, end).
+magma_int_t magma_mapfile_count_lines( const char* begin, const char* end );
+
+
+// -----------------------------------------------------------------------------
+// Number parsing for one line of a text file. Each parser skips leading
+// spaces and tabs, but not newlines, and returns a pointer past the number,
+// or NULL if there is no valid number there.
+
+inline bool magma_is_blank( char c )
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* magma_skip_blanks( const char* p, const char* end )
+{
+    while ( p < end && magma_is_blank( *p ))
+        ++p;
+    return p;
+}
+
+// Returns start of next line (after '\n'), or end.
+inline const char* magma_next_line( const char* p, const char* end )
+{
+    p = (const char*) memchr( p, '\n', end - p );
+    return (p == NULL ? end : p + 1);
+}
+
+inline bool magma_is_token_end( const char* p, const char* end )
+{
+    return p == end || magma_is_blank( *p ) || *p == '\n';
+}
+
+// Parses a non-negative decimal integer that fits in magma_index_t.
+inline const char* magma_parse_index(
+    const char* p, const char* end, magma_index_t* value )
+{
+    p = magma_skip_blanks( p, end );
+    if ( p < end && *p == '+' )
+        ++p;
+    const char* start = p;
+    long long v = 0;
+    while ( p < end && *p >= '0' && *p <= '9' ) {
+        v = 10*v + (*p - '0');
+        if ( v > 2147483647 )
+            return NULL;
+        ++p;
+    }
+    if ( p == start || ! magma_is_token_end( p, end ))
+        return NULL;
+    *value = magma_index_t( v );
+    return p;
+}
+
+// Parses a floating point number. Numbers with at most 19 significant digits
+// and a small exponent (the usual case) are converted exactly by hand,
+// since m * 10^e is correctly rounded if m < 2^53 and |e| <= 22;
+// others (long mantissas, large exponents, inf, nan) use strtod.
+const char* magma_parse_real_slow(
+    const char* p, const char* end, double* value );
+
+inline const char* magma_parse_real(
+    const char* p, const char* end, double* value )
+{
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    p = magma_skip_blanks( p, end );
+    const char* start = p;
+    bool negative = false;
+    if ( p < end && (*p == '-' || *p == '+') ) {
+        negative = (*p == '-');
+        ++p;
+    }
+    unsigned long long mant = 0;
+    int ndigit = 0, exp10 = 0;
+    while ( p < end && *p >= '0' && *p <= '9' ) {
+        mant = 10*mant + (*p - '0');
+        ndigit += (mant != 0);  // leading zeros are not significant
+        ++p;
+    }
+    if ( p < end && *p == '.' ) {
+        ++p;
+        while ( p < end && *p >= '0' && *p <= '9' ) {
+            mant = 10*mant + (*p - '0');
+            ndigit += (mant != 0);
+            exp10 -= 1;
+            ++p;
+        }
+    }
+    if ( p == start || ndigit > 19 )
+        return magma_parse_real_slow( start, end, value );
+    if ( p < end && (*p == 'e' || *p == 'E') ) {
+        ++p;
+        bool eneg = false;
+        if ( p < end && (*p == '-' || *p == '+') ) {
+            eneg = (*p == '-');
+            ++p;
+        }
+        int e = 0;
+        const char* estart = p;
+        while ( p < end && *p >= '0' && *p <= '9' && e < 10000 ) {
+            e = 10*e + (*p - '0');
+            ++p;
+        }
+        if ( p == estart )
+            return NULL;
+        exp10 += (eneg ? -e : e);
+    }
+    if ( ! magma_is_token_end( p, end ))
+        return magma_parse_real_slow( start, end, value );
+    if ( mant > (1ull << 53) || exp10 < -22 || exp10 > 22 )
+        return magma_parse_real_slow( start, end, value );
+
+    double v = double( mant );
+    v = (exp10 < 0 ? v / pow10[ -exp10 ] : v * pow10[ exp10 ]);
+    *value = (negative ? -v : v);
+    return p;
+}
+
+// Single precision version, parsing in double then rounding.
+inline const char* magma_parse_real(
+    const char* p, const char* end, float* value )
+{
+    double v;
+    p = magma_parse_real( p, end, &v );
+    if ( p != NULL )
+        *value = float( v );
+    return p;
+}
+
+
+// -----------------------------------------------------------------------------
+// Number formatting for text files. Each writes at p, without a nul
+// terminator, and returns a pointer past the text.
+
+// Formats a signed decimal integer, same as printf "%lld".
+char* magma_format_index( char* p, long long value );
+
+// Formats a number with the same text as printf "%.16g".
+// Numbers from 1e-4 to 1e16 (fixed notation) are converted exactly with
+// integer arithmetic where 128-bit integers are available; others use snprintf.
+char* magma_format_real( char* p, double value );
+
+// Maximum length of text from magma_format_index and magma_format_real.
+static const size_t c_format_index_len = 20;
+static const size_t c_format_real_len  = 24;
+
+// Formats chunk k of a text file into buf, which has room for max_bytes
+// given to magma_write_chunks. Returns a pointer past the text.
+typedef char* (*magma_format_chunk_t)( magma_int_t k, char* buf, void* arg );
+
+// Formats chunks 0, ..., nchunk-1 in parallel, one per thread at a time into
+// per-thread buffers of max_bytes each, and writes them to fp in order, with
+// one fwrite per chunk. Returns MAGMA_ERR_HOST_ALLOC if buffers cannot be
+// allocated, MAGMA_ERR_UNKNOWN if writing fails.
+magma_int_t magma_write_chunks(
+    FILE* fp, magma_int_t nchunk, size_t max_bytes,
+    magma_format_chunk_t format, void* arg );
+
+// -----------------------------------------------------------------------------
+// Binary CSR file, written by magma_zwrite_csrtobin and read by magma_z_csr_bin.
+// This header is followed by the row, col, and val arrays, each starting at
+// a byte offset that is a multiple of c_csr_file_align, so they can be used
+// in place when the file is mapped.
+struct magma_csr_file_header
+{
+    char     magic[8];      // "MAGMACSR", not nul terminated
+    uint32_t version;       // c_csr_file_version
+    uint32_t byte_order;    // c_csr_file_byte_order, as written by the writer
+    uint32_t index_size;    // sizeof(magma_index_t)
+    uint32_t value_size;    // bytes per value
+    uint32_t is_complex;    // 1 if values are complex, else 0
+    uint32_t sym;           // magma_symmetry_t
+    uint32_t fill_mode;     // magma_uplo_t
+    uint32_t reserved;
+    int64_t  num_rows;
+    int64_t  num_cols;
+    int64_t  nnz;
+    uint64_t row_offset;    // byte offsets from start of file
+    uint64_t col_offset;
+    uint64_t val_offset;
+    uint64_t file_size;
+};
+
+static const char     c_csr_file_magic[8]   = { 'M','A','G','M','A','C','S','R' };
+static const uint32_t c_csr_file_version    = 1;
+static const uint32_t c_csr_file_byte_order = 0x01020304;
+static const uint64_t c_csr_file_align      = 64;
+
+// Fills in header for a matrix, including offsets of each array.
+void magma_csr_file_init(
+    magma_csr_file_header* header,
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t nnz,
+    size_t value_size, bool is_complex );
+
+// Checks that data[0:size-1] is a binary CSR file with the given index and
+// value types. Prints a message and returns MAGMA_ERR_NOT_SUPPORTED if the
+// file is valid but for different types, version, or byte order;
+// MAGMA_ERR_UNKNOWN if it is truncated or corrupt.
+magma_int_t magma_csr_file_check(
+    const char* data, size_t size, size_t value_size, bool is_complex,
+    magma_csr_file_header* header );
+
+// Checks the row and col arrays of a CSR matrix read from a binary CSR file:
+// row starts at 0, ends at nnz, and is non-decreasing, and each column index
+// is in [0, num_cols). Returns MAGMA_ERR_UNKNOWN if not.
+magma_int_t magma_csr_file_check_arrays(
+    const magma_index_t* row, const magma_index_t* col,
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t nnz );
+
+// Writes header, then row, col, and val at the offsets in header, padding
+// with zeros. Returns MAGMA_ERR_UNKNOWN if writing fails.
+magma_int_t magma_csr_file_write(
+    FILE* fp, const magma_csr_file_header* header,
+    const magma_index_t* row, const magma_index_t* col, const void* val );
+
+// Returns true if the file starts with the binary CSR magic string.
+bool magma_csr_file_is_binary( const char* filename );
+
+#endif  // MAGMA_MAPFILE_H
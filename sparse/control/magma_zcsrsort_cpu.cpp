@@ -0,0 +1,220 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <algorithm>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+// rows up to this length are sorted by insertion sort
+#define CSRSORT_SMALL 32
+
+// rows longer than this are sorted by the parallel radix sort
+#define CSRSORT_LONG 8192
+
+
+/**
+    Purpose
+    -------
+    Column index with its value, ordered by column index.
+*/
+struct csrsort_pair
+{
+    magma_index_t col;
+    magmaDoubleComplex val;
+
+    bool operator< ( const csrsort_pair& other ) const
+    {
+        return col < other.col;
+    }
+};
+
+
+/**
+    Purpose
+    -------
+    Returns nonzero if col[0:len-1] is sorted in increasing order.
+*/
+static inline int
+csrsort_is_sorted(
+    magma_index_t len,
+    const magma_index_t *col )
+{
+    for (magma_index_t k = 1; k < len; ++k) {
+        if ( col[k-1] > col[k] ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/**
+    Purpose
+    -------
+    Insertion sort of a short row col[0:len-1], carrying val (may be NULL).
+*/
+static inline void
+csrsort_insertion(
+    magma_index_t len,
+    magma_index_t *col,
+    magmaDoubleComplex *val )
+{
+    for (magma_index_t k = 1; k < len; ++k) {
+        magma_index_t c = col[k];
+        magma_index_t j = k;
+        if ( val != NULL ) {
+            magmaDoubleComplex v = val[k];
+            for (; j > 0 && col[j-1] > c; --j) {
+                col[j] = col[j-1];
+                val[j] = val[j-1];
+            }
+            val[j] = v;
+        }
+        else {
+            for (; j > 0 && col[j-1] > c; --j) {
+                col[j] = col[j-1];
+            }
+        }
+        col[j] = c;
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Sorts a medium row col[0:len-1] by std::sort (introsort), carrying val
+    (may be NULL) through the pair buffer work.
+*/
+static void
+csrsort_medium(
+    magma_index_t len,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    std::vector< csrsort_pair >& work )
+{
+    if ( val == NULL ) {
+        std::sort( col, col + len );
+        return;
+    }
+    work.resize( len );
+    for (magma_index_t k = 0; k < len; ++k) {
+        work[k].col = col[k];
+        work[k].val = val[k];
+    }
+    std::sort( work.begin(), work.end() );
+    for (magma_index_t k = 0; k < len; ++k) {
+        col[k] = work[k].col;
+        val[k] = work[k].val;
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sorts the column indices in each row of a CSR matrix on the CPU in
+    increasing order, carrying the values along. The sort is chosen by the
+    length of the row: rows that are already sorted are skipped, rows of
+    up to 32 entries are sorted by insertion sort, medium rows by
+    std::sort, and rows longer than 8192 entries by magma_zradixsort_index
+    using all threads. The other rows are split among the OpenMP threads
+    in ranges of about equal nnz, using the row pointer.
+
+    Arguments
+    ---------
+
+    @param[in]
+    num_rows    magma_int_t
+                number of rows
+
+    @param[in]
+    row         magma_index_t*
+                row pointer
+
+    @param[in,out]
+    col         magma_index_t*
+                column indices, sorted within each row on output
+
+    @param[in,out]
+    val         magmaDoubleComplex*
+                values, permuted with col; may be NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcsr_sort_rows_cpu(
+    magma_int_t num_rows,
+    const magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    if ( num_rows <= 0 ) {
+        return info;
+    }
+
+    #pragma omp parallel
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        // rows [first, last) hold this thread's share of the nonzeros
+        int64_t nnz = row[ num_rows ] - row[0];
+        magma_index_t lo = magma_index_t( row[0] + nnz * t / nt );
+        magma_index_t hi = magma_index_t( row[0] + nnz * (t+1) / nt );
+        magma_int_t first = std::lower_bound( row, row + num_rows, lo ) - row;
+        magma_int_t last  = std::lower_bound( row, row + num_rows, hi ) - row;
+        if ( t == nt-1 ) {
+            last = num_rows;
+        }
+        std::vector< csrsort_pair > work;
+
+        for (magma_int_t i = first; i < last; ++i) {
+            magma_index_t len = row[i+1] - row[i];
+            magma_index_t *c = col + row[i];
+            magmaDoubleComplex *v = (val != NULL ? val + row[i] : NULL);
+            if ( len > CSRSORT_LONG || csrsort_is_sorted( len, c )) {
+                continue;
+            }
+            else if ( len <= CSRSORT_SMALL ) {
+                csrsort_insertion( len, c, v );
+            }
+            else {
+                csrsort_medium( len, c, v, work );
+            }
+        }
+    }
+
+    // long rows, each sorted by all threads
+    for (magma_int_t i = 0; i < num_rows; ++i) {
+        magma_index_t len = row[i+1] - row[i];
+        if ( len > CSRSORT_LONG && ! csrsort_is_sorted( len, col + row[i] )) {
+            CHECK( magma_zradixsort_index( len, col + row[i],
+                       (val != NULL ? val + row[i] : NULL), NULL, queue ));
+        }
+    }
+
+cleanup:
+    return info;
+}
@@ -8,6 +8,7 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
+#include "magma_mapfile.h"  // before magma_internal.h's min, max macros
 #include "magmasparse_internal.h"
 
 #include "../blas/magma_trisolve.h"
@@ -25,6 +26,8 @@
     Free the memory of a magma_z_matrix.
     Note, this routine performs a magma_queue_sync on the queue passed
     to it prior to freeing any memory.
+    If A is a CSR matrix mapped from a file by magma_z_csr_bin,
+    this unmaps the file.
 
 
     Arguments
@@ -79,6 +82,7 @@ magma_zmfree(
                 magma_free_cpu( A->val );
                 magma_free_cpu( A->row );
                 magma_free_cpu( A->col );
+                magma_free_cpu( A->rowidx );
             }
             A->num_rows = 0;
             A->num_cols = 0;
@@ -128,6 +132,15 @@ magma_zmfree(
                 magma_free_cpu( A->col );
                 magma_free_cpu( A->row );
             }
+            else {
+                // unmap file if arrays are from magma_z_csr_bin( ..., MagmaTrue, ... )
+                magma_mapfile_release( A->row );
+            }
+            // copies for mixed-precision SpMV are always allocated,
+            // also for a matrix that does not own (e.g., maps) its arrays
+            magma_free_cpu( A->lval );
+            magma_free_cpu( A->lcol );
+            magma_free_cpu( A->lcolbase );
             A->num_rows = 0;
             A->num_cols = 0;
             A->nnz = 0; A->true_nnz = 0;
@@ -186,6 +199,9 @@ magma_zmfree(
         A->dtile_desc_offset = NULL;
         A->calibrator = NULL;
         A->dcalibrator = NULL;
+        A->lval = NULL;
+        A->lcol = NULL;
+        A->lcolbase = NULL;
     }
 
     if ( A->memory_location == Magma_DEV ) {
@@ -253,6 +269,10 @@ magma_zmfree(
                     printf("Memory Free Error.\n");
                     return MAGMA_ERR_INVALID_PTR; 
                 }
+                if ( magma_free( A->drowidx ) != MAGMA_SUCCESS ) {
+                    printf("Memory Free Error.\n");
+                    return MAGMA_ERR_INVALID_PTR; 
+                }
             }
             A->num_rows = 0;
             A->num_cols = 0;
@@ -738,6 +758,19 @@ magma_zprecondfree(
         magma_free( precond_par->U_dgraphindegree_bak );
         precond_par->U_dgraphindegree_bak = NULL;
     }
+    // host trisolve analysis
+    magma_free_cpu( precond_par->L_levelptr );
+    magma_free_cpu( precond_par->L_levelrows );
+    magma_free_cpu( precond_par->U_levelptr );
+    magma_free_cpu( precond_par->U_levelrows );
+    magma_free_cpu( precond_par->trisolve_done );
+    precond_par->L_levelptr = NULL;
+    precond_par->L_levelrows = NULL;
+    precond_par->U_levelptr = NULL;
+    precond_par->U_levelrows = NULL;
+    precond_par->trisolve_done = NULL;
+    precond_par->L_num_levels = 0;
+    precond_par->U_num_levels = 0;
 
     precond_par->solver = Magma_NONE;
     
@@ -8,7 +8,16 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
-#include "magmasparse_internal.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"  // after STL, for its min, max macros
+#include "magma_timer.h"
 
 #include <cuda.h>  // for CUDA_VERSION
 
@@ -140,12 +149,53 @@ cleanup:
 }
 
 
+/**
+    Purpose
+    -------
+    Sorts the rows of the CSR matrix A by decreasing length within windows
+    of sigma consecutive rows, as in SELL-C-sigma. Sets perm[i] to the row of
+    A that is stored as row i. Rows of equal length keep their order.
+*/
+static void
+magma_zsellp_sort_rows(
+    magma_z_matrix A,
+    magma_int_t sigma,
+    magma_index_t *perm )
+{
+    magma_int_t windows = magma_ceildiv( A.num_rows, sigma );
+    #pragma omp parallel
+    {
+        // (-length, row), so sorting is by decreasing length, then by row
+        std::vector< std::pair< magma_index_t, magma_index_t > > key( sigma );
+        #pragma omp for schedule(dynamic)
+        for( magma_int_t w=0; w < windows; w++ ) {
+            magma_index_t first = w*sigma;
+            magma_index_t n = min( sigma, A.num_rows - first );
+            for( magma_index_t i=0; i < n; i++ ) {
+                key[i].first  = -(A.row[first+i+1] - A.row[first+i]);
+                key[i].second = first + i;
+            }
+            std::sort( key.begin(), key.begin() + n );
+            for( magma_index_t i=0; i < n; i++ ) {
+                perm[first+i] = key[i].second;
+            }
+        }
+    }
+}
+
+
 /**
     Purpose
     -------
 
     Converter between different sparse storage formats.
 
+    For conversion to SELLP, the slice size C and alignment are taken from
+    B->blocksize and B->alignment. If B->sigma > 1, rows are sorted by
+    decreasing length within windows of sigma rows before they are packed
+    into slices (SELL-C-sigma), which reduces padding; sigma should be a
+    multiple of C. The stored row i is then row B->rowidx[i] of A.
+
     Arguments
     ---------
 
@@ -181,6 +231,7 @@ magma_zmconvert(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_profile_scope profile( "zmconvert" );
 
     magma_index_t *length=NULL;
 
@@ -657,18 +708,26 @@ magma_zmconvert(
                 B->numblocks = slices;
                 magma_int_t alignedlength, alignment = B->alignment;
                 // conversion
-                magma_index_t i, j, k, maxrowlength=0;
+                magma_index_t i, j, maxrowlength=0;
                 CHECK( magma_index_malloc_cpu( &length, C));
                 // B-row points to the start of each slice
                 CHECK( magma_index_malloc_cpu( &B->row, slices+1 ));
 
 
+                // SELL-C-sigma: B->rowidx holds the row permutation
+                if ( B->sigma > 1 ) {
+                    CHECK( magma_index_malloc_cpu( &B->rowidx, A.num_rows ));
+                    magma_zsellp_sort_rows( A, B->sigma, B->rowidx );
+                }
+
                 B->row[0] = 0;
                 for( i=0; i < slices; i++ ) {
                     maxrowlength = 0;
                     for(j=0; j < C; j++) {
                         if (i*C+j < A.num_rows) {
-                            length[j] = A.row[i*C+j+1]-A.row[i*C+j];
+                            magma_index_t line = ( B->rowidx != NULL ?
+                                                   B->rowidx[i*C+j] : i*C+j );
+                            length[j] = A.row[line+1]-A.row[line];
                         }
                         else
                             length[j]=0;
@@ -690,21 +749,22 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->col, B->row[slices] ));
 
                 // zero everything
-                for( i=0; i < B->row[slices]; i++ ) {
-                    B->val[ i ] = MAGMA_Z_MAKE(0., 0.);
-                    B->col[ i ] =  0;
+                #pragma omp parallel for
+                for( magma_int_t ii=0; ii < B->row[slices]; ii++ ) {
+                    B->val[ ii ] = MAGMA_Z_MAKE(0., 0.);
+                    B->col[ ii ] =  0;
                 }
-                // fill in values
-                for( i=0; i < slices; i++ ) {
-                    for(j=0; j < C; j++) {
-                        magma_int_t line = i*C+j;
+                // fill in values; slices are disjoint
+                #pragma omp parallel for schedule(dynamic, 64)
+                for( magma_int_t ii=0; ii < slices; ii++ ) {
+                    for( magma_int_t jj=0; jj < C && ii*C+jj < A.num_rows; jj++ ) {
+                        magma_int_t line = ( B->rowidx != NULL ?
+                                             B->rowidx[ii*C+jj] : ii*C+jj );
                         magma_int_t offset = 0;
-                        if ( line < A.num_rows) {
-                            for( k=A.row[line]; k < A.row[line+1]; k++ ) {
-                                B->val[ B->row[i] + j +offset*C ] = A.val[k];
-                                B->col[ B->row[i] + j +offset*C ] = A.col[k];
-                                offset++;
-                            }
+                        for( magma_index_t kk=A.row[line]; kk < A.row[line+1]; kk++ ) {
+                            B->val[ B->row[ii] + jj +offset*C ] = A.val[kk];
+                            B->col[ B->row[ii] + jj +offset*C ] = A.col[kk];
+                            offset++;
                         }
                     }
                 }
@@ -764,6 +824,7 @@ magma_zmconvert(
                 CHECK( magma_index_malloc_cpu( &B->row, A.num_rows+1 ));
                 CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
 
+                #pragma omp parallel for
                 for( magma_int_t i=0; i < A.num_rows+1; i++) {
                     B->row[i] = A.row[i];
                 }
@@ -814,12 +875,14 @@ magma_zmconvert(
                 //printf("sigma = %i, p = %i\n", B->csr5_sigma, B->csr5_p);
                 // malloc the newly added arrays for CSR5
                 CHECK( magma_uindex_malloc_cpu( &B->tile_ptr, B->csr5_p+1 ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p+1; i++) {
                     B->tile_ptr[i] = 0;
                 }
 
                 CHECK( magma_uindex_malloc_cpu( &B->tile_desc,
                           B->csr5_p * MAGMA_CSR5_OMEGA * B->csr5_num_packets ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p * MAGMA_CSR5_OMEGA
                                         * B->csr5_num_packets; i++) {
                     B->tile_desc[i] = 0;
@@ -827,12 +890,14 @@ magma_zmconvert(
 
 
                 CHECK( magma_zmalloc_cpu( &B->calibrator, B->csr5_p ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p; i++) {
                     B->calibrator[i] = MAGMA_Z_MAKE(0., 0.);
                 }
 
                 CHECK( magma_index_malloc_cpu( &B->tile_desc_offset_ptr,
                                                B->csr5_p+1 ));
+                #pragma omp parallel for
                 for( magma_int_t i=0; i<B->csr5_p+1; i++) {
                     B->tile_desc_offset_ptr[i] = 0;
                 }
@@ -841,6 +906,7 @@ magma_zmconvert(
                 // convert csr data to csr5 data (3 steps)
                 // step 1 generate tile pointer
                 // step 1.1 binary search row pointer
+                #pragma omp parallel for
                 for (magma_index_t global_id = 0; global_id <= B->csr5_p;
                      global_id++)
                 {
@@ -867,28 +933,31 @@ magma_zmconvert(
                 }
                 
                 // step 1.2 check empty rows
+                // tile_ptr[group_id+1] is read while the bit of tile_ptr[group_id]
+                // is set, so find the tiles with empty rows first
+                std::vector< char > dirty( B->csr5_p, 0 );
+                #pragma omp parallel for schedule(dynamic, 64)
                 for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
-                    int dirty = 0;
-                
                     magma_uindex_t start = B->tile_ptr[group_id];
                     magma_uindex_t stop  = B->tile_ptr[group_id+1];
-                    start = (start << 1) >> 1;
-                    stop  = (stop << 1) >> 1;
                 
                     if (start == stop)
                         continue;
                 
+                    // the last tile ends at row num_rows, which has no row[i+1]
+                    stop = (stop < magma_uindex_t(B->num_rows) ? stop : B->num_rows - 1);
                     for (magma_uindex_t row_idx = start; row_idx <= stop; row_idx++) {
                         if (B->row[row_idx] == B->row[row_idx+1]) {
-                            dirty = 1;
+                            dirty[group_id] = 1;
                             break;
                         }
                     }
-                
-                    if (dirty) {
-                        start |= sizeof(magma_uindex_t) == 4
-                                           ? 0x80000000 : 0x8000000000000000;
-                        B->tile_ptr[group_id] = start;
+                }
+                #pragma omp parallel for
+                for (magma_index_t group_id = 0; group_id < B->csr5_p; group_id++) {
+                    if (dirty[group_id]) {
+                        B->tile_ptr[group_id] |= sizeof(magma_uindex_t) == 4
+                                                 ? 0x80000000 : 0x8000000000000000;
                     }
                 }
                 B->csr5_tail_tile_start = (B->tile_ptr[B->csr5_p-1] << 1) >> 1;
@@ -899,6 +968,8 @@ magma_zmconvert(
                                      + B->csr5_bit_scansum_offset;
                 
                 //generate_tile_descriptor_s1_kernel
+                //each tile sets bits only in its own descriptor
+                #pragma omp parallel for schedule(dynamic, 64)
                 for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
                     const magma_index_t row_start = B->tile_ptr[par_id]
                                                     & 0x7FFFFFFF;
@@ -927,7 +998,11 @@ magma_zmconvert(
                 }
                 
                 //generate_tile_descriptor_s2_kernel
-                int num_thread = 1; //omp_get_max_threads();
+                int num_thread = 1;
+                #ifdef _OPENMP
+                num_thread = omp_get_max_threads();
+                #endif
+                int any_empty_rows = 0;
                 magma_index_t *s_segn_scan_all, *s_present_all;
                 
                 CHECK( magma_index_malloc_cpu( &s_segn_scan_all,
@@ -946,9 +1021,12 @@ magma_zmconvert(
                 
                 //const int bit_all_offset = bit_y_offset + bit_scansum_offset;
                 
-                //#pragma omp parallel for
+                #pragma omp parallel for num_threads(num_thread) reduction(|:any_empty_rows)
                 for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
-                    int tid = 0; //omp_get_thread_num();
+                    int tid = 0;
+                    #ifdef _OPENMP
+                    tid = omp_get_thread_num();
+                    #endif
                     int *s_segn_scan = &s_segn_scan_all[tid * 2
                                                         * MAGMA_CSR5_OMEGA];
                     int *s_present = &s_present_all[tid * 2
@@ -1022,7 +1100,7 @@ magma_zmconvert(
                     if (with_empty_rows) {
                         B->tile_desc_offset_ptr[par_id]
                             = s_segn_scan[MAGMA_CSR5_OMEGA];
-                        B->tile_desc_offset_ptr[B->csr5_p] = 1;
+                        any_empty_rows = 1;
                     }
                 
                     //#pragma simd
@@ -1054,6 +1132,8 @@ magma_zmconvert(
                 
                 magma_free_cpu(s_segn_scan_all);
                 magma_free_cpu(s_present_all);
+                if (any_empty_rows)
+                    B->tile_desc_offset_ptr[B->csr5_p] = 1;
                 
                 if (B->tile_desc_offset_ptr[B->csr5_p]) {
                     //scan_single(B->tile_desc_offset_ptr, p+1);
@@ -1078,7 +1158,7 @@ magma_zmconvert(
                     //err = generate_tile_descriptor_offset
                     const int bit_bitflag = 32 - bit_all_offset;
                 
-                    //#pragma omp parallel for
+                    #pragma omp parallel for schedule(dynamic, 64)
                     for (int par_id = 0; par_id < B->csr5_p-1; par_id++) {
                         bool with_empty_rows = (B->tile_ptr[par_id] >> 31)&0x1;
                         if (!with_empty_rows)
@@ -1176,7 +1256,7 @@ magma_zmconvert(
                 }
                 
                 // step 3. transpose column_index and value arrays
-                //#pragma omp parallel for
+                #pragma omp parallel for
                 for (int par_id = 0; par_id < B->csr5_p; par_id++) {
                     // if this is fast track tile, do not transpose it
                     if (B->tile_ptr[par_id] == B->tile_ptr[par_id + 1]) {
@@ -1234,14 +1314,8 @@ magma_zmconvert(
             // CSRD to CSR (diagonal elements first)
             else if ( old_format == Magma_CSRD ) {
                 CHECK( magma_zmconvert( A, B, Magma_CSR, Magma_CSR, queue ));
-                for( magma_int_t i=0; i < A.num_rows; i++) {
-                    magma_zindexsortval(
-                    B->col,
-                    B->val,
-                    B->row[i],
-                    B->row[i+1]-1,
-                    queue );
-                }
+                CHECK( magma_zcsr_sort_rows_cpu( B->num_rows, B->row, B->col,
+                                                 B->val, queue ));
             }
 
             // CSRCOO to CSR
@@ -1268,14 +1342,8 @@ magma_zmconvert(
                     B->row[ row+1 ] = numnnz;
                 }
                 // sort elements in every row according to col
-                for( magma_int_t i=0; i < A.num_rows; i++) {
-                    magma_zindexsortval(
-                    B->col,
-                    B->val,
-                    B->row[i],
-                    B->row[i+1]-1,
-                    queue );
-                }
+                CHECK( magma_zcsr_sort_rows_cpu( B->num_rows, B->row, B->col,
+                                                 B->val, queue ));
             }
 
             // ELL/ELLPACK to CSR
@@ -1465,13 +1533,17 @@ magma_zmconvert(
                 }
 
                 //transform RowMajor to ColMajor
+                //for SELL-C-sigma, undo the row permutation
                 for( magma_int_t k=0; k < slices; k++) {
                     magma_int_t blockinfo = (A.row[k+1]-A.row[k])/A.blocksize;
                     for( magma_int_t j=0; j < C; j++ ) {
+                        magma_int_t line = k*C+j;
+                        if ( A.rowidx != NULL && line < A.num_rows )
+                            line = A.rowidx[ line ];
                         for( magma_int_t i=0; i < blockinfo; i++ ) {
-                            col_tmp[ (k*C+j)*A.max_nnz_row+i ] =
+                            col_tmp[ line*A.max_nnz_row+i ] =
                                                     A.col[A.row[k]+i*C+j];
-                            val_tmp[ (k*C+j)*A.max_nnz_row+i ] =
+                            val_tmp[ line*A.max_nnz_row+i ] =
                                                     A.val[A.row[k]+i*C+j];
                         }
                     }
@@ -1988,6 +2060,11 @@ cleanup:
     magma_free( transpose );
     magma_free_cpu( length );
     length = NULL;
+    if ( info == 0 ) {
+        // entries read and written, ignoring padding and row pointers
+        profile.add_bytes( (A.nnz + B->nnz)
+                           * double( sizeof(magmaDoubleComplex) + sizeof(magma_index_t) ));
+    }
     magma_zmfree( &hA, queue );
     magma_zmfree( &hB, queue );
     magma_zmfree( &dA, queue );
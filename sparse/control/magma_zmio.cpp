@@ -14,25 +14,392 @@
 //  the IO functions provided by MatrixMarket
 
 #include <algorithm>
+#include <limits>
 #include <vector>
-#include <utility>  // pair
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "magmasparse_internal.h"
 #include "magmasparse_mmio.h"
+#include "magma_mapfile.h"
+
+#define COMPLEX
 
 
 /**
     Purpose
     -------
-    Returns true if first element of a is less than first element of b.
-    Ignores second element. Used for sorting pairs,
-    std::pair< int, magmaDoubleComplex >, of column indices and values.
+    In-place inclusive prefix sum of x[0:n-1], in parallel by blocks.
 */
-static bool compare_first(
-    const std::pair< magma_index_t, magmaDoubleComplex >& a,
-    const std::pair< magma_index_t, magmaDoubleComplex >& b )
+static void inclusive_scan(
+    magma_index_t *x,
+    magma_int_t n )
 {
-    return (a.first < b.first);
+    magma_int_t nthreads = 1;
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    // short arrays are summed by one thread
+    magma_int_t nblock = max( 1, min( nthreads, n / 65536 ));
+    std::vector< magma_index_t > sums( nblock+1, 0 );
+
+    #pragma omp parallel for schedule(static,1)
+    for (magma_int_t b = 0; b < nblock; ++b) {
+        int64_t lo = int64_t( n ) * b / nblock;
+        int64_t hi = int64_t( n ) * (b+1) / nblock;
+        magma_index_t sum = 0;
+        for (int64_t i = lo; i < hi; ++i) {
+            sum += x[i];
+            x[i] = sum;
+        }
+        sums[b+1] = sum;
+    }
+    for (magma_int_t b = 1; b < nblock; ++b) {
+        sums[b+1] += sums[b];
+    }
+    #pragma omp parallel for schedule(static,1)
+    for (magma_int_t b = 1; b < nblock; ++b) {
+        int64_t lo = int64_t( n ) * b / nblock;
+        int64_t hi = int64_t( n ) * (b+1) / nblock;
+        for (int64_t i = lo; i < hi; ++i) {
+            x[i] += sums[b];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Parses one entry line of a Matrix Market coordinate file, starting at p,
+    with nvalues values: 0 for pattern, 1 for real or integer, 2 for complex.
+    Values not read are left unchanged.
+    Returns a pointer past the entry, or NULL if the entry is invalid.
+*/
+static inline const char* parse_entry(
+    const char *p,
+    const char *end,
+    int nvalues,
+    magma_index_t *ROW,
+    magma_index_t *COL,
+    double *VAL,
+    double *VALC )
+{
+    p = magma_parse_index( p, end, ROW );
+    if ( p != NULL )
+        p = magma_parse_index( p, end, COL );
+    if ( p != NULL && nvalues >= 1 )
+        p = magma_parse_real( p, end, VAL );
+    if ( p != NULL && nvalues >= 2 )
+        p = magma_parse_real( p, end, VALC );
+    return p;
+}
+
+
+/**
+    Purpose
+    -------
+    Reads the entries of a Matrix Market coordinate file into CSR format,
+    with column indices sorted within each row. Used by the mtx readers
+    after they parse the banner and size line.
+
+    The file is memory mapped and split into line-aligned chunks, which are
+    parsed in parallel, in two passes. The first pass reads only indices,
+    counting entries in each row. After a prefix sum gives the row pointer,
+    the second pass reads the entries again and stores each one directly in
+    its row. Each row is then sorted by column index.
+    Besides the CSR output, this allocates only O(num_rows) memory, so large
+    matrices can be read without an intermediate COO copy.
+
+    Arguments
+    ---------
+
+    @param[in]
+    filename    const char*
+                filename of the mtx matrix
+
+    @param[in]
+    offset      long
+                byte offset of the first entry, after the size line
+
+    @param[in]
+    matcode     MM_typecode
+                Matrix Market type
+
+    @param[in]
+    num_rows    magma_index_t
+                number of rows, from the size line
+
+    @param[in]
+    num_cols    magma_index_t
+                number of columns, from the size line
+
+    @param[in]
+    num_nonzeros magma_index_t
+                number of entries, from the size line
+
+    @param[in]
+    expand      bool
+                For symmetric and hermitian matrices, whether to duplicate
+                off-diagonal entries (conjugated if hermitian).
+
+    @param[out]
+    nnz         magma_int_t*
+                number of nonzeros in CSR output
+
+    @param[out]
+    row         magma_index_t**
+                row pointer of CSR output
+
+    @param[out]
+    col         magma_index_t**
+                column indices of CSR output
+
+    @param[out]
+    val         magmaDoubleComplex**
+                value array of CSR output
+
+    @param[out]
+    has_zeros   int*
+                set to 1 if a real or integer matrix has explicit zeros,
+                else 0.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+*/
+static magma_int_t
+magma_zmtx_read_csr(
+    const char *filename,
+    long offset,
+    MM_typecode matcode,
+    magma_index_t num_rows,
+    magma_index_t num_cols,
+    magma_index_t num_nonzeros,
+    bool expand,
+    magma_int_t *nnz,
+    magma_index_t **row,
+    magma_index_t **col,
+    magmaDoubleComplex **val,
+    int *has_zeros,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_index_t *pos=NULL;
+
+    magma_mapfile file;
+    std::vector< const char* > bounds;
+    std::vector< magma_int_t > chunk_start;
+    const char *begin, *end;
+    magma_int_t nthreads = 1, nchunk, nbad = 0, nzeros = 0, noffdiag = 0;
+    int64_t total;
+
+    // number of values per entry
+    int nvalues = ((mm_is_real(matcode) || mm_is_integer(matcode)) ? 1
+                   : mm_is_pattern(matcode) ? 0 : 2);
+    bool duplicate = expand && (mm_is_symmetric(matcode) || mm_is_hermitian(matcode));
+    bool conjugate = mm_is_hermitian(matcode);
+
+    *nnz = 0;
+    *row = NULL;
+    *col = NULL;
+    *val = NULL;
+    *has_zeros = 0;
+
+    if ( ! ( mm_is_real(matcode)    ||
+             mm_is_integer(matcode) ||
+             mm_is_pattern(matcode) ||
+             mm_is_complex(matcode) ) )
+    {
+        printf("\n%% Unrecognized data type\n");
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( file.open( filename ));
+    if ( offset < 0 || size_t( offset ) > file.size() ) {
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    begin = file.data() + offset;
+    end   = file.data() + file.size();
+
+    // several chunks per thread to balance load, but at least 64 KiB each
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    nchunk = max( 1, min( 4*nthreads, magma_int_t( (end - begin) / 65536 )));
+    magma_mapfile_split_lines( begin, end, nchunk, bounds );
+
+    // count entries in each chunk, to find which entries each chunk has
+    chunk_start.resize( nchunk+1 );
+    chunk_start[0] = 0;
+    #pragma omp parallel for schedule(dynamic,1)
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        chunk_start[k+1] = magma_mapfile_count_lines( bounds[k], bounds[k+1] );
+    }
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        chunk_start[k+1] += chunk_start[k];
+    }
+    if ( chunk_start[nchunk] < num_nonzeros ) {
+        printf("\n%% File has %lld entries, but size line says %lld.\n",
+               (long long) chunk_start[nchunk], (long long) num_nonzeros );
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+
+    // first pass: count nonzeros in each row i, in row[i+1]
+    // lines after the first num_nonzeros entries are ignored
+    CHECK( magma_index_malloc_cpu( row, num_rows+1 ));
+    #pragma omp parallel for
+    for (magma_int_t i = 0; i <= num_rows; ++i) {
+        (*row)[i] = 0;
+    }
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:nbad,noffdiag)
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        magma_int_t i = chunk_start[k];
+        const char *p = bounds[k], *chunk_end = bounds[k+1];
+        while ( p < chunk_end && i < num_nonzeros ) {
+            p = magma_skip_blanks( p, chunk_end );
+            if ( p < chunk_end && *p != '\n' ) {
+                magma_index_t ROW = 0, COL = 0;
+                if ( parse_entry( p, chunk_end, 0, &ROW, &COL, NULL, NULL ) == NULL
+                     || ROW < 1 || ROW > num_rows || COL < 1 || COL > num_cols ) {
+                    nbad += 1;
+                }
+                else {
+                    #pragma omp atomic
+                    (*row)[ ROW ] += 1;
+                    if ( ROW != COL ) {
+                        noffdiag += 1;
+                        if ( duplicate ) {
+                            #pragma omp atomic
+                            (*row)[ COL ] += 1;
+                        }
+                    }
+                }
+                ++i;
+            }
+            p = magma_next_line( p, chunk_end );
+        }
+    }
+    if ( nbad > 0 ) {
+        printf("\n%% File has %lld invalid entries.\n", (long long) nbad );
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+
+    total = int64_t( num_nonzeros ) + (duplicate ? noffdiag : 0);
+    if ( total > (std::numeric_limits< magma_index_t >::max)() ) {
+        printf("\n%% Matrix has %lld nonzeros, too many for magma_index_t.\n",
+               (long long) total );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+    *nnz = magma_int_t( total );
+    inclusive_scan( *row + 1, num_rows );
+
+    CHECK( magma_index_malloc_cpu( col, *nnz ));
+    CHECK( magma_zmalloc_cpu( val, *nnz ));
+    CHECK( magma_index_malloc_cpu( &pos, num_rows+1 ));
+
+    // second pass: parse entries again, storing each in its row;
+    // pos[i] is next free slot in row i
+    #pragma omp parallel for
+    for (magma_int_t i = 0; i < num_rows; ++i) {
+        pos[i] = (*row)[i];
+    }
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:nbad,nzeros)
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        magma_int_t i = chunk_start[k];
+        const char *p = bounds[k], *chunk_end = bounds[k+1];
+        while ( p < chunk_end && i < num_nonzeros ) {
+            p = magma_skip_blanks( p, chunk_end );
+            if ( p < chunk_end && *p != '\n' ) {
+                magma_index_t ROW = 0, COL = 0, r, c, dest;
+                double VAL = 1.0, VALC = 0.0;  // always read in a double and convert later if necessary
+                if ( parse_entry( p, chunk_end, nvalues, &ROW, &COL, &VAL, &VALC ) == NULL ) {
+                    nbad += 1;  // invalid value; indices were checked in first pass
+                }
+                else {
+                    if ( nvalues == 1 && VAL == 0 )
+                        nzeros += 1;
+                    magmaDoubleComplex v = MAGMA_Z_MAKE( VAL, VALC );
+                    r = ROW - 1;
+                    c = COL - 1;
+                    #pragma omp atomic capture
+                    dest = pos[r]++;
+                    (*col)[dest] = c;
+                    (*val)[dest] = v;
+                    if ( duplicate && r != c ) {
+                        #pragma omp atomic capture
+                        dest = pos[c]++;
+                        (*col)[dest] = r;
+                        (*val)[dest] = (conjugate ? conj(v) : v);
+                    }
+                }
+                ++i;
+            }
+            p = magma_next_line( p, chunk_end );
+        }
+    }
+    if ( nbad > 0 ) {
+        printf("\n%% File has %lld invalid entries.\n", (long long) nbad );
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    *has_zeros = (nzeros > 0);
+
+    // sort column indices within each row
+    CHECK( magma_zcsr_sort_rows_cpu( num_rows, *row, *col, *val, queue ));
+
+cleanup:
+    if ( info != 0 ) {
+        magma_free_cpu( *row );
+        magma_free_cpu( *col );
+        magma_free_cpu( *val );
+        *row = NULL;
+        *col = NULL;
+        *val = NULL;
+        *nnz = 0;
+    }
+    magma_free_cpu( pos );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+    Removes explicit zeros from a CSR matrix in place, keeping the order of
+    the other entries. Gives the same result as magma_z_csr_compressor,
+    without allocating new arrays; col and val keep their allocated length.
+*/
+static void
+magma_zcsr_remove_zeros(
+    magma_int_t num_rows,
+    magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_int_t *nnz )
+{
+    magma_index_t nnz_new = 0;
+    for (magma_int_t i = 0; i < num_rows; ++i) {
+        magma_index_t start = row[i];
+        row[i] = nnz_new;
+        for (magma_index_t j = start; j < row[i+1]; ++j) {
+            if ( (MAGMA_Z_REAL(val[j]) != 0) || (MAGMA_Z_IMAG(val[j]) != 0) ) {
+                col[nnz_new] = col[j];
+                val[nnz_new] = val[j];
+                nnz_new++;
+            }
+        }
+    }
+    row[num_rows] = nnz_new;
+    *nnz = nnz_new;
 }
 
 
@@ -105,13 +472,8 @@ magma_int_t read_z_csr_from_mtx(
     char buffer[ 1024 ];
     magma_int_t info = 0;
     
-    magma_index_t *coo_col=NULL, *coo_row=NULL;
-    magmaDoubleComplex *coo_val=NULL;
-    magma_index_t *new_col=NULL, *new_row=NULL;
-    magmaDoubleComplex *new_val=NULL;
-    magma_int_t hermitian = 0;
-    
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
+    long offset = 0;
+    int has_zeros = 0;
     
     FILE *fid = NULL;
     MM_typecode matcode;
@@ -158,196 +520,434 @@ magma_int_t read_z_csr_from_mtx(
         goto cleanup;
     }
     
+    offset = ftell( fid );
+    fclose(fid);
+    fid = NULL;
+    
     *type     = Magma_CSR;
     *location = Magma_CPU;
     *n_row    = num_rows;
     *n_col    = num_cols;
-    *nnz      = num_nonzeros;
     
-    CHECK( magma_index_malloc_cpu( &coo_col, *nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, *nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, *nnz ) );
-
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
-        }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL );
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
-        }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < *nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
-        }
-        // printf(" ...successfully read complex matrix... ");
-    } else {
-        printf("\n%% Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
-    }
-    fclose(fid);
-    fid = NULL;
-    printf(" done. Converting to CSR:");
-    fflush(stdout);
-    
-
     if( mm_is_hermitian(matcode) ) {
-        hermitian = 1;
         printf("hermitian case!\n\n\n");
     }
     if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
                                         // duplicate off diagonal entries
         printf("\n%% Detected symmetric case.");
-        
-        magma_index_t off_diagonals = 0;
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            if (coo_row[i] != coo_col[i])
-                ++off_diagonals;
-        }
-        magma_index_t true_nonzeros = 2*off_diagonals + (*nnz - off_diagonals);
-        
-        //printf("%% total number of nonzeros: %d\n%%", int(*nnz));
-
-        CHECK( magma_index_malloc_cpu( &new_row, true_nonzeros ));
-        CHECK( magma_index_malloc_cpu( &new_col, true_nonzeros ));
-        CHECK( magma_zmalloc_cpu( &new_val, true_nonzeros ));
+    }
     
-        magma_index_t ptr = 0;
-        for(magma_int_t i = 0; i < *nnz; ++i) {
-            if (coo_row[i] != coo_col[i]) {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-                new_col[ptr] = coo_row[i];
-                new_row[ptr] = coo_col[i];
-                new_val[ptr] = (hermitian == 0) ? coo_val[i] : conj(coo_val[i]);
-                ptr++;
-            } else {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-            }
-        }
-        
-        magma_free_cpu(coo_row); 
-        magma_free_cpu(coo_col); 
-        magma_free_cpu(coo_val);
+    CHECK( magma_zmtx_read_csr( filename, offset, matcode,
+                                num_rows, num_cols, num_nonzeros, true,
+                                nnz, row, col, val, &has_zeros, queue ));
 
-        coo_row = new_row;
-        coo_col = new_col;
-        coo_val = new_val;
-        
-        *nnz = true_nonzeros;
-    } // end symmetric case
-    
-    CHECK( magma_zmalloc_cpu( val, *nnz ) );
-    
-    CHECK( magma_index_malloc_cpu( col, *nnz ) );
-    CHECK( magma_index_malloc_cpu( row, (*n_row+1) ) );
-    CHECK( magma_zmalloc_cpu( val, *nnz ) );
+    printf(" done.\n");
+cleanup:
+    if ( fid != NULL ) {
+        fclose( fid );
+        fid = NULL;
+    }
+    return info;
+}
 
-    // original code from  Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (*row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < *nnz; i++)
-        (*row)[coo_row[i]]++;
-    
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (*row)[i];
-        (*row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (*row)[num_rows] = *nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < *nnz; i++) {
-        magma_index_t row_  = coo_row[i];
-        magma_index_t dest = (*row)[row_];
-        (*col)[dest] = coo_col[i];
-        (*val)[dest] = coo_val[i];
-        (*row)[row_]++;
+
+extern "C" magma_int_t
+magma_zwrite_csrtomtx(
+    magma_z_matrix B,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    // TODO: why does this hard code MagmaColMajor?
+    CHECK( magma_zwrite_csr_mtx( B, MagmaColMajor, filename, queue ));
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Writes a matrix to a binary CSR file, which magma_z_csr_bin and
+    magma_z_csr_mtx read without parsing.
+
+    The file has a header with the dimensions, number of nonzeros,
+    precision, symmetry, and index size, followed by the row, col, and val
+    arrays, each aligned to 64 bytes, in native byte order.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                matrix to write out; converted to CSR on the CPU if needed.
+
+    @param[in]
+    filename    const char*
+                output filename of the binary matrix
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zwrite_csrtobin(
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_z_matrix hA={Magma_CSR}, B={Magma_CSR};
+    magma_z_matrix *C = &A;
+    magma_csr_file_header header;
+    FILE *fp = NULL;
+    #ifdef COMPLEX
+    const bool is_complex = true;
+    #else
+    const bool is_complex = false;
+    #endif
+
+    if ( A.memory_location != Magma_CPU ) {
+        CHECK( magma_zmtransfer( A, &hA, A.memory_location, Magma_CPU, queue ));
+        C = &hA;
     }
-    
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp  = (*row)[i];
-        (*row)[i] = last;
-        last      = temp;
+    if ( C->storage_type != Magma_CSR ) {
+        CHECK( magma_zmconvert( *C, &B, C->storage_type, Magma_CSR, queue ));
+        C = &B;
     }
-    
-    (*row)[*n_row] = *nnz;
 
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < *n_row; ++k) {
-        int kk  = (*row)[k];
-        int len = (*row)[k+1] - (*row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (*col)[kk+i], (*val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (*col)[kk+i] = rowval[i].first;
-            (*val)[kk+i] = rowval[i].second;
+    magma_csr_file_init( &header, C->num_rows, C->num_cols, C->nnz,
+                         sizeof(magmaDoubleComplex), is_complex );
+    header.sym       = C->sym;
+    header.fill_mode = C->fill_mode;
+
+    printf("%% Writing sparse matrix to file (%s):", filename);
+    fflush(stdout);
+
+    fp = fopen( filename, "wb" );
+    if ( fp == NULL ) {
+        printf("\n%% error writing matrix: missing write permission\n");
+        info = MAGMA_ERR_NOT_FOUND;
+        goto cleanup;
+    }
+    info = magma_csr_file_write( fp, &header, C->row, C->col, C->val );
+    if ( fclose( fp ) != 0 || info != 0 ) {
+        printf("\n%% error: writing matrix failed\n");
+        info = MAGMA_ERR_UNKNOWN;
+        goto cleanup;
+    }
+    printf(" done\n");
+
+cleanup:
+    magma_zmfree( &hA, queue );
+    magma_zmfree( &B, queue );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Reads a matrix from a binary CSR file, written by magma_zwrite_csrtobin.
+
+    If map is MagmaTrue, the file is memory mapped, and A's arrays point
+    directly into the mapping, so no data is read until it is used.
+    A->ownership is then MagmaFalse, and magma_zmfree( A ) unmaps the file.
+    The mapping is copy-on-write: changes to A's values are not written
+    to the file. Do not call magma_zmfree on a shallow copy of A.
+
+    If map is MagmaFalse, the arrays are copied into memory owned by A,
+    and checked: row pointers must be non-decreasing, from 0 to nnz, and
+    column indices must be in [0, num_cols).
+
+    Mapped files are trusted: only the header and the first and last row
+    pointers are checked, so that no index data is read until it is used.
+    A corrupt mapped file can cause out-of-bounds reads in later routines;
+    use map = MagmaFalse for files from untrusted sources.
+
+    Arguments
+    ---------
+
+    @param[out]
+    A           magma_z_matrix*
+                matrix in magma sparse matrix format
+
+    @param[in]
+    filename    const char*
+                filename of the binary matrix
+
+    @param[in]
+    map         magma_bool_t
+                whether to map the file instead of copying it
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_z_csr_bin(
+    magma_z_matrix *A,
+    const char *filename,
+    magma_bool_t map,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+
+    magma_mapfile file;
+    magma_csr_file_header header;
+    char *data;
+    #ifdef COMPLEX
+    const bool is_complex = true;
+    #else
+    const bool is_complex = false;
+    #endif
+
+    // make sure the target structure is empty
+    magma_zmfree( A, queue );
+    A->ownership = MagmaTrue;
+
+    info = file.open( filename, map == MagmaTrue );
+    if ( info != 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        goto cleanup;
+    }
+
+    printf("%% Reading sparse matrix from file (%s):", filename);
+    fflush(stdout);
+
+    info = magma_csr_file_check( file.data(), file.size(),
+                                 sizeof(magmaDoubleComplex), is_complex, &header );
+    if ( info == MAGMA_ERR_UNKNOWN ) {
+        printf("\n%% Invalid binary CSR file.\n");
+    }
+    if ( info != 0 ) {
+        goto cleanup;
+    }
+
+    A->storage_type    = Magma_CSR;
+    A->memory_location = Magma_CPU;
+    A->sym             = magma_symmetry_t( header.sym );
+    A->fill_mode       = magma_uplo_t( header.fill_mode );
+    A->num_rows        = header.num_rows;
+    A->num_cols        = header.num_cols;
+    A->nnz             = header.nnz;
+    A->true_nnz        = header.nnz;
+
+    // the mapping is writable (copy-on-write), so casting away const is okay
+    data = (char*) file.data();
+    if ( map == MagmaTrue ) {
+        A->row = (magma_index_t*)      (data + header.row_offset);
+        A->col = (magma_index_t*)      (data + header.col_offset);
+        A->val = (magmaDoubleComplex*) (data + header.val_offset);
+        A->ownership = MagmaFalse;
+        file.retain();
+    }
+    else {
+        CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ));
+        CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
+        CHECK( magma_zmalloc_cpu( &A->val, A->nnz ));
+        memcpy( A->row, data + header.row_offset, (A->num_rows+1)*sizeof(magma_index_t) );
+        memcpy( A->col, data + header.col_offset, A->nnz*sizeof(magma_index_t) );
+        memcpy( A->val, data + header.val_offset, A->nnz*sizeof(magmaDoubleComplex) );
+        info = magma_csr_file_check_arrays( A->row, A->col, A->num_rows, A->num_cols, A->nnz );
+        if ( info != 0 ) {
+            printf("\n%% Invalid binary CSR file: bad row pointers or column indices.\n");
+            goto cleanup;
         }
     }
-
     printf(" done.\n");
+
 cleanup:
-    if ( fid != NULL ) {
-        fclose( fid );
-        fid = NULL;
+    if ( info != 0 ) {
+        magma_zmfree( A, queue );
     }
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
     return info;
 }
 
 
-extern "C" magma_int_t
-magma_zwrite_csrtomtx(
-    magma_z_matrix B,
+/**
+    Purpose
+    -------
+
+    Reads a matrix from a binary CSR file, written by magma_zwrite_csrtobin,
+    into arrays owned by the caller, to be freed with magma_free_cpu.
+
+    Arguments
+    ---------
+
+    @param[out]
+    n_row       magma_int_t*
+                number of rows in matrix
+
+    @param[out]
+    n_col       magma_int_t*
+                number of columns in matrix
+
+    @param[out]
+    nnz         magma_int_t*
+                number of nonzeros in matrix
+
+    @param[out]
+    val         magmaDoubleComplex**
+                value array of CSR output
+
+    @param[out]
+    row         magma_index_t**
+                row pointer of CSR output
+
+    @param[out]
+    col         magma_index_t**
+                column indices of CSR output
+
+    @param[in]
+    filename    const char*
+                filename of the binary matrix
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C"
+magma_int_t read_z_csr_from_binary(
+    magma_int_t* n_row,
+    magma_int_t* n_col,
+    magma_int_t* nnz,
+    magmaDoubleComplex **val,
+    magma_index_t **row,
+    magma_index_t **col,
     const char *filename,
     magma_queue_t queue )
 {
     magma_int_t info = 0;
-    // TODO: why does this hard code MagmaColMajor?
-    CHECK( magma_zwrite_csr_mtx( B, MagmaColMajor, filename, queue ));
+    magma_z_matrix A={Magma_CSR};
+
+    CHECK( magma_z_csr_bin( &A, filename, MagmaFalse, queue ));
+    *n_row = A.num_rows;
+    *n_col = A.num_cols;
+    *nnz   = A.nnz;
+    *val   = A.val;
+    *row   = A.row;
+    *col   = A.col;
+
 cleanup:
     return info;
 }
 
 
+/**
+    Purpose
+    -------
+    Arguments for format_csr_chunk. Chunk k has rows
+    chunk_row[k], ..., chunk_row[k+1]-1.
+*/
+struct csr_text
+{
+    const magma_index_t *row;
+    const magma_index_t *col;
+    const magmaDoubleComplex *val;
+    const magma_index_t *chunk_row;
+    bool transposed;  // write column index first
+};
+
+
+/**
+    Purpose
+    -------
+    Formats chunk k of a CSR matrix as Matrix Market entries, one per line,
+    with 1-based indices. Used with magma_write_chunks.
+*/
+static char* format_csr_chunk( magma_int_t k, char* p, void* arg )
+{
+    const csr_text& A = *(const csr_text*) arg;
+    for (magma_index_t i = A.chunk_row[k]; i < A.chunk_row[k+1]; ++i) {
+        for (magma_index_t j = A.row[i]; j < A.row[i+1]; ++j) {
+            p = magma_format_index( p, (A.transposed ? A.col[j] : i) + 1 );
+            *p++ = ' ';
+            p = magma_format_index( p, (A.transposed ? i : A.col[j]) + 1 );
+            *p++ = ' ';
+            p = magma_format_real( p, MAGMA_Z_REAL( A.val[j] ));
+            #ifdef COMPLEX
+            *p++ = ' ';
+            p = magma_format_real( p, MAGMA_Z_IMAG( A.val[j] ));
+            #endif
+            *p++ = '\n';
+        }
+    }
+    return p;
+}
+
+
+/**
+    Purpose
+    -------
+    Writes the entries of a CSR matrix on the CPU to fp as Matrix Market
+    text, the same as fprintf with "%d %d %.16g %.16g\n", or "%d %d %.16g\n"
+    if real. Rows are split into chunks of about the same number of
+    nonzeros, which are formatted in parallel and written in order.
+
+    Arguments
+    ---------
+
+    @param[in]
+    fp          FILE*
+                file to write to
+
+    @param[in]
+    A           magma_z_matrix
+                matrix in CSR format on the CPU
+
+    @param[in]
+    transposed  bool
+                whether to write column index first, then row index
+*/
+static magma_int_t
+magma_zwrite_csr_text(
+    FILE *fp,
+    magma_z_matrix A,
+    bool transposed )
+{
+    // line is 2 indices and 1 or 2 values, with spaces and newline
+    const size_t max_line = 2*(c_format_index_len + 1) + 2*(c_format_real_len + 1);
+    const magma_int_t chunk_nnz = 16384;
+
+    std::vector< magma_index_t > chunk_row;
+    csr_text arg;
+    magma_int_t nchunk = 1 + A.nnz / chunk_nnz;
+    magma_index_t max_nnz = 0;
+
+    // chunk k starts at first row with an entry at or after k*nnz/nchunk
+    chunk_row.resize( nchunk+1 );
+    chunk_row[0] = 0;
+    chunk_row[nchunk] = magma_index_t( A.num_rows );
+    for (magma_int_t k = 1; k < nchunk; ++k) {
+        magma_index_t target = magma_index_t( int64_t( A.nnz ) * k / nchunk );
+        chunk_row[k] = magma_index_t(
+            std::lower_bound( A.row, A.row + A.num_rows, target ) - A.row );
+    }
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        max_nnz = max( max_nnz, A.row[ chunk_row[k+1] ] - A.row[ chunk_row[k] ] );
+    }
+
+    arg.row        = A.row;
+    arg.col        = A.col;
+    arg.val        = A.val;
+    arg.chunk_row  = &chunk_row[0];
+    arg.transposed = transposed;
+    return magma_write_chunks( fp, nchunk, max( 1, max_nnz ) * max_line,
+                               format_csr_chunk, &arg );
+}
+
+
 /**
     Purpose
     -------
@@ -387,131 +987,51 @@ magma_zwrite_csr_mtx(
 {
     magma_int_t info = 0;
     
-    FILE *fp;
+    FILE *fp = NULL;
     magma_z_matrix B = {Magma_CSR};
+    magma_z_matrix *C = &A;
+    bool transposed = false;
     
     if ( MajorType == MagmaColMajor ) {
         // to obtain ColMajor output we transpose the matrix
         // and flip the row and col pointer in the output
-        
         CHECK( magma_z_cucsrtranspose( A, &B, queue ));
-        
-        // TODO avoid duplicating this code below.
-        printf("%% Writing sparse matrix to file (%s):", filename);
-        fflush(stdout);
-        
-        fp = fopen(filename, "w");
-        if ( fp == NULL ){
-            printf("\n%% error writing matrix: file exists or missing write permission\n");
-            info = -1;
-            goto cleanup;
-        }
-            
-        #define COMPLEX
-
-        #ifdef COMPLEX
-        // complex case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
-        fprintf( fp, "%d %d %d\n", int(B.num_cols), int(B.num_rows), int(B.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-        
-        for(i=0; i < B.num_rows; i++) {
-            magma_index_t rowtemp1 = B.row[i];
-            magma_index_t rowtemp2 = B.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g %.16g\n",
-                    ((B.col)[rowtemp1+j]+1), rowindex,
-                    MAGMA_Z_REAL((B.val)[rowtemp1+j]),
-                    MAGMA_Z_IMAG((B.val)[rowtemp1+j]) );
-            }
-            rowindex++;
-        }
-        #else
-        // real case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
-        fprintf( fp, "%d %d %d\n", int(B.num_cols), int(B.num_rows), int(B.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-                
-        for(i=0; i < B.num_rows; i++) {
-            magma_index_t rowtemp1 = B.row[i];
-            magma_index_t rowtemp2 = B.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g\n",
-                    ((B.col)[rowtemp1+j]+1), rowindex,
-                    MAGMA_Z_REAL((B.val)[rowtemp1+j]) );
-            }
-            rowindex++;
-        }
-        #endif
-       
-        if (fclose(fp) != 0)
-            printf("\n%% error: writing matrix failed\n");
-        else
-            printf(" done\n");
+        C = &B;
+        transposed = true;
+    }
+    
+    printf("%% Writing sparse matrix to file (%s):", filename);
+    fflush(stdout);
+    
+    fp = fopen(filename, "w");
+    if ( fp == NULL ){
+        printf("\n%% error writing matrix: file exists or missing write permission\n");
+        info = -1;
+        goto cleanup;
+    }
+    
+    #ifdef COMPLEX
+    fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
+    #else
+    fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
+    #endif
+    if ( transposed ) {
+        fprintf( fp, "%d %d %d\n", int(C->num_cols), int(C->num_rows), int(C->nnz));
     }
     else {
-        printf("%% Writing sparse matrix to file (%s):", filename);
-        fflush(stdout);
-        
-        fp = fopen (filename, "w");
-        if (  fp == NULL ){
-            printf("\n%% error writing matrix: file exists or missing write permission\n");
-            info = -1;
-            goto cleanup;
-        }
-             
-            
-        #define COMPLEX
-
-        #ifdef COMPLEX
-        // complex case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate complex general\n" );
-        fprintf( fp, "%d %d %d\n", int(A.num_rows), int(A.num_cols), int(A.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-        
-        for(i=0; i < A.num_rows; i++) {
-            magma_index_t rowtemp1 = A.row[i];
-            magma_index_t rowtemp2 = A.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g %.16g\n",
-                    rowindex, ((A.col)[rowtemp1+j]+1), 
-                    MAGMA_Z_REAL((A.val)[rowtemp1+j]),
-                    MAGMA_Z_IMAG((A.val)[rowtemp1+j]) );
-            }
-            rowindex++;
-        }
-        #else
-        // real case
-        fprintf( fp, "%%%%MatrixMarket matrix coordinate real general\n" );
-        fprintf( fp, "%d %d %d\n", int(A.num_rows), int(A.num_cols), int(A.nnz));
-        
-        // TODO what's the difference between i (or i+1) and rowindex?
-        magma_index_t i=0, j=0, rowindex=1;
-                
-        for(i=0; i < B.num_rows; i++) {
-            magma_index_t rowtemp1 = A.row[i];
-            magma_index_t rowtemp2 = A.row[i+1];
-            for(j=0; j < rowtemp2 - rowtemp1; j++) {
-                fprintf( fp, "%d %d %.16g\n",
-                    rowindex, ((A.col)[rowtemp1+j]+1),
-                    MAGMA_Z_REAL((A.val)[rowtemp1+j]));
-            }
-            rowindex++;
-        }
-        #endif
-
-        if (fclose(fp) != 0)
-            printf("\n%% error: writing matrix failed\n");
-        else
-            printf(" done\n");
+        fprintf( fp, "%d %d %d\n", int(C->num_rows), int(C->num_cols), int(C->nnz));
+    }
+    info = magma_zwrite_csr_text( fp, *C, transposed );
+    
+    if ( fclose(fp) != 0 || info != 0 ) {
+        printf("\n%% error: writing matrix failed\n");
+        info = MAGMA_ERR_UNKNOWN;
+    }
+    else {
+        printf(" done\n");
     }
 cleanup:
+    magma_zmfree( &B, queue );
     return info;
 }
 
@@ -949,21 +1469,12 @@ magma_z_csr_mtx(
     magma_int_t info = 0;
 
     int csr_compressor = 0;       // checks for zeros in original file
-    
-    magma_z_matrix B={Magma_CSR};
-
-    magma_index_t *coo_col = NULL;
-    magma_index_t *coo_row = NULL;
-    magmaDoubleComplex *coo_val = NULL;
-    magmaDoubleComplex *new_val = NULL;
-    magma_index_t* new_row = NULL;
-    magma_index_t* new_col = NULL;
-    magma_int_t hermitian = 0;
+
+    long offset = 0;
     
     // make sure the target structure is empty
     magma_zmfree( A, queue );
     A->ownership = MagmaTrue;
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
     
     FILE *fid = NULL;
     MM_typecode matcode;
@@ -975,6 +1486,12 @@ magma_z_csr_mtx(
         goto cleanup;
     }
     
+    // binary CSR files, from magma_zwrite_csrtobin, need no parsing
+    if ( magma_csr_file_is_binary( filename )) {
+        CHECK( magma_z_csr_bin( A, filename, MagmaFalse, queue ));
+        goto cleanup;
+    }
+    
     printf("%% Reading sparse matrix from file (%s):", filename);
     fflush(stdout);
     
@@ -1010,189 +1527,30 @@ magma_z_csr_mtx(
         goto cleanup;
     }
     
+    offset = ftell( fid );
+    fclose(fid);
+    fid = NULL;
+    
     A->storage_type    = Magma_CSR;
     A->memory_location = Magma_CPU;
     A->num_rows        = num_rows;
     A->num_cols        = num_cols;
-    A->nnz             = num_nonzeros;
     A->fill_mode       = MagmaFull;
     
-    CHECK( magma_index_malloc_cpu( &coo_col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, A->nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, A->nnz ) );
-
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            if ( VAL == 0 )
-                csr_compressor = 1;
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
-        }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL );
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
-        }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
-        }
-        // printf(" ...successfully read complex matrix... ");
-    } else {
-        printf("\n%% Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        goto cleanup;
-    }
-    fclose(fid);
-    fid = NULL;
-    printf(" done. Converting to CSR:");
-    fflush(stdout);
-    
     A->sym = Magma_GENERAL;
-
-
-    if( mm_is_hermitian(matcode) ) {
-        hermitian = 1;
-    }
     if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
                                         // duplicate off diagonal entries
         printf("\n%% Detected symmetric case.");
         A->sym = Magma_SYMMETRIC;
-        magma_index_t off_diagonals = 0;
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            if (coo_row[i] != coo_col[i])
-                ++off_diagonals;
-        }
-        magma_index_t true_nonzeros = 2*off_diagonals + (A->nnz - off_diagonals);
-        
-        //printf("%% total number of nonzeros: %d\n%%", int(A->nnz));
-
-        CHECK( magma_index_malloc_cpu( &new_row, true_nonzeros ));
-        CHECK( magma_index_malloc_cpu( &new_col, true_nonzeros ));
-        CHECK( magma_zmalloc_cpu( &new_val, true_nonzeros ));
-        
-        magma_index_t ptr = 0;
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            if (coo_row[i] != coo_col[i]) {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-                new_col[ptr] = coo_row[i];
-                new_row[ptr] = coo_col[i];
-                new_val[ptr] = (hermitian == 0) ? coo_val[i] : conj(coo_val[i]);
-                ptr++;
-            } else {
-                new_row[ptr] = coo_row[i];
-                new_col[ptr] = coo_col[i];
-                new_val[ptr] = coo_val[i];
-                ptr++;
-            }
-        }
-        
-        magma_free_cpu(coo_row);
-        magma_free_cpu(coo_col);
-        magma_free_cpu(coo_val);
-
-        coo_row = new_row;
-        coo_col = new_col;
-        coo_val = new_val;
-        A->nnz = true_nonzeros;
-        //printf("total number of nonzeros: %d\n", A->nnz);
-    } // end symmetric case
-    
-    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ));
-    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ));
-    CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ));
-    
-    // original code from Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-        
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_ = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }    
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
-    coo_row = NULL;
-    coo_col = NULL;
-    coo_val = NULL;
-
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
-    }
-    (A->row)[A->num_rows] = A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
-        }
     }
+    
+    CHECK( magma_zmtx_read_csr( filename, offset, matcode,
+                                num_rows, num_cols, num_nonzeros, true,
+                                &A->nnz, &A->row, &A->col, &A->val,
+                                &csr_compressor, queue ));
 
-    if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
-        //printf("removing zeros: ");
-        CHECK( magma_zmtransfer( *A, &B, Magma_CPU, Magma_CPU, queue ));
-        CHECK( magma_z_csr_compressor(
-            &(A->val), &(A->row), &(A->col),
-            &B.val, &B.row, &B.col, &B.num_rows, queue ));
-        B.nnz = B.row[num_rows];
-        //printf(" remaining nonzeros:%d ", B.nnz);
-        magma_free_cpu( A->val );
-        magma_free_cpu( A->row );
-        magma_free_cpu( A->col );
-        *A = {Magma_CSR};
-        CHECK( magma_zmtransfer( B, A, Magma_CPU, Magma_CPU, queue ));
-        //printf("done.\n");
+    if ( csr_compressor > 0) { // remove zeros
+        magma_zcsr_remove_zeros( num_rows, A->row, A->col, A->val, &A->nnz );
     }
     A->true_nnz = A->nnz;
     printf(" done.\n");
@@ -1201,10 +1559,6 @@ cleanup:
         fclose( fid );
         fid = NULL;
     }
-    magma_zmfree( &B, queue );
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
     return info;
 }
 
@@ -1244,14 +1598,9 @@ magma_z_csr_mtxsymm(
     char buffer[ 1024 ];
     magma_int_t info = 0;
     
-    magma_z_matrix B={Magma_CSR};
-        
     int csr_compressor = 0;       // checks for zeros in original file
     
-    magma_index_t *coo_col=NULL, *coo_row=NULL;
-    magmaDoubleComplex *coo_val=NULL;
-
-    std::vector< std::pair< magma_index_t, magmaDoubleComplex > > rowval;
+    long offset = 0;
     
     FILE *fid = NULL;
     MM_typecode matcode;
@@ -1300,146 +1649,29 @@ magma_z_csr_mtxsymm(
         goto cleanup;
     }
     
+    offset = ftell( fid );
+    fclose(fid);
+    fid = NULL;
+    
     A->storage_type    = Magma_CSR;
     A->memory_location = Magma_CPU;
     A->num_rows        = num_rows;
     A->num_cols        = num_cols;
-    A->nnz             = num_nonzeros;
     A->fill_mode       = MagmaFull;
-  
-    CHECK( magma_index_malloc_cpu( &coo_col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &coo_row, A->nnz ) );
-    CHECK( magma_zmalloc_cpu( &coo_val, A->nnz ) );
-    
-    if (mm_is_real(matcode) || mm_is_integer(matcode)) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf \n", &ROW, &COL, &VAL);
-            if ( VAL == 0 )
-                csr_compressor = 1;
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, 0.);
-        }
-    } else if (mm_is_pattern(matcode) ) {
-        for(magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            
-            fscanf(fid, " %d %d \n", &ROW, &COL);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( 1.0, 0.);
-        }
-    } else if (mm_is_complex(matcode) ){
-        for (magma_int_t i = 0; i < A->nnz; ++i) {
-            magma_index_t ROW, COL;
-            double VAL, VALC;  // always read in a double and convert later if necessary
-            
-            fscanf(fid, " %d %d %lf %lf\n", &ROW, &COL, &VAL, &VALC);
-            
-            coo_row[i] = ROW - 1;
-            coo_col[i] = COL - 1;
-            coo_val[i] = MAGMA_Z_MAKE( VAL, VALC);
-        }
-        // printf(" ...successfully read complex matrix... ");
-    } else {
-        printf("Unrecognized data type\n");
-        info = MAGMA_ERR_NOT_SUPPORTED;
-        // TODO goto cleanup?
-    }
-    
-    fclose(fid);
-    fid = NULL;
-    printf(" done. Converting to CSR:");
-    fflush(stdout);
     
     A->sym = Magma_GENERAL;
-
     if ( mm_is_symmetric(matcode) || mm_is_hermitian(matcode) ) { 
             // do not duplicate off diagonal entries!
         A->sym = Magma_SYMMETRIC;
-    } // end symmetric case
-    
-    CHECK( magma_index_malloc_cpu( &A->col, A->nnz ) );
-    CHECK( magma_index_malloc_cpu( &A->row, A->num_rows+1 ) );
-    CHECK( magma_zmalloc_cpu( &A->val, A->nnz ) );
-
-    // original code from  Nathan Bell and Michael Garland
-    for (magma_index_t i = 0; i < num_rows; i++)
-        (A->row)[i] = 0;
-    
-    for (magma_index_t i = 0; i < A->nnz; i++)
-        (A->row)[coo_row[i]]++;
-    
-    // cumulative sum the nnz per row to get row[]
-    magma_int_t cumsum;
-    cumsum = 0;
-    for(magma_int_t i = 0; i < num_rows; i++) {
-        magma_index_t temp = (A->row)[i];
-        (A->row)[i] = cumsum;
-        cumsum += temp;
-    }
-    (A->row)[num_rows] = A->nnz;
-    
-    // write Aj,Ax into Bj,Bx
-    for(magma_int_t i = 0; i < A->nnz; i++) {
-        magma_index_t row_  = coo_row[i];
-        magma_index_t dest = (A->row)[row_];
-        (A->col)[dest] = coo_col[i];
-        (A->val)[dest] = coo_val[i];
-        (A->row)[row_]++;
-    }
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
-    coo_row = NULL;
-    coo_col = NULL;
-    coo_val = NULL;
-    
-    int last;
-    last = 0;
-    for(int i = 0; i <= num_rows; i++) {
-        int temp    = (A->row)[i];
-        (A->row)[i] = last;
-        last        = temp;
     }
     
-    (A->row)[A->num_rows]=A->nnz;
-    
-    // sort column indices within each row
-    // copy into vector of pairs (column index, value), sort by column index, then copy back
-    for (magma_index_t k=0; k < A->num_rows; ++k) {
-        int kk  = (A->row)[k];
-        int len = (A->row)[k+1] - (A->row)[k];
-        rowval.resize( len );
-        for( int i=0; i < len; ++i ) {
-            rowval[i] = std::make_pair( (A->col)[kk+i], (A->val)[kk+i] );
-        }
-        std::sort( rowval.begin(), rowval.end(), compare_first );
-        for( int i=0; i < len; ++i ) {
-            (A->col)[kk+i] = rowval[i].first;
-            (A->val)[kk+i] = rowval[i].second;
-        }
-    }
+    CHECK( magma_zmtx_read_csr( filename, offset, matcode,
+                                num_rows, num_cols, num_nonzeros, false,
+                                &A->nnz, &A->row, &A->col, &A->val,
+                                &csr_compressor, queue ));
 
-    if ( csr_compressor > 0) { // run the CSR compressor to remove zeros
-        //printf("removing zeros: ");
-        CHECK( magma_zmtransfer( *A, &B, Magma_CPU, Magma_CPU, queue ));
-        CHECK( magma_z_csr_compressor(
-            &(A->val), &(A->row), &(A->col),
-            &B.val, &B.row, &B.col, &B.num_rows, queue ));
-        B.nnz = B.row[num_rows];
-        //printf(" remaining nonzeros:%d ", B.nnz);
-        magma_free_cpu( A->val );
-        magma_free_cpu( A->row );
-        magma_free_cpu( A->col );
-        *A = {Magma_CSR};
-        CHECK( magma_zmtransfer( B, A, Magma_CPU, Magma_CPU, queue ));
-
-        //printf("done.\n");
+    if ( csr_compressor > 0) { // remove zeros
+        magma_zcsr_remove_zeros( num_rows, A->row, A->col, A->val, &A->nnz );
     }
     A->true_nnz = A->nnz;
     
@@ -1449,9 +1681,5 @@ cleanup:
         fclose( fid );
         fid = NULL;
     }
-    magma_zmfree( &B, queue );
-    magma_free_cpu(coo_row);
-    magma_free_cpu(coo_col);
-    magma_free_cpu(coo_val);
     return info;
 }
@@ -86,6 +86,9 @@ magma_zmtransfer(
     B->dtile_desc_offset = NULL;
     B->calibrator = NULL;
     B->dcalibrator = NULL;
+    B->lval = NULL;
+    B->lcol = NULL;
+    B->lcolbase = NULL;
     
 
     // first case: copy matrix from host to device
@@ -267,6 +270,7 @@ magma_zmtransfer(
             B->blocksize = A.blocksize;
             B->numblocks = A.numblocks;
             B->alignment = A.alignment;
+            B->sigma = A.sigma;
             // memory allocation
             CHECK( magma_zmalloc( &B->dval, A.nnz ));
             CHECK( magma_index_malloc( &B->dcol, A.nnz ));
@@ -275,6 +279,11 @@ magma_zmtransfer(
             magma_zsetvector( A.nnz, A.val, 1, B->dval, 1, queue );
             magma_index_setvector( A.nnz, A.col, 1, B->dcol, 1, queue );
             magma_index_setvector( A.numblocks + 1, A.row, 1, B->drow, 1, queue );
+            // row permutation of SELL-C-sigma
+            if ( A.rowidx != NULL ) {
+                CHECK( magma_index_malloc( &B->drowidx, A.num_rows ));
+                magma_index_setvector( A.num_rows, A.rowidx, 1, B->drowidx, 1, queue );
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -581,6 +590,7 @@ magma_zmtransfer(
             B->diameter = A.diameter;
             B->blocksize = A.blocksize;
             B->alignment = A.alignment;
+            B->sigma = A.sigma;
             B->numblocks = A.numblocks;
             // memory allocation
             CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
@@ -596,6 +606,14 @@ magma_zmtransfer(
             for( magma_int_t i=0; i<A.numblocks+1; i++ ) {
                 B->row[i] = A.row[i];
             }
+            // row permutation of SELL-C-sigma
+            if ( A.rowidx != NULL ) {
+                CHECK( magma_index_malloc_cpu( &B->rowidx, A.num_rows ));
+                #pragma omp parallel for
+                for( magma_int_t i=0; i<A.num_rows; i++ ) {
+                    B->rowidx[i] = A.rowidx[i];
+                }
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -906,6 +924,7 @@ magma_zmtransfer(
             B->blocksize = A.blocksize;
             B->numblocks = A.numblocks;
             B->alignment = A.alignment;
+            B->sigma = A.sigma;
             // memory allocation
             CHECK( magma_zmalloc_cpu( &B->val, A.nnz ));
             CHECK( magma_index_malloc_cpu( &B->col, A.nnz ));
@@ -914,6 +933,11 @@ magma_zmtransfer(
             magma_zgetvector( A.nnz, A.dval, 1, B->val, 1, queue );
             magma_index_getvector( A.nnz, A.dcol, 1, B->col, 1, queue );
             magma_index_getvector( A.numblocks + 1, A.drow, 1, B->row, 1, queue );
+            // row permutation of SELL-C-sigma
+            if ( A.drowidx != NULL ) {
+                CHECK( magma_index_malloc_cpu( &B->rowidx, A.num_rows ));
+                magma_index_getvector( A.num_rows, A.drowidx, 1, B->rowidx, 1, queue );
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
@@ -1188,6 +1212,7 @@ magma_zmtransfer(
             B->blocksize = A.blocksize;
             B->numblocks = A.numblocks;
             B->alignment = A.alignment;
+            B->sigma = A.sigma;
             // memory allocation
             CHECK( magma_zmalloc( &B->dval, A.nnz ));
             CHECK( magma_index_malloc( &B->dcol, A.nnz ));
@@ -1196,6 +1221,11 @@ magma_zmtransfer(
             magma_zcopyvector( A.nnz, A.dval, 1, B->dval, 1, queue );
             magma_index_copyvector( A.nnz, A.dcol, 1, B->dcol, 1, queue );
             magma_index_copyvector( A.numblocks + 1, A.drow, 1, B->drow, 1, queue );
+            // row permutation of SELL-C-sigma
+            if ( A.drowidx != NULL ) {
+                CHECK( magma_index_malloc( &B->drowidx, A.num_rows ));
+                magma_index_copyvector( A.num_rows, A.drowidx, 1, B->drowidx, 1, queue );
+            }
         }
         //CSR5-type
         else if ( A.storage_type == Magma_CSR5 ) {
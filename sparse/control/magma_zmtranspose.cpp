@@ -11,6 +11,7 @@
 
 */
 #include "magmasparse_internal.h"
+#include "magma_timer.h"
 
 #include <cuda.h>  // for CUDA_VERSION
 
@@ -226,6 +227,7 @@ magma_zmtranspose(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_profile_scope profile( "zmtranspose" );
     
     // make sure the target structure is empty
     magma_zmfree( B, queue );
@@ -234,6 +236,7 @@ magma_zmtranspose(
     } else {
         CHECK( magma_zmtranspose_cpu(A, B, queue) );
     }
+    profile.add_bytes( 2. * A.nnz * (sizeof(magmaDoubleComplex) + sizeof(magma_index_t)) );
     
 cleanup:
     return info;
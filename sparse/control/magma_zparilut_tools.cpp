@@ -4482,56 +4482,16 @@ magma_zparilut_set_approx_thrs(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_ptr tmp = NULL;
+    magma_int_t tmp_size = 0;
     
-    magma_int_t sample_size =  8192;
-    
-    magmaDoubleComplex element;
-    magmaDoubleComplex *val=NULL;
-    const magma_int_t incy = 1;
-    const magma_int_t incx = (int) (LU->nnz)/(sample_size);
-    magma_int_t loc_nnz;
-    double ratio;
-    magma_int_t loc_num_rm;
-    magma_int_t num_threads=1;
-    magmaDoubleComplex *elements = NULL;
-    magma_int_t lsize;
-    magma_int_t lnum_rm;
-    magmaDoubleComplex *lval;
-
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-     num_threads = 1;
-    loc_nnz = (int) LU->nnz/incx;
-    ratio = ((double)num_rm)/((double)LU->nnz);
-    loc_num_rm = (int) ((double)ratio*(double)loc_nnz);
-    CHECK( magma_zmalloc_cpu( &val, loc_nnz ));
-    blasf77_zcopy(&loc_nnz, LU->val, &incx, val, &incy );
-       
-    lsize = loc_nnz/num_threads;
-    lnum_rm = loc_num_rm/num_threads;
-
-    lval = val;
-    // compare with random select
-    if( order == 0 ){
-        magma_zselectrandom( lval, lsize, lnum_rm, queue );
-        element = (lval[lnum_rm]);
-    } else {
-         magma_zselectrandom( lval, lsize, lsize-lnum_rm, queue );
-        element = (lval[lsize-lnum_rm]);  
-    }
-               
-
-    *thrs = MAGMA_Z_ABS(element);
+    // one parallel counting pass over all values, no copy
+    CHECK( magma_zsampleselect_approx_cpu( LU->nnz,
+               ( order == 0 ? num_rm : LU->nnz-num_rm ),
+               LU->val, thrs, &tmp, &tmp_size, queue ));
 
 cleanup:
-    magma_free_cpu( val );
-    magma_free_cpu( elements );
+    magma_free_cpu( tmp );
     return info;
 }
 
@@ -4577,24 +4537,17 @@ magma_zparilut_set_thrs_randomselect(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_ptr tmp = NULL;
+    magma_int_t tmp_size = 0;
     
     magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    CHECK( magma_zmalloc_cpu( &val, size ));
     assert( size > num_rm );
-    blasf77_zcopy(&size, LU->val, &incx, val, &incx );
-    if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
-    } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
-    }
+    // parallel sample-select; LU is not changed
+    CHECK( magma_zsampleselect_cpu( size, ( order == 0 ? num_rm : size-num_rm ),
+               LU->val, thrs, &tmp, &tmp_size, queue ));
 
 cleanup:
-    magma_free_cpu( val );
+    magma_free_cpu( tmp );
     return info;
 }
 
@@ -4645,24 +4598,16 @@ magma_zparilut_set_thrs_L_scaled(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_ptr tmp = NULL;
+    magma_int_t tmp_size = 0;
     
     magma_int_t size =  L->nnz;
-    const magma_int_t incx = 1;
-    // copy as we may change the elements
-    magmaDoubleComplex *val=NULL;
-    CHECK( magma_zmalloc_cpu( &val, size ));
     assert( size > num_rm );
-    blasf77_zcopy(&size, L->val, &incx, val, &incx );
-    if( order == 0 ){
-        magma_zselectrandom( val, size, num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[num_rm]);
-    } else {
-         magma_zselectrandom( val, size, size-num_rm, queue );
-        *thrs = MAGMA_Z_ABS(val[size-num_rm]);  
-    }
+    CHECK( magma_zsampleselect_cpu( size, ( order == 0 ? num_rm : size-num_rm ),
+               L->val, thrs, &tmp, &tmp_size, queue ));
 
 cleanup:
-    magma_free_cpu( val );
+    magma_free_cpu( tmp );
     return info;
 }
 
@@ -4789,72 +4734,17 @@ magma_zparilut_set_thrs_randomselect_approx(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_ptr tmp = NULL;
+    magma_int_t tmp_size = 0;
     
-    magma_int_t size =  LU->nnz;
-    const magma_int_t incx = 1;
-    //magma_int_t incy = 1;
-    //magma_int_t nz_copy = LU->nnz;
-    magma_int_t num_threads = 1;
-    magma_int_t el_per_block;
-    //magma_int_t num_rm_loc;
-    magmaDoubleComplex *dthrs;
-    magmaDoubleComplex *val;
-    
-
-    if( LU->nnz <= 680){
-       CHECK( magma_zparilut_set_thrs_randomselect(
-           num_rm,
-           LU,
-           order,
-           thrs,
-           queue ) );
-    } else {
-        CHECK( magma_zmalloc_cpu( &val, size ));
-        blasf77_zcopy(&size, LU->val, &incx, val, &incx );
-        assert( size > num_rm );
-#ifdef _OPENMP
-    #pragma omp parallel
-    {
-        num_threads = omp_get_max_threads();
-    }
-#else
-    num_threads = 1;
-#endif
-        num_threads = 272;
-        CHECK( magma_zmalloc_cpu( &dthrs, num_threads ));
-        
-        
-        el_per_block = magma_ceildiv( LU->nnz, num_threads );
-        
-        #pragma omp parallel for
-        for( magma_int_t i=0; i<num_threads; i++ ){
-            magma_int_t start = min(i*el_per_block, size);
-            magma_int_t end = min((i+1)*el_per_block,LU->nnz);
-            magma_int_t loc_nz = end-start;
-            magma_int_t loc_rm = (int) (num_rm)/num_threads;
-            if( i == num_threads-1){
-                loc_rm = (int) (loc_nz * num_rm)/size;
-            }
-            if( loc_nz > loc_rm ){
-            if( order == 0 ){
-                magma_zselectrandom( val+start, loc_nz, loc_rm, queue );
-                dthrs[i] = val[start+loc_rm];
-            } else {
-                 magma_zselectrandom( val+start, loc_nz, loc_nz-loc_rm, queue );
-                dthrs[i] = val[start+loc_nz-loc_rm];  
-            }
-        }
-            
-        }
-        
-        // compute the median
-        magma_zselectrandom( dthrs, num_threads, (num_threads+1)/2, queue);
-        
-        *thrs = MAGMA_Z_ABS(dthrs[(num_threads+1)/2]);
-    }
+    assert( LU->nnz > num_rm );
+    // bucket counts in one parallel pass instead of one select per block
+    CHECK( magma_zsampleselect_approx_cpu( LU->nnz,
+               ( order == 0 ? num_rm : LU->nnz-num_rm ),
+               LU->val, thrs, &tmp, &tmp_size, queue ));
+
 cleanup:
-    magma_free_cpu( val );
-    magma_free_cpu( dthrs );
+    magma_free_cpu( tmp );
     return info;
 }
 
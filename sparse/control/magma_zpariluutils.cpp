@@ -128,20 +128,13 @@ magma_znonlinres(
         
     magmaDoubleComplex one = MAGMA_Z_MAKE( 1.0, 0.0 );
 
-    magma_z_matrix dL={Magma_CSR}, dU={Magma_CSR}, dLU={Magma_CSR}, A_t={Magma_CSR};
+    magma_z_matrix A_t={Magma_CSR};
     
     // make sure the target structure is empty
     magma_zmfree( LU, queue );
 
-    CHECK( magma_zmtransfer( L, &dL, Magma_CPU, Magma_DEV, queue  ));
-    CHECK( magma_zmtransfer( U, &dU, Magma_CPU, Magma_DEV, queue  ));
     CHECK( magma_zmtransfer( A, &A_t, Magma_CPU, Magma_CPU, queue  ));
-    CHECK( magma_z_spmm( one, dL, dU, &dLU, queue ));
-
-    CHECK( magma_zmtransfer(dLU, LU, Magma_DEV, Magma_CPU, queue ));
-    magma_zmfree( &dL, queue  );
-    magma_zmfree( &dU, queue  );
-    magma_zmfree( &dLU, queue  );
+    CHECK( magma_z_spmm( one, L, U, LU, queue ));
 
     // compute Frobenius norm of A-LU
     for(i=0; i<A.num_rows; i++){
@@ -176,9 +169,6 @@ cleanup:
         magma_zmfree( LU, queue  );
     }
     magma_zmfree( &A_t, queue  );
-    magma_zmfree( &dL, queue  );
-    magma_zmfree( &dU, queue  );
-    magma_zmfree( &dLU, queue  );
     return info;
 }
 
@@ -242,7 +232,7 @@ magma_zilures(
     
     magmaDoubleComplex one = MAGMA_Z_MAKE( 1.0, 0.0 );
 
-    magma_z_matrix LL={Magma_CSR}, dL={Magma_CSR}, dU={Magma_CSR}, dLU={Magma_CSR};
+    magma_z_matrix LL={Magma_CSR};
     
     // make sure the target structure is empty
     magma_zmfree( LU, queue );
@@ -279,17 +269,8 @@ magma_zilures(
         printf("error: L neither lower nor strictly lower triangular!\n");
     }
 
-    CHECK( magma_zmtransfer( LL, &dL, Magma_CPU, Magma_DEV, queue  ));
-    CHECK( magma_zmtransfer( U, &dU, Magma_CPU, Magma_DEV, queue  ));
+    CHECK( magma_z_spmm( one, LL, U, LU, queue ));
     magma_zmfree( &LL, queue );
-    CHECK( magma_z_spmm( one, dL, dU, &dLU, queue ));
-
-
-
-    CHECK( magma_zmtransfer(dLU, LU, Magma_DEV, Magma_CPU, queue ));
-    magma_zmfree( &dL, queue );
-    magma_zmfree( &dU, queue );
-    magma_zmfree( &dLU, queue );
 
     // compute Frobenius norm of A-LU
     for(i=0; i<A.num_rows; i++){
@@ -324,9 +305,6 @@ cleanup:
         magma_zmfree( LU, queue  );
     }
     magma_zmfree( &LL, queue );
-    magma_zmfree( &dL, queue  );
-    magma_zmfree( &dU, queue  );
-    magma_zmfree( &dLU, queue  );
     return info;
 }
 
@@ -392,20 +370,13 @@ magma_zicres(
 
     magmaDoubleComplex one = MAGMA_Z_MAKE( 1.0, 0.0 );
     
-    magma_z_matrix dL={Magma_CSR}, dU={Magma_CSR}, dLU={Magma_CSR};
-    
     // make sure the target structure is empty
     magma_zmfree( LU, queue );
     
     *res = 0.0;
     *nonlinres = 0.0;
 
-    CHECK( magma_zmtransfer( C, &dL, Magma_CPU, Magma_DEV, queue ));
-    CHECK( magma_zmtransfer( CT, &dU, Magma_CPU, Magma_DEV, queue ));
-    CHECK( magma_z_spmm( one, dL, dU, &dLU, queue ));
-    CHECK( magma_zmtransfer(dLU, LU, Magma_DEV, Magma_CPU, queue ));
-
-    magma_zmfree( &dLU, queue );
+    CHECK( magma_z_spmm( one, C, CT, LU, queue ));
 
     // compute Frobenius norm of A-LU
     for(i=0; i<A.num_rows; i++){
@@ -440,9 +411,6 @@ cleanup:
     if( info !=0 ){
         magma_zmfree( LU, queue  );
     }
-    magma_zmfree( &dL, queue  );
-    magma_zmfree( &dU, queue  );
-    magma_zmfree( &dLU, queue  );
     return info;
 }
 
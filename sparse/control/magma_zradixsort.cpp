@@ -0,0 +1,449 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <algorithm>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+// bits per radix digit
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+// below this size, sort with std::sort (introsort)
+#define RADIX_CUTOFF 1024
+
+// elements per thread; smaller arrays use fewer threads
+#define RADIX_PER_THREAD 32768
+
+
+/**
+    Purpose
+    -------
+    Key with the position of the element it was extracted from. Ordered by
+    key, then position, so sorting pairs is stable.
+*/
+template< typename K >
+struct radix_pair
+{
+    K key;
+    magma_index_t idx;
+
+    bool operator< ( const radix_pair& other ) const
+    {
+        return key < other.key || (key == other.key && idx < other.idx);
+    }
+};
+
+
+/**
+    Purpose
+    -------
+    Returns the sort key of a magnitude: for nonnegative doubles, the
+    order of the bit patterns as unsigned integers is the order of the
+    values.
+*/
+static inline uint64_t
+radix_abs_key( double a )
+{
+    uint64_t key;
+    memcpy( &key, &a, sizeof(key) );
+    return key;
+}
+
+
+/**
+    Purpose
+    -------
+    Returns the sort key of an index: the sign bit is flipped, so negative
+    indices sort first.
+*/
+static inline uint32_t
+radix_index_key( magma_index_t i )
+{
+    return uint32_t( i ) ^ 0x80000000u;
+}
+
+
+/**
+    Purpose
+    -------
+    Returns the number of threads for sorting n elements.
+*/
+static magma_int_t
+radix_threads( magma_int_t n )
+{
+    magma_int_t nthreads = 1;
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    return min( nthreads, n / RADIX_PER_THREAD + 1 );
+}
+
+
+/**
+    Purpose
+    -------
+    Stable LSD radix sort of keys key[0:n-1], with positions perm (may be
+    NULL), one RADIX_BITS digit per pass. key2 and perm2 are workspaces of
+    size n; counts has RADIX_SIZE*nthreads entries. Each thread counts the
+    digits of its part of the array, the offsets are a prefix sum over
+    (digit, thread), and each thread scatters its part. Passes where all
+    keys share the digit are skipped, e.g., the high bytes of small
+    indices. Returns 1 if the result is in key2, perm2, else 0.
+*/
+template< typename K >
+static magma_int_t
+radix_sort_keys(
+    magma_int_t n,
+    K *key,
+    magma_index_t *perm,
+    K *key2,
+    magma_index_t *perm2,
+    magma_int_t nthreads,
+    magma_int_t *counts )
+{
+    const int passes = int( sizeof(K) ) * 8 / RADIX_BITS;
+    magma_int_t swapped = 0;
+    magma_int_t skip = 0;
+
+    #pragma omp parallel num_threads( nthreads )
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        magma_int_t first = magma_int_t( int64_t( n ) * t / nt );
+        magma_int_t last  = magma_int_t( int64_t( n ) * (t+1) / nt );
+        magma_int_t *c = counts + t*RADIX_SIZE;
+
+        for (int pass = 0; pass < passes; ++pass) {
+            // the source and target of this pass
+            const K *src = (swapped ? key2 : key);
+            K *dst = (swapped ? key : key2);
+            const magma_index_t *psrc = (swapped ? perm2 : perm);
+            magma_index_t *pdst = (swapped ? perm : perm2);
+            int shift = pass * RADIX_BITS;
+
+            for (magma_int_t d = 0; d < RADIX_SIZE; ++d) {
+                c[d] = 0;
+            }
+            for (magma_int_t i = first; i < last; ++i) {
+                c[ (src[i] >> shift) & (RADIX_SIZE-1) ]++;
+            }
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                magma_int_t pos = 0;
+                skip = 0;
+                for (magma_int_t d = 0; d < RADIX_SIZE; ++d) {
+                    magma_int_t total = 0;
+                    for (magma_int_t s = 0; s < nt; ++s) {
+                        magma_int_t cs = counts[ s*RADIX_SIZE + d ];
+                        counts[ s*RADIX_SIZE + d ] = pos;
+                        pos += cs;
+                        total += cs;
+                    }
+                    skip = skip || (total == n);
+                }
+            }
+
+            if ( ! skip ) {
+                for (magma_int_t i = first; i < last; ++i) {
+                    magma_int_t p = c[ (src[i] >> shift) & (RADIX_SIZE-1) ]++;
+                    dst[p] = src[i];
+                    if ( psrc != NULL ) {
+                        pdst[p] = psrc[i];
+                    }
+                }
+                // all threads read swapped before the single above
+                #pragma omp barrier
+                #pragma omp single
+                swapped = ! swapped;
+            }
+            else {
+                #pragma omp barrier
+            }
+        }
+    }
+    return swapped;
+}
+
+
+/**
+    Purpose
+    -------
+    Sorts keys key[0:n-1] and the positions perm (may be NULL) in place,
+    with a radix sort for large arrays and std::sort for small ones.
+    Workspace is allocated here.
+*/
+template< typename K >
+static magma_int_t
+radix_sort(
+    magma_int_t n,
+    K *key,
+    magma_index_t *perm )
+{
+    magma_int_t info = 0;
+    K *key2 = NULL;
+    magma_index_t *perm2 = NULL;
+    magma_int_t *counts = NULL;
+    radix_pair<K> *pairs = NULL;
+    magma_int_t nthreads = radix_threads( n );
+
+    if ( n <= RADIX_CUTOFF ) {
+        if ( perm == NULL ) {
+            std::sort( key, key + n );
+        }
+        else {
+            CHECK( magma_malloc_cpu( (void**) &pairs, n*sizeof(radix_pair<K>) ));
+            for (magma_int_t i = 0; i < n; ++i) {
+                pairs[i].key = key[i];
+                pairs[i].idx = perm[i];
+            }
+            std::sort( pairs, pairs + n );
+            for (magma_int_t i = 0; i < n; ++i) {
+                key[i] = pairs[i].key;
+                perm[i] = pairs[i].idx;
+            }
+        }
+        goto cleanup;
+    }
+
+    CHECK( magma_malloc_cpu( (void**) &key2, n*sizeof(K) ));
+    if ( perm != NULL ) {
+        CHECK( magma_index_malloc_cpu( &perm2, n ));
+    }
+    CHECK( magma_malloc_cpu( (void**) &counts, nthreads*RADIX_SIZE*sizeof(magma_int_t) ));
+    if ( radix_sort_keys( n, key, perm, key2, perm2, nthreads, counts )) {
+        #pragma omp parallel for num_threads( nthreads )
+        for (magma_int_t i = 0; i < n; ++i) {
+            key[i] = key2[i];
+            if ( perm != NULL ) {
+                perm[i] = perm2[i];
+            }
+        }
+    }
+
+cleanup:
+    magma_free_cpu( key2 );
+    magma_free_cpu( perm2 );
+    magma_free_cpu( counts );
+    magma_free_cpu( pairs );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+    Reorders x[0:n-1] to x[ perm[i] ], using the workspace work of size n.
+*/
+template< typename T >
+static void
+radix_gather(
+    magma_int_t n,
+    const magma_index_t *perm,
+    T *x,
+    T *work,
+    magma_int_t nthreads )
+{
+    #pragma omp parallel num_threads( nthreads )
+    {
+        #pragma omp for
+        for (magma_int_t i = 0; i < n; ++i) {
+            work[i] = x[ perm[i] ];
+        }
+        #pragma omp for
+        for (magma_int_t i = 0; i < n; ++i) {
+            x[i] = work[i];
+        }
+    }
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sorts an array of values in increasing order of their magnitude on the
+    CPU, optionally carrying two index arrays along. The magnitudes are
+    computed once, in a key-extraction pass. Large arrays are sorted by a
+    stable parallel LSD radix sort on the keys, small ones by introsort
+    (std::sort). Unlike a quicksort, the run time does not degrade for
+    sorted input, and there is no recursion.
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the arrays
+
+    @param[in,out]
+    val         magmaDoubleComplex*
+                array to sort
+
+    @param[in,out]
+    col         magma_index_t*
+                array reordered with val, or NULL
+
+    @param[in,out]
+    row         magma_index_t*
+                array reordered with val, or NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zradixsort_abs(
+    magma_int_t n,
+    magmaDoubleComplex *val,
+    magma_index_t *col,
+    magma_index_t *row,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    uint64_t *key = NULL;
+    magma_index_t *perm = NULL;
+    magmaDoubleComplex *vwork = NULL;
+    magma_index_t *iwork = NULL;
+    magma_int_t nthreads = radix_threads( n );
+
+    if ( n <= 1 ) {
+        goto cleanup;
+    }
+
+    CHECK( magma_malloc_cpu( (void**) &key, n*sizeof(uint64_t) ));
+    CHECK( magma_index_malloc_cpu( &perm, n ));
+    #pragma omp parallel for num_threads( nthreads )
+    for (magma_int_t i = 0; i < n; ++i) {
+        key[i] = radix_abs_key( MAGMA_Z_ABS( val[i] ));
+        perm[i] = magma_index_t( i );
+    }
+    CHECK( radix_sort( n, key, perm ));
+
+    CHECK( magma_zmalloc_cpu( &vwork, n ));
+    radix_gather( n, perm, val, vwork, nthreads );
+    if ( col != NULL || row != NULL ) {
+        CHECK( magma_index_malloc_cpu( &iwork, n ));
+    }
+    if ( col != NULL ) {
+        radix_gather( n, perm, col, iwork, nthreads );
+    }
+    if ( row != NULL ) {
+        radix_gather( n, perm, row, iwork, nthreads );
+    }
+
+cleanup:
+    magma_free_cpu( key );
+    magma_free_cpu( perm );
+    magma_free_cpu( vwork );
+    magma_free_cpu( iwork );
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    Sorts an array of indices in increasing order on the CPU, optionally
+    carrying an array of values and an index array along. Large arrays
+    are sorted by a stable parallel LSD radix sort, skipping the digits
+    all indices share, small ones by introsort (std::sort).
+
+    Arguments
+    ---------
+
+    @param[in]
+    n           magma_int_t
+                length of the arrays
+
+    @param[in,out]
+    x           magma_index_t*
+                array to sort
+
+    @param[in,out]
+    val         magmaDoubleComplex*
+                array reordered with x, or NULL
+
+    @param[in,out]
+    y           magma_index_t*
+                array reordered with x, or NULL
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zradixsort_index(
+    magma_int_t n,
+    magma_index_t *x,
+    magmaDoubleComplex *val,
+    magma_index_t *y,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    uint32_t *key = NULL;
+    magma_index_t *perm = NULL;
+    magmaDoubleComplex *vwork = NULL;
+    magma_index_t *iwork = NULL;
+    magma_int_t nthreads = radix_threads( n );
+    bool carry = (val != NULL || y != NULL);
+
+    if ( n <= 1 ) {
+        goto cleanup;
+    }
+
+    CHECK( magma_malloc_cpu( (void**) &key, n*sizeof(uint32_t) ));
+    if ( carry ) {
+        CHECK( magma_index_malloc_cpu( &perm, n ));
+    }
+    #pragma omp parallel for num_threads( nthreads )
+    for (magma_int_t i = 0; i < n; ++i) {
+        key[i] = radix_index_key( x[i] );
+        if ( carry ) {
+            perm[i] = magma_index_t( i );
+        }
+    }
+    CHECK( radix_sort( n, key, perm ));
+    #pragma omp parallel for num_threads( nthreads )
+    for (magma_int_t i = 0; i < n; ++i) {
+        x[i] = magma_index_t( key[i] ^ 0x80000000u );
+    }
+
+    if ( val != NULL ) {
+        CHECK( magma_zmalloc_cpu( &vwork, n ));
+        radix_gather( n, perm, val, vwork, nthreads );
+    }
+    if ( y != NULL ) {
+        CHECK( magma_index_malloc_cpu( &iwork, n ));
+        radix_gather( n, perm, y, iwork, nthreads );
+    }
+
+cleanup:
+    magma_free_cpu( key );
+    magma_free_cpu( perm );
+    magma_free_cpu( vwork );
+    magma_free_cpu( iwork );
+    return info;
+}
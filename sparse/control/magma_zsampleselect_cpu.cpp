@@ -0,0 +1,429 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magmasparse_internal.h"
+
+// number of buckets; must be a power of 2, at most 256 (ids are bytes)
+#define SELECT_BUCKETS     256
+
+// sample elements per bucket
+#define SELECT_OVERSAMPLE  4
+
+#define SELECT_SAMPLE      (SELECT_BUCKETS*SELECT_OVERSAMPLE)
+
+// below this size, select sequentially
+#define SELECT_BASECASE    (16*SELECT_SAMPLE)
+
+
+/**
+    Purpose
+    -------
+    Makes sure the temporary storage *tmp_ptr holds required_size bytes,
+    reallocating it with some headroom if it is smaller.
+*/
+static magma_int_t
+select_realloc(
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_int_t required_size )
+{
+    magma_int_t info = 0;
+    if ( *tmp_size < required_size ) {
+        magma_int_t newsize = required_size * 5 / 4;
+        magma_free_cpu( *tmp_ptr );
+        *tmp_ptr = NULL;
+        *tmp_size = 0;
+        CHECK( magma_malloc_cpu( tmp_ptr, newsize ));
+        *tmp_size = newsize;
+    }
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+    Returns the position of sample element i in an array of size n >=
+    SELECT_SAMPLE: a pseudo-random position in the i-th of SELECT_SAMPLE
+    equal stripes, so sorted or periodic data is sampled evenly.
+*/
+static inline magma_int_t
+select_sample_index(
+    magma_int_t i,
+    magma_int_t n )
+{
+    int64_t lo = int64_t( i ) * n / SELECT_SAMPLE;
+    int64_t hi = int64_t( i+1 ) * n / SELECT_SAMPLE;
+    uint32_t hash = uint32_t( i ) * 2654435761u;
+    return magma_int_t( lo + int64_t( hash >> 8 ) % (hi - lo) );
+}
+
+
+/**
+    Purpose
+    -------
+    Sorts the sample and picks the SELECT_BUCKETS-1 splitters from it.
+    Bucket b holds the values x with splitters[b-1] <= x < splitters[b].
+*/
+static void
+select_splitters(
+    double *sample,
+    double *splitters )
+{
+    std::sort( sample, sample + SELECT_SAMPLE );
+    for (magma_int_t j = 0; j < SELECT_BUCKETS-1; ++j) {
+        splitters[j] = sample[ (j+1)*SELECT_OVERSAMPLE ];
+    }
+}
+
+
+/**
+    Purpose
+    -------
+    Returns the bucket of x, i.e., the number of splitters <= x, by a
+    binary search without branches over the sorted splitters.
+*/
+static inline magma_int_t
+select_bucket(
+    const double *splitters,
+    double x )
+{
+    magma_int_t b = 0;
+    for (magma_int_t step = SELECT_BUCKETS/2; step > 0; step /= 2) {
+        b += (splitters[ b + step - 1 ] <= x ? step : 0);
+    }
+    return b;
+}
+
+
+/**
+    Purpose
+    -------
+    One step of the sample-select on a[0:n-1]: counts the elements of each
+    bucket in parallel, with counts per thread, finds the bucket holding
+    rank *k, and gathers that bucket into out. On exit, *k is the rank
+    within the bucket. Returns the size of the bucket; if it equals n, out
+    is not written.
+*/
+static magma_int_t
+select_step(
+    const double *a,
+    magma_int_t n,
+    magma_int_t *k,
+    const double *splitters,
+    unsigned char *ids,
+    magma_int_t *counts,
+    magma_int_t nthreads,
+    double *out )
+{
+    magma_int_t *total = counts + nthreads*SELECT_BUCKETS;
+    magma_int_t bucket = 0;
+    magma_int_t rank = *k;
+
+    #pragma omp parallel num_threads( nthreads )
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        magma_int_t first = magma_int_t( int64_t( n ) * t / nt );
+        magma_int_t last  = magma_int_t( int64_t( n ) * (t+1) / nt );
+        magma_int_t *c = counts + t*SELECT_BUCKETS;
+        for (magma_int_t b = 0; b < SELECT_BUCKETS; ++b) {
+            c[b] = 0;
+        }
+        for (magma_int_t i = first; i < last; ++i) {
+            magma_int_t b = select_bucket( splitters, a[i] );
+            ids[i] = (unsigned char) b;
+            c[b]++;
+        }
+        #pragma omp barrier
+
+        #pragma omp single
+        {
+            for (magma_int_t b = 0; b < SELECT_BUCKETS; ++b) {
+                total[b] = 0;
+                for (magma_int_t s = 0; s < nt; ++s) {
+                    total[b] += counts[ s*SELECT_BUCKETS + b ];
+                }
+            }
+            while ( total[bucket] <= rank ) {
+                rank -= total[bucket];
+                bucket++;
+            }
+            // offsets of the threads' elements of the bucket in out
+            magma_int_t pos = 0;
+            for (magma_int_t s = 0; s < nt; ++s) {
+                magma_int_t cs = counts[ s*SELECT_BUCKETS + bucket ];
+                counts[ s*SELECT_BUCKETS + bucket ] = pos;
+                pos += cs;
+            }
+        }
+
+        if ( total[bucket] < n ) {
+            magma_int_t pos = counts[ t*SELECT_BUCKETS + bucket ];
+            for (magma_int_t i = first; i < last; ++i) {
+                if ( ids[i] == bucket ) {
+                    out[ pos++ ] = a[i];
+                }
+            }
+        }
+    }
+
+    *k = rank;
+    return total[bucket];
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects a threshold separating the subset_size smallest
+    magnitude elements from the rest, on the CPU: thrs is the magnitude of
+    the element of rank subset_size (counting from 0) in ascending order.
+    This is the host counterpart of magma_zsampleselect.
+
+    The magnitudes are split into 256 buckets by splitters taken from a
+    sorted sample. The buckets are counted in parallel with OpenMP, and
+    the search continues in the one bucket holding the rank, until it is
+    small enough for a sequential selection. val is not changed.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary storage on the CPU.
+                May be reallocated during execution.
+
+    @param[in,out]
+    tmp_size    magma_int_t*
+                pointer to size of temporary storage in bytes.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    const magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t nthreads = 1;
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    magma_int_t n = total_size, k = subset_size;
+    double *a, *b, *sample, *splitters;
+    magma_int_t *counts;
+    unsigned char *ids;
+
+    if ( subset_size < 0 || subset_size >= total_size ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+
+    CHECK( select_realloc( tmp_ptr, tmp_size,
+               sizeof(double) * (2*total_size + SELECT_SAMPLE + SELECT_BUCKETS)
+             + sizeof(magma_int_t) * (nthreads+1) * SELECT_BUCKETS
+             + total_size ));
+    a = (double*) *tmp_ptr;
+    b = a + total_size;
+    sample = b + total_size;
+    splitters = sample + SELECT_SAMPLE;
+    counts = (magma_int_t*) (splitters + SELECT_BUCKETS);
+    ids = (unsigned char*) (counts + (nthreads+1) * SELECT_BUCKETS);
+
+    #pragma omp parallel for
+    for (magma_int_t i = 0; i < total_size; ++i) {
+        a[i] = MAGMA_Z_ABS( val[i] );
+    }
+
+    while ( n > SELECT_BASECASE ) {
+        for (magma_int_t i = 0; i < SELECT_SAMPLE; ++i) {
+            sample[i] = a[ select_sample_index( i, n ) ];
+        }
+        select_splitters( sample, splitters );
+        magma_int_t m = select_step( a, n, &k, splitters, ids, counts, nthreads, b );
+        // no progress, e.g., if most values are equal
+        if ( m == n ) {
+            break;
+        }
+        std::swap( a, b );
+        n = m;
+    }
+    std::nth_element( a, a + k, a + n );
+    *thrs = a[k];
+
+cleanup:
+    return info;
+}
+
+
+/**
+    Purpose
+    -------
+
+    This routine selects an approximate threshold separating the
+    subset_size smallest magnitude elements from the rest, on the CPU.
+    This is the host counterpart of magma_zsampleselect_approx.
+
+    The magnitudes are split into 256 buckets by splitters taken from a
+    sorted sample, and counted in a single parallel pass over val, without
+    copying it. thrs is the lower splitter of the bucket holding the rank
+    subset_size, so about subset_size elements are smaller than thrs, up
+    to the size of one bucket. For small arrays, the exact threshold from
+    magma_zsampleselect_cpu is returned.
+
+    Arguments
+    ---------
+
+    @param[in]
+    total_size  magma_int_t
+                size of array val
+
+    @param[in]
+    subset_size magma_int_t
+                number of smallest elements to separate
+
+    @param[in]
+    val         magmaDoubleComplex*
+                array containing the values
+
+    @param[out]
+    thrs        double*
+                computed threshold
+
+    @param[in,out]
+    tmp_ptr     magma_ptr*
+                pointer to pointer to temporary storage on the CPU.
+                May be reallocated during execution.
+
+    @param[in,out]
+    tmp_size    magma_int_t*
+                pointer to size of temporary storage in bytes.
+                May be increased during execution.
+
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zaux
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    const magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue )
+{
+    magma_int_t info = 0;
+    magma_int_t nthreads = 1;
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    magma_int_t bucket = 0, rank = subset_size;
+    double *sample, *splitters;
+    magma_int_t *counts, *total;
+
+    if ( subset_size < 0 || subset_size >= total_size ) {
+        info = MAGMA_ERR_ILLEGAL_VALUE;
+        goto cleanup;
+    }
+    if ( total_size <= SELECT_BASECASE ) {
+        info = magma_zsampleselect_cpu( total_size, subset_size, val, thrs,
+                                        tmp_ptr, tmp_size, queue );
+        goto cleanup;
+    }
+
+    CHECK( select_realloc( tmp_ptr, tmp_size,
+               sizeof(double) * (SELECT_SAMPLE + SELECT_BUCKETS)
+             + sizeof(magma_int_t) * (nthreads+1) * SELECT_BUCKETS ));
+    sample = (double*) *tmp_ptr;
+    splitters = sample + SELECT_SAMPLE;
+    counts = (magma_int_t*) (splitters + SELECT_BUCKETS);
+    total = counts + nthreads * SELECT_BUCKETS;
+
+    for (magma_int_t i = 0; i < SELECT_SAMPLE; ++i) {
+        sample[i] = MAGMA_Z_ABS( val[ select_sample_index( i, total_size ) ] );
+    }
+    select_splitters( sample, splitters );
+
+    for (magma_int_t b = 0; b < SELECT_BUCKETS; ++b) {
+        total[b] = 0;
+    }
+    #pragma omp parallel num_threads( nthreads )
+    {
+        magma_int_t t = 0, nt = 1;
+        #ifdef _OPENMP
+        t  = omp_get_thread_num();
+        nt = omp_get_num_threads();
+        #endif
+        magma_int_t first = magma_int_t( int64_t( total_size ) * t / nt );
+        magma_int_t last  = magma_int_t( int64_t( total_size ) * (t+1) / nt );
+        magma_int_t *c = counts + t*SELECT_BUCKETS;
+        for (magma_int_t b = 0; b < SELECT_BUCKETS; ++b) {
+            c[b] = 0;
+        }
+        for (magma_int_t i = first; i < last; ++i) {
+            c[ select_bucket( splitters, MAGMA_Z_ABS( val[i] )) ]++;
+        }
+        #pragma omp critical
+        for (magma_int_t b = 0; b < SELECT_BUCKETS; ++b) {
+            total[b] += c[b];
+        }
+    }
+
+    while ( total[bucket] <= rank ) {
+        rank -= total[bucket];
+        bucket++;
+    }
+    *thrs = (bucket > 0 ? splitters[ bucket-1 ] : sample[0]);
+
+cleanup:
+    return info;
+}
@@ -608,6 +608,13 @@ magma_zsolverinfo_init(
     precond_par->U_dgraphindegree = NULL;
     precond_par->L_dgraphindegree_bak = NULL;
     precond_par->U_dgraphindegree_bak = NULL;
+    precond_par->L_levelptr = NULL;
+    precond_par->L_levelrows = NULL;
+    precond_par->U_levelptr = NULL;
+    precond_par->U_levelrows = NULL;
+    precond_par->trisolve_done = NULL;
+    precond_par->L_num_levels = 0;
+    precond_par->U_num_levels = 0;
 
 cleanup:
     if( info != 0 ){
@@ -27,7 +27,9 @@
     Purpose
     -------
 
-    Sorts an array of values in increasing order.
+    Sorts an array of values in increasing order of their magnitude.
+    Uses magma_zradixsort_abs: a parallel radix sort for large arrays,
+    introsort for small ones.
 
     Arguments
     ---------
@@ -61,31 +63,8 @@ magma_zsort(
 {
     magma_int_t info = 0;
 
-    magmaDoubleComplex temp;
-    magma_index_t pivot,j,i;
-
     if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( MAGMA_Z_ABS(x[i]) <= MAGMA_Z_ABS(x[pivot]) && i<last )
-                i++;
-            while( MAGMA_Z_ABS(x[j]) > MAGMA_Z_ABS(x[pivot]) )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-            }
-        }
-
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-        CHECK( magma_zsort( x, first, j-1, queue ));
-        CHECK( magma_zsort( x, j+1, last, queue ));
+        CHECK( magma_zradixsort_abs( last-first+1, x+first, NULL, NULL, queue ));
     }
 cleanup:
     return info;
@@ -96,7 +75,10 @@ cleanup:
     Purpose
     -------
 
-    Sorts an array of values in increasing order.
+    Sorts an array of values in increasing order of their magnitude,
+    updates the respective column and row indices.
+    Uses magma_zradixsort_abs: a parallel radix sort for large arrays,
+    introsort for small ones.
 
     Arguments
     ---------
@@ -140,37 +122,9 @@ magma_zmsort(
 {
     magma_int_t info = 0;
 
-    magmaDoubleComplex temp;
-    magma_index_t pivot,j,i, tmpcol, tmprow;
-
     if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( MAGMA_Z_ABS(x[i]) <= MAGMA_Z_ABS(x[pivot]) && i<last )
-                i++;
-            while( MAGMA_Z_ABS(x[j]) > MAGMA_Z_ABS(x[pivot]) )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-                tmpcol = col[i];
-                col[i] = col[j];
-                col[j] = tmpcol;
-                tmprow = row[i];
-                row[i] = row[j];
-                row[j] = tmprow;
-            }
-        }
-
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-        CHECK( magma_zmsort( x, col, row, first, j-1, queue ));
-        CHECK( magma_zmsort( x, col, row, j+1, last, queue ));
+        CHECK( magma_zradixsort_abs( last-first+1, x+first,
+                                     col+first, row+first, queue ));
     }
 cleanup:
     return info;
@@ -182,6 +136,8 @@ cleanup:
     -------
 
     Sorts an array of integers in increasing order.
+    Uses magma_zradixsort_index: a parallel radix sort for large arrays,
+    introsort for small ones.
 
     Arguments
     ---------
@@ -215,30 +171,8 @@ magma_zindexsort(
 {
     magma_int_t info = 0;
 
-    magma_index_t pivot,j,temp,i;
-
     if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( x[i]<=x[pivot] && i<last )
-                i++;
-            while( x[j]>x[pivot] )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-            }
-        }
-
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-        CHECK( magma_zindexsort( x, first, j-1, queue ));
-        CHECK( magma_zindexsort( x, j+1, last, queue ));
+        CHECK( magma_zradixsort_index( last-first+1, x+first, NULL, NULL, queue ));
     }
 cleanup:
     return info;
@@ -250,6 +184,8 @@ cleanup:
     -------
 
     Sorts an array of integers, updates a respective array of values.
+    Uses magma_zradixsort_index: a parallel radix sort for large arrays,
+    introsort for small ones.
 
     Arguments
     ---------
@@ -288,38 +224,8 @@ magma_zindexsortval(
 {
     magma_int_t info = 0;
 
-    magma_index_t pivot,j,temp,i;
-    magmaDoubleComplex tempval;
-
     if(first<last){
-         pivot=first;
-         i=first;
-         j=last;
-
-        while(i<j){
-            while( x[i]<=x[pivot] && i<last )
-                i++;
-            while( x[j]>x[pivot] )
-                j--;
-            if( i<j ){
-                temp = x[i];
-                x[i] = x[j];
-                x[j] = temp;
-                tempval = y[i];
-                y[i] = y[j];
-                y[j] = tempval;
-            }
-        }
-
-        temp=x[pivot];
-        x[pivot]=x[j];
-        x[j]=temp;
-
-        tempval=y[pivot];
-        y[pivot]=y[j];
-        y[j]=tempval;
-        CHECK( magma_zindexsortval( x, y, first, j-1, queue ));
-        CHECK( magma_zindexsortval( x, y, j+1, last, queue ));
+        CHECK( magma_zradixsort_index( last-first+1, x+first, y+first, NULL, queue ));
     }
 cleanup:
     return info;
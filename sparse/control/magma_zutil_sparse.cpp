@@ -39,6 +39,10 @@ static const char *usage_sparse =
 "               CSR, ELL, SELLP, CUSPARSECSR, CSR5.\n"
 " --blocksize x Set a specific blocksize for SELL-P format.\n"
 " --alignment x Set a specific alignment for SELL-P format.\n"
+" --mixed_spmv k For CG with A in CSR on the CPU, only in the z and d precisions:\n"
+"               1 stores the values in single precision for SpMV,\n"
+"               2 also 16-bit column offsets. testing_zsolver then solves\n"
+"               on the CPU.\n"
 " --mscale      Possibility to scale the original matrix:\n"
 "               NOSCALE   no scaling\n"
 "               UNITDIAG   symmetric scaling to unit diagonal\n"
@@ -114,6 +118,7 @@ magma_zparse_opts(
     opts->input_location = Magma_CPU;
     opts->output_location = Magma_CPU;
     opts->scaling = Magma_NOSCALE;
+    opts->mixed_spmv = 0;
     #if defined(PRECISION_z) | defined(PRECISION_d)
         opts->solver_par.atol = 1e-16;
         opts->solver_par.rtol = 1e-10;
@@ -427,6 +432,14 @@ magma_zparse_opts(
             opts->blocksize = atoi( argv[++i] );
         } else if ( strcmp("--alignment", argv[i]) == 0 && i+1 < argc ) {
             opts->alignment = atoi( argv[++i] );
+        } else if ( strcmp("--mixed_spmv", argv[i]) == 0 && i+1 < argc ) {
+            opts->mixed_spmv = atoi( argv[++i] );
+            #if defined(PRECISION_c) | defined(PRECISION_s)
+            if ( opts->mixed_spmv != 0 ) {
+                printf( "%% warning: --mixed_spmv is only for the z and d precisions; ignored.\n" );
+                opts->mixed_spmv = 0;
+            }
+            #endif
         } else if ( strcmp("--verbose", argv[i]) == 0 && i+1 < argc ) {
             opts->solver_par.verbose = atoi( argv[++i] );
         }  else if ( strcmp("--maxiter", argv[i]) == 0 && i+1 < argc ) {
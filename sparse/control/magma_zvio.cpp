@@ -8,6 +8,13 @@
        @precisions normal z -> s d c
        @author Hartwig Anzt
 */
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "magma_mapfile.h"  // before magma_internal.h's min, max macros
 #include "magmasparse_internal.h"
 
 #define COMPLEX
@@ -106,6 +113,11 @@ cleanup:
     -------
 
     Reads in a double vector of length "length".
+    The file has one entry per line: a real value, or if the first line
+    has two numbers, a real and imaginary part.
+
+    The file is memory mapped and split into line-aligned chunks,
+    which are parsed in parallel.
 
     Arguments
     ---------
@@ -116,7 +128,8 @@ cleanup:
 
     @param[in]
     length      magma_int_t
-                length of vector
+                length of vector; the vector has room for at least this
+                many entries, and num_rows is the number read.
     @param[in]
     filename    char*
                 file where vector is stored
@@ -137,11 +150,12 @@ magma_zvread(
 {
     magma_int_t info = 0;
     
-    magma_int_t nnz=0, i=0;
-    FILE *fid;
-    char buff[BUFSIZ]={0};
-    int count=0;
-    char *p;
+    magma_mapfile file;
+    std::vector< const char* > bounds;
+    std::vector< magma_int_t > chunk_start;
+    const char *begin, *end, *p;
+    magma_int_t nthreads = 1, nchunk, n, nbad = 0;
+    int count = 0;
     
     // make sure the target structure is empty
     magma_zmfree( x, queue );
@@ -153,92 +167,79 @@ magma_zvread(
     x->num_cols = 1;
     x->major = MagmaColMajor;
     
-    fid = fopen(filename, "r");
-
-    if(NULL==fgets(buff, BUFSIZ, fid))
-        return -1;
-    rewind(fid);
-    for( p=buff; NULL != strtok(p, " \t\n"); p=NULL)
-        count++;
-    while( !feof(fid) )
-    {
-        double VAL1;
-
-        magmaDoubleComplex VAL;
-        
-        #if defined(PRECISION_z) || defined(PRECISION_d)
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%lg %lg\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%lg\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #else // single-complex or single
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%g %g\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%g\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #endif
-        
-        if ( VAL != MAGMA_Z_ZERO )
-            nnz++;
-        i++;
+    info = file.open( filename );
+    if ( info != 0 ) {
+        printf("%% Unable to open file %s\n", filename);
+        goto cleanup;
+    }
+    begin = file.data();
+    end   = file.data() + file.size();
+    if ( begin == end ) {
+        info = -1;
+        goto cleanup;
     }
     
-    x->num_rows = i;
-    x->nnz = i;
-    i=0; nnz=0; count=0;
-    // printf("n:%d\n");
+    // count numbers on first line: 2 means complex entries
+    p = begin;
+    while ( p < end && *p != '\n' ) {
+        p = magma_skip_blanks( p, end );
+        if ( p < end && *p != '\n' ) {
+            count++;
+            while ( ! magma_is_token_end( p, end ))
+                ++p;
+        }
+    }
     
-    CHECK( magma_zmalloc_cpu( &x->val, length ));
+    // several chunks per thread to balance load, but at least 64 KiB each
+    #ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+    #endif
+    nchunk = max( 1, min( 4*nthreads, magma_int_t( (end - begin) / 65536 )));
+    magma_mapfile_split_lines( begin, end, nchunk, bounds );
     
-    rewind(fid);
-    for( p=buff; NULL != strtok(p, " \t\n"); p=NULL)
-        count++;
-    //while( i<length )  // eof() is 'true' at the end of data
-    while( !feof(fid) )
-    {
-        double VAL1;
-
-        magmaDoubleComplex VAL;
-        
-        #if defined(PRECISION_z) || defined(PRECISION_d)
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%lg %lg\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%lg\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #else // single-complex or single
-            double VAL2;
-            if( count == 2 ){
-                fscanf(fid, "%g %g\n", &VAL1, &VAL2);
-                VAL = MAGMA_Z_MAKE(VAL1, VAL2);
-            }else{
-                fscanf(fid, "%g\n", &VAL1);
-                VAL = MAGMA_Z_MAKE(VAL1, 0.0);  
-            }
-        #endif
-        
-        if ( VAL != MAGMA_Z_ZERO )
-            nnz++;
-        x->val[i] = VAL;
-        i++;
+    // count entries in each chunk, to find where each chunk's entries go
+    chunk_start.resize( nchunk+1 );
+    chunk_start[0] = 0;
+    #pragma omp parallel for schedule(dynamic,1)
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        chunk_start[k+1] = magma_mapfile_count_lines( bounds[k], bounds[k+1] );
+    }
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        chunk_start[k+1] += chunk_start[k];
     }
-    fclose(fid);
+    n = chunk_start[nchunk];
     
-    // magma_zprint_vector( *x, 0, x->num_rows, queue );
+    CHECK( magma_zmalloc_cpu( &x->val, max( length, n )));
+    x->num_rows = n;
+    x->nnz = n;
     
+    #pragma omp parallel for schedule(dynamic,1) reduction(+:nbad)
+    for (magma_int_t k = 0; k < nchunk; ++k) {
+        magma_int_t i = chunk_start[k];
+        const char *q = bounds[k], *chunk_end = bounds[k+1];
+        while ( q < chunk_end ) {
+            q = magma_skip_blanks( q, chunk_end );
+            if ( q < chunk_end && *q != '\n' ) {
+                double VAL1 = 0, VAL2 = 0;
+                const char *r = magma_parse_real( q, chunk_end, &VAL1 );
+                if ( r != NULL && count == 2 )
+                    r = magma_parse_real( r, chunk_end, &VAL2 );
+                nbad += (r == NULL);
+                x->val[i] = MAGMA_Z_MAKE( VAL1, VAL2 );
+                ++i;
+            }
+            q = magma_next_line( q, chunk_end );
+        }
+    }
+    if ( nbad > 0 ) {
+        printf("%% File %s has %lld invalid entries.\n", filename, (long long) nbad );
+        info = MAGMA_ERR_UNKNOWN;
+    }
     
 cleanup:
+    if ( info != 0 ) {
+        magma_zmfree( x, queue );
+    }
     return info;
 }
 
@@ -275,19 +276,19 @@ magma_zvspread(
 {
     magma_int_t info = 0;
     
-    magma_z_matrix A={Magma_CSR}, B={Magma_CSR};
-    magma_int_t entry=0;
+    magma_z_matrix A={Magma_CSR};
     magma_zmfree( x, queue );
     x->ownership = MagmaTrue;
      //   char *vfilename[] = {"/mnt/sparse_matrices/mtx/rail_79841_B.mtx"};
     CHECK( magma_z_csr_mtx( &A,  filename, queue  ));
-    CHECK( magma_zmconvert( A, &B, Magma_CSR, Magma_DENSE, queue ));
     CHECK( magma_zvinit( x, Magma_CPU, A.num_cols, A.num_rows, MAGMA_Z_ZERO, queue ));
     x->major = MagmaRowMajor;
-    for(magma_int_t i=0; i<A.num_cols; i++) {
-        for(magma_int_t j=0; j<A.num_rows; j++) {
-            x->val[i*A.num_rows+j] = B.val[ i+j*A.num_cols ];
-            entry++;
+    // entry (j, i) goes to x->val[ i*A.num_rows + j ];
+    // scattered directly from CSR, without converting A to dense
+    #pragma omp parallel for
+    for(magma_int_t j=0; j<A.num_rows; j++) {
+        for(magma_int_t k=A.row[j]; k<A.row[j+1]; k++) {
+            x->val[ A.col[k]*A.num_rows + j ] = A.val[k];
         }
     }
     x->num_rows = A.num_rows;
@@ -295,15 +296,46 @@ magma_zvspread(
     
 cleanup:
     magma_zmfree( &A, queue );
-    magma_zmfree( &B, queue );
     return info;
 }
 
+/**
+    Purpose
+    -------
+    Arguments for format_vector_chunk, which formats chunk k of vector x,
+    entries k*chunk_size, ..., (k+1)*chunk_size - 1 (fewer in the last
+    chunk), one per line. Used with magma_write_chunks.
+*/
+struct vector_text
+{
+    const magmaDoubleComplex *val;
+    magma_int_t n;
+    magma_int_t chunk_size;
+};
+
+static char* format_vector_chunk( magma_int_t k, char* p, void* arg )
+{
+    const vector_text& x = *(const vector_text*) arg;
+    magma_int_t last = min( x.n, (k+1)*x.chunk_size );
+    for (magma_int_t i = k*x.chunk_size; i < last; ++i) {
+        p = magma_format_real( p, MAGMA_Z_REAL( x.val[i] ));
+        #ifdef COMPLEX
+        *p++ = ' ';
+        p = magma_format_real( p, MAGMA_Z_IMAG( x.val[i] ));
+        #endif
+        *p++ = '\n';
+    }
+    return p;
+}
+
+
 /**
     Purpose
     -------
 
-    Writes a vector to a file.
+    Writes a vector to a file, one entry per line, the same as fprintf
+    with "%.16g %.16g\n", or "%.16g\n" if real. Chunks of entries are
+    formatted in parallel and written in order.
 
     Arguments
     ---------
@@ -329,9 +361,13 @@ magma_zwrite_vector(
     const char *filename,
     magma_queue_t queue )
 {
-    magma_int_t i, info = 0;
+    magma_int_t info = 0;
+    
+    // line is 1 or 2 values, with space and newline
+    const size_t max_line = 2*(c_format_real_len + 1);
     
     FILE *fp;
+    vector_text arg;
     
     fp = fopen(filename, "w");
     if ( fp == NULL ){
@@ -339,27 +375,18 @@ magma_zwrite_vector(
         info = -1;
         goto cleanup;
     }
-            
-    #define COMPLEX
-
-    #ifdef COMPLEX
-    // complex case
-    for(i=0; i < A.num_rows; i++) {
-        fprintf( fp, "%.16g %.16g\n",
-            MAGMA_Z_REAL((A.val)[i]),
-            MAGMA_Z_IMAG((A.val)[i]) );
-    }
-    #else
-    for(i=0; i < A.num_rows; i++) {
-        fprintf( fp, "%.16g\n",
-            MAGMA_Z_REAL((A.val)[i]) );
-    }
-    #endif
     
-    if (fclose(fp) != 0)
-        printf("\n%% error: writing matrix failed\n");
-    else
-        info = 0;
+    arg.val        = A.val;
+    arg.n          = A.num_rows;
+    arg.chunk_size = 32768;
+    info = magma_write_chunks( fp, magma_ceildiv( arg.n, arg.chunk_size ),
+                               arg.chunk_size * max_line,
+                               format_vector_chunk, &arg );
+    
+    if (fclose(fp) != 0 || info != 0) {
+        printf("\n%% error: writing vector failed\n");
+        info = MAGMA_ERR_UNKNOWN;
+    }
 
 cleanup:
     return info;
@@ -151,6 +151,10 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sigma;                   // opt: info for SELL-C-sigma
+        magmaFloatComplex *lval;             // opt: single-precision values CPU case
+        unsigned short *lcol;                // opt: 16-bit column offsets from lcolbase CPU case
+        magma_index_t *lcolbase;             // opt: column base per row block, or -1 CPU case
     } magma_z_matrix;
 
     typedef struct magma_c_matrix
@@ -235,6 +239,10 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sigma;                   // opt: info for SELL-C-sigma
+        magmaFloatComplex *lval;             // opt: unused in single precision
+        unsigned short *lcol;                // opt: unused in single precision
+        magma_index_t *lcolbase;             // opt: unused in single precision
     } magma_c_matrix;
 
     typedef struct magma_d_matrix
@@ -319,6 +327,10 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sigma;                   // opt: info for SELL-C-sigma
+        float *lval;                         // opt: single-precision values CPU case
+        unsigned short *lcol;                // opt: 16-bit column offsets from lcolbase CPU case
+        magma_index_t *lcolbase;             // opt: column base per row block, or -1 CPU case
     } magma_d_matrix;
 
     typedef struct magma_s_matrix
@@ -403,6 +415,10 @@ extern "C"
         magma_index_t csr5_tail_tile_start;  // opt: info for CSR5
         magma_order_t major;                 // opt: row/col major for dense matrices
         magma_int_t ld;                      // opt: leading dimension for dense
+        magma_int_t sigma;                   // opt: info for SELL-C-sigma
+        float *lval;                         // opt: unused in single precision
+        unsigned short *lcol;                // opt: unused in single precision
+        magma_index_t *lcolbase;             // opt: unused in single precision
     } magma_s_matrix;
 
     // for backwards compatability, make these aliases.
@@ -692,6 +708,13 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_index_t *L_levelptr;           // for host trisolve: level sets
+        magma_index_t *L_levelrows;          // for host trisolve: level sets
+        magma_index_t *U_levelptr;           // for host trisolve: level sets
+        magma_index_t *U_levelrows;          // for host trisolve: level sets
+        magma_index_t *trisolve_done;        // for host sync-free trisolve
+        magma_int_t L_num_levels;            // for host trisolve
+        magma_int_t U_num_levels;            // for host trisolve
 
         /* was merge conflict, assume master */
         magma_ilu_info_t cuinfoILU;
@@ -753,6 +776,13 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_index_t *L_levelptr;           // for host trisolve: level sets
+        magma_index_t *L_levelrows;          // for host trisolve: level sets
+        magma_index_t *U_levelptr;           // for host trisolve: level sets
+        magma_index_t *U_levelrows;          // for host trisolve: level sets
+        magma_index_t *trisolve_done;        // for host sync-free trisolve
+        magma_int_t L_num_levels;            // for host trisolve
+        magma_int_t U_num_levels;            // for host trisolve
 
         magma_ilu_info_t cuinfoILU;
         magma_solve_info_t cuinfoL;
@@ -813,6 +843,13 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_index_t *L_levelptr;           // for host trisolve: level sets
+        magma_index_t *L_levelrows;          // for host trisolve: level sets
+        magma_index_t *U_levelptr;           // for host trisolve: level sets
+        magma_index_t *U_levelrows;          // for host trisolve: level sets
+        magma_index_t *trisolve_done;        // for host sync-free trisolve
+        magma_int_t L_num_levels;            // for host trisolve
+        magma_int_t U_num_levels;            // for host trisolve
 
         magma_ilu_info_t cuinfoILU;
         magma_solve_info_t cuinfoL;
@@ -873,6 +910,13 @@ typedef struct magma_solve_info_t
         magma_index_t *L_dgraphindegree_bak; // for sync-free trisolve
         magma_index_t *U_dgraphindegree;     // for sync-free trisolve
         magma_index_t *U_dgraphindegree_bak; // for sync-free trisolve
+        magma_index_t *L_levelptr;           // for host trisolve: level sets
+        magma_index_t *L_levelrows;          // for host trisolve: level sets
+        magma_index_t *U_levelptr;           // for host trisolve: level sets
+        magma_index_t *U_levelrows;          // for host trisolve: level sets
+        magma_index_t *trisolve_done;        // for host sync-free trisolve
+        magma_int_t L_num_levels;            // for host trisolve
+        magma_int_t U_num_levels;            // for host trisolve
 
         magma_ilu_info_t cuinfoILU;
         magma_solve_info_t cuinfoL;
@@ -908,6 +952,7 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t mixed_spmv;
     } magma_zopts;
 
     typedef struct magma_copts
@@ -924,6 +969,7 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t mixed_spmv;
     } magma_copts;
 
     typedef struct magma_dopts
@@ -940,6 +986,7 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t mixed_spmv;
     } magma_dopts;
 
     typedef struct magma_sopts
@@ -956,6 +1003,7 @@ typedef struct magma_solve_info_t
         magma_location_t input_location;
         magma_location_t output_location;
         magma_scale_t scaling;
+        magma_int_t mixed_spmv;
     } magma_sopts;
 
 #ifdef __cplusplus
@@ -97,6 +97,13 @@ magma_z_csr_mtx(
     const char *filename,
     magma_queue_t queue );
 
+magma_int_t 
+magma_z_csr_bin( 
+    magma_z_matrix *A, 
+    const char *filename,
+    magma_bool_t map,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zcsrset( 
     magma_int_t m, 
@@ -352,6 +359,22 @@ magma_zsort(
     magma_int_t last,
     magma_queue_t queue );
 
+magma_int_t
+magma_zradixsort_abs(
+    magma_int_t n,
+    magmaDoubleComplex *val,
+    magma_index_t *col,
+    magma_index_t *row,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zradixsort_index(
+    magma_int_t n,
+    magma_index_t *x,
+    magmaDoubleComplex *val,
+    magma_index_t *y,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zbitonic_sort(
     magma_int_t start, 
@@ -424,6 +447,26 @@ magma_zselectrandom(
     magma_int_t k,
     magma_queue_t queue );
 
+magma_int_t
+magma_zsampleselect_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    const magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zsampleselect_approx_cpu(
+    magma_int_t total_size,
+    magma_int_t subset_size,
+    const magmaDoubleComplex *val,
+    double *thrs,
+    magma_ptr *tmp_ptr,
+    magma_int_t *tmp_size,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zdomainoverlap(
     magma_index_t num_rows,
@@ -461,6 +504,12 @@ magma_zwrite_csrtomtx(
     const char *filename,
     magma_queue_t queue );
 
+magma_int_t 
+magma_zwrite_csrtobin( 
+    magma_z_matrix A,
+    const char *filename,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zprint_csr( 
     magma_int_t n_row, 
@@ -1598,6 +1647,14 @@ magma_zcsr_sort(
     magma_z_matrix *A,
     magma_queue_t queue);
 
+magma_int_t
+magma_zcsr_sort_rows_cpu(
+    magma_int_t num_rows,
+    const magma_index_t *row,
+    magma_index_t *col,
+    magmaDoubleComplex *val,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zcsr_sort_gpu(
     magma_z_matrix *A,
@@ -1608,6 +1665,12 @@ magma_zcsr_sort_gpu(
  -- MAGMA_SPARSE function definitions / Data on CPU
 */
 
+magma_int_t 
+magma_zcg_cpu(
+    magma_z_matrix A, magma_z_matrix b, 
+    magma_z_matrix *x, magma_z_solver_par *solver_par,
+    magma_queue_t queue );
+
 
 /* ////////////////////////////////////////////////////////////////////////////
  -- MAGMA_SPARSE supernodal and RCM reordering
@@ -2204,6 +2267,25 @@ magma_zapplycumilu_l_transpose(
     magma_z_preconditioner *precond,
     magma_queue_t queue );
 
+magma_int_t
+magma_zilugeneratesolverinfo_cpu(
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zapplyilu_l_cpu(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zapplyilu_r_cpu(
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_z_preconditioner *precond,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zapplycumilu_r_transpose(
     magma_z_matrix b, magma_z_matrix *x, 
@@ -2303,6 +2385,14 @@ magma_zcuspmm(
     magma_z_matrix *AB,
     magma_queue_t queue );
 
+magma_int_t
+magma_zspmm_cpu(
+    magmaDoubleComplex alpha,
+    magma_z_matrix A,
+    magma_z_matrix B,
+    magma_z_matrix *AB,
+    magma_queue_t queue );
+
 magma_int_t
 magma_z_spmm(
     magmaDoubleComplex alpha, 
@@ -2326,6 +2416,20 @@ magma_zcuspaxpy(
     magma_z_matrix *AB,
     magma_queue_t queue );
 
+magma_int_t
+magma_zspaxpy_cpu(
+    magmaDoubleComplex alpha, magma_z_matrix A,
+    magmaDoubleComplex beta, magma_z_matrix B,
+    magma_z_matrix *AB,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zspaxpy_values_cpu(
+    magmaDoubleComplex alpha, magma_z_matrix A,
+    magmaDoubleComplex beta, magma_z_matrix B,
+    magma_z_matrix *AB,
+    magma_queue_t queue );
+
 magma_int_t
 magma_z_precond(
     magma_z_matrix A, 
@@ -2478,6 +2582,51 @@ magma_zgecsrmv_shift(
     magmaDoubleComplex_ptr dy,
     magma_queue_t queue );
 
+magma_int_t
+magma_zgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zgecsrmv_shift_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    magmaDoubleComplex lambda,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magma_int_t offset,
+    magma_int_t blocksize,
+    const magma_index_t *addrows,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgecsrmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    magma_order_t major,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
 magma_int_t 
 magma_zmgecsrmv(
     magma_trans_t transA,
@@ -2648,6 +2797,42 @@ magma_zmgesellpmv(
     magmaDoubleComplex_ptr dy,
     magma_queue_t queue );
 
+magma_int_t
+magma_zgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zmgesellpmv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t num_vecs,
+    magma_int_t blocksize,
+    magma_int_t slices,
+    magma_int_t alignment,
+    magmaDoubleComplex alpha,
+    const magmaDoubleComplex *val,
+    const magma_index_t *col,
+    const magma_index_t *row,
+    const magma_index_t *rowperm,
+    magma_order_t major,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zmgesellpmv_blocked(
     magma_trans_t transA,
@@ -2690,6 +2875,51 @@ magma_zgecsr5mv(
     magmaDoubleComplex_ptr  dy,
     magma_queue_t           queue );
 
+magma_int_t
+magma_zgecsr5mv_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magma_int_t p,
+    magmaDoubleComplex alpha,
+    magma_int_t sigma,
+    magma_int_t bit_y_offset,
+    magma_int_t bit_scansum_offset,
+    magma_int_t num_packet,
+    const magma_uindex_t *tile_ptr,
+    const magma_uindex_t *tile_desc,
+    const magma_index_t *tile_desc_offset_ptr,
+    const magma_index_t *tile_desc_offset,
+    magmaDoubleComplex *calibrator,
+    magma_int_t tail_tile_start,
+    const magmaDoubleComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcsrtrsv_analysis_cpu(
+    magma_uplo_t uplo,
+    magma_z_matrix T,
+    magma_int_t *num_levels,
+    magma_index_t **levelptr,
+    magma_index_t **levelrows,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcsrtrsv_cpu(
+    magma_solver_type trisolver,
+    magma_z_matrix T,
+    magma_int_t num_levels,
+    const magma_index_t *levelptr,
+    const magma_index_t *levelrows,
+    magma_index_t *done,
+    magma_z_matrix b,
+    magma_z_matrix *x,
+    magma_queue_t queue );
+
 magma_int_t
 magma_zgecscsyncfreetrsm_analysis(
     magma_int_t             m, 
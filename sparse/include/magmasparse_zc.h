@@ -99,6 +99,32 @@ magma_zlag2c_CSR_DENSE_convert(
  -- MAGMA_SPARSE function definitions / Data on CPU
 */
 
+magma_int_t
+magma_zcmixed_prec_setup_cpu(
+    magma_z_matrix *A,
+    magma_int_t packcols,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcmixed_prec_free_cpu(
+    magma_z_matrix *A,
+    magma_queue_t queue );
+
+magma_int_t
+magma_zcgecsrmv_mixed_prec_cpu(
+    magma_trans_t transA,
+    magma_int_t m, magma_int_t n,
+    magmaDoubleComplex alpha,
+    const magmaFloatComplex *val,
+    const magma_index_t *row,
+    const magma_index_t *col,
+    const unsigned short *lcol,
+    const magma_index_t *lcolbase,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex beta,
+    magmaDoubleComplex *y,
+    magma_queue_t queue );
+
 
 /* ////////////////////////////////////////////////////////////////////////////
  -- MAGMA_SPARSE function definitions / Data on CPU / Multi-GPU
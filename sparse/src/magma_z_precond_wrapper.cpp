@@ -267,7 +267,8 @@ magma_z_precondsetup(
         ( precond->solver == Magma_ILU      || 
             precond->solver == Magma_PARILU   || 
             precond->solver == Magma_ICC    || 
-            precond->solver == Magma_PARIC ) ) {  // also prepare the transpose
+            precond->solver == Magma_PARIC ) &&
+        precond->L_levelptr == NULL ) {  // also prepare the transpose
         info = magma_zcumilusetup_transpose( A, precond, queue );
         if( info == 0 && 
             ( precond->trisolver == Magma_ISAI  ||
@@ -431,6 +432,10 @@ magma_z_applyprecond_left(
         if ( precond->solver == Magma_JACOBI ) {
             CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
         }
+        else if ( precond->L_levelptr != NULL ) {
+            // factors on the CPU, analyzed by magma_zilugeneratesolverinfo_cpu
+            CHECK( magma_zapplyilu_l_cpu( b, x, precond, queue ));
+        }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
                   ( precond->trisolver == Magma_CUSOLVE ||
@@ -487,6 +492,10 @@ magma_z_applyprecond_left(
         if ( precond->solver == Magma_JACOBI ) {
             CHECK( magma_zjacobi_diagscal( b.num_rows, precond->d, b, x, queue ));
         }
+        else if ( precond->L_levelptr != NULL ) {
+            printf( "error: transposed solves with factors on the CPU not supported.\n" );
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
                   ( precond->trisolver == Magma_CUSOLVE ||
@@ -601,6 +610,10 @@ magma_z_applyprecond_right(
         if ( precond->solver == Magma_JACOBI ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );    // x = b
         }
+        else if ( precond->L_levelptr != NULL ) {
+            // factors on the CPU, analyzed by magma_zilugeneratesolverinfo_cpu
+            CHECK( magma_zapplyilu_r_cpu( b, x, precond, queue ));
+        }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
                   ( precond->trisolver == Magma_CUSOLVE ||
@@ -661,6 +674,10 @@ magma_z_applyprecond_right(
         if ( precond->solver == Magma_JACOBI ) {
             magma_zcopy( b.num_rows*b.num_cols, b.dval, 1, x->dval, 1, queue );    // x = b
         }
+        else if ( precond->L_levelptr != NULL ) {
+            printf( "error: transposed solves with factors on the CPU not supported.\n" );
+            info = MAGMA_ERR_NOT_SUPPORTED;
+        }
         else if ( ( precond->solver == Magma_ILU ||
                     precond->solver == Magma_PARILU ) && 
                   ( precond->trisolver == Magma_CUSOLVE ||
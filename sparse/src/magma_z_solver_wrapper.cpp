@@ -11,6 +11,8 @@
 */
 #include "magmasparse_internal.h"
 
+#define PRECISION_z
+
 
 /**
     Purpose
@@ -18,6 +20,8 @@
 
     This is an interface that allows to use any iterative solver on the linear
     system Ax = b. All linear algebra objects are expected to be on the device,
+    except for CG (Magma_CG, Magma_CGMERGE, and Magma_PCG or Magma_PCGMERGE
+    without preconditioner), which runs on the CPU if A is on the CPU;
     the linear algebra objects are MAGMA-sparse specific structures 
     (dense matrix b, dense matrix x, sparse/dense matrix A).
     The additional parameter zopts contains information about the solver
@@ -26,6 +30,8 @@
     * the relative / absolute stopping criterion
     * the maximum number of iterations
     * the preconditioner type
+    * single-precision values for the SpMV of a CSR matrix on the CPU,
+      used by CG with A, b, and x on the CPU (magma_zcg_cpu)
     * ...
     Please see magmasparse_types.h for details about the fields and
     magma_zutil_sparse.cpp for the possible options.
@@ -62,12 +68,44 @@ magma_z_solver(
     magma_queue_t queue )
 {
     magma_int_t info = 0;
+    magma_int_t mixed = 0;
     
     // make sure RHS is a dense matrix
     if ( b.storage_type != Magma_DENSE ) {
         printf( "error: sparse RHS not yet supported.\n" );
         return MAGMA_ERR_NOT_SUPPORTED;
     }
+    // A on the CPU: CG runs on the CPU, with single-precision values for
+    // the SpMV of a CSR matrix if zopts->mixed_spmv > 0.
+    // The other solvers need A on the device.
+    if ( A.memory_location == Magma_CPU && b.num_cols == 1 &&
+         ( zopts->solver_par.solver == Magma_CG ||
+           zopts->solver_par.solver == Magma_CGMERGE ||
+           ( ( zopts->solver_par.solver == Magma_PCG ||
+               zopts->solver_par.solver == Magma_PCGMERGE ) &&
+             zopts->precond_par.solver == Magma_NONE ) ) )
+    {
+        #if defined(PRECISION_z) || defined(PRECISION_d)
+        if ( zopts->mixed_spmv > 0 && A.lval == NULL &&
+             ( A.storage_type == Magma_CSR  ||
+               A.storage_type == Magma_CSRL ||
+               A.storage_type == Magma_CSRU ) )
+        {
+            // on a copy of the values owned here
+            #if defined(PRECISION_z)
+            CHECK( magma_zcmixed_prec_setup_cpu( &A, zopts->mixed_spmv > 1, queue ));
+            #else
+            CHECK( magma_dsmixed_prec_setup_cpu( &A, zopts->mixed_spmv > 1, queue ));
+            #endif
+            mixed = 1;
+        }
+        #endif
+        CHECK( magma_zcg_cpu( A, b, x, &zopts->solver_par, queue ));
+        goto cleanup;
+    }
+    if ( zopts->mixed_spmv > 0 ) {
+        printf( "%% warning: mixed_spmv needs A on the CPU and the CG solver; ignored.\n" );
+    }
     if( b.num_cols == 1 ){
         switch( zopts->solver_par.solver ) {
             case  Magma_BICG:
@@ -161,5 +199,12 @@ magma_z_solver(
         }
     }
 cleanup:
+    if ( mixed ) {
+        #if defined(PRECISION_z)
+        magma_zcmixed_prec_free_cpu( &A, queue );
+        #elif defined(PRECISION_d)
+        magma_dsmixed_prec_free_cpu( &A, queue );
+        #endif
+    }
     return info; 
 }
@@ -0,0 +1,195 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+
+       @precisions normal z -> s d c
+*/
+
+#include "magmasparse_internal.h"
+
+#define RTOLERANCE     lapackf77_dlamch( "E" )
+#define ATOLERANCE     lapackf77_dlamch( "E" )
+
+
+/**
+    Purpose
+    -------
+
+    Solves a system of linear equations
+       A * X = B
+    where A is a complex Hermitian N-by-N positive definite matrix A.
+    This is a CPU implementation of the Conjugate Gradient method, for
+    A, b, and x on the CPU. The SpMV is done by magma_z_spmv, so a CSR
+    matrix prepared by magma_zcmixed_prec_setup_cpu is applied with its
+    values in single precision.
+
+    Arguments
+    ---------
+
+    @param[in]
+    A           magma_z_matrix
+                input matrix A, on the CPU
+
+    @param[in]
+    b           magma_z_matrix
+                RHS b, on the CPU
+
+    @param[in,out]
+    x           magma_z_matrix*
+                solution approximation, on the CPU
+
+    @param[in,out]
+    solver_par  magma_z_solver_par*
+                solver parameters
+    @param[in]
+    queue       magma_queue_t
+                Queue to execute in.
+
+    @ingroup magmasparse_zposv
+    ********************************************************************/
+
+extern "C" magma_int_t
+magma_zcg_cpu(
+    magma_z_matrix A, magma_z_matrix b, magma_z_matrix *x,
+    magma_z_solver_par *solver_par,
+    magma_queue_t queue )
+{
+    magma_int_t info = MAGMA_NOTCONVERGED;
+
+    // prepare solver feedback
+    solver_par->solver = Magma_CG;
+    solver_par->numiter = 0;
+    solver_par->spmv_count = 0;
+
+    // local variables
+    magmaDoubleComplex c_zero = MAGMA_Z_ZERO, c_one = MAGMA_Z_ONE,
+                       c_neg_one = MAGMA_Z_NEG_ONE;
+    const magma_int_t ione = 1;
+
+    magma_int_t dofs = A.num_rows * b.num_cols;
+
+    // CPU workspace
+    magma_z_matrix r={Magma_CSR}, p={Magma_CSR}, q={Magma_CSR};
+
+    // solver variables
+    magmaDoubleComplex alpha, beta, neg_alpha;
+    double nom, nom0, r0, betanom, betanomsq, den, nomb;
+
+    //Chronometry
+    real_Double_t tempo1, tempo2;
+
+    if ( A.memory_location != Magma_CPU || b.memory_location != Magma_CPU ||
+         x->memory_location != Magma_CPU ) {
+        printf( "error: magma_zcg_cpu requires A, b, and x on the CPU.\n" );
+        info = MAGMA_ERR_NOT_SUPPORTED;
+        goto cleanup;
+    }
+
+    CHECK( magma_zvinit( &r, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &p, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+    CHECK( magma_zvinit( &q, Magma_CPU, A.num_rows, b.num_cols, c_zero, queue ));
+
+    // solver setup
+    CHECK( magma_z_spmv( c_neg_one, A, *x, c_zero, r, queue ));          // r = -A x
+    blasf77_zaxpy( &dofs, &c_one, b.val, &ione, r.val, &ione );          // r = b - A x
+    blasf77_zcopy( &dofs, r.val, &ione, p.val, &ione );                  // p = r
+    nom0 = magma_cblas_dznrm2( dofs, r.val, 1 );
+    betanom = nom0;
+    nom  = nom0 * nom0;                                // nom = r' * r
+    CHECK( magma_z_spmv( c_one, A, p, c_zero, q, queue ));             // q = A p
+    den = MAGMA_Z_REAL( magma_cblas_zdotc( dofs, p.val, 1, q.val, 1 )); // den = p dot q
+    solver_par->init_res = nom0;
+
+    nomb = magma_cblas_dznrm2( dofs, b.val, 1 );
+    if ( nomb == 0.0 ){
+        nomb=1.0;
+    }
+    if ( (r0 = nomb * solver_par->rtol) < ATOLERANCE ){
+        r0 = ATOLERANCE;
+    }
+    solver_par->final_res = solver_par->init_res;
+    solver_par->iter_res = solver_par->init_res;
+    if ( solver_par->verbose > 0 ) {
+        solver_par->res_vec[0] = (real_Double_t)nom0;
+        solver_par->timing[0] = 0.0;
+    }
+    if ( nom0 < r0 ) {
+        info = MAGMA_SUCCESS;
+        goto cleanup;
+    }
+    // check positive definite
+    if (den <= 0.0) {
+        info = MAGMA_NONSPD;
+        goto cleanup;
+    }
+
+    tempo1 = magma_wtime();
+
+    // start iteration
+    do
+    {
+        solver_par->numiter++;
+        alpha = MAGMA_Z_MAKE(nom/den, 0.);
+        neg_alpha = MAGMA_Z_NEGATE( alpha );
+        blasf77_zaxpy( &dofs, &alpha,     p.val, &ione, x->val, &ione );  // x = x + alpha p
+        blasf77_zaxpy( &dofs, &neg_alpha, q.val, &ione, r.val,  &ione );  // r = r - alpha q
+        betanom = magma_cblas_dznrm2( dofs, r.val, 1 );                   // betanom = || r ||
+        betanomsq = betanom * betanom;                      // betanoms = r' * r
+        solver_par->iter_res = betanom;
+
+        if ( solver_par->verbose > 0 ) {
+            tempo2 = magma_wtime();
+            if ( (solver_par->numiter)%solver_par->verbose==0 ) {
+                solver_par->res_vec[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) betanom;
+                solver_par->timing[(solver_par->numiter)/solver_par->verbose]
+                        = (real_Double_t) tempo2-tempo1;
+            }
+        }
+
+        if (  betanom  < r0 ) {
+            break;
+        }
+
+        beta = MAGMA_Z_MAKE(betanomsq/nom, 0.);           // beta = betanoms/nom
+        blasf77_zscal( &dofs, &beta, p.val, &ione );                      // p = beta*p
+        blasf77_zaxpy( &dofs, &c_one, r.val, &ione, p.val, &ione );       // p = p + r
+        CHECK( magma_z_spmv( c_one, A, p, c_zero, q, queue ));   // q = A p
+        solver_par->spmv_count++;
+        den = MAGMA_Z_REAL( magma_cblas_zdotc( dofs, p.val, 1, q.val, 1 ));
+                // den = p dot q
+        nom = betanomsq;
+    }
+    while ( solver_par->numiter+1 <= solver_par->maxiter );
+
+    tempo2 = magma_wtime();
+    solver_par->runtime = (real_Double_t) tempo2-tempo1;
+    double residual;
+    CHECK( magma_z_spmv( c_neg_one, A, *x, c_zero, r, queue ));          // r = -A x
+    blasf77_zaxpy( &dofs, &c_one, b.val, &ione, r.val, &ione );          // r = b - A x
+    residual = magma_cblas_dznrm2( dofs, r.val, 1 );
+    solver_par->final_res = residual;
+
+    if ( solver_par->numiter < solver_par->maxiter ) {
+        info = MAGMA_SUCCESS;
+    } else if ( solver_par->init_res > solver_par->final_res ) {
+        info = MAGMA_SLOW_CONVERGENCE;
+        if( solver_par->iter_res < solver_par->rtol*nomb ){
+            info = MAGMA_SUCCESS;
+        }
+    }
+    else {
+        info = MAGMA_DIVERGENCE;
+    }
+
+cleanup:
+    magma_zmfree(&r, queue );
+    magma_zmfree(&p, queue );
+    magma_zmfree(&q, queue );
+
+    solver_par->info = info;
+    return info;
+}   /* magma_zcg_cpu */
@@ -38,7 +38,11 @@
 
     @param[in]
     b           magma_z_matrix
-                input RHS b
+                input RHS b. By default, the factors are copied to the
+                device. If b is on the CPU and precond->trisolver is
+                Magma_CUSOLVE or Magma_SYNCFREESOLVE, the factors stay on
+                the CPU, and the preconditioner can then only be applied
+                to vectors on the CPU, with the host triangular solves.
 
     @param[in,out]
     precond     magma_z_preconditioner*
@@ -100,24 +104,31 @@ magma_zparic_cpu(
     }
     
 
-    CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_DEV, queue));
-    CHECK(magma_z_cucsrtranspose(precond->L, &precond->U, queue));
-    CHECK(magma_zmtransfer(precond->L, &precond->M, Magma_DEV, Magma_DEV, queue));
-    
-    if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
-        CHECK(magma_zcumicgeneratesolverinfo(precond, queue));
+    if (b.memory_location == Magma_CPU &&
+        (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE ||
+         precond->trisolver == Magma_SYNCFREESOLVE)) {
+        // opt-in by a host b: keep the factors on the CPU for the host
+        // triangular solves, so the preconditioner applies to host vectors
+        CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_CPU, queue));
+        CHECK(magma_zmtranspose(hAL, &precond->U, queue));
+        CHECK(magma_zilugeneratesolverinfo_cpu(precond, queue));
     } else {
-        //prepare for iterative solves
-
-        // extract the diagonal of L into precond->d
-        CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
-        CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
-            MAGMA_Z_ZERO, queue));
-
-        // extract the diagonal of U into precond->d2
-        CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
-        CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
-            MAGMA_Z_ZERO, queue));
+        CHECK(magma_zmtransfer(hAL, &precond->L, Magma_CPU, Magma_DEV, queue));
+        CHECK(magma_z_cucsrtranspose(precond->L, &precond->U, queue));
+        CHECK(magma_zmtransfer(precond->L, &precond->M, Magma_DEV, Magma_DEV, queue));
+        if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
+            CHECK(magma_zcumicgeneratesolverinfo(precond, queue));
+        } else {
+            //prepare for iterative solves
+            // extract the diagonal of L into precond->d
+            CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
+            CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
+                MAGMA_Z_ZERO, queue));
+            // extract the diagonal of U into precond->d2
+            CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
+            CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
+                MAGMA_Z_ZERO, queue));
+        }
     }
 
 cleanup:
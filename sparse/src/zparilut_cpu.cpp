@@ -11,6 +11,7 @@
 */
 
 #include "magmasparse_internal.h"
+#include "magma_timer.h"
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -53,7 +54,11 @@
 
     @param[in]
     b           magma_z_matrix
-                input RHS b
+                input RHS b. By default, the factors are copied to the
+                device. If b is on the CPU and precond->trisolver is
+                Magma_CUSOLVE or Magma_SYNCFREESOLVE, the factors stay on
+                the CPU, and the preconditioner can then only be applied
+                to vectors on the CPU, with the host triangular solves.
 
     @param[in,out]
     precond     magma_z_preconditioner*
@@ -99,6 +104,9 @@ magma_zparilut_cpu(
     {
         num_threads = omp_get_max_threads();
     }
+
+    // before first CHECK, so goto cleanup does not skip its initialization
+    magma_profile_scope profile( "zparilut_cpu" );
     
     CHECK(magma_zmtransfer(A, &hA, A.memory_location, Magma_CPU, queue));
     
@@ -137,26 +145,34 @@ magma_zparilut_cpu(
      
         // step 1: transpose U
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu transpose U" );
         magma_zmfree(&UT, queue);
         CHECK(magma_zcsrcoo_transpose(U, &UT, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_transpose1+=end-start;
         
         
         // step 2: find candidates
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu candidates" );
         CHECK(magma_zparilut_candidates(L0, U0, L, UT, &hL, &hU, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_cand=+end-start;
         
         
         // step 3: compute residuals (optional when adding all candidates)
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu residuals" );
         CHECK(magma_zparilut_residuals(hA, L, U, &hL, queue));
         CHECK(magma_zparilut_residuals(hA, L, U, &hU, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_res=+end-start;
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu norm" );
         CHECK(magma_zmatrix_abssum(hL, &sumL, queue));
         CHECK(magma_zmatrix_abssum(hU, &sumU, queue));
         sum = sumL + sumU;
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_nrm+=end-start;
         CHECK(magma_zmatrix_swap(&hL, &oneL, queue));
         magma_zmfree(&hL, queue);
@@ -164,21 +180,27 @@ magma_zparilut_cpu(
         
         // step 4: sort candidates
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu sort" );
         CHECK(magma_zcsr_sort(&hL, queue));
         CHECK(magma_zcsr_sort(&hU, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_sort+=end-start;
         
         
         // step 5: transpose candidates
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu transpose candidates" );
         magma_zcsrcoo_transpose(hU, &oneU, queue);
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_transpose2+=end-start;
         
         
         // step 6: add candidates
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu add" );
         CHECK(magma_zmatrix_cup(L, oneL, &L_new, queue));   
         CHECK(magma_zmatrix_cup(U, oneU, &U_new, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_add=+end-start;
         magma_zmfree(&oneL, queue);
         magma_zmfree(&oneU, queue);
@@ -186,12 +208,15 @@ magma_zparilut_cpu(
         
         // step 7: sweep
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu sweep1" );
         CHECK(magma_zparilut_sweep_sync(&hA, &L_new, &U_new, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_sweep1+=end-start;
         
         
         // step 8: select threshold to remove elements
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu select" );
         num_rmL = max((L_new.nnz-L0nnz*(1+(precond->atol-1.)
             *(iters+1)/precond->sweeps)), 0);
         num_rmU = max((U_new.nnz-U0nnz*(1+(precond->atol-1.)
@@ -213,23 +238,28 @@ magma_zparilut_cpu(
         }
         magma_zmfree(&oneL, queue);
         magma_zmfree(&oneU, queue);
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_selectrm=end-start;
 
         
         // step 9: remove elements
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu remove" );
         CHECK(magma_zparilut_thrsrm(1, &L_new, &thrsL, queue));
         CHECK(magma_zparilut_thrsrm(1, &U_new, &thrsU, queue));
         CHECK(magma_zmatrix_swap(&L_new, &L, queue));
         CHECK(magma_zmatrix_swap(&U_new, &U, queue));
         magma_zmfree(&L_new, queue);
         magma_zmfree(&U_new, queue);
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_rm=end-start;
         
         
         // step 10: sweep
         start = magma_sync_wtime(queue);
+        magma_profile_begin( "zparilut_cpu sweep2" );
         CHECK(magma_zparilut_sweep_sync(&hA, &L, &U, queue));
+        magma_profile_end();
         end = magma_sync_wtime(queue); t_sweep2+=end-start;
         
         if (timing == 1) {
@@ -249,24 +279,34 @@ magma_zparilut_cpu(
     }
     //##########################################################################
 
-    // for CUSPARSE
-    CHECK(magma_zmtransfer(L, &precond->L, Magma_CPU, Magma_DEV , queue));
-    CHECK(magma_zcsrcoo_transpose(U, &UT, queue));
-    //magma_zmtranspose(U, &UT, queue);
-    CHECK(magma_zmtransfer(UT, &precond->U, Magma_CPU, Magma_DEV , queue));
-    
-    if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
-        CHECK(magma_zcumilugeneratesolverinfo(precond, queue));
+    if (b.memory_location == Magma_CPU &&
+        (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE ||
+         precond->trisolver == Magma_SYNCFREESOLVE)) {
+        // opt-in by a host b: keep the factors on the CPU for the host
+        // triangular solves, so the preconditioner applies to host vectors
+        CHECK(magma_zmtransfer(L, &precond->L, Magma_CPU, Magma_CPU , queue));
+        CHECK(magma_zcsrcoo_transpose(U, &UT, queue));
+        CHECK(magma_zmtransfer(UT, &precond->U, Magma_CPU, Magma_CPU , queue));
+        CHECK(magma_zilugeneratesolverinfo_cpu(precond, queue));
     } else {
-        //prepare for iterative solves
-        // extract the diagonal of L into precond->d
-        CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
-        CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
-            MAGMA_Z_ZERO, queue));
-        // extract the diagonal of U into precond->d2
-        CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
-        CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
-            MAGMA_Z_ZERO, queue));
+        // for CUSPARSE
+        CHECK(magma_zmtransfer(L, &precond->L, Magma_CPU, Magma_DEV , queue));
+        CHECK(magma_zcsrcoo_transpose(U, &UT, queue));
+        //magma_zmtranspose(U, &UT, queue);
+        CHECK(magma_zmtransfer(UT, &precond->U, Magma_CPU, Magma_DEV , queue));
+        if (precond->trisolver == 0 || precond->trisolver == Magma_CUSOLVE) {
+            CHECK(magma_zcumilugeneratesolverinfo(precond, queue));
+        } else {
+            //prepare for iterative solves
+            // extract the diagonal of L into precond->d
+            CHECK(magma_zjacobisetup_diagscal(precond->L, &precond->d, queue));
+            CHECK(magma_zvinit(&precond->work1, Magma_DEV, hA.num_rows, 1, 
+                MAGMA_Z_ZERO, queue));
+            // extract the diagonal of U into precond->d2
+            CHECK(magma_zjacobisetup_diagscal(precond->U, &precond->d2, queue));
+            CHECK(magma_zvinit(&precond->work2, Magma_DEV, hA.num_rows, 1, 
+                MAGMA_Z_ZERO, queue));
+        }
     }
 
 cleanup:
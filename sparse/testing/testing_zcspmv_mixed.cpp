@@ -39,6 +39,8 @@ int main(  int argc, char** argv )
     magma_c_matrix cA={Magma_CSR}, dcB={Magma_CSR};
     magma_z_matrix diag={Magma_CSR}, ddiag={Magma_CSR};
     magma_z_matrix x={Magma_CSR}, b={Magma_CSR};
+    magma_z_matrix hx={Magma_CSR}, hb={Magma_CSR}, hbref={Magma_CSR}, hA={Magma_CSR};
+    magma_zopts zopts;
     real_Double_t start, end;
 
     int i=1;
@@ -129,6 +131,105 @@ int main(  int argc, char** argv )
         
         magma_cmfree(&dcB, queue );
 
+        // mixed precision SpMV on the CPU, with and without 16-bit column
+        // offsets, compared to the SpMV in double precision
+        printf("\n\nhost mixed precision SpMV run:\n");
+        TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, A.num_cols, 1, one, queue ));
+        TESTING_CHECK( magma_zvinit( &hb, Magma_CPU, A.num_rows, 1, zero, queue ));
+        TESTING_CHECK( magma_zvinit( &hbref, Magma_CPU, A.num_rows, 1, zero, queue ));
+        for (magma_int_t k=0; k<A.num_cols; k++) {
+            hx.val[k] = MAGMA_Z_MAKE( 1.0 + k%7, (double) (k%3) );
+        }
+        TESTING_CHECK( magma_z_spmv( one, A, hx, zero, hbref, queue ));
+        for (magma_int_t packcols=0; packcols<2; packcols++) {
+            TESTING_CHECK( magma_zcmixed_prec_setup_cpu( &A, packcols, queue ));
+            start = magma_wtime();
+            for (int z=0; z<10; z++) {
+                TESTING_CHECK( magma_z_spmv( one, A, hx, zero, hb, queue ));
+            }
+            end = magma_wtime();
+            printf( "\n > MAGMA host mixed precision SpMV%s : %.2e seconds %.2e GFLOP/s.\n",
+                    (packcols ? " (16-bit columns)" : ""),
+                    (end-start)/10, FLOPS*10/(end-start) );
+            double err = 0.0, nrm = 0.0;
+            for (magma_int_t k=0; k<A.num_rows; k++) {
+                double d = MAGMA_Z_ABS( MAGMA_Z_SUB( hb.val[k], hbref.val[k] ));
+                double r = MAGMA_Z_ABS( hbref.val[k] );
+                err = (d > err ? d : err);
+                nrm = (r > nrm ? r : nrm);
+            }
+            printf("%% max|b-bref| / max|bref| = %8.2e\n", err/nrm );
+            if ( err <= 1e-5 * nrm )
+                printf("%% tester host mixed precision SpMV:  ok\n");
+            else
+                printf("%% tester host mixed precision SpMV:  failed\n");
+        }
+        TESTING_CHECK( magma_zcmixed_prec_free_cpu( &A, queue ));
+
+        // CG on the CPU through magma_z_solver with mixed_spmv 0, 1, 2.
+        // The matrix is D A D / 3, whose values are not exact in single
+        // precision. With mixed_spmv > 0, CG iterates with the values in
+        // single precision, so the true residual of its solution, computed
+        // here in double precision, stays at the level of single precision,
+        // far above the residual of the double run.
+        printf("\n\nhost CG with mixed precision SpMV:\n");
+        TESTING_CHECK( magma_zmtransfer( A, &hA, Magma_CPU, Magma_CPU, queue ));
+        for (magma_int_t r=0; r<hA.num_rows; r++) {
+            for (magma_int_t k=hA.row[r]; k<hA.row[r+1]; k++) {
+                double dr = 1.0 + (r % 7)/10.0, dc = 1.0 + (hA.col[k] % 7)/10.0;
+                hA.val[k] = MAGMA_Z_MUL( hA.val[k], MAGMA_Z_MAKE( dr*dc/3.0, 0.0 ));
+            }
+        }
+        TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, A.num_cols, 1, one, queue ));
+        TESTING_CHECK( magma_zvinit( &hb, Magma_CPU, A.num_rows, 1, zero, queue ));
+        TESTING_CHECK( magma_zvinit( &hbref, Magma_CPU, A.num_rows, 1, zero, queue ));
+        TESTING_CHECK( magma_z_spmv( one, hA, hx, zero, hb, queue ));    // b = A ones
+        zopts.solver_par.solver = Magma_CG;
+        zopts.solver_par.verbose = 0;
+        zopts.solver_par.atol = 1e-16;
+        zopts.solver_par.rtol = 1e-10;
+        zopts.solver_par.maxiter = 10*n;
+        zopts.precond_par.solver = Magma_NONE;
+        double cgres[3];
+        for (magma_int_t mixed=0; mixed<3; mixed++) {
+            zopts.mixed_spmv = mixed;
+            for (magma_int_t k=0; k<A.num_cols; k++) {
+                hx.val[k] = zero;
+            }
+            info = magma_z_solver( hA, hb, &hx, &zopts, queue );
+            // true residual |b - A x| / |b|, in double precision
+            TESTING_CHECK( magma_z_spmv( one, hA, hx, zero, hbref, queue ));
+            double nrm = 0.0, err = 0.0;
+            for (magma_int_t k=0; k<A.num_rows; k++) {
+                double d = MAGMA_Z_ABS( MAGMA_Z_SUB( hb.val[k], hbref.val[k] ));
+                double r = MAGMA_Z_ABS( hb.val[k] );
+                err += d*d;
+                nrm += r*r;
+            }
+            cgres[mixed] = sqrt( err / nrm );
+            printf("%% mixed_spmv %lld: info %lld, %lld iterations, |b-Ax|/|b| = %8.2e\n",
+                   (long long) mixed, (long long) info,
+                   (long long) zopts.solver_par.numiter, cgres[mixed] );
+            if ( info != 0 || hA.lval != NULL ) {
+                printf("%% tester host CG, mixed_spmv %lld:  failed\n", (long long) mixed );
+            }
+        }
+        info = 0;
+        if ( cgres[0] < 1e-8 )
+            printf("%% tester host CG, double SpMV converged:  ok\n");
+        else
+            printf("%% tester host CG, double SpMV converged:  failed\n");
+        for (magma_int_t mixed=1; mixed<3; mixed++) {
+            if ( cgres[mixed] > 10*cgres[0] && cgres[mixed] < 1e-3 )
+                printf("%% tester host CG, mixed_spmv %lld used single precision:  ok\n", (long long) mixed );
+            else
+                printf("%% tester host CG, mixed_spmv %lld used single precision:  failed\n", (long long) mixed );
+        }
+        magma_zmfree(&hA, queue );
+        magma_zmfree(&hx, queue );
+        magma_zmfree(&hb, queue );
+        magma_zmfree(&hbref, queue );
+
         magma_cmfree(&cA, queue );
         
         magma_zmfree(&x, queue );
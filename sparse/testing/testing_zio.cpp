@@ -41,7 +41,8 @@ int main(  int argc, char** argv )
     
     real_Double_t res;
     magma_z_matrix A={Magma_CSR}, A2={Magma_CSR}, 
-    A3={Magma_CSR}, A4={Magma_CSR}, A5={Magma_CSR};
+    A3={Magma_CSR}, A4={Magma_CSR}, A5={Magma_CSR},
+    A6={Magma_CSR}, A7={Magma_CSR}, A8={Magma_CSR}, B={Magma_CSR};
     
     int i=1;
     TESTING_CHECK( magma_zparse_opts( argc, argv, &zopts, &i, queue ));
@@ -102,10 +103,52 @@ int main(  int argc, char** argv )
         else
             printf("%% tester matrix interface:  failed\n");
 
+        // binary CSR file, read as a copy and mapped
+        const char *binname = "testmatrix.bin";
+        TESTING_CHECK( magma_zwrite_csrtobin( A, binname, queue ));
+        TESTING_CHECK( magma_z_csr_bin( &A6, binname, MagmaFalse, queue ));
+        TESTING_CHECK( magma_z_csr_bin( &A7, binname, MagmaTrue, queue ));
+        unlink( binname );
+
+        real_Double_t res2;
+        TESTING_CHECK( magma_zmdiff( A, A6, &res,  queue ));
+        TESTING_CHECK( magma_zmdiff( A, A7, &res2, queue ));
+        printf("%% ||A-B||_F = %8.2e, %8.2e\n", res, res2);
+        if ( res == 0 && res2 == 0 && A7.ownership == MagmaFalse )
+            printf("%% tester binary IO:  ok\n");
+        else
+            printf("%% tester binary IO:  failed\n");
+
+        // corrupt binary CSR files are rejected when copied:
+        // a column index out of range, and non-monotone row pointers
+        magma_int_t info1 = 0, info2 = 0;
+        TESTING_CHECK( magma_zmtransfer( A, &B, Magma_CPU, Magma_CPU, queue ));
+        if ( B.nnz > 0 ) {
+            magma_index_t save = B.col[ B.nnz-1 ];
+            B.col[ B.nnz-1 ] = B.num_cols;
+            TESTING_CHECK( magma_zwrite_csrtobin( B, binname, queue ));
+            info1 = magma_z_csr_bin( &A8, binname, MagmaFalse, queue );
+            B.col[ B.nnz-1 ] = save;
+        }
+        if ( B.num_rows > 1 ) {
+            B.row[1] = B.nnz + 1;
+            TESTING_CHECK( magma_zwrite_csrtobin( B, binname, queue ));
+            info2 = magma_z_csr_bin( &A8, binname, MagmaFalse, queue );
+        }
+        unlink( binname );
+        if ( (B.nnz == 0 || info1 != 0) && (B.num_rows <= 1 || info2 != 0) )
+            printf("%% tester corrupt binary IO:  ok\n");
+        else
+            printf("%% tester corrupt binary IO:  failed\n");
+
         magma_zmfree(&A, queue );
         magma_zmfree(&A2, queue );
         magma_zmfree(&A4, queue );
         magma_zmfree(&A5, queue );
+        magma_zmfree(&A6, queue );
+        magma_zmfree(&A7, queue );
+        magma_zmfree(&A8, queue );
+        magma_zmfree(&B, queue );
 
         i++;
     }
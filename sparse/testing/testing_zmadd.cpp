@@ -35,7 +35,8 @@ int main(  int argc, char** argv )
 
     real_Double_t res;
     magma_z_matrix A={Magma_CSR}, B={Magma_CSR}, B2={Magma_CSR}, 
-    dA={Magma_CSR}, dB={Magma_CSR}, dC={Magma_CSR};
+    dA={Magma_CSR}, dB={Magma_CSR}, dC={Magma_CSR}, hC={Magma_CSR},
+    hC2={Magma_CSR};
 
     magmaDoubleComplex one = MAGMA_Z_MAKE(1.0, 0.0);
     magmaDoubleComplex mone = MAGMA_Z_MAKE(-1.0, 0.0);
@@ -86,6 +87,46 @@ int main(  int argc, char** argv )
         printf("%% tester matrix add:  ok\n");
     else
         printf("%% tester matrix add:  failed\n");
+    magma_zmfree(&B2, queue );
+
+    // same on the CPU, then again reusing the patterns of the sums
+    TESTING_CHECK( magma_zspaxpy_cpu( one, A, one, B, &hC, queue ));
+    TESTING_CHECK( magma_zspaxpy_cpu( mone, A, one, hC, &B2, queue ));
+    TESTING_CHECK( magma_zmdiff( B, B2, &res, queue ));
+    printf("%% ||A-B||_F = %8.2e\n", res);
+    if ( res < .000001 )
+        printf("%% tester matrix add host:  ok\n");
+    else
+        printf("%% tester matrix add host:  failed\n");
+    // new values of A with the same pattern: only the values of the sums
+    // are recomputed, compared to a sum computed from scratch
+    for (magma_int_t k = 0; k < A.nnz; ++k) {
+        A.val[k] = MAGMA_Z_MUL( A.val[k], MAGMA_Z_MAKE( 1.0 + k%3, 0.0 ));
+    }
+    TESTING_CHECK( magma_zspaxpy_values_cpu( one, A, one, B, &hC, queue ));
+    TESTING_CHECK( magma_zspaxpy_cpu( one, A, one, B, &hC2, queue ));
+    TESTING_CHECK( magma_zmdiff( hC, hC2, &res, queue ));
+    printf("%% ||C-C2||_F = %8.2e\n", res);
+    if ( res < .000001 )
+        printf("%% tester matrix add host (values only):  ok\n");
+    else
+        printf("%% tester matrix add host (values only):  failed\n");
+    TESTING_CHECK( magma_zspaxpy_values_cpu( mone, A, one, hC, &B2, queue ));
+    TESTING_CHECK( magma_zmdiff( B, B2, &res, queue ));
+    printf("%% ||A-B||_F = %8.2e\n", res);
+    if ( res < .000001 )
+        printf("%% tester matrix add host (values only):  ok\n");
+    else
+        printf("%% tester matrix add host (values only):  failed\n");
+    // a pattern other than the one of the sum is rejected
+    if ( hC.nnz != A.nnz ) {
+        if ( magma_zspaxpy_values_cpu( one, A, one, A, &hC, queue ) == MAGMA_ERR_NOT_SUPPORTED )
+            printf("%% tester matrix add host (other pattern):  ok\n");
+        else
+            printf("%% tester matrix add host (other pattern):  failed\n");
+    }
+    magma_zmfree(&hC2, queue );
+    magma_zmfree(&hC, queue );
 
     magma_zmfree(&A, queue );
     magma_zmfree(&B, queue );
@@ -44,6 +44,10 @@ int main(  int argc, char** argv )
     magma_queue_create( 0, &queue );
     // using std::swap;
     real_Double_t start, end, t_select, t_selectrandom, t_selectbitonic;
+    real_Double_t t_sampleselect, t_sampleselect_approx;
+    magma_ptr tmp = NULL;
+    magma_int_t tmp_size = 0;
+    double thrs, thrs_approx;
     
     int size = atoi(argv[1]);
     int selectset = atoi(argv[2]);
@@ -89,6 +93,25 @@ int main(  int argc, char** argv )
         printf(" Inconsistent result.\n");
     }
     
+    // parallel sample-select on the CPU, the array is not changed
+    makeRandomArray(a, size);
+    start = magma_sync_wtime( queue );
+    TESTING_CHECK( magma_zsampleselect_cpu( size, selectset, a, &thrs,
+                                            &tmp, &tmp_size, queue ));
+    end = magma_sync_wtime( queue );
+    t_sampleselect = end-start;
+    printf("\n selected by sample-select: %.2f\n\n", thrs );
+    if ( thrs != MAGMA_Z_ABS(selectRandomResult) ){
+        printf(" Inconsistent result.\n");
+    }
+    start = magma_sync_wtime( queue );
+    TESTING_CHECK( magma_zsampleselect_approx_cpu( size, selectset, a, &thrs_approx,
+                                                   &tmp, &tmp_size, queue ));
+    end = magma_sync_wtime( queue );
+    t_sampleselect_approx = end-start;
+    printf("\n selected by approximate sample-select: %.2f\n\n", thrs_approx );
+    magma_free_cpu( tmp );
+    
     makeRandomArray(a, size);
     start = magma_sync_wtime( queue );
     magma_int_t flag =0;
@@ -117,6 +140,8 @@ int main(  int argc, char** argv )
     printf(" Select time (ms): %.4f\n", double(t_select)*1000 );
     printf(" Randomized select time (ms): %.4f\n", double(t_selectrandom)*1000 );
     printf(" Bitonicsort time (ms): %.4f\n", double(t_selectbitonic)*1000 );
+    printf(" Sample-select time (ms): %.4f\n", double(t_sampleselect)*1000 );
+    printf(" Approximate sample-select time (ms): %.4f\n", double(t_sampleselect_approx)*1000 );
 
     // magma_free_cpu( &a );
     
@@ -88,6 +88,82 @@ int main(  int argc, char** argv )
 
     magma_free_cpu( y );
     
+    // benchmark: random and presorted inputs, checking the order
+    // and that col, row are carried along with the values
+    magma_int_t sizes[3] = { 1000, 100000, 1000000 };
+    magma_index_t *col=NULL, *row=NULL;
+    magmaDoubleComplex *y0=NULL;
+    real_Double_t start, end;
+    printf("%%      n   input    zsort (ms)   zmsort (ms)   zindexsort (ms)   check\n");
+    for( magma_int_t s = 0; s < 3; s++ ){
+        n = sizes[s];
+        TESTING_CHECK( magma_zmalloc_cpu( &y, n ));
+        TESTING_CHECK( magma_zmalloc_cpu( &y0, n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &x, n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &col, n ));
+        TESTING_CHECK( magma_index_malloc_cpu( &row, n ));
+        for( magma_int_t sorted = 0; sorted < 2; sorted++ ){
+            for(i = 0; i < n; i++ ){
+                y0[i] = ( sorted
+                        ? MAGMA_Z_MAKE( (double) i, 0.0 )
+                        : MAGMA_Z_MAKE( (double) rand()/RAND_MAX - 0.5,
+                                        (double) rand()/RAND_MAX - 0.5 ));
+            }
+            bool okay = true;
+
+            for(i = 0; i < n; i++ ){
+                y[i] = y0[i];
+            }
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zsort( y, 0, n-1, queue ));
+            end = magma_sync_wtime( queue );
+            real_Double_t t_sort = end - start;
+            for(i = 1; i < n; i++ ){
+                okay = okay && MAGMA_Z_ABS(y[i-1]) <= MAGMA_Z_ABS(y[i]);
+            }
+
+            for(i = 0; i < n; i++ ){
+                y[i] = y0[i];
+                col[i] = i;
+                row[i] = n-1-i;
+            }
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zmsort( y, col, row, 0, n-1, queue ));
+            end = magma_sync_wtime( queue );
+            real_Double_t t_msort = end - start;
+            for(i = 0; i < n; i++ ){
+                okay = okay && MAGMA_Z_EQUAL( y[i], y0[ col[i] ] )
+                            && row[i] == n-1-col[i];
+                if( i > 0 ){
+                    okay = okay && MAGMA_Z_ABS(y[i-1]) <= MAGMA_Z_ABS(y[i]);
+                }
+            }
+
+            for(i = 0; i < n; i++ ){
+                x[i] = ( sorted ? i : rand()%n );
+            }
+            start = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zindexsort( x, 0, n-1, queue ));
+            end = magma_sync_wtime( queue );
+            real_Double_t t_indexsort = end - start;
+            for(i = 1; i < n; i++ ){
+                okay = okay && x[i-1] <= x[i];
+            }
+
+            printf("%8lld   %-6s   %10.4f   %11.4f   %15.4f   %s\n",
+                   (long long) n, (sorted ? "sorted" : "random"),
+                   t_sort*1000, t_msort*1000, t_indexsort*1000,
+                   (okay ? "ok" : "failed"));
+            info += (okay ? 0 : 1);
+        }
+        magma_free_cpu( y );
+        magma_free_cpu( y0 );
+        magma_free_cpu( x );
+        magma_free_cpu( col );
+        magma_free_cpu( row );
+    }
+    printf("\n");
+    
     i=1;
     while( i < argc ) {
         if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
@@ -111,6 +187,28 @@ int main(  int argc, char** argv )
         }
         printf("\n\n");
         magma_free_cpu( x );
+
+        // reverse each row, sort the rows again, and compare with A
+        magma_z_matrix B={Magma_CSR};
+        TESTING_CHECK( magma_zmtransfer( A, &B, Magma_CPU, Magma_CPU, queue ));
+        for(magma_int_t r = 0; r < B.num_rows; r++ ){
+            for(magma_int_t k = 0; k < (B.row[r+1]-B.row[r])/2; k++ ){
+                magma_index_t k1 = B.row[r]+k, k2 = B.row[r+1]-1-k;
+                magma_index_t tc = B.col[k1]; B.col[k1] = B.col[k2]; B.col[k2] = tc;
+                magmaDoubleComplex tv = B.val[k1]; B.val[k1] = B.val[k2]; B.val[k2] = tv;
+            }
+        }
+        start = magma_sync_wtime( queue );
+        TESTING_CHECK( magma_zcsr_sort( &B, queue ));
+        end = magma_sync_wtime( queue );
+        bool okay = true;
+        for(magma_int_t k = 0; k < A.nnz; k++ ){
+            okay = okay && B.col[k] == A.col[k] && MAGMA_Z_EQUAL( B.val[k], A.val[k] );
+        }
+        printf("%% CSR row sort time (ms): %.4f   %s\n\n",
+               (end-start)*1000, (okay ? "ok" : "failed"));
+        info += (okay ? 0 : 1);
+        magma_zmfree(&B, queue);
         magma_zmfree(&A, queue);
         
         i++;
@@ -95,6 +95,7 @@ int main(  int argc, char** argv )
     
     magma_z_matrix hx={Magma_CSR}, hy={Magma_CSR}, dx={Magma_CSR}, 
     dy={Magma_CSR}, hrefvec={Magma_CSR}, hcheck={Magma_CSR};
+    magma_z_matrix hAA={Magma_CSR}, dAA={Magma_CSR}, hAAref={Magma_CSR};
         
     hA_SELLP.blocksize = 8;
     hA_SELLP.alignment = 8;
@@ -328,6 +329,24 @@ int main(  int argc, char** argv )
         cusparseHandle = NULL;
         //#endif
 
+        // sparse matrix product A*A on the CPU, compared to cuSPARSE
+        start = magma_wtime();
+        TESTING_CHECK( magma_z_spmm( c_one, hA, hA, &hAA, queue ));
+        end = magma_wtime();
+        printf( " > MAGMA: %.2e seconds    (SpGEMM A*A on the CPU).\n",
+                                        (end-start) );
+        TESTING_CHECK( magma_z_spmm( c_one, dA, dA, &dAA, queue ));
+        TESTING_CHECK( magma_zmtransfer( dAA, &hAAref, Magma_DEV, Magma_CPU, queue ));
+        TESTING_CHECK( magma_zmdiff( hAA, hAAref, &res, queue ));
+        printf("%% |AA-AAref|_F = %8.2e\n", res);
+        if ( res < accuracy && hAA.nnz == hAAref.nnz )
+            printf("%% tester spgemm host:  ok\n");
+        else
+            printf("%% tester spgemm host:  failed\n");
+        magma_zmfree( &hAA, queue );
+        magma_zmfree( &dAA, queue );
+        magma_zmfree( &hAAref, queue );
+
         printf("\n\n");
 
         // free CPU memory
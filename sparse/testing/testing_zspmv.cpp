@@ -81,6 +81,67 @@
   #endif
 #endif
 
+/* ////////////////////////////////////////////////////////////////////////////
+   -- reference y = A*x for CSR matrix A, on the host, with plain serial loops
+*/
+static void
+zcsrmv_ref(
+    magma_z_matrix A,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y )
+{
+    for( magma_int_t r=0; r < A.num_rows; r++ ) {
+        magmaDoubleComplex sum = MAGMA_Z_ZERO;
+        for( magma_int_t k=A.row[r]; k < A.row[r+1]; k++ ) {
+            sum += A.val[k] * x[ A.col[k] ];
+        }
+        y[r] = sum;
+    }
+}
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- reference Y = A*X for CSR matrix A and nv vectors, on the host.
+      X is A.num_cols by nv, column-major or row-major as given by major;
+      Y is A.num_rows by nv, column-major.
+*/
+static void
+zcsrmm_ref(
+    magma_z_matrix A,
+    magma_int_t nv,
+    magma_order_t major,
+    const magmaDoubleComplex *x,
+    magmaDoubleComplex *y )
+{
+    for( magma_int_t v=0; v < nv; v++ ) {
+        for( magma_int_t r=0; r < A.num_rows; r++ ) {
+            magmaDoubleComplex sum = MAGMA_Z_ZERO;
+            for( magma_int_t k=A.row[r]; k < A.row[r+1]; k++ ) {
+                magma_int_t c = A.col[k];
+                sum += A.val[k] * (major == MagmaRowMajor ? x[ c*nv + v ]
+                                                          : x[ c + v*A.num_cols ]);
+            }
+            y[ r + v*A.num_rows ] = sum;
+        }
+    }
+}
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- returns |y - yref|_1 / |yref|_1, or |y - yref|_1 if yref is zero
+*/
+static double
+zrel_error(
+    magma_int_t n,
+    const magmaDoubleComplex *y,
+    const magmaDoubleComplex *yref )
+{
+    double diff = 0.0, norm = 0.0;
+    for( magma_int_t k=0; k < n; k++ ) {
+        diff += MAGMA_Z_ABS( y[k] - yref[k] );
+        norm += MAGMA_Z_ABS( yref[k] );
+    }
+    return norm == 0 ? diff : diff / norm;
+}
+
 /* ////////////////////////////////////////////////////////////////////////////
    -- testing sparse matrix vector product
 */
@@ -96,10 +157,12 @@ int main(  int argc, char** argv )
     hA_CSR5={Magma_CSR}, dA_CSR5={Magma_CSR};
     
     magma_z_matrix hx={Magma_CSR}, hy={Magma_CSR}, dx={Magma_CSR}, 
-    dy={Magma_CSR}, hrefvec={Magma_CSR}, hcheck={Magma_CSR};
+    dy={Magma_CSR}, hrefvec={Magma_CSR}, hcheck={Magma_CSR},
+    hX={Magma_CSR}, hY={Magma_CSR}, hyref={Magma_CSR}, hYref={Magma_CSR};
             
     hA_SELLP.blocksize = 32;
     hA_SELLP.alignment = 1;
+    magma_int_t sigma = 256;  // for host SELL-C-sigma
     real_Double_t start, end, res, ref;
     real_Double_t elltime = 0.0, ellgflops = 0.0, mkltime = 0.0, mklgflops = 0.0, 
                   cuCSRtime = 0.0, cuCSRgflops = 0.0, 
@@ -133,12 +196,15 @@ int main(  int argc, char** argv )
             hA_SELLP.blocksize = atoi( argv[++i] );
         } else if ( strcmp("--alignment", argv[i]) == 0 ) {
             hA_SELLP.alignment = atoi( argv[++i] );
+        } else if ( strcmp("--sigma", argv[i]) == 0 ) {
+            sigma = atoi( argv[++i] );
         } else
             break;
     }
     printf( "\n%% #    usage: ./run_zspmv"
-            " [ --blocksize %lld --alignment %lld (for SELLP) ] matrices\n\n",
-            (long long) hA_SELLP.blocksize, (long long) hA_SELLP.alignment );
+            " [ --blocksize %lld --alignment %lld --sigma %lld (for SELLP) ] matrices\n\n",
+            (long long) hA_SELLP.blocksize, (long long) hA_SELLP.alignment,
+            (long long) sigma );
 
     while( i < argc ) {
         if ( strcmp("LAPLACE2D", argv[i]) == 0 && i+1 < argc ) {   // Laplace test
@@ -338,6 +404,111 @@ int main(  int argc, char** argv )
 
         magma_zmfree(&dA_CSR5, queue );
 
+        // SpMV on CPU (CSR), random x; the reference is computed on the
+        // host, so these checks do not depend on the GPU results above
+        magma_zmfree( &hx, queue );
+        TESTING_CHECK( magma_zvinit_rand( &hx, Magma_CPU, hA.num_cols, 1, queue ));
+        TESTING_CHECK( magma_zvinit( &hyref, Magma_CPU, hA.num_rows, 1, c_zero, queue ));
+        zcsrmv_ref( hA, hx.val, hyref.val );
+        start = magma_wtime();
+        for (j=0; j < 200; j++) {
+            TESTING_CHECK( magma_z_spmv( c_one, hA, hx, c_zero, hy, queue ));
+        }
+        end = magma_wtime();
+        res = zrel_error( hA.num_rows, hy.val, hyref.val );
+        printf( "%% > MAGMA: %.2e seconds %.2e GFLOP/s    (host CSR).\n",
+            (end-start)/200, FLOPS*200/(end-start) );
+        if ( res < accuracy ) {
+            printf("%% |x-y|_F/|y| = %8.2e Tester spmv host CSR:  ok\n", res);
+        } else{
+            printf("%% |x-y|_F/|y| = %8.2e Tester spmv host CSR:  failed\n", res);
+        }
+
+        // SpMV on CPU (SELL-C-sigma), rows sorted within windows of sigma rows.
+        // Also run a sigma smaller than the matrix, so rows are reordered
+        // and the permutation of y is checked.
+        magma_int_t sigmas[2] = { sigma, 2*hA_SELLP.blocksize };
+        if ( sigmas[1] >= hA.num_rows ) {
+            sigmas[1] = hA_SELLP.blocksize;
+        }
+        for (magma_int_t s=0; s < 2; s++) {
+            hA_SELLP.sigma = sigmas[s];
+            TESTING_CHECK( magma_zmconvert(  hA, &hA_SELLP, Magma_CSR, Magma_SELLP, queue ));
+            hA_SELLP.sigma = 0;
+            magma_int_t moved = 0;
+            if ( hA_SELLP.rowidx != NULL ) {
+                for(magma_int_t k=0; k < hA.num_rows; k++ ){
+                    moved += (hA_SELLP.rowidx[k] != k);
+                }
+            }
+            start = magma_wtime();
+            for (j=0; j < 200; j++) {
+                TESTING_CHECK( magma_z_spmv( c_one, hA_SELLP, hx, c_zero, hy, queue ));
+            }
+            end = magma_wtime();
+            magma_zmfree( &hA_SELLP, queue );
+            res = zrel_error( hA.num_rows, hy.val, hyref.val );
+            printf( "%% > MAGMA: %.2e seconds %.2e GFLOP/s    (host SELL-C-sigma, sigma %lld, %lld rows moved).\n",
+                (end-start)/200, FLOPS*200/(end-start), (long long) sigmas[s], (long long) moved );
+            if ( res < accuracy ) {
+                printf("%% |x-y|_F/|y| = %8.2e Tester spmv host SELL-C-sigma:  ok\n", res);
+            } else{
+                printf("%% |x-y|_F/|y| = %8.2e Tester spmv host SELL-C-sigma:  failed\n", res);
+            }
+        }
+
+        // SpMV on CPU (CSR5), same tiles as on the GPU
+        TESTING_CHECK( magma_zmconvert(  hA, &hA_CSR5, Magma_CSR, Magma_CSR5, queue ));
+        start = magma_wtime();
+        for (j=0; j < 200; j++) {
+            TESTING_CHECK( magma_z_spmv( c_one, hA_CSR5, hx, c_zero, hy, queue ));
+        }
+        end = magma_wtime();
+        magma_zmfree( &hA_CSR5, queue );
+        res = zrel_error( hA.num_rows, hy.val, hyref.val );
+        printf( "%% > MAGMA: %.2e seconds %.2e GFLOP/s    (host CSR5).\n",
+            (end-start)/200, FLOPS*200/(end-start) );
+        if ( res < accuracy ) {
+            printf("%% |x-y|_F/|y| = %8.2e Tester spmv host CSR5:  ok\n", res);
+        } else{
+            printf("%% |x-y|_F/|y| = %8.2e Tester spmv host CSR5:  failed\n", res);
+        }
+
+        // SpMM on CPU (CSR, SELLP, and SELL-C-sigma), distinct random
+        // vectors, X in both orders. 21 and 29 vectors go through the
+        // blocks of 16, 8, 4, and single vectors in the host kernels.
+        const char* formats[3] = { "CSR", "SELLP", "SELL-C-sigma" };
+        magma_int_t nvecs[2] = { 21, 29 };
+        for (magma_int_t v=0; v < 2; v++) {
+            magma_int_t nv = nvecs[v];
+            TESTING_CHECK( magma_zvinit_rand( &hX, Magma_CPU, hA.num_cols, nv, queue ));
+            TESTING_CHECK( magma_zvinit( &hY, Magma_CPU, hA.num_rows, nv, c_zero, queue ));
+            TESTING_CHECK( magma_zvinit( &hYref, Magma_CPU, hA.num_rows, nv, c_zero, queue ));
+            for (magma_int_t f=0; f < 3; f++) {
+                if ( f > 0 ) {
+                    hA_SELLP.sigma = (f == 2 ? sigmas[1] : 0);
+                    TESTING_CHECK( magma_zmconvert(  hA, &hA_SELLP, Magma_CSR, Magma_SELLP, queue ));
+                    hA_SELLP.sigma = 0;
+                }
+                for (j=0; j < 2; j++) {
+                    hX.major = (j == 0 ? MagmaColMajor : MagmaRowMajor);
+                    zcsrmm_ref( hA, nv, hX.major, hX.val, hYref.val );
+                    TESTING_CHECK( magma_z_spmv( c_one, (f == 0 ? hA : hA_SELLP), hX, c_zero, hY, queue ));
+                    res = zrel_error( hA.num_rows*nv, hY.val, hYref.val );
+                    printf("%% |x-y|_F/|y| = %8.2e Tester spmm host %s, %lld vectors, %s:  %s\n",
+                           res, formats[f], (long long) nv,
+                           (j == 0 ? "col-major" : "row-major"),
+                           (res < accuracy ? "ok" : "failed"));
+                }
+                if ( f > 0 ) {
+                    magma_zmfree( &hA_SELLP, queue );
+                }
+            }
+            magma_zmfree( &hX, queue );
+            magma_zmfree( &hY, queue );
+            magma_zmfree( &hYref, queue );
+        }
+
 
         // SpMV on GPU (CUSPARSE - CSR)
         // CUSPARSE context
@@ -453,6 +624,7 @@ int main(  int argc, char** argv )
         magma_zmfree( &hx, queue );
         magma_zmfree( &hy, queue );
         magma_zmfree( &hrefvec, queue );
+        magma_zmfree( &hyref, queue );
         // free GPU memory
         magma_zmfree( &dA, queue );
         magma_zmfree( &dx, queue );
@@ -22,6 +22,31 @@
 #include "magmasparse.h"
 #include "testings.h"
 
+/* ////////////////////////////////////////////////////////////////////////////
+   -- reference solve of T x = b for triangular CSR matrix T on the host,
+      with plain serial loops; a missing diagonal entry is taken as 1
+*/
+static void
+zcsrtrsv_ref(
+    magma_uplo_t uplo,
+    magma_z_matrix T,
+    const magmaDoubleComplex *b,
+    magmaDoubleComplex *x )
+{
+    for( magma_int_t k=0; k < T.num_rows; k++ ) {
+        magma_int_t r = (uplo == MagmaLower ? k : T.num_rows-1 - k);
+        magmaDoubleComplex sum = b[r];
+        magmaDoubleComplex diag = MAGMA_Z_ONE;
+        for( magma_int_t j=T.row[r]; j < T.row[r+1]; j++ ) {
+            if ( T.col[j] == r )
+                diag = T.val[j];
+            else
+                sum = MAGMA_Z_SUB( sum, MAGMA_Z_MUL( T.val[j], x[ T.col[j] ] ));
+        }
+        x[r] = MAGMA_Z_DIV( sum, diag );
+    }
+}
+
 /* ////////////////////////////////////////////////////////////////////////////
    -- testing any solver
 */
@@ -43,6 +68,12 @@ int main(  int argc, char** argv )
     magma_int_t dofs;
     double res;
     
+    double accuracy = 1e-10;
+    #define PRECISION_z
+    #if defined(PRECISION_c) || defined(PRECISION_s)
+        accuracy = 1e-4;
+    #endif
+    
     //Chronometry
     real_Double_t tempo1, tempo2;
     
@@ -79,7 +110,7 @@ int main(  int argc, char** argv )
         
         if(debug)printf("%% --- debug mode ---");
         else { printf("prec_info = [\n");
-               printf("%% row-wise: cuSOLVE, sync-free, BJ(1)-3, BJ(1)-5, BJ(12)-3, BJ(12)-5, BJ(24)-3, BJ(24)-5, ISAI(1)-0, ISAI(2)-0, ISAI(3)-0\n");
+               printf("%% row-wise: cuSOLVE, sync-free, host level-set, host sync-free, BJ(1)-3, BJ(1)-5, BJ(12)-3, BJ(12)-5, BJ(24)-3, BJ(24)-5, ISAI(1)-0, ISAI(2)-0, ISAI(3)-0\n");
                printf("%% col-wise: prec-setup res_L time_L res_U time_U\n");
         }
         // preconditioner with cusparse trisolve
@@ -191,6 +222,170 @@ int main(  int argc, char** argv )
         magma_zprecondfree( &zopts.precond_par , queue );
 
 
+        // host trisolves: level-scheduled and sync-free, L = tril(A), U = triu(A)
+        for( int k=0; k < 2; k++ ) {
+            magma_z_matrix hA={Magma_CSR}, ha={Magma_CSR}, hb={Magma_CSR}, hc={Magma_CSR};
+            if ( k == 0 ) {
+                printf("\n%% --- Now use host level-scheduled trisolve ---\n");
+                zopts.precond_par.trisolver = Magma_CUSOLVE;
+            } else {
+                printf("\n%% --- Now use host sync-free trisolve ---\n");
+                zopts.precond_par.trisolver = Magma_SYNCFREESOLVE;
+            }
+            zopts.precond_par.solver = Magma_ILU;
+            TESTING_CHECK( magma_zmconvert( A, &hA, A.storage_type, Magma_CSR, queue ));
+            tempo1 = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_zmatrix_tril( hA, &zopts.precond_par.L, queue ));
+            TESTING_CHECK( magma_zmatrix_triu( hA, &zopts.precond_par.U, queue ));
+            TESTING_CHECK( magma_zilugeneratesolverinfo_cpu( &zopts.precond_par, queue ));
+            tempo2 = magma_sync_wtime( queue );
+            if(debug)printf("%% time_magma_zilugeneratesolverinfo_cpu = %.6e\n",tempo2-tempo1 );
+            else printf("%.6e\t",tempo2-tempo1 );
+
+            TESTING_CHECK( magma_zvinit( &ha, Magma_CPU, A.num_rows, 1, one, queue ));
+            TESTING_CHECK( magma_zvinit( &hb, Magma_CPU, A.num_rows, 1, zero, queue ));
+            TESTING_CHECK( magma_zvinit( &hc, Magma_CPU, A.num_rows, 1, zero, queue ));
+
+            // hb = sptrsv(L,ha)
+            // hc = L*hb
+            // res = norm(ha-hc)
+            tempo1 = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_z_applyprecond_left( MagmaNoTrans, hA, ha, &hb, &zopts.precond_par, queue ));
+            tempo2 = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_z_spmv( one, zopts.precond_par.L, hb, zero, hc, queue ));
+            res = 0.0;
+            for( magma_int_t j=0; j < dofs; j++ ) {
+                double dj = MAGMA_Z_ABS( MAGMA_Z_SUB( ha.val[j], hc.val[j] ));
+                res += dj * dj;
+            }
+            res = sqrt( res );
+            if(debug)printf("%% residual_L = %.6e\n", res );
+            else printf("%.6e\t", res );
+            if(debug)printf("%% time_L = %.6e\n",tempo2-tempo1 );
+            else printf("%.6e\t",tempo2-tempo1 );
+
+            // hb = sptrsv(U,ha)
+            // hc = U*hb
+            // res = norm(ha-hc)
+            tempo1 = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_z_applyprecond_right( MagmaNoTrans, hA, ha, &hb, &zopts.precond_par, queue ));
+            tempo2 = magma_sync_wtime( queue );
+            TESTING_CHECK( magma_z_spmv( one, zopts.precond_par.U, hb, zero, hc, queue ));
+            res = 0.0;
+            for( magma_int_t j=0; j < dofs; j++ ) {
+                double dj = MAGMA_Z_ABS( MAGMA_Z_SUB( ha.val[j], hc.val[j] ));
+                res += dj * dj;
+            }
+            res = sqrt( res );
+            if(debug)printf("%% residual_U = %.6e\n", res );
+            else printf("%.6e\t", res );
+            if(debug)printf("%% time_U = %.6e\n",tempo2-tempo1 );
+            else printf("%.6e\n",tempo2-tempo1 );
+            magma_zmfree(&hA, queue );
+            magma_zmfree(&ha, queue );
+            magma_zmfree(&hb, queue );
+            magma_zmfree(&hc, queue );
+            magma_zprecondfree( &zopts.precond_par , queue );
+        }
+
+        // ParILUT and ParIC: with a device b, the factors go to the device;
+        // with a host b, they stay on the host and are applied with the
+        // host trisolves, here in 20 steps of a preconditioned Richardson
+        // iteration x = x + U^{-1} L^{-1} (b - A x) on host vectors.
+        // The result is compared with the same iteration using serial
+        // reference trisolves.
+        for( int k=0; k < 2; k++ ) {
+            magma_z_matrix hA={Magma_CSR}, db={Magma_CSR}, hb={Magma_CSR},
+                           hx={Magma_CSR}, hr={Magma_CSR}, ht={Magma_CSR},
+                           hxref={Magma_CSR}, hrref={Magma_CSR};
+            const char* name = (k == 0 ? "ParILUT" : "ParIC");
+            double res0 = 0.0, diff = 0.0, norm = 0.0;
+            magma_int_t okay;
+            zopts.precond_par.solver = (k == 0 ? Magma_PARILU : Magma_PARIC);
+            zopts.precond_par.trisolver = Magma_CUSOLVE;
+            TESTING_CHECK( magma_zmconvert( A, &hA, A.storage_type, Magma_CSR, queue ));
+            TESTING_CHECK( magma_zvinit( &db, Magma_DEV, A.num_rows, 1, one, queue ));
+            TESTING_CHECK( magma_zvinit( &hb, Magma_CPU, A.num_rows, 1, one, queue ));
+            TESTING_CHECK( magma_zvinit( &hx, Magma_CPU, A.num_rows, 1, zero, queue ));
+            TESTING_CHECK( magma_zvinit( &hr, Magma_CPU, A.num_rows, 1, zero, queue ));
+            TESTING_CHECK( magma_zvinit( &ht, Magma_CPU, A.num_rows, 1, zero, queue ));
+            TESTING_CHECK( magma_zvinit( &hxref, Magma_CPU, A.num_rows, 1, zero, queue ));
+            TESTING_CHECK( magma_zvinit( &hrref, Magma_CPU, A.num_rows, 1, zero, queue ));
+
+            // default: device b, factors on the device
+            if ( k == 0 ) {
+                TESTING_CHECK( magma_zparilut_cpu( hA, db, &zopts.precond_par, queue ));
+            } else {
+                TESTING_CHECK( magma_zparic_cpu( hA, db, &zopts.precond_par, queue ));
+            }
+            okay = ( zopts.precond_par.L.memory_location == Magma_DEV &&
+                     zopts.precond_par.L_levelptr == NULL );
+            printf("%% %s with device b: factors on the device:  %s\n",
+                   name, (okay ? "ok" : "failed"));
+            magma_zprecondfree( &zopts.precond_par , queue );
+
+            // opt-in: host b, factors on the host
+            zopts.precond_par.solver = (k == 0 ? Magma_PARILU : Magma_PARIC);
+            if ( k == 0 ) {
+                TESTING_CHECK( magma_zparilut_cpu( hA, hb, &zopts.precond_par, queue ));
+            } else {
+                TESTING_CHECK( magma_zparic_cpu( hA, hb, &zopts.precond_par, queue ));
+            }
+            okay = ( zopts.precond_par.L.memory_location == Magma_CPU &&
+                     zopts.precond_par.L_levelptr != NULL );
+            printf("%% %s with host b: factors on the host:  %s\n",
+                   name, (okay ? "ok" : "failed"));
+
+            for( magma_int_t iter=0; iter <= 20; iter++ ) {
+                // hr = b - A x
+                TESTING_CHECK( magma_z_spmv( one, hA, hx, zero, hr, queue ));
+                res = 0.0;
+                for( magma_int_t j=0; j < dofs; j++ ) {
+                    hr.val[j] = MAGMA_Z_SUB( hb.val[j], hr.val[j] );
+                    res += MAGMA_Z_ABS( hr.val[j] ) * MAGMA_Z_ABS( hr.val[j] );
+                }
+                res = sqrt( res );
+                if ( iter == 0 ) {
+                    res0 = res;
+                }
+                if ( iter == 20 ) {
+                    break;
+                }
+                // x = x + U^{-1} L^{-1} hr, and the same with reference trisolves
+                TESTING_CHECK( magma_z_applyprecond_left( MagmaNoTrans, hA, hr, &ht, &zopts.precond_par, queue ));
+                TESTING_CHECK( magma_z_applyprecond_right( MagmaNoTrans, hA, ht, &hr, &zopts.precond_par, queue ));
+                TESTING_CHECK( magma_z_spmv( one, hA, hxref, zero, hrref, queue ));
+                for( magma_int_t j=0; j < dofs; j++ ) {
+                    hrref.val[j] = MAGMA_Z_SUB( hb.val[j], hrref.val[j] );
+                }
+                zcsrtrsv_ref( MagmaLower, zopts.precond_par.L, hrref.val, ht.val );
+                zcsrtrsv_ref( MagmaUpper, zopts.precond_par.U, ht.val, hrref.val );
+                for( magma_int_t j=0; j < dofs; j++ ) {
+                    hx.val[j]    = MAGMA_Z_ADD( hx.val[j],    hr.val[j] );
+                    hxref.val[j] = MAGMA_Z_ADD( hxref.val[j], hrref.val[j] );
+                }
+            }
+            for( magma_int_t j=0; j < dofs; j++ ) {
+                diff += MAGMA_Z_ABS( MAGMA_Z_SUB( hx.val[j], hxref.val[j] ));
+                norm += MAGMA_Z_ABS( hxref.val[j] );
+            }
+            diff = (norm == 0 ? diff : diff / norm);
+            printf("%% %s Richardson on the host, 20 steps: |b-Ax| %.6e -> %.6e:  %s\n",
+                   name, res0, res, (res < res0 ? "ok" : "failed"));
+            printf("%% %s Richardson on the host, |x-xref|/|xref| = %.6e:  %s\n",
+                   name, diff, (diff < accuracy ? "ok" : "failed"));
+            magma_zprecondfree( &zopts.precond_par , queue );
+            magma_zmfree(&hA, queue );
+            magma_zmfree(&db, queue );
+            magma_zmfree(&hb, queue );
+            magma_zmfree(&hx, queue );
+            magma_zmfree(&hr, queue );
+            magma_zmfree(&ht, queue );
+            magma_zmfree(&hxref, queue );
+            magma_zmfree(&hrref, queue );
+        }
+
+
         
                 // preconditioner with blcok-Jacobi trisolve
         printf("\n%% --- Now use block-Jacobi trisolve ---\n");
@@ -16,6 +16,7 @@
 
 #include "magma_internal.h"
 #include "magma_timer.h"
+#include "trace.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -284,6 +285,9 @@ magma_dlaex3(
     // Quick return if possible
     if (k == 0)
         return *info;
+
+    magma_trace_scope trace( "dstedx", "dlaex3", k );
+    magma_profile_scope profile( "dlaex3" );
     /*
      Modify values DLAMDA(i) to make sure all DLAMDA(i)-DLAMDA(j) can
      be computed with high relative accuracy (barring over/underflow).
@@ -316,9 +320,6 @@ magma_dlaex3(
     // -------------------------------------------------------------------------
     // openmp implementation
     // -------------------------------------------------------------------------
-    //magma_timer_t time = 0;
-    //timer_start( time );
-
     #pragma omp parallel private(i, j, tmp, temp)
     {
         magma_int_t tid     = omp_get_thread_num();
@@ -328,6 +329,9 @@ magma_dlaex3(
         magma_int_t iend   = ((tid+1) * k) / nthread; // end   index of local loop
         magma_int_t ik     = iend - ibegin;           // number of local indices
 
+        magma_trace_scope trace_secular( "dstedx", "dlaex3 secular", k );
+        magma_profile_scope profile_secular( "dlaex3 secular" );
+
         for (i = ibegin; i < iend; ++i)
             dlamda[i] = lapackf77_dlamc3(&dlamda[i], &dlamda[i]) - dlamda[i];
 
@@ -432,15 +436,11 @@ magma_dlaex3(
     if (*info != 0)
         return *info;
 
-    //timer_stop( time );
-    //timer_printf( "eigenvalues/vector D+zzT = %6.2f\n", time );
-
 #else
     // -------------------------------------------------------------------------
     // Non openmp implementation
     // -------------------------------------------------------------------------
-    // magma_timer_t time = 0;
-    // timer_start( time );
+    magma_profile_begin( "dlaex3 secular" );
 
     for (i = 0; i < k; ++i)
         dlamda[i] = lapackf77_dlamc3(&dlamda[i], &dlamda[i]) - dlamda[i];
@@ -514,15 +514,15 @@ magma_dlaex3(
         }
     }
 
-    //timer_stop( time );
-    //timer_printf( "eigenvalues/vector D+zzT = %6.2f\n", time );
+    magma_profile_end();
 
 #endif // _OPENMP
     // Compute the updated eigenvectors.
 
-    //timer_start( time );
     //magma_queue_sync( queue );  // previously, needed to setvector finished. Now all on same queue, so not needed?
 
+    magma_trace_begin( "dstedx", "dlaex3 update", rk );
+    magma_profile_begin( "dlaex3 update" );
     if (rk != 0) {
         if ( n23 != 0 ) {
             if (rk < magma_get_dlaed3_k()) {
@@ -562,8 +562,8 @@ magma_dlaex3(
             lapackf77_dlaset("A", &n1, &rk, &d_zero, &d_zero, Q(0,iil-1), &ldq);
         }
     }
-    //timer_stop( time );
-    //timer_printf( "gemms = %6.2f\n", time );
+    magma_trace_end();
+    magma_profile_end( 2.*rk*(double(n2)*n23 + double(n1)*n12) );
 
     return *info;
 } /* magma_dlaex3 */
@@ -10,6 +10,7 @@
        @precisions normal d -> s
 */
 #include "magma_internal.h"
+#include "magma_timer.h"
 
 /***************************************************************************//**
     Purpose
@@ -217,6 +218,8 @@ magma_dstedx(
         return *info;
     }
 
+    magma_profile_scope profile( "dstedx" );
+
     /* determine the number of threads *///not needed here to be checked Azzam
     //magma_int_t threads = magma_get_parallel_numthreads();
     //magma_int_t mklth   = magma_get_lapack_numthreads();
@@ -230,7 +233,9 @@ magma_dstedx(
     // solve the problem with another solver.
 
     if (n < smlsiz) {
+        magma_profile_begin( "dsteqr" );
         lapackf77_dsteqr("I", &n, d, e, Z, &ldz, work, info);
+        magma_profile_end();
     } else {
         lapackf77_dlaset("F", &n, &n, &d_zero, &d_one, Z, &ldz);
 
@@ -274,7 +279,9 @@ magma_dstedx(
                     magma_int_t mm = m-1;
                     lapackf77_dlascl("G", &izero, &izero, &orgnrm, &d_one, &mm, &ione, &e[start], &mm, info);
 
+                    magma_profile_begin( "dlaex0" );
                     magma_dlaex0( m, &d[start], &e[start], Z(start, start), ldz, work, iwork, dwork, MagmaRangeAll, vl, vu, il, iu, info);
+                    magma_profile_end();
 
                     if ( *info != 0) {
                         return *info;
@@ -283,7 +290,9 @@ magma_dstedx(
                     // Scale Back
                     lapackf77_dlascl("G", &izero, &izero, &d_one, &orgnrm, &m, &ione, &d[start], &m, info);
                 } else {
+                    magma_profile_begin( "dsteqr" );
                     lapackf77_dsteqr( "I", &m, &d[start], &e[start], Z(start, start), &ldz, work, info);
+                    magma_profile_end();
                     if (*info != 0) {
                         *info = (start+1) *(n+1) + end;
                     }
@@ -321,7 +330,9 @@ magma_dstedx(
             magma_int_t nm = n-1;
             lapackf77_dlascl("G", &izero, &izero, &orgnrm, &d_one, &nm, &ione, e, &nm, info);
 
+            magma_profile_begin( "dlaex0" );
             magma_dlaex0( n, d, e, Z, ldz, work, iwork, dwork, range, vl, vu, il, iu, info);
+            magma_profile_end();
 
             if ( *info != 0) {
                 return *info;
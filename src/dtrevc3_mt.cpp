@@ -12,6 +12,7 @@
 */
 #include "thread_queue.hpp"
 #include "magma_timer.h"
+#include "trace.h"
 
 #include "magma_internal.h"  // after thread.hpp, so max, min are defined
 
@@ -39,6 +40,7 @@ public:
     
     virtual void run()
     {
+        magma_trace_scope trace( "trevc3", "dlaqtrsd" );
         magma_int_t info = 0;
         magma_dlaqtrsd( trans, n, T, ldt, x, incx, cnorm, &info );
         if ( info != 0 ) {
@@ -90,6 +92,7 @@ public:
     
     virtual void run()
     {
+        magma_trace_scope trace( "trevc3", "dgemm" );
         blasf77_dgemm( lapack_trans_const(transA), lapack_trans_const(transB),
                        &m, &n, &k, &alpha, A, &lda, B, &ldb, &beta, C, &ldc );
     }
@@ -111,6 +114,97 @@ private:
 };
 
 
+// ---------------------------------------------
+// stores arguments and executes call to dlaset to zero an m-by-n matrix (on CPU)
+class dzero_task: public magma_task
+{
+public:
+    dzero_task( magma_int_t in_m, magma_int_t in_n, double *in_A, magma_int_t in_lda ):
+        m  ( in_m   ),
+        n  ( in_n   ),
+        A  ( in_A   ),
+        lda( in_lda )
+    {}
+    
+    virtual void run()
+    {
+        magma_trace_scope trace( "trevc3", "dzero" );
+        const double c_zero = 0;
+        lapackf77_dlaset( "F", &m, &n, &c_zero, &c_zero, A, &lda );
+    }
+    
+private:
+    magma_int_t m;
+    magma_int_t n;
+    double     *A;
+    magma_int_t lda;
+};
+
+
+// ---------------------------------------------
+// normalizes back-transformed eigenvectors in columns 0:nvec-1 of W
+// and copies them to V (on CPU).
+// iscomplex[k] is 0 for real eigenvector, 1 for first and -1 for second
+// of conjugate pair, as in dtrevc3_mt.
+class dnormalize_task: public magma_task
+{
+public:
+    dnormalize_task(
+        magma_int_t in_n, magma_int_t in_nvec, const magma_int_t *in_iscomplex,
+        double *in_W, magma_int_t in_ldw,
+        double *in_V, magma_int_t in_ldv
+    ):
+        n        ( in_n   ),
+        nvec     ( in_nvec ),
+        iscomplex( in_iscomplex, in_iscomplex + in_nvec ),
+        W        ( in_W   ),
+        ldw      ( in_ldw ),
+        V        ( in_V   ),
+        ldv      ( in_ldv )
+    {}
+    
+    virtual void run()
+    {
+        magma_trace_scope trace( "trevc3", "dnormalize" );
+        const magma_int_t ione = 1;
+        const double c_zero = 0;
+        const double c_one  = 1;
+        double emax, remax = c_one;
+        magma_int_t ii;
+        for( magma_int_t k=0; k < nvec; ++k ) {
+            double *Wk = W + k*ldw;
+            if ( iscomplex[k] == 0 ) {
+                // real eigenvector
+                ii = blasf77_idamax( &n, Wk, &ione ) - 1;  // subtract 1; ii is 0-based
+                remax = c_one / fabs( Wk[ii] );
+            }
+            else if ( iscomplex[k] == 1 ) {
+                // first eigenvector of conjugate pair
+                emax = c_zero;
+                for( ii=0; ii < n; ++ii ) {
+                    emax = max( emax, fabs( Wk[ii] ) + fabs( Wk[ii + ldw] ) );
+                }
+                remax = c_one / emax;
+            // else if iscomplex[k] == -1
+            //     second eigenvector of conjugate pair
+            //     reuse same remax as previous k
+            }
+            blasf77_dscal( &n, &remax, Wk, &ione );
+        }
+        lapackf77_dlacpy( "F", &n, &nvec, W, &ldw, V, &ldv );
+    }
+    
+private:
+    magma_int_t n;
+    magma_int_t nvec;
+    std::vector< magma_int_t > iscomplex;
+    double     *W;
+    magma_int_t ldw;
+    double     *V;
+    magma_int_t ldv;
+};
+
+
 /***************************************************************************//**
     Purpose
     -------
@@ -240,8 +334,11 @@ private:
     @param[in]
     lwork    INTEGER
              The dimension of array work. lwork >= max(1,3*n).
-             For optimum performance, lwork >= (1 + 2*nb)*n, where nb is
-             the optimal blocksize.
+             For optimum performance, lwork >= 2*(1 + 2*nb)*n, where nb is
+             the optimal blocksize. This holds two sets of x and Q*x
+             vectors, so solves for the next block overlap the
+             back-transform of the current block; with lwork >= (1 + 2*nb)*n,
+             one set is used.
 
     @param[out]
     info     INTEGER
@@ -280,6 +377,7 @@ magma_int_t magma_dtrevc3_mt(
 #define VR(i,j) (VR + (i) + (j)*ldvr)
 #define X(i,j)  (X  + (i)-1 + ((j)-1)*2)  // still as 1-based indices
 #define work(i,j) (work + (i) + (j)*n)
+#define xwork(i,j) (xwork + (i) + (j)*n)
 
     // constants
     const magma_int_t ione = 1;
@@ -290,8 +388,14 @@ magma_int_t magma_dtrevc3_mt(
     // .. Local Scalars ..
     magma_int_t allv, bothv, leftv, over, pair, rightv, somev;
     magma_int_t i, ii, ip, is, j, k, ki, ki2,
-                iv, n2, nb, nb2, version;
+                iv, n2, nb, nb2, nsets, version;
     double emax, remax;
+    magma_task *task;
+    
+    // xwork points to current set of x and Q*x vectors, either work or work2.
+    // Column 0 of work holds 1-norms; column 0 of work2 is unused.
+    double *work2 = NULL;
+    double *xwork = work;
     
     // .. Local Arrays ..
     // since iv is a 1-based index, allocate one extra here
@@ -378,10 +482,20 @@ magma_int_t magma_dtrevc3_mt(
     nb = 2;
     if ( lwork >= n + 2*n*nbmin ) {
         version = 2;
-        nb = (lwork - n) / (2*n);
+        // Use two sets of x and Q*x vectors if both fit with nb >= nbmin,
+        // so solves for the next block can proceed while GEMMs for the
+        // current block are in flight. With one set, all blocks use it,
+        // which is still correct, as tasks' reads and writes tags order them.
+        nsets = (lwork >= 2*(n + 2*n*nbmin) ? 2 : 1);
+        nb = (lwork/nsets - n) / (2*n);
         nb = min( nb, nbmax );
+        nb = min( nb, max( nbmin, magma_tune_get( "dtrevc3_mt_nb", n, nbmax )));
         nb2 = 1 + 2*nb;
         lapackf77_dlaset( "F", &n, &nb2, &c_zero, &c_zero, work, &n );
+        if ( nsets == 2 ) {
+            work2 = work + n*nb2;
+            lapackf77_dlaset( "F", &n, &nb2, &c_zero, &c_zero, work2, &n );
+        }
     }
     else {
         version = 1;
@@ -398,12 +512,11 @@ magma_int_t magma_dtrevc3_mt(
     }
         
     // launch threads -- each single-threaded MKL
-    magma_int_t nthread = magma_get_parallel_numthreads();
-    magma_int_t lapack_nthread = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads( 1 );
+    magma_thread_budget budget( 0 );
+    magma_int_t nthread = budget.workers();
     magma_thread_queue queue;
-    queue.launch( nthread );
-    //printf( "nthread %lld, %lld\n", (long long) nthread, (long long) lapack_nthread );
+    queue.launch( nthread, MagmaThreadWorkStealing );
+    //printf( "nthread %lld, blas %lld\n", (long long) nthread, (long long) budget.blas() );
     
     // gemm_nb = N/thread, rounded up to multiple of 16,
     // but avoid multiples of page size, e.g., 512*8 bytes = 4096.
@@ -412,7 +525,8 @@ magma_int_t magma_dtrevc3_mt(
         gemm_nb += 32;
     }
     
-    magma_timer_t time_total=0, time_trsv=0, time_gemm=0, time_gemv=0, time_trsv_sum=0, time_gemm_sum=0, time_gemv_sum=0;
+    // with version 2, gemms overlap solves, so time_trsv includes both
+    magma_timer_t time_total=0, time_trsv=0, time_gemv=0, time_trsv_sum=0, time_gemv_sum=0;
     timer_start( time_total );
 
     // Index ip is used to specify the real or complex eigenvalue:
@@ -474,8 +588,10 @@ magma_int_t magma_dtrevc3_mt(
                 // Real right eigenvector
                 // Solve upper quasi-triangular system:
                 // [ T(0:ki-1,0:ki-1) - wr ]*X = -T(0:ki-1,ki)
-                queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaNoTrans, ki+1, T(0,0), ldt, work(0,iv), n, work(0,0) ));
+                task = new magma_dlaqtrsd_task(
+                    MagmaNoTrans, ki+1, T(0,0), ldt, xwork(0,iv), n, work(0,0) );
+                task->writes( xwork(0,iv) );
+                queue.push_task( task );
                 
                 // Copy the vector x or Q*x to VR and normalize.
                 if ( ! over ) {
@@ -483,7 +599,7 @@ magma_int_t magma_dtrevc3_mt(
                     // no back-transform: copy x to VR and normalize.
                     queue.sync();
                     n2 = ki+1;
-                    blasf77_dcopy( &n2, work(0,iv), &ione, VR(0,is), &ione );
+                    blasf77_dcopy( &n2, xwork(0,iv), &ione, VR(0,is), &ione );
 
                     ii = blasf77_idamax( &n2, VR(0,is), &ione ) - 1;  // subtract 1; ii is 0-based
                     remax = c_one / fabs( *VR(ii,is) );
@@ -503,8 +619,8 @@ magma_int_t magma_dtrevc3_mt(
                         n2 = ki;
                         blasf77_dgemv( "n", &n, &n2, &c_one,
                                        VR, &ldvr,
-                                       work(0, iv), &ione,
-                                       work(ki,iv), VR(0,ki), &ione );
+                                       xwork(0, iv), &ione,
+                                       xwork(ki,iv), VR(0,ki), &ione );
                     }
                     time_gemv_sum += timer_stop( time_gemv );
                     ii = blasf77_idamax( &n, VR(0,ki), &ione ) - 1;  // subtract 1; ii is 0-based
@@ -516,8 +632,10 @@ magma_int_t magma_dtrevc3_mt(
                     // ------------------------------
                     // version 2: back-transform block of vectors with GEMM
                     // zero out below vector
-                    for( k=ki + 1; k < n; ++k ) {
-                        *work(k,iv) = c_zero;
+                    if ( ki+1 < n ) {
+                        task = new dzero_task( n-ki-1, 1, xwork(ki+1,iv), n );
+                        task->writes( xwork(0,iv) );
+                        queue.push_task( task );
                     }
                     iscomplex[ iv ] = ip;
                     // back-transform and normalization is done below
@@ -528,8 +646,11 @@ magma_int_t magma_dtrevc3_mt(
                 // Complex right eigenvector
                 // Solve upper quasi-triangular system:
                 // [ T(0:ki-2,0:ki-2) - (wr+i*wi) ]*x = u
-                queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaNoTrans, ki+1, T(0,0), ldt, work(0,iv-1), n, work(0,0) ));
+                task = new magma_dlaqtrsd_task(
+                    MagmaNoTrans, ki+1, T(0,0), ldt, xwork(0,iv-1), n, work(0,0) );
+                task->writes( xwork(0,iv-1) );
+                task->writes( xwork(0,iv  ) );
+                queue.push_task( task );
 
                 // Copy the vector x or Q*x to VR and normalize.
                 if ( ! over ) {
@@ -537,8 +658,8 @@ magma_int_t magma_dtrevc3_mt(
                     // no back-transform: copy x to VR and normalize.
                     queue.sync();
                     n2 = ki+1;
-                    blasf77_dcopy( &n2, work(0,iv-1), &ione, VR(0,is-1), &ione );
-                    blasf77_dcopy( &n2, work(0,iv  ), &ione, VR(0,is  ), &ione );
+                    blasf77_dcopy( &n2, xwork(0,iv-1), &ione, VR(0,is-1), &ione );
+                    blasf77_dcopy( &n2, xwork(0,iv  ), &ione, VR(0,is  ), &ione );
 
                     emax = c_zero;
                     for( k=0; k <= ki; ++k ) {
@@ -563,16 +684,16 @@ magma_int_t magma_dtrevc3_mt(
                         n2 = ki-1;
                         blasf77_dgemv( "n", &n, &n2, &c_one,
                                        VR, &ldvr,
-                                       work(0,   iv-1), &ione,
-                                       work(ki-1,iv-1), VR(0,ki-1), &ione );
+                                       xwork(0,   iv-1), &ione,
+                                       xwork(ki-1,iv-1), VR(0,ki-1), &ione );
                         blasf77_dgemv( "n", &n, &n2, &c_one,
                                        VR, &ldvr,
-                                       work(0, iv), &ione,
-                                       work(ki,iv), VR(0,ki), &ione );
+                                       xwork(0, iv), &ione,
+                                       xwork(ki,iv), VR(0,ki), &ione );
                     }
                     else {
-                        blasf77_dscal( &n, work(ki-1,iv-1), VR(0,ki-1), &ione );
-                        blasf77_dscal( &n, work(ki,  iv  ), VR(0,ki  ), &ione );
+                        blasf77_dscal( &n, xwork(ki-1,iv-1), VR(0,ki-1), &ione );
+                        blasf77_dscal( &n, xwork(ki,  iv  ), VR(0,ki  ), &ione );
                     }
                     time_gemv_sum += timer_stop( time_gemv );
 
@@ -589,9 +710,11 @@ magma_int_t magma_dtrevc3_mt(
                     // ------------------------------
                     // version 2: back-transform block of vectors with GEMM
                     // zero out below vector
-                    for( k=ki + 1; k < n; ++k ) {
-                        *work(k,iv-1) = c_zero;
-                        *work(k,iv  ) = c_zero;
+                    if ( ki+1 < n ) {
+                        task = new dzero_task( n-ki-1, 2, xwork(ki+1,iv-1), n );
+                        task->writes( xwork(0,iv-1) );
+                        task->writes( xwork(0,iv  ) );
+                        queue.push_task( task );
                     }
                     iscomplex[ iv-1 ] = -ip;
                     iscomplex[ iv   ] =  ip;
@@ -615,52 +738,44 @@ magma_int_t magma_dtrevc3_mt(
                 // When the number of vectors stored reaches nb-1 or nb,
                 // or if this was last vector, do the GEMM
                 if ( (iv <= 2) || (ki2 == 0) ) {
-                    queue.sync();
-                    time_trsv_sum += timer_stop( time_trsv );
-                    timer_start( time_gemm );
                     nb2 = nb-iv+1;
                     n2  = ki2+nb-iv+1;
                     
-                    // split gemm into multiple tasks, each doing one block row
+                    // split gemm into multiple tasks, each doing one block row.
+                    // Rather than syncing, tags order gemms after this block's
+                    // solves, and normalization after the gemms, so solves for
+                    // the next block (in the other set of vectors) overlap them.
                     for( i=0; i < n; i += gemm_nb ) {
                         magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new dgemm_task(
+                        task = new dgemm_task(
                             MagmaNoTrans, MagmaNoTrans, ib, nb2, n2, c_one,
                             VR(i,0), ldvr,
-                            work(0,iv), n, c_zero,
-                            work(i,nb+iv), n ));
+                            xwork(0,iv), n, c_zero,
+                            xwork(i,nb+iv), n );
+                        for( k=iv; k <= nb; ++k ) {
+                            task->reads( xwork(0,k) );
+                        }
+                        task->reads( VR );
+                        task->writes( xwork(i,2*nb) );  // tag for block row i of Q*x
+                        queue.push_task( task );
                     }
-                    queue.sync();
-                    time_gemm_sum += timer_stop( time_gemm );
-
-                    // normalize vectors
+                    
+                    // normalize vectors and copy to VR
                     // TODO if somev, should copy vectors individually to correct location.
-                    for( k=iv; k <= nb; ++k ) {
-                        if ( iscomplex[k] == 0 ) {
-                            // real eigenvector
-                            ii = blasf77_idamax( &n, work(0,nb+k), &ione ) - 1;  // subtract 1; ii is 0-based
-                            remax = c_one / fabs( *work(ii,nb+k) );
-                        }
-                        else if ( iscomplex[k] == 1 ) {
-                            // first eigenvector of conjugate pair
-                            emax = c_zero;
-                            for( ii=0; ii < n; ++ii ) {
-                                emax = max( emax, fabs( *work(ii,nb+k  ) )
-                                                + fabs( *work(ii,nb+k+1) ) );
-                            }
-                            remax = c_one / emax;
-                        // else if iscomplex[k] == -1
-                        //     second eigenvector of conjugate pair
-                        //     reuse same remax as previous k
-                        }
-                        blasf77_dscal( &n, &remax, work(0,nb+k), &ione );
+                    task = new dnormalize_task( n, nb2, &iscomplex[iv],
+                                                xwork(0,nb+iv), n,
+                                                VR(0,ki2), ldvr );
+                    for( i=0; i < n; i += gemm_nb ) {
+                        task->reads( xwork(i,2*nb) );
+                    }
+                    task->writes( VR );
+                    queue.push_task( task );
+                    
+                    // switch to other set of vectors for next block
+                    if ( work2 != NULL ) {
+                        xwork = (xwork == work ? work2 : work);
                     }
-                    nb2 = nb-iv+1;
-                    lapackf77_dlacpy( "F", &n, &nb2,
-                                      work(0,nb+iv), &n,
-                                      VR(0,ki2), &ldvr );
                     iv = nb;
-                    timer_start( time_trsv );
                 }
                 else {
                     iv -= 1;
@@ -672,12 +787,16 @@ magma_int_t magma_dtrevc3_mt(
                 is -= 1;
             }
         }
+        queue.sync();
     }
-    timer_stop( time_trsv );
+    time_trsv_sum += timer_stop( time_trsv );
     
     timer_stop( time_total );
-    timer_printf( "trevc trsv %.4f, gemm %.4f, gemv %.4f, total %.4f\n",
-                  time_trsv_sum, time_gemm_sum, time_gemv_sum, time_total );
+    timer_printf( "trevc trsv+gemm %.4f, gemv %.4f, total %.4f\n",
+                  time_trsv_sum, time_gemv_sum, time_total );
+    
+    // left eigenvectors start with first set of vectors
+    xwork = work;
 
     if ( leftv ) {
         // ============================================================
@@ -721,8 +840,10 @@ magma_int_t magma_dtrevc3_mt(
                 // Real left eigenvector
                 // Solve transposed quasi-triangular system:
                 // [ T(ki+1:n,ki+1:n) - wr ]**T * X = -T(ki+1:n,ki)
-                queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaTrans, n-ki, T(ki,ki), ldt, work(ki,iv), n, work(ki,0) ));
+                task = new magma_dlaqtrsd_task(
+                    MagmaTrans, n-ki, T(ki,ki), ldt, xwork(ki,iv), n, work(ki,0) );
+                task->writes( xwork(0,iv) );
+                queue.push_task( task );
     
                 // Copy the vector x or Q*x to VL and normalize.
                 if ( ! over ) {
@@ -730,7 +851,7 @@ magma_int_t magma_dtrevc3_mt(
                     // no back-transform: copy x to VL and normalize.
                     queue.sync();
                     n2 = n-ki;
-                    blasf77_dcopy( &n2, work(ki,iv), &ione, VL(ki,is), &ione );
+                    blasf77_dcopy( &n2, xwork(ki,iv), &ione, VL(ki,is), &ione );
     
                     ii = blasf77_idamax( &n2, VL(ki,is), &ione ) + ki - 1;  // subtract 1; ii is 0-based
                     remax = c_one / fabs( *VL(ii,is) );
@@ -748,8 +869,8 @@ magma_int_t magma_dtrevc3_mt(
                         n2 = n-ki-1;
                         blasf77_dgemv( "n", &n, &n2, &c_one,
                                        VL(0,ki+1), &ldvl,
-                                       work(ki+1,iv), &ione,
-                                       work(ki,  iv), VL(0,ki), &ione );
+                                       xwork(ki+1,iv), &ione,
+                                       xwork(ki,  iv), VL(0,ki), &ione );
                     }
                     ii = blasf77_idamax( &n, VL(0,ki), &ione ) - 1;  // subtract 1; ii is 0-based
                     remax = c_one / fabs( *VL(ii,ki) );
@@ -760,8 +881,10 @@ magma_int_t magma_dtrevc3_mt(
                     // version 2: back-transform block of vectors with GEMM
                     // zero out above vector
                     // could go from (ki+1)-NV+1 to ki
-                    for( k=0; k < ki; ++k ) {
-                        *work(k,iv) = c_zero;
+                    if ( ki > 0 ) {
+                        task = new dzero_task( ki, 1, xwork(0,iv), n );
+                        task->writes( xwork(0,iv) );
+                        queue.push_task( task );
                     }
                     iscomplex[ iv ] = ip;
                     // back-transform and normalization is done below
@@ -772,8 +895,11 @@ magma_int_t magma_dtrevc3_mt(
                 // Complex left eigenvector
                 // Solve transposed quasi-triangular system:
                 // [ T(ki+2:n,ki+2:n)**T - (wr-i*wi) ]*X = V
-                queue.push_task( new magma_dlaqtrsd_task(
-                    MagmaTrans, n-ki, T(ki,ki), ldt, work(ki,iv), n, work(ki,0) ));
+                task = new magma_dlaqtrsd_task(
+                    MagmaTrans, n-ki, T(ki,ki), ldt, xwork(ki,iv), n, work(ki,0) );
+                task->writes( xwork(0,iv  ) );
+                task->writes( xwork(0,iv+1) );
+                queue.push_task( task );
     
                 // Copy the vector x or Q*x to VL and normalize.
                 if ( ! over ) {
@@ -781,8 +907,8 @@ magma_int_t magma_dtrevc3_mt(
                     // no back-transform: copy x to VL and normalize.
                     queue.sync();
                     n2 = n-ki;
-                    blasf77_dcopy( &n2, work(ki,iv  ), &ione, VL(ki,is  ), &ione );
-                    blasf77_dcopy( &n2, work(ki,iv+1), &ione, VL(ki,is+1), &ione );
+                    blasf77_dcopy( &n2, xwork(ki,iv  ), &ione, VL(ki,is  ), &ione );
+                    blasf77_dcopy( &n2, xwork(ki,iv+1), &ione, VL(ki,is+1), &ione );
     
                     emax = c_zero;
                     for( k=ki; k < n; ++k ) {
@@ -805,16 +931,16 @@ magma_int_t magma_dtrevc3_mt(
                         n2 = n-ki-2;
                         blasf77_dgemv( "n", &n, &n2, &c_one,
                                        VL(0,ki+2), &ldvl,
-                                       work(ki+2,iv), &ione,
-                                       work(ki,  iv), VL(0,ki), &ione );
+                                       xwork(ki+2,iv), &ione,
+                                       xwork(ki,  iv), VL(0,ki), &ione );
                         blasf77_dgemv( "n", &n, &n2, &c_one,
                                        VL(0,ki+2), &ldvl,
-                                       work(ki+2,iv+1), &ione,
-                                       work(ki+1,iv+1), VL(0,ki+1), &ione );
+                                       xwork(ki+2,iv+1), &ione,
+                                       xwork(ki+1,iv+1), VL(0,ki+1), &ione );
                     }
                     else {
-                        blasf77_dscal( &n, work(ki,  iv  ), VL(0, ki  ), &ione );
-                        blasf77_dscal( &n, work(ki+1,iv+1), VL(0, ki+1), &ione );
+                        blasf77_dscal( &n, xwork(ki,  iv  ), VL(0, ki  ), &ione );
+                        blasf77_dscal( &n, xwork(ki+1,iv+1), VL(0, ki+1), &ione );
                     }
     
                     emax = c_zero;
@@ -830,9 +956,11 @@ magma_int_t magma_dtrevc3_mt(
                     // version 2: back-transform block of vectors with GEMM
                     // zero out above vector
                     // could go from (ki+1)-NV+1 to ki
-                    for( k=0; k < ki; ++k ) {
-                        *work(k,iv  ) = c_zero;
-                        *work(k,iv+1) = c_zero;
+                    if ( ki > 0 ) {
+                        task = new dzero_task( ki, 2, xwork(0,iv), n );
+                        task->writes( xwork(0,iv  ) );
+                        task->writes( xwork(0,iv+1) );
+                        queue.push_task( task );
                     }
                     iscomplex[ iv   ] =  ip;
                     iscomplex[ iv+1 ] = -ip;
@@ -856,43 +984,39 @@ magma_int_t magma_dtrevc3_mt(
                 // When the number of vectors stored reaches nb-1 or nb,
                 // or if this was last vector, do the GEMM
                 if ( (iv >= nb-1) || (ki2 == n-1) ) {
-                    queue.sync();
                     n2 = n-(ki2+1)+iv;
                     
-                    // split gemm into multiple tasks, each doing one block row
+                    // split gemm into multiple tasks, each doing one block row.
+                    // As for right eigenvectors, tags replace syncs.
                     for( i=0; i < n; i += gemm_nb ) {
                         magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new dgemm_task(
+                        task = new dgemm_task(
                             MagmaNoTrans, MagmaNoTrans, ib, iv, n2, c_one,
                             VL(i,ki2-iv+1), ldvl,
-                            work(ki2-iv+1,1), n, c_zero,
-                            work(i,nb+1), n ));
-                    }
-                    queue.sync();
-                    // normalize vectors
-                    for( k=1; k <= iv; ++k ) {
-                        if ( iscomplex[k] == 0 ) {
-                            // real eigenvector
-                            ii = blasf77_idamax( &n, work(0,nb+k), &ione ) - 1;  // subtract 1; ii is 0-based
-                            remax = c_one / fabs( *work(ii,nb+k) );
-                        }
-                        else if ( iscomplex[k] == 1) {
-                            // first eigenvector of conjugate pair
-                            emax = c_zero;
-                            for( ii=0; ii < n; ++ii ) {
-                                emax = max( emax, fabs( *work(ii,nb+k  ) )
-                                                + fabs( *work(ii,nb+k+1) ) );
-                            }
-                            remax = c_one / emax;
-                        // else if iscomplex[k] == -1
-                        //     second eigenvector of conjugate pair
-                        //     reuse same remax as previous k
+                            xwork(ki2-iv+1,1), n, c_zero,
+                            xwork(i,nb+1), n );
+                        for( k=1; k <= iv; ++k ) {
+                            task->reads( xwork(0,k) );
                         }
-                        blasf77_dscal( &n, &remax, work(0,nb+k), &ione );
+                        task->reads( VL );
+                        task->writes( xwork(i,2*nb) );  // tag for block row i of Q*x
+                        queue.push_task( task );
+                    }
+                    
+                    // normalize vectors and copy to VL
+                    task = new dnormalize_task( n, iv, &iscomplex[1],
+                                                xwork(0,nb+1), n,
+                                                VL(0,ki2-iv+1), ldvl );
+                    for( i=0; i < n; i += gemm_nb ) {
+                        task->reads( xwork(i,2*nb) );
+                    }
+                    task->writes( VL );
+                    queue.push_task( task );
+                    
+                    // switch to other set of vectors for next block
+                    if ( work2 != NULL ) {
+                        xwork = (xwork == work ? work2 : work);
                     }
-                    lapackf77_dlacpy( "F", &n, &iv,
-                                      work(0,nb+1), &n,
-                                      VL(0,ki2-iv+1), &ldvl );
                     iv = 1;
                 }
                 else {
@@ -905,11 +1029,11 @@ magma_int_t magma_dtrevc3_mt(
                 is += 1;
             }
         }
+        queue.sync();
     }
     
     // close down threads
     queue.quit();
-    magma_set_lapack_numthreads( lapack_nthread );
     
     return *info;
 }  // end of DTREVC3
@@ -16,6 +16,10 @@
 #include "magma_bulge.h"
 #include "magma_zbulge.h"
 
+#ifndef MAGMA_NOAFFINITY
+#include "affinity.h"
+#endif
+
 #define COMPLEX
 
 static void *magma_zapplyQ_parallel_section(void *arg);
@@ -123,9 +127,9 @@ magma_zbulge_back(
     magmaDoubleComplex *T, magma_int_t ldt,
     magma_int_t* info)
 {
-    magma_int_t threads = magma_get_parallel_numthreads();
-    magma_int_t mklth   = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads(1);
+    // one core per thread, each with single-threaded BLAS
+    magma_thread_budget budget( 0 );
+    magma_int_t threads = budget.workers();
 
     real_Double_t timeaplQ2=0.0;
     double f= 1.;
@@ -178,39 +182,29 @@ magma_zbulge_back(
         magma_zapplyQ_id_data* arg;
         magma_malloc_cpu((void**) &arg, threads*sizeof(magma_zapplyQ_id_data));
 
-        pthread_t* thread_id;
-        magma_malloc_cpu((void**) &thread_id, threads*sizeof(pthread_t));
-
-        pthread_attr_t thread_attr;
-
         // ===============================
         // relaunch thread to apply Q
         // ===============================
-        // Set one thread per core
-        pthread_attr_init(&thread_attr);
-        pthread_attr_setscope(&thread_attr, PTHREAD_SCOPE_SYSTEM);
-        pthread_setconcurrency( (unsigned)threads );
-
-        // Launch threads
-        for (magma_int_t thread = 1; thread < threads; thread++) {
+        // Run parallel section on the persistent thread pool;
+        // this thread executes arg[0]
+        for (magma_int_t thread = 0; thread < threads; thread++) {
             magma_zapplyQ_id_data_init(&(arg[thread]), thread, &data_applyQ);
-            pthread_create(&thread_id[thread], &thread_attr, magma_zapplyQ_parallel_section, &arg[thread]);
         }
-        magma_zapplyQ_id_data_init(&(arg[0]), 0, &data_applyQ);
-        magma_zapplyQ_parallel_section(&arg[0]);
+        magma_int_t run_info = magma_threadpool_run(
+            threads, magma_zapplyQ_parallel_section,
+            arg, sizeof(magma_zapplyQ_id_data) );
 
-        // Wait for completion
-        for (magma_int_t thread = 1; thread < threads; thread++) {
-            void *exitcodep;
-            pthread_join(thread_id[thread], &exitcodep);
-        }
-
-        magma_free_cpu(thread_id);
         magma_free_cpu(arg);
         magma_zapplyQ_data_destroy(&data_applyQ);
 
-
-        magma_zsetmatrix( n, ne-n_gpu, Z + n_gpu*ldz, ldz, dZ + n_gpu*ldz, lddz, queue );
+        if (run_info != 0) {
+            // threads could not be created and nothing ran; apply Q on the GPU only
+            magma_zsetmatrix( n, ne, Z, ldz, dZ, lddz, queue );
+            magma_zbulge_applyQ_v2(MagmaLeft, ne, n, nb, Vblksiz, dZ, lddz, V, ldv, T, ldt, info);
+        }
+        else {
+            magma_zsetmatrix( n, ne-n_gpu, Z + n_gpu*ldz, ldz, dZ + n_gpu*ldz, lddz, queue );
+        }
 
         /*============================
          *  use only GPU
@@ -223,7 +217,6 @@ magma_zbulge_back(
     timeaplQ2 = magma_wtime()-timeaplQ2;
 
     magma_queue_destroy( queue );
-    magma_set_lapack_numthreads(mklth);
     return MAGMA_SUCCESS;
 }
 
@@ -259,9 +252,7 @@ static void *magma_zapplyQ_parallel_section(void *arg)
 
     magma_int_t n_cpu = ne - n_gpu;
 
-    // with MKL and when using omp_set_num_threads instead of mkl_set_num_threads
-    // it need that all threads setting it to 1.
-    magma_set_lapack_numthreads(1);
+    // single-threaded BLAS, from the caller's magma_thread_budget
 
 #ifndef MAGMA_NOAFFINITY
     //#define PRINTAFFINITY
@@ -269,16 +260,16 @@ static void *magma_zapplyQ_parallel_section(void *arg)
     affinity_set print_set;
     print_set.print_affinity(my_core_id, "starting affinity");
 #endif
-    cpu_set_t old_set, new_set;
-
-    //store current affinity
-    CPU_ZERO(&old_set);
-    sched_getaffinity( 0, sizeof(old_set), &old_set);
-    //set new affinity
-    // bind threads
-    CPU_ZERO(&new_set);
-    CPU_SET(my_core_id, &new_set);
-    sched_setaffinity( 0, sizeof(new_set), &new_set);
+    affinity_set old_set;
+    affinity_set new_set;
+    magma_int_t check = -1;
+    // store current affinity, then bind threads to CPUs chosen by the
+    // placement policy (see MAGMA_AFFINITY)
+    if (new_set.place_thread(my_core_id)) {
+        check = old_set.get_affinity();
+        if (check == 0)
+            new_set.set_affinity();
+    }
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "set affinity");
 #endif
@@ -333,7 +324,8 @@ static void *magma_zapplyQ_parallel_section(void *arg)
 
 #ifndef MAGMA_NOAFFINITY
     //restore old affinity
-    sched_setaffinity(0, sizeof(old_set), &old_set);
+    if (check == 0)
+        old_set.set_affinity();
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "restored_affinity");
 #endif
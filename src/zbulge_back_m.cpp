@@ -126,9 +126,9 @@ magma_zbulge_back_m(
     magmaDoubleComplex *T, magma_int_t ldt,
     magma_int_t* info)
 {
-    magma_int_t threads = magma_get_parallel_numthreads();
-    magma_int_t mklth   = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads(1);
+    // one core per thread, each with single-threaded BLAS
+    magma_thread_budget budget( 0 );
+    magma_int_t threads = budget.workers();
 
     real_Double_t timeaplQ2=0.0;
     double f= 1.;
@@ -170,36 +170,25 @@ magma_zbulge_back_m(
         magma_zapplyQ_m_id_data* arg;
         magma_malloc_cpu((void**) &arg, threads*sizeof(magma_zapplyQ_m_id_data));
 
-        pthread_t* thread_id;
-        magma_malloc_cpu((void**) &thread_id, threads*sizeof(pthread_t));
-
-        pthread_attr_t thread_attr;
-
         // ===============================
         // relaunch thread to apply Q
         // ===============================
-        // Set one thread per core
-        pthread_attr_init(&thread_attr);
-        pthread_attr_setscope(&thread_attr, PTHREAD_SCOPE_SYSTEM);
-        pthread_setconcurrency( (unsigned)threads );
-
-        // Launch threads
-        for (magma_int_t thread = 1; thread < threads; thread++) {
+        // Run parallel section on the persistent thread pool;
+        // this thread executes arg[0]
+        for (magma_int_t thread = 0; thread < threads; thread++) {
             arg[thread] = magma_zapplyQ_m_id_data(thread, &data_applyQ);
-            pthread_create(&thread_id[thread], &thread_attr, magma_zapplyQ_m_parallel_section, &arg[thread]);
         }
-        arg[0] = magma_zapplyQ_m_id_data(0, &data_applyQ);
-        magma_zapplyQ_m_parallel_section(&arg[0]);
+        magma_int_t run_info = magma_threadpool_run(
+            threads, magma_zapplyQ_m_parallel_section,
+            arg, sizeof(magma_zapplyQ_m_id_data) );
 
-        // Wait for completion
-        for (magma_int_t thread = 1; thread < threads; thread++) {
-            void *exitcodep;
-            pthread_join(thread_id[thread], &exitcodep);
-        }
-
-        magma_free_cpu(thread_id);
         magma_free_cpu(arg);
 
+        if (run_info != 0) {
+            // threads could not be created and nothing ran; apply Q on the GPUs only
+            magma_zbulge_applyQ_v2_m(ngpu, MagmaLeft, ne, n, nb, Vblksiz, Z, ldz, V, ldv, T, ldt, info);
+        }
+
         /*============================
          *  use only GPU
          *==========================*/
@@ -209,7 +198,6 @@ magma_zbulge_back_m(
 
     timeaplQ2 = magma_wtime()-timeaplQ2;
 
-    magma_set_lapack_numthreads(mklth);
     return MAGMA_SUCCESS;
 }
 
@@ -244,9 +232,7 @@ static void *magma_zapplyQ_m_parallel_section(void *arg)
 
     magma_int_t n_cpu = ne - n_gpu;
 
-    // with MKL and when using omp_set_num_threads instead of mkl_set_num_threads
-    // it need that all threads setting it to 1.
-    magma_set_lapack_numthreads(1);
+    // single-threaded BLAS, from the caller's magma_thread_budget
 
 #ifndef MAGMA_NOAFFINITY
     //#define PRINTAFFINITY
@@ -255,18 +241,20 @@ static void *magma_zapplyQ_m_parallel_section(void *arg)
     print_set.print_affinity(my_core_id, "starting affinity");
 #endif
     affinity_set original_set;
-    affinity_set new_set(my_core_id);
-    magma_int_t check  = 0;
+    affinity_set new_set;
+    magma_int_t check  = -1;
     magma_int_t check2 = 0;
-    // bind threads
-    check = original_set.get_affinity();
-    if (check == 0) {
-        check2 = new_set.set_affinity();
-        if (check2 != 0)
-            printf("Error in sched_setaffinity (single cpu)\n");
-    }
-    else {
-        printf("Error in sched_getaffinity\n");
+    // bind threads to CPUs chosen by the placement policy (see MAGMA_AFFINITY)
+    if (new_set.place_thread(my_core_id)) {
+        check = original_set.get_affinity();
+        if (check == 0) {
+            check2 = new_set.set_affinity();
+            if (check2 != 0)
+                printf("Error in sched_setaffinity (single cpu)\n");
+        }
+        else {
+            printf("Error in sched_getaffinity\n");
+        }
     }
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "set affinity");
@@ -223,8 +223,7 @@ magma_zhetrd(
     #endif
 
     #ifdef MAGMA_DISABLE_MKL_THREADING_ISSUE_BLAS1
-    magma_int_t lapack_nthread = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads(lapack_nthread > 1 ? 2 : 1);
+    magma_thread_budget budget( 1, min( magma_get_lapack_numthreads(), 2 ));
     #endif
 
     // nx <= n is required
@@ -345,8 +344,5 @@ magma_zhetrd(
 
     work[0] = magma_zmake_lwork( lwkopt );
 
-    #ifdef MAGMA_DISABLE_MKL_THREADING_ISSUE_BLAS1
-    magma_set_lapack_numthreads(lapack_nthread);
-    #endif
     return *info;
 } /* magma_zhetrd */
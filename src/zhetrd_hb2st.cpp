@@ -15,6 +15,8 @@
 #include "magma_internal.h"
 #include "magma_bulge.h"
 #include "magma_zbulge.h"
+#include "trace.h"
+#include "magma_timer.h"
 
 #ifndef MAGMA_NOAFFINITY
 #include "affinity.h"
@@ -192,16 +194,11 @@ magma_zhetrd_hb2st(
     magmaDoubleComplex *V, magma_int_t ldv, magmaDoubleComplex *TAU,
     magma_int_t wantz, magmaDoubleComplex *T, magma_int_t ldt)
 {
-    #ifdef ENABLE_TIMER
-    real_Double_t timeblg=0.0;
-    #endif
-
-    magma_int_t parallel_threads = magma_get_parallel_numthreads();
-    magma_int_t mklth   = magma_get_lapack_numthreads();
-    magma_int_t ompth   = magma_get_omp_numthreads();
+    magma_profile_scope profile( "zhetrd_hb2st" );
 
-    //magma_set_omp_numthreads(1);
-    //magma_set_lapack_numthreads(1);
+    // one core per thread, each with single-threaded BLAS and OpenMP
+    magma_thread_budget budget( 0 );
+    magma_int_t parallel_threads = budget.workers();
 
     magma_int_t blkcnt, sizTAU2, sizT2, sizV2;
     magma_zbulge_getstg2size(n, nb, wantz, 
@@ -211,7 +208,7 @@ magma_zhetrd_hb2st(
     memset(TAU, 0, sizTAU2*sizeof(magmaDoubleComplex));
     memset(V,   0, sizV2*sizeof(magmaDoubleComplex));
 
-    magma_int_t INgrsiz=1;
+    magma_int_t INgrsiz = magma_tune_get( "zhetrd_hb2st_grsiz", n, 1 );
     magma_int_t nbtiles = magma_ceildiv(n, nb);
     volatile magma_int_t* prog;
     magma_malloc_cpu((void**) &prog, (2*nbtiles+parallel_threads+10)*sizeof(magma_int_t));
@@ -220,51 +217,30 @@ magma_zhetrd_hb2st(
     magma_zbulge_id_data* arg;
     magma_malloc_cpu((void**) &arg, parallel_threads*sizeof(magma_zbulge_id_data));
 
-    pthread_t* thread_id;
-    magma_malloc_cpu((void**) &thread_id, parallel_threads*sizeof(pthread_t));
-    pthread_attr_t thread_attr;
-
     magma_zbulge_data data_bulge;
     magma_zbulge_data_init(&data_bulge, parallel_threads, n, nb, nbtiles, INgrsiz, Vblksiz, wantz,
                                  A, lda, V, ldv, TAU, T, ldt, prog);
 
-    // Set one thread per core
-    pthread_attr_init(&thread_attr);
-    pthread_attr_setscope(&thread_attr, PTHREAD_SCOPE_SYSTEM);
-    pthread_setconcurrency( (unsigned)parallel_threads );
-
-    //timing
-    #ifdef ENABLE_TIMER
-    timeblg = magma_wtime();
-    #endif
-
-    // Launch threads
-    for (magma_int_t thread = 1; thread < parallel_threads; thread++) {
+    // Run parallel section on the persistent thread pool;
+    // this thread executes arg[0]
+    for (magma_int_t thread = 0; thread < parallel_threads; thread++) {
         magma_zbulge_id_data_init(&(arg[thread]), thread, &data_bulge);
-        pthread_create(&thread_id[thread], &thread_attr, magma_zhetrd_hb2st_parallel_section, &arg[thread]);
     }
-    magma_zbulge_id_data_init(&(arg[0]), 0, &data_bulge);
-    magma_zhetrd_hb2st_parallel_section(&arg[0]);
-
-    // Wait for completion
-    for (magma_int_t thread = 1; thread < parallel_threads; thread++) {
-        void *exitcodep;
-        pthread_join(thread_id[thread], &exitcodep);
+    if ( magma_threadpool_run( parallel_threads, magma_zhetrd_hb2st_parallel_section,
+                               arg, sizeof(magma_zbulge_id_data) ) != 0 ) {
+        // threads could not be created and nothing ran; run on this thread only
+        magma_zbulge_data_destroy(&data_bulge);
+        magma_zbulge_data_init(&data_bulge, 1, n, nb, nbtiles, INgrsiz, Vblksiz, wantz,
+                                     A, lda, V, ldv, TAU, T, ldt, prog);
+        magma_zbulge_id_data_init(&(arg[0]), 0, &data_bulge);
+        magma_threadpool_run( 1, magma_zhetrd_hb2st_parallel_section,
+                              arg, sizeof(magma_zbulge_id_data) );
     }
 
-    // timing
-    #ifdef ENABLE_TIMER
-    timeblg = magma_wtime()-timeblg;
-    printf("  time BULGE+T = %f\n", timeblg);
-    #endif
-
-    magma_free_cpu(thread_id);
     magma_free_cpu(arg);
     magma_free_cpu((void *) prog);
     magma_zbulge_data_destroy(&data_bulge);
 
-    magma_set_omp_numthreads(ompth);
-    magma_set_lapack_numthreads(mklth);
     /*================================================
      *  store resulting diag and lower diag d and e
      *  note that d and e are always real
@@ -342,14 +318,7 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
 
     //magma_int_t sys_corenbr    = 1;
 
-    #ifdef ENABLE_TIMER
-    real_Double_t timeB=0.0, timeT=0.0;
-    #endif
-
-    // with MKL and when using omp_set_num_threads instead of mkl_set_num_threads
-    // it need that all threads setting it to 1.
-    magma_set_omp_numthreads(1);
-    //magma_set_lapack_numthreads(1);
+    // single-threaded BLAS and OpenMP, from the caller's magma_thread_budget
 
 /*
 #ifndef MAGMA_NOAFFINITY
@@ -372,18 +341,20 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
     print_set.print_affinity(my_core_id, "starting affinity");
 #endif
     affinity_set original_set;
-    affinity_set new_set(my_core_id);
-    magma_int_t check  = 0;
+    affinity_set new_set;
+    magma_int_t check  = -1;
     magma_int_t check2 = 0;
-    // bind threads
-    check = original_set.get_affinity();
-    if (check == 0) {
-        check2 = new_set.set_affinity();
-        if (check2 != 0)
-            printf("Error in sched_setaffinity (single cpu)\n");
-    }
-    else {
-        printf("Error in sched_getaffinity\n");
+    // bind threads to CPUs chosen by the placement policy (see MAGMA_AFFINITY)
+    if (new_set.place_thread(my_core_id)) {
+        check = original_set.get_affinity();
+        if (check == 0) {
+            check2 = new_set.set_affinity();
+            if (check2 != 0)
+                printf("Error in sched_setaffinity (single cpu)\n");
+        }
+        else {
+            printf("Error in sched_getaffinity\n");
+        }
     }
 #ifdef PRINTAFFINITY
     print_set.print_affinity(my_core_id, "set affinity");
@@ -398,39 +369,24 @@ static void *magma_zhetrd_hb2st_parallel_section(void *arg)
     //=========================
     //    bulge chasing
     //=========================
-    #ifdef ENABLE_TIMER
-    if (my_core_id == 0)
-        timeB = magma_wtime();
-    #endif
-
+    // profiled per thread, including the barrier, to show load imbalance
+    magma_profile_begin( "zhetrd_hb2st bulge" );
+    magma_trace_begin( "hb2st", "bulge chasing" );
     magma_ztile_bulge_parallel(my_core_id, allcores_num, A, lda, V, ldv, TAU, n, nb, nbtiles, grsiz, Vblksiz, wantz, prog, myptbarrier);
+    magma_trace_end();
     if (allcores_num > 1) pthread_barrier_wait(myptbarrier);
-
-    #ifdef ENABLE_TIMER
-    if (my_core_id == 0) {
-        timeB = magma_wtime()-timeB;
-        printf("  Finish BULGE   timing= %f\n", timeB);
-    }
-    #endif
+    magma_profile_end();
 
     //=========================
     // compute the T's to be used when applying Q2
     //=========================
     if ( wantz > 0 ) {
-        #ifdef ENABLE_TIMER
-        if (my_core_id == 0)
-            timeT = magma_wtime();
-        #endif
-       
+        magma_profile_begin( "zhetrd_hb2st computeT" );
+        magma_trace_begin( "hb2st", "compute T" );
         magma_ztile_bulge_computeT_parallel(my_core_id, allcores_num, V, ldv, TAU, T, ldt, n, nb, Vblksiz);
+        magma_trace_end();
         if (allcores_num > 1) pthread_barrier_wait(myptbarrier);
-       
-        #ifdef ENABLE_TIMER
-        if (my_core_id == 0) {
-            timeT = magma_wtime()-timeT;
-            printf("  Finish T's     timing= %f\n", timeT);
-        }
-        #endif
+        magma_profile_end();
     }
 
 #ifndef MAGMA_NOAFFINITY
@@ -630,7 +586,10 @@ static void magma_ztile_bulge_parallel(
                         if (my_core_id == coreid) {
                             if (myid == 1) {
                                 myss_cond_wait(myid+shift-1, 0, sweepid-1);
-                                magma_zhbtype1cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
+                                {
+                                    magma_trace_scope trace( "hb2st", "zhbtype1cb", sweepid-1 );
+                                    magma_zhbtype1cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
+                                }
                                 myss_cond_set(myid, 0, sweepid);
 
                                 if (blklastind >= (n-1)) {
@@ -641,8 +600,10 @@ static void magma_ztile_bulge_parallel(
                                 myss_cond_wait(myid-1,       0, sweepid);
                                 myss_cond_wait(myid+shift-1, 0, sweepid-1);
                                 if (myid%2 == 0) {
+                                    magma_trace_scope trace( "hb2st", "zhbtype2cb", sweepid-1 );
                                     magma_zhbtype2cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
                                 } else {
+                                    magma_trace_scope trace( "hb2st", "zhbtype3cb", sweepid-1 );
                                     magma_zhbtype3cb(n, nb, A, lda, V, ldv, TAU, stind-1, edind-1, sweepid-1, Vblksiz, wantz, work);
                                 }
                                 myss_cond_set(myid, 0, sweepid);
@@ -212,9 +212,8 @@ magma_zhetrd_he2hb(
         return *info;
     }
 
-    // limit to 16 threads
-    magma_int_t orig_threads = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads( min(orig_threads,16) );
+    // limit BLAS to 16 threads
+    magma_thread_budget budget( 1, min( magma_get_lapack_numthreads(), 16 ));
 
     /* Use the first panel of dA as work space */
     magmaDoubleComplex *dwork = dA + n*ldda;
@@ -436,7 +435,5 @@ magma_zhetrd_he2hb(
     magma_queue_destroy( queues[1] );
     magma_free( dA );
 
-    magma_set_lapack_numthreads( orig_threads );
-
     return *info;
 } /* magma_zhetrd_he2hb */
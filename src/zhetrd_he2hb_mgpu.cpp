@@ -245,9 +245,8 @@ magma_zhetrd_he2hb_mgpu(
     magma_device_t orig_dev;
     magma_getdevice( &orig_dev );
 
-    // limit to 16 threads
-    magma_int_t orig_threads = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads( min(orig_threads,16) );
+    // limit BLAS to 16 threads
+    magma_thread_budget budget( 1, min( magma_get_lapack_numthreads(), 16 ));
 
     magma_int_t gnode[MagmaMaxGPUs][MagmaMaxGPUs+2];
     magma_int_t ncmplx=0;
@@ -530,7 +529,6 @@ magma_zhetrd_he2hb_mgpu(
     }
 
     magma_setdevice( orig_dev );
-    magma_set_lapack_numthreads( orig_threads );
 
     work[0] = magma_zmake_lwork( lwkopt );
     return *info;
@@ -222,8 +222,7 @@ magma_zhetrd_mgpu(
     }
 
     #ifdef MAGMA_DISABLE_MKL_THREADING_ISSUE_BLAS1
-    magma_int_t lapack_nthread = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads(lapack_nthread > 1 ? 2 : 1);
+    magma_thread_budget budget( 1, min( magma_get_lapack_numthreads(), 2 ));
     #endif
 
     magma_device_t orig_dev;
@@ -489,10 +488,6 @@ CLEANUP:
     magma_setdevice( orig_dev );
     
     work[0] = magma_zmake_lwork( lwkopt );
-    
-    #ifdef MAGMA_DISABLE_MKL_THREADING_ISSUE_BLAS1
-    magma_set_lapack_numthreads(lapack_nthread);
-    #endif
 
     return *info;
 } /* magma_zhetrd */
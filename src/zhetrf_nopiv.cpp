@@ -110,7 +110,8 @@ magma_zhetrf_nopiv(
 
     ldda = magma_roundup( n, 32 );
     nb = magma_get_zhetrf_nopiv_nb(n);
-    ib = min(32, nb); // inner-block for diagonal factorization
+    // inner-block for diagonal factorization, magma_zhetrf_nopiv_cpu
+    ib = min( magma_tune_get( "zhetrf_nopiv_ib", nb, 32 ), nb );
 
     if ((MAGMA_SUCCESS != magma_zmalloc(&dA, n *ldda)) ||
         (MAGMA_SUCCESS != magma_zmalloc(&dW, nb*ldda))) {
@@ -107,7 +107,8 @@ magma_zhetrf_nopiv_gpu(
       return *info;
 
     nb = magma_get_zhetrf_nopiv_nb(n);
-    ib = min(32, nb); // inner-block for diagonal factorization
+    // inner-block for diagonal factorization, magma_zhetrf_nopiv_cpu
+    ib = min( magma_tune_get( "zhetrf_nopiv_ib", nb, 32 ), nb );
 
     magma_device_t cdev;
     magma_getdevice( &cdev );
@@ -107,7 +107,8 @@ magma_zsytrf_nopiv_gpu(
         return *info;
 
     nb = magma_get_zhetrf_nopiv_nb(n);
-    ib = min(32, nb); // inner-block for diagonal factorization
+    // inner-block for diagonal factorization, magma_zsytrf_nopiv_cpu
+    ib = min( magma_tune_get( "zsytrf_nopiv_ib", nb, 32 ), nb );
 
     magma_queue_t queues[2];
     magma_event_t event;
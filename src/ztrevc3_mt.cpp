@@ -12,6 +12,7 @@
 */
 #include "thread_queue.hpp"
 #include "magma_timer.h"
+#include "trace.h"
 
 #include "magma_internal.h"  // after thread.hpp, so max, min are defined
 
@@ -47,6 +48,7 @@ public:
     
     virtual void run()
     {
+        magma_trace_scope trace( "trevc3", "zlatrsd" );
         // zlatrs takes scale as double, but in ztrevc it eventually gets
         // stored in a complex; it's easiest to do that conversion here,
         // rather than storing a vector double scales[ nbmax+1 ] in ztrevc.
@@ -109,6 +111,7 @@ public:
     
     virtual void run()
     {
+        magma_trace_scope trace( "trevc3", "zgemm" );
         blasf77_zgemm( lapack_trans_const(transA), lapack_trans_const(transB),
                        &m, &n, &k, &alpha, A, &lda, B, &ldb, &beta, C, &ldc );
     }
@@ -130,6 +133,106 @@ private:
 };
 
 
+// ---------------------------------------------
+// forms right-hand side x for eigenvector ki (on CPU):
+// for right eigenvectors (trans = NoTrans), x(0:ki-1) = -T(0:ki-1,ki), x(ki) = 1;
+// for left  eigenvectors (trans = ConjTrans), x(ki) = 1, x(ki+1:n-1) = -T(ki,ki+1:n-1)**H.
+// If zero, sets rest of x to zero, as needed for blocked back-transform.
+class zrhs_task: public magma_task
+{
+public:
+    zrhs_task(
+        magma_trans_t in_trans, magma_int_t in_n, magma_int_t in_ki,
+        const magmaDoubleComplex *in_T, magma_int_t in_ldt,
+        magmaDoubleComplex *in_x, bool in_zero
+    ):
+        trans( in_trans ),
+        n    ( in_n     ),
+        ki   ( in_ki    ),
+        T    ( in_T     ),
+        ldt  ( in_ldt   ),
+        x    ( in_x     ),
+        zero ( in_zero  )
+    {}
+    
+    virtual void run()
+    {
+        magma_trace_scope trace( "trevc3", "zrhs" );
+        #define T(i,j)  ( T + (i) + (j)*ldt )
+        magma_int_t k;
+        x[ki] = MAGMA_Z_ONE;
+        if ( trans == MagmaNoTrans ) {
+            for( k=0; k < ki; ++k ) {
+                x[k] = -(*T(k,ki));
+            }
+            for( k=ki+1; zero && k < n; ++k ) {
+                x[k] = MAGMA_Z_ZERO;
+            }
+        }
+        else {
+            for( k=ki+1; k < n; ++k ) {
+                x[k] = -MAGMA_Z_CONJ( *T(ki,k) );
+            }
+            for( k=0; zero && k < ki; ++k ) {
+                x[k] = MAGMA_Z_ZERO;
+            }
+        }
+        #undef T
+    }
+    
+private:
+    magma_trans_t trans;
+    magma_int_t   n;
+    magma_int_t   ki;
+    const magmaDoubleComplex *T;
+    magma_int_t   ldt;
+    magmaDoubleComplex *x;
+    bool          zero;
+};
+
+
+// ---------------------------------------------
+// normalizes back-transformed eigenvectors in columns 0:nvec-1 of W
+// and copies them to V (on CPU).
+class znormalize_task: public magma_task
+{
+public:
+    znormalize_task(
+        magma_int_t in_n, magma_int_t in_nvec,
+        magmaDoubleComplex *in_W, magma_int_t in_ldw,
+        magmaDoubleComplex *in_V, magma_int_t in_ldv
+    ):
+        n    ( in_n    ),
+        nvec ( in_nvec ),
+        W    ( in_W    ),
+        ldw  ( in_ldw  ),
+        V    ( in_V    ),
+        ldv  ( in_ldv  )
+    {}
+    
+    virtual void run()
+    {
+        magma_trace_scope trace( "trevc3", "znormalize" );
+        const magma_int_t ione = 1;
+        for( magma_int_t k=0; k < nvec; ++k ) {
+            magmaDoubleComplex *Wk = W + k*ldw;
+            magma_int_t ii = blasf77_izamax( &n, Wk, &ione ) - 1;
+            double remax = 1. / MAGMA_Z_ABS1( Wk[ii] );
+            blasf77_zdscal( &n, &remax, Wk, &ione );
+        }
+        lapackf77_zlacpy( "F", &n, &nvec, W, &ldw, V, &ldv );
+    }
+    
+private:
+    magma_int_t n;
+    magma_int_t nvec;
+    magmaDoubleComplex *W;
+    magma_int_t ldw;
+    magmaDoubleComplex *V;
+    magma_int_t ldv;
+};
+
+
 /***************************************************************************//**
     Purpose
     -------
@@ -246,8 +349,11 @@ private:
     @param[in]
     lwork    INTEGER
              The dimension of array work. lwork >= max(1,2*n).
-             For optimum performance, lwork >= (1 + 2*nb)*n, where nb is
-             the optimal blocksize.
+             For optimum performance, lwork >= 2*(1 + 2*nb)*n, where nb is
+             the optimal blocksize. This holds two sets of x and Q*x
+             vectors, so solves for the next block overlap the
+             back-transform of the current block; with lwork >= (1 + 2*nb)*n,
+             one set is used.
 
     @param[out]
     rwork    double array, dimension (n)
@@ -288,6 +394,7 @@ magma_int_t magma_ztrevc3_mt(
     #define VL(i,j)  (VL + (i) + (j)*ldvl)
     #define VR(i,j)  (VR + (i) + (j)*ldvr)
     #define work(i,j) (work + (i) + (j)*n)
+    #define xwork(i,j) (xwork + (i) + (j)*n)
 
     // .. Parameters ..
     const magmaDoubleComplex c_zero = MAGMA_Z_ZERO;
@@ -297,8 +404,14 @@ magma_int_t magma_ztrevc3_mt(
     
     // .. Local Scalars ..
     magma_int_t            allv, bothv, leftv, over, rightv, somev;
-    magma_int_t            i, ii, is, j, k, ki, iv, n2, nb, nb2, version;
+    magma_int_t            i, ii, is, j, k, ki, iv, n2, nb, nb2, nsets, version;
     double                 ovfl, remax, unfl;  //smlnum, smin, ulp
+    magma_task            *task;
+    
+    // xwork points to current set of x and Q*x vectors, either work or work2.
+    // Column 0 of work holds diagonal of T; column 0 of work2 is unused.
+    magmaDoubleComplex *work2 = NULL;
+    magmaDoubleComplex *xwork = work;
     
     // Decode and test the input parameters
     bothv  = (side == MagmaBothSides);
@@ -358,10 +471,20 @@ magma_int_t magma_ztrevc3_mt(
     nb = 2;
     if ( lwork >= n + 2*n*nbmin ) {
         version = 2;
-        nb = (lwork - n) / (2*n);
+        // Use two sets of x and Q*x vectors if both fit with nb >= nbmin,
+        // so solves for the next block can proceed while GEMMs for the
+        // current block are in flight. With one set, all blocks use it,
+        // which is still correct, as tasks' reads and writes tags order them.
+        nsets = (lwork >= 2*(n + 2*n*nbmin) ? 2 : 1);
+        nb = (lwork/nsets - n) / (2*n);
         nb = min( nb, nbmax );
+        nb = min( nb, max( nbmin, magma_tune_get( "ztrevc3_mt_nb", n, nbmax )));
         nb2 = 1 + 2*nb;
         lapackf77_zlaset( "F", &n, &nb2, &c_zero, &c_zero, work, &n );
+        if ( nsets == 2 ) {
+            work2 = work + n*nb2;
+            lapackf77_zlaset( "F", &n, &nb2, &c_zero, &c_zero, work2, &n );
+        }
     }
     else {
         version = 1;
@@ -387,12 +510,11 @@ magma_int_t magma_ztrevc3_mt(
     }
 
     // launch threads -- each single-threaded MKL
-    magma_int_t nthread = magma_get_parallel_numthreads();
-    magma_int_t lapack_nthread = magma_get_lapack_numthreads();
-    magma_set_lapack_numthreads( 1 );
+    magma_thread_budget budget( 0 );
+    magma_int_t nthread = budget.workers();
     magma_thread_queue queue;
-    queue.launch( nthread );
-    //printf( "nthread %lld, %lld\n", (long long) nthread, (long long) lapack_nthread );
+    queue.launch( nthread, MagmaThreadWorkStealing );
+    //printf( "nthread %lld, blas %lld\n", (long long) nthread, (long long) budget.blas() );
     
     // gemm_nb = N/thread, rounded up to multiple of 16,
     // but avoid multiples of page size, e.g., 512*8 bytes = 4096.
@@ -401,7 +523,8 @@ magma_int_t magma_ztrevc3_mt(
         gemm_nb += 32;
     }
     
-    magma_timer_t time_total=0, time_trsv=0, time_gemm=0, time_gemv=0, time_trsv_sum=0, time_gemm_sum=0, time_gemv_sum=0;
+    // with version 2, gemms overlap solves, so time_trsv includes both
+    magma_timer_t time_total=0, time_trsv=0, time_gemv=0, time_trsv_sum=0, time_gemv_sum=0;
     timer_start( time_total );
 
     if ( rightv ) {
@@ -428,20 +551,21 @@ magma_int_t magma_ztrevc3_mt(
 
             // --------------------------------------------------------
             // Complex right eigenvector
-            *work(ki,iv) = c_one;
-
-            // Form right-hand side.
-            for( k=0; k < ki; ++k ) {
-                *work(k,iv) = -(*T(k,ki));
-            }
+            // Form right-hand side; for version 2, zero out below vector.
+            task = new zrhs_task( MagmaNoTrans, n, ki, T, ldt, xwork(0,iv),
+                                  version == 2 && over );
+            task->writes( xwork(0,iv) );
+            queue.push_task( task );
 
             // Solve upper triangular system:
             // [ T(1:ki-1,1:ki-1) - T(ki,ki) ]*X = scale*work.
             if ( ki > 0 ) {
-                queue.push_task( new magma_zlatrsd_task(
+                task = new magma_zlatrsd_task(
                     MagmaUpper, MagmaNoTrans, MagmaNonUnit, MagmaTrue,
                     ki, T, ldt, *T(ki,ki),
-                    work(0,iv), work(ki,iv), rwork ));
+                    xwork(0,iv), xwork(ki,iv), rwork );
+                task->writes( xwork(0,iv) );
+                queue.push_task( task );
             }
 
             // Copy the vector x or Q*x to VR and normalize.
@@ -450,7 +574,7 @@ magma_int_t magma_ztrevc3_mt(
                 // no back-transform: copy x to VR and normalize
                 queue.sync();
                 n2 = ki+1;
-                blasf77_zcopy( &n2, work(0,iv), &ione, VR(0,is), &ione );
+                blasf77_zcopy( &n2, xwork(0,iv), &ione, VR(0,is), &ione );
 
                 ii = blasf77_izamax( &n2, VR(0,is), &ione ) - 1;
                 remax = 1. / MAGMA_Z_ABS1( *VR(ii,is) );
@@ -469,8 +593,8 @@ magma_int_t magma_ztrevc3_mt(
                 if ( ki > 0 ) {
                     blasf77_zgemv( "n", &n, &ki, &c_one,
                                    VR, &ldvr,
-                                   work(0, iv), &ione,
-                                   work(ki,iv), VR(0,ki), &ione );
+                                   xwork(0, iv), &ione,
+                                   xwork(ki,iv), VR(0,ki), &ione );
                 }
                 time_gemv_sum += timer_stop( time_gemv );
                 ii = blasf77_izamax( &n, VR(0,ki), &ione ) - 1;
@@ -481,43 +605,48 @@ magma_int_t magma_ztrevc3_mt(
             else if ( version == 2 ) {
                 // ------------------------------
                 // version 2: back-transform block of vectors with GEMM
-                // zero out below vector
-                for( k=ki+1; k < n; ++k ) {
-                    *work(k,iv) = c_zero;
-                }
+                // (below vector was zeroed out by zrhs_task)
 
                 // Columns iv:nb of work are valid vectors.
                 // When the number of vectors stored reaches nb,
                 // or if this was last vector, do the GEMM
                 if ( (iv == 1) || (ki == 0) ) {
-                    queue.sync();
-                    time_trsv_sum += timer_stop( time_trsv );
-                    timer_start( time_gemm );
                     nb2 = nb-iv+1;
                     n2  = ki+nb-iv+1;
                     
-                    // split gemm into multiple tasks, each doing one block row
+                    // split gemm into multiple tasks, each doing one block row.
+                    // Rather than syncing, tags order gemms after this block's
+                    // solves, and normalization after the gemms, so solves for
+                    // the next block (in the other set of vectors) overlap them.
                     for( i=0; i < n; i += gemm_nb ) {
                         magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new zgemm_task(
+                        task = new zgemm_task(
                             MagmaNoTrans, MagmaNoTrans, ib, nb2, n2, c_one,
                             VR(i,0), ldvr,
-                            work(0,iv   ), n, c_zero,
-                            work(i,nb+iv), n ));
+                            xwork(0,iv   ), n, c_zero,
+                            xwork(i,nb+iv), n );
+                        for( k=iv; k <= nb; ++k ) {
+                            task->reads( xwork(0,k) );
+                        }
+                        task->reads( VR );
+                        task->writes( xwork(i,2*nb) );  // tag for block row i of Q*x
+                        queue.push_task( task );
                     }
-                    queue.sync();
-                    time_gemm_sum += timer_stop( time_gemm );
                     
-                    // normalize vectors
+                    // normalize vectors and copy to VR
                     // TODO if somev, should copy vectors individually to correct location.
-                    for( k = iv; k <= nb; ++k ) {
-                        ii = blasf77_izamax( &n, work(0,nb+k), &ione ) - 1;
-                        remax = 1. / MAGMA_Z_ABS1( *work(ii,nb+k) );
-                        blasf77_zdscal( &n, &remax, work(0,nb+k), &ione );
+                    task = new znormalize_task( n, nb2, xwork(0,nb+iv), n, VR(0,ki), ldvr );
+                    for( i=0; i < n; i += gemm_nb ) {
+                        task->reads( xwork(i,2*nb) );
+                    }
+                    task->writes( VR );
+                    queue.push_task( task );
+                    
+                    // switch to other set of vectors for next block
+                    if ( work2 != NULL ) {
+                        xwork = (xwork == work ? work2 : work);
                     }
-                    lapackf77_zlacpy( "F", &n, &nb2, work(0,nb+iv), &n, VR(0,ki), &ldvr );
                     iv = nb;
-                    timer_start( time_trsv );
                 }
                 else {
                     iv -= 1;
@@ -526,12 +655,16 @@ magma_int_t magma_ztrevc3_mt(
 
             is -= 1;
         }
+        queue.sync();
     }
-    timer_stop( time_trsv );
+    time_trsv_sum += timer_stop( time_trsv );
     
     timer_stop( time_total );
-    timer_printf( "trevc trsv %.4f, gemm %.4f, gemv %.4f, total %.4f\n",
-                  time_trsv_sum, time_gemm_sum, time_gemv_sum, time_total );
+    timer_printf( "trevc trsv+gemm %.4f, gemv %.4f, total %.4f\n",
+                  time_trsv_sum, time_gemv_sum, time_total );
+    
+    // left eigenvectors start with first set of vectors
+    xwork = work;
 
     if ( leftv ) {
         // ============================================================
@@ -552,22 +685,23 @@ magma_int_t magma_ztrevc3_mt(
         
             // --------------------------------------------------------
             // Complex left eigenvector
-            *work(ki,iv) = c_one;
-        
-            // Form right-hand side.
-            for( k = ki + 1; k < n; ++k ) {
-                *work(k,iv) = -MAGMA_Z_CONJ( *T(ki,k) );
-            }
+            // Form right-hand side; for version 2, zero out above vector.
+            task = new zrhs_task( MagmaConjTrans, n, ki, T, ldt, xwork(0,iv),
+                                  version == 2 && over );
+            task->writes( xwork(0,iv) );
+            queue.push_task( task );
             
             // Solve conjugate-transposed triangular system:
             // [ T(ki+1:n,ki+1:n) - T(ki,ki) ]**H * X = scale*work.
             // TODO what happens with T(k,k) - lambda is small? Used to have < smin test.
             if ( ki < n-1 ) {
                 n2 = n-ki-1;
-                queue.push_task( new magma_zlatrsd_task(
+                task = new magma_zlatrsd_task(
                     MagmaUpper, MagmaConjTrans, MagmaNonUnit, MagmaTrue,
                     n2, T(ki+1,ki+1), ldt, *T(ki,ki),
-                    work(ki+1,iv), work(ki,iv), rwork ));
+                    xwork(ki+1,iv), xwork(ki,iv), rwork );
+                task->writes( xwork(0,iv) );
+                queue.push_task( task );
             }
             
             // Copy the vector x or Q*x to VL and normalize.
@@ -576,7 +710,7 @@ magma_int_t magma_ztrevc3_mt(
                 // no back-transform: copy x to VL and normalize
                 queue.sync();
                 n2 = n-ki;
-                blasf77_zcopy( &n2, work(ki,iv), &ione, VL(ki,is), &ione );
+                blasf77_zcopy( &n2, xwork(ki,iv), &ione, VL(ki,is), &ione );
         
                 ii = blasf77_izamax( &n2, VL(ki,is), &ione ) + ki - 1;
                 remax = 1. / MAGMA_Z_ABS1( *VL(ii,is) );
@@ -594,8 +728,8 @@ magma_int_t magma_ztrevc3_mt(
                     n2 = n-ki-1;
                     blasf77_zgemv( "n", &n, &n2, &c_one,
                                    VL(0,ki+1), &ldvl,
-                                   work(ki+1,iv), &ione,
-                                   work(ki,  iv), VL(0,ki), &ione );
+                                   xwork(ki+1,iv), &ione,
+                                   xwork(ki,  iv), VL(0,ki), &ione );
                 }
                 ii = blasf77_izamax( &n, VL(0,ki), &ione ) - 1;
                 remax = 1. / MAGMA_Z_ABS1( *VL(ii,ki) );
@@ -604,36 +738,43 @@ magma_int_t magma_ztrevc3_mt(
             else if ( version == 2 ) {
                 // ------------------------------
                 // version 2: back-transform block of vectors with GEMM
-                // zero out above vector
-                // could go from (ki+1)-NV+1 to ki
-                for( k=0; k < ki; ++k ) {
-                    *work(k,iv) = c_zero;
-                }
+                // (above vector was zeroed out by zrhs_task)
         
                 // Columns 1:iv of work are valid vectors.
                 // When the number of vectors stored reaches nb,
                 // or if this was last vector, do the GEMM
                 if ( (iv == nb) || (ki == n-1) ) {
-                    queue.sync();
                     n2 = n-(ki+1)+iv;
                     
-                    // split gemm into multiple tasks, each doing one block row
+                    // split gemm into multiple tasks, each doing one block row.
+                    // As for right eigenvectors, tags replace syncs.
                     for( i=0; i < n; i += gemm_nb ) {
                         magma_int_t ib = min( gemm_nb, n-i );
-                        queue.push_task( new zgemm_task(
+                        task = new zgemm_task(
                             MagmaNoTrans, MagmaNoTrans, ib, iv, n2, c_one,
                             VL(i,ki-iv+1), ldvl,
-                            work(ki-iv+1,1), n, c_zero,
-                            work(i,nb+1), n ));
+                            xwork(ki-iv+1,1), n, c_zero,
+                            xwork(i,nb+1), n );
+                        for( k=1; k <= iv; ++k ) {
+                            task->reads( xwork(0,k) );
+                        }
+                        task->reads( VL );
+                        task->writes( xwork(i,2*nb) );  // tag for block row i of Q*x
+                        queue.push_task( task );
                     }
-                    queue.sync();
-                    // normalize vectors
-                    for( k=1; k <= iv; ++k ) {
-                        ii = blasf77_izamax( &n, work(0,nb+k), &ione ) - 1;
-                        remax = 1. / MAGMA_Z_ABS1( *work(ii,nb+k) );
-                        blasf77_zdscal( &n, &remax, work(0,nb+k), &ione );
+                    
+                    // normalize vectors and copy to VL
+                    task = new znormalize_task( n, iv, xwork(0,nb+1), n, VL(0,ki-iv+1), ldvl );
+                    for( i=0; i < n; i += gemm_nb ) {
+                        task->reads( xwork(i,2*nb) );
+                    }
+                    task->writes( VL );
+                    queue.push_task( task );
+                    
+                    // switch to other set of vectors for next block
+                    if ( work2 != NULL ) {
+                        xwork = (xwork == work ? work2 : work);
                     }
-                    lapackf77_zlacpy( "F", &n, &iv, work(0,nb+1), &n, VL(0,ki-iv+1), &ldvl );
                     iv = 1;
                 }
                 else {
@@ -643,11 +784,11 @@ magma_int_t magma_ztrevc3_mt(
         
             is += 1;
         }
+        queue.sync();
     }
     
     // close down threads
     queue.quit();
-    magma_set_lapack_numthreads( lapack_nthread );
     
     return *info;
 }  // End of ZTREVC
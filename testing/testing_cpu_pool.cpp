@@ -0,0 +1,270 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// includes, project
+#include "magma_v2.h"
+
+
+/******************************************************************************/
+// Prints result of one check; returns 1 if it failed, else 0.
+static magma_int_t check( const char* what, bool okay )
+{
+    printf( "%-60s %s\n", what, (okay ? "ok" : "failed"));
+    return ! okay;
+}
+
+static void print_stats( const char* label )
+{
+    magma_cpu_pool_stats_t stats;
+    magma_cpu_pool_get_stats( &stats );
+    printf( "%% %-12s in use %10llu, peak %10llu, reserved %10llu, peak %10llu,"
+            " nalloc %6lld, nhit %6lld\n", label,
+            (unsigned long long) stats.bytes_in_use,
+            (unsigned long long) stats.peak_bytes_in_use,
+            (unsigned long long) stats.bytes_reserved,
+            (unsigned long long) stats.peak_bytes_reserved,
+            stats.nalloc, stats.nhit );
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing the caching allocator behind magma_malloc_cpu
+      (magma_cpu_pool_config): alignment, reuse of freed blocks,
+      freeing on another thread, caching and trimming large spans,
+      statistics, freeing pool blocks after the pool is disabled,
+      and rejecting pointers inside a block. Host only; no GPU needed.
+      Usage: testing_cpu_pool
+*/
+int main( int argc, char** argv)
+{
+    magma_init();
+
+    const size_t align = 256;
+    const size_t small = 1000;             // small size class
+    const size_t large = size_t(6) << 20;  // large span
+    const int nblock = 200;
+    magma_int_t failures = 0;
+    magma_int_t info;
+    magma_cpu_pool_stats_t s0, s1;
+    std::vector< char* > ptrs( nblock );
+
+    // ----- configuration
+    info = magma_cpu_pool_config( 1, 100, 0 );
+    failures += check( "config rejects alignment not a power of 2",
+                       info == MAGMA_ERR_ILLEGAL_VALUE );
+    info = magma_cpu_pool_config( 1, 8192, 0 );
+    failures += check( "config rejects alignment > 4096",
+                       info == MAGMA_ERR_ILLEGAL_VALUE );
+    info = magma_cpu_pool_config( 1, align, 0 );
+    failures += check( "config enables pool", info == MAGMA_SUCCESS );
+
+    // ----- alignment; blocks are writable and distinct
+    size_t sizes[] = { 0, 1, 7, 16, 100, small, 4096, 65536, 200000,
+                       300000, large, 3*large };
+    const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    char* p[ nsizes ];
+    bool aligned = true;
+    for( int i=0; i < nsizes; ++i ) {
+        info = magma_malloc_cpu( (void**) &p[i], sizes[i] );
+        aligned = aligned && info == 0 && (uintptr_t( p[i] ) % align) == 0;
+        if ( info == 0 )
+            memset( p[i], i+1, sizes[i] );
+    }
+    bool intact = true;
+    for( int i=0; i < nsizes; ++i ) {
+        for( size_t j=0; j < sizes[i]; j += 511 ) {
+            intact = intact && p[i][j] == char(i+1);
+        }
+        if ( sizes[i] > 0 )
+            intact = intact && p[i][ sizes[i]-1 ] == char(i+1);
+    }
+    failures += check( "blocks aligned to 256 bytes", aligned );
+    failures += check( "blocks writable and not overlapping", intact );
+    for( int i=0; i < nsizes; ++i ) {
+        magma_free_cpu( p[i] );
+    }
+
+    // ----- statistics count whole blocks, and return to baseline on free
+    magma_cpu_pool_reset_stats();
+    magma_cpu_pool_get_stats( &s0 );
+    print_stats( "before" );
+    for( int i=0; i < nblock; ++i ) {
+        magma_malloc_cpu( (void**) &ptrs[i], small );
+    }
+    magma_cpu_pool_get_stats( &s1 );
+    print_stats( "allocated" );
+    failures += check( "stats nalloc counts allocations",
+                       s1.nalloc - s0.nalloc == nblock );
+    failures += check( "stats bytes_in_use >= bytes requested",
+                       s1.bytes_in_use - s0.bytes_in_use >= nblock*small );
+    failures += check( "stats bytes_in_use <= bytes requested rounded up",
+                       s1.bytes_in_use - s0.bytes_in_use <= nblock*2*(small + align) );
+    failures += check( "stats peak_bytes_in_use >= bytes_in_use",
+                       s1.peak_bytes_in_use >= s1.bytes_in_use );
+    failures += check( "stats bytes_reserved >= bytes_in_use",
+                       s1.bytes_reserved >= s1.bytes_in_use );
+    for( int i=0; i < nblock; ++i ) {
+        magma_free_cpu( ptrs[i] );
+    }
+    magma_cpu_pool_get_stats( &s1 );
+    print_stats( "freed" );
+    failures += check( "stats bytes_in_use returns to baseline after free",
+                       s1.bytes_in_use == s0.bytes_in_use );
+    failures += check( "stats peak_bytes_in_use keeps peak",
+                       s1.peak_bytes_in_use >= s0.bytes_in_use + nblock*small );
+
+    // ----- reuse of freed small blocks, from this thread's cache
+    magma_cpu_pool_reset_stats();
+    for( int i=0; i < nblock; ++i ) {
+        magma_malloc_cpu( (void**) &ptrs[i], small );
+    }
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "freed small blocks are reused (nhit)",
+                       s1.nalloc == nblock && s1.nhit == nblock );
+    for( int i=0; i < nblock; ++i ) {
+        magma_free_cpu( ptrs[i] );
+    }
+
+    // ----- free on a different thread than the one that allocated;
+    // blocks return to the global lists when that thread exits,
+    // then are reused here. Use a size class not used above.
+    const size_t small2 = 3000;
+    for( int i=0; i < nblock; ++i ) {
+        magma_malloc_cpu( (void**) &ptrs[i], small2 );
+        memset( ptrs[i], 0xab, small2 );
+    }
+    magma_cpu_pool_get_stats( &s0 );
+    std::vector< magma_int_t > thread_info( nblock, -1 );
+    std::thread freer( [&] {
+        for( int i=0; i < nblock; ++i ) {
+            thread_info[i] = magma_free_cpu( ptrs[i] );
+        }
+    });
+    freer.join();
+    bool freed = true;
+    for( int i=0; i < nblock; ++i ) {
+        freed = freed && thread_info[i] == MAGMA_SUCCESS;
+    }
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "free on other thread succeeds", freed );
+    failures += check( "free on other thread releases bytes_in_use",
+                       s0.bytes_in_use - s1.bytes_in_use >= nblock*small2 );
+    magma_cpu_pool_reset_stats();
+    for( int i=0; i < nblock; ++i ) {
+        magma_malloc_cpu( (void**) &ptrs[i], small2 );
+    }
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "blocks freed on other thread are reused here (nhit)",
+                       s1.nhit == nblock );
+    // and the reverse: allocate on another thread, free here
+    std::vector< char* > ptrs2( nblock );
+    std::thread allocer( [&] {
+        for( int i=0; i < nblock; ++i ) {
+            magma_malloc_cpu( (void**) &ptrs2[i], small2 );
+        }
+    });
+    allocer.join();
+    freed = true;
+    for( int i=0; i < nblock; ++i ) {
+        freed = freed && magma_free_cpu( ptrs [i] ) == MAGMA_SUCCESS
+                      && magma_free_cpu( ptrs2[i] ) == MAGMA_SUCCESS;
+    }
+    failures += check( "free here of blocks from exited thread succeeds", freed );
+
+    // ----- large spans are cached on free, reused, and released by trim
+    magma_cpu_pool_trim();
+    magma_cpu_pool_reset_stats();
+    magma_cpu_pool_get_stats( &s0 );
+    char* big;
+    magma_malloc_cpu( (void**) &big, large );
+    memset( big, 1, large );
+    magma_free_cpu( big );
+    magma_cpu_pool_get_stats( &s1 );
+    print_stats( "large freed" );
+    failures += check( "freed large span stays reserved (cached)",
+                       s1.bytes_reserved >= s0.bytes_reserved + large );
+    char* big2;
+    magma_malloc_cpu( (void**) &big2, large );
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "cached large span is reused (nhit)",
+                       s1.nhit == 1 && big2 == big );
+    magma_free_cpu( big2 );
+    magma_cpu_pool_trim();
+    magma_cpu_pool_get_stats( &s1 );
+    print_stats( "trimmed" );
+    failures += check( "trim returns cached large spans to the system",
+                       s1.bytes_reserved == s0.bytes_reserved );
+    magma_cpu_pool_reset_stats();
+    magma_malloc_cpu( (void**) &big, large );
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "allocation after trim is not a hit",
+                       s1.nalloc == 1 && s1.nhit == 0 );
+    magma_free_cpu( big );
+
+    // ----- interior pointers are rejected, and the block is still usable
+    char* block;
+    magma_malloc_cpu( (void**) &block, 4*align );
+    memset( block, 0, 4*align );
+    info = magma_free_cpu( block + align );
+    failures += check( "free of aligned interior pointer: MAGMA_ERR_INVALID_PTR",
+                       info == MAGMA_ERR_INVALID_PTR );
+    info = magma_free_cpu( block + 1 );
+    failures += check( "free of unaligned interior pointer: MAGMA_ERR_INVALID_PTR",
+                       info == MAGMA_ERR_INVALID_PTR );
+    magma_malloc_cpu( (void**) &big, large );
+    memset( big, 0, large );
+    info = magma_free_cpu( big + large/2 );
+    failures += check( "free of pointer inside large span: MAGMA_ERR_INVALID_PTR",
+                       info == MAGMA_ERR_INVALID_PTR );
+    info = magma_free_cpu( block );
+    failures += check( "free of block itself still succeeds", info == MAGMA_SUCCESS );
+
+    // ----- pool blocks freed after the pool is disabled
+    for( int i=0; i < nblock; ++i ) {
+        magma_malloc_cpu( (void**) &ptrs[i], small );
+    }
+    magma_cpu_pool_reset_stats();
+    magma_cpu_pool_get_stats( &s0 );
+    info = magma_cpu_pool_config( 0, align, 0 );
+    failures += check( "config disables pool", info == MAGMA_SUCCESS );
+    char* sys;
+    info = magma_malloc_cpu( (void**) &sys, small );
+    failures += check( "disabled pool: malloc uses system, still aligned",
+                       info == 0 && (uintptr_t( sys ) % align) == 0 );
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "disabled pool: malloc not counted in nalloc",
+                       s1.nalloc == s0.nalloc );
+    freed = (magma_free_cpu( sys ) == MAGMA_SUCCESS);
+    for( int i=0; i < nblock; ++i ) {
+        freed = freed && magma_free_cpu( ptrs[i] ) == MAGMA_SUCCESS;
+    }
+    freed = freed && magma_free_cpu( big ) == MAGMA_SUCCESS;
+    magma_cpu_pool_get_stats( &s1 );
+    failures += check( "disabled pool: pool blocks freed with magma_free_cpu", freed );
+    failures += check( "disabled pool: bytes_in_use released",
+                       s0.bytes_in_use - s1.bytes_in_use >= nblock*small + large );
+    info = magma_cpu_pool_config( 1, 64, 0 );
+    failures += check( "config cannot change alignment after pool is used",
+                       info == MAGMA_ERR_ILLEGAL_VALUE );
+    print_stats( "end" );
+
+    if ( failures == 0 )
+        printf( "\nAll tests passed.\n" );
+    else
+        printf( "\n%lld tests failed.\n", (long long) failures );
+
+    magma_finalize();
+    return int(failures);
+}
@@ -0,0 +1,376 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+
+// tests internal class magma_thread_queue and magma_threadpool_run,
+// so include thread_queue.hpp (and magma_internal.h) instead of magma_v2.h
+#include "../control/thread_queue.hpp"
+
+
+/******************************************************************************/
+// Task doing a fixed amount of scalar work, then counting itself.
+// If depth > 0, it spawns two children, to exercise pushes from worker threads.
+class bench_task: public magma_task
+{
+public:
+    bench_task( magma_thread_queue* queue, std::atomic<magma_int_t>* count,
+                magma_int_t grain, magma_int_t depth ):
+        m_queue( queue ), m_count( count ), m_grain( grain ), m_depth( depth )
+    {}
+    
+    virtual void run()
+    {
+        volatile double x = 1.0;
+        for( magma_int_t i=0; i < m_grain; ++i ) {
+            x = x*0.999 + 0.001;
+        }
+        *m_count += 1;
+        if ( m_depth > 0 ) {
+            m_queue->push_task( new bench_task( m_queue, m_count, m_grain, m_depth-1 ));
+            m_queue->push_task( new bench_task( m_queue, m_count, m_grain, m_depth-1 ));
+        }
+    }
+    
+private:
+    magma_thread_queue*       m_queue;
+    std::atomic<magma_int_t>* m_count;
+    magma_int_t m_grain;
+    magma_int_t m_depth;
+};
+
+
+/******************************************************************************/
+// Runs ntask root tasks (each with 2^(depth+1) - 1 tasks in its tree)
+// on nthread threads with given mode. Returns tasks/sec; sets okay = false
+// if not all tasks ran.
+static double bench_queue(
+    magma_thread_mode_t mode, magma_int_t nthread,
+    magma_int_t ntask, magma_int_t grain, magma_int_t depth,
+    magma_int_t niter, bool& okay )
+{
+    std::atomic<magma_int_t> count( 0 );
+    magma_int_t expect = ntask * ((1 << (depth+1)) - 1);
+    
+    magma_thread_queue queue;
+    queue.launch( nthread, mode );
+    
+    double time = magma_wtime();
+    for( magma_int_t iter=0; iter < niter; ++iter ) {
+        count = 0;
+        for( magma_int_t i=0; i < ntask; ++i ) {
+            queue.push_task( new bench_task( &queue, &count, grain, depth ));
+        }
+        queue.sync();
+        okay = okay && (count == expect);
+    }
+    time = magma_wtime() - time;
+    queue.quit();
+    
+    return (expect * niter) / time;
+}
+
+
+/******************************************************************************/
+// Task that sets x[i] = x[j] + 1 after a short delay; used to check ordering.
+class chain_task: public magma_task
+{
+public:
+    chain_task( magma_int_t* x, magma_int_t i, magma_int_t j ):
+        m_x( x ), m_i( i ), m_j( j )
+    {}
+    
+    virtual void run()
+    {
+        volatile double y = 1.0;
+        for( magma_int_t k=0; k < 1000; ++k ) {
+            y = y*0.999 + 0.001;
+        }
+        m_x[ m_i ] = m_x[ m_j ] + 1;
+    }
+    
+private:
+    magma_int_t* m_x;
+    magma_int_t  m_i, m_j;
+};
+
+
+/******************************************************************************/
+// Checks reads/writes tags, depends_on, and futures on nthread threads.
+// Returns number of failures.
+static magma_int_t test_dependencies( magma_thread_mode_t mode, magma_int_t nthread )
+{
+    const magma_int_t n = 200;
+    magma_int_t x[ n+1 ], failures = 0;
+    
+    magma_thread_queue queue;
+    queue.launch( nthread, mode );
+    
+    // chain via tags: task i reads x[i-1], writes x[i], so x[i] = i.
+    // Tasks are pushed in chain order, but only the tags order them:
+    // without tags, workers run them concurrently (and LIFO when
+    // work-stealing), reading x[i-1] before it is written, so x[i] != i.
+    x[0] = 0;
+    for( magma_int_t i=1; i <= n; ++i ) {
+        x[i] = -n;
+    }
+    magma_future_t last;
+    for( magma_int_t i=1; i <= n; ++i ) {
+        magma_task* t = new chain_task( x, i, i-1 );
+        t->reads( &x[i-1] );
+        t->writes( &x[i] );
+        last = t->get_future();
+        queue.push_task( t );
+    }
+    last->wait();
+    failures += (x[n] != n);
+    queue.sync();
+    for( magma_int_t i=0; i <= n; ++i ) {
+        failures += (x[i] != i);
+    }
+    
+    // chain via depends_on
+    x[0] = 0;
+    last.reset();
+    for( magma_int_t i=1; i <= n; ++i ) {
+        magma_task* t = new chain_task( x, i, i-1 );
+        t->depends_on( last );
+        last = t->get_future();
+        queue.push_task( t );
+    }
+    queue.sync();
+    failures += ! last->is_done();
+    for( magma_int_t i=0; i <= n; ++i ) {
+        failures += (x[i] != i);
+    }
+    
+    // write-after-read: x[0] is overwritten only after all readers finish
+    x[0] = 0;
+    for( magma_int_t i=1; i <= n; ++i ) {
+        magma_task* t = new chain_task( x, i, 0 );
+        t->reads( &x[0] );
+        t->writes( &x[i] );
+        queue.push_task( t );
+    }
+    magma_task* t = new chain_task( x, 0, 0 );  // x[0] = 1
+    t->writes( &x[0] );
+    queue.push_task( t );
+    queue.sync();
+    failures += (x[0] != 1);
+    for( magma_int_t i=1; i <= n; ++i ) {
+        failures += (x[i] != 1);
+    }
+    
+    return failures;
+}
+
+
+/******************************************************************************/
+// Parallel section for magma_threadpool_run: each thread marks its slot,
+// waits at a barrier, then checks all threads marked theirs.
+struct section_data {
+    pthread_barrier_t barrier;
+    magma_int_t nthread;
+    std::atomic<magma_int_t>* marks;
+    std::atomic<magma_int_t> errors;
+};
+
+struct section_arg {
+    magma_int_t id;
+    section_data* data;
+};
+
+static void* section_func( void* arg )
+{
+    magma_int_t id     = ((section_arg*) arg)->id;
+    section_data* data = ((section_arg*) arg)->data;
+    data->marks[ id ] += 1;
+    pthread_barrier_wait( &data->barrier );
+    for( magma_int_t i=0; i < data->nthread; ++i ) {
+        if ( data->marks[ i ] != data->marks[ id ] ) {
+            data->errors += 1;
+        }
+    }
+    pthread_barrier_wait( &data->barrier );
+    return NULL;
+}
+
+
+/******************************************************************************/
+// Runs nsection parallel sections on nthread threads, using the thread pool,
+// and using pthread_create/join per section, as the bulge routines did.
+// Returns sections/sec for each; sets okay = false on error.
+static void bench_threadpool(
+    magma_int_t nthread, magma_int_t nsection,
+    double& pool, double& spawn, bool& okay )
+{
+    std::vector< std::atomic<magma_int_t> > marks( nthread );
+    std::vector< section_arg > args( nthread );
+    std::vector< pthread_t > threads( nthread );
+    section_data data;
+    data.nthread = nthread;
+    data.marks   = &marks[0];
+    data.errors  = 0;
+    pthread_barrier_init( &data.barrier, NULL, (unsigned) nthread );
+    for( magma_int_t i=0; i < nthread; ++i ) {
+        marks[i]     = 0;
+        args[i].id   = i;
+        args[i].data = &data;
+    }
+    
+    double time = magma_wtime();
+    for( magma_int_t k=0; k < nsection; ++k ) {
+        magma_threadpool_run( nthread, section_func, &args[0], sizeof(section_arg) );
+    }
+    pool = nsection / (magma_wtime() - time);
+    
+    time = magma_wtime();
+    for( magma_int_t k=0; k < nsection; ++k ) {
+        for( magma_int_t i=1; i < nthread; ++i ) {
+            pthread_create( &threads[i], NULL, section_func, &args[i] );
+        }
+        section_func( &args[0] );
+        for( magma_int_t i=1; i < nthread; ++i ) {
+            pthread_join( threads[i], NULL );
+        }
+    }
+    spawn = nsection / (magma_wtime() - time);
+    
+    pthread_barrier_destroy( &data.barrier );
+    if ( data.errors != 0 || marks[ nthread-1 ] != 2*nsection ) {
+        okay = false;
+    }
+}
+
+
+/******************************************************************************/
+// Each thread checks that it is limited to its share of the budget.
+struct budget_arg
+{
+    magma_int_t expect;
+    std::atomic<magma_int_t>* errors;
+};
+
+static void* budget_func( void* arg )
+{
+    budget_arg* barg = (budget_arg*) arg;
+    if ( magma_get_parallel_numthreads() != barg->expect ) {
+        *barg->errors += 1;
+    }
+    return NULL;
+}
+
+
+/******************************************************************************/
+// Checks magma_thread_budget divides cores among threadpool workers,
+// and magma_set_thread_budget caps the calling thread.
+// Returns number of errors.
+static magma_int_t test_budget( magma_int_t ncores )
+{
+    std::atomic<magma_int_t> errors( 0 );
+    magma_int_t nworker = max( 1, ncores / 2 );
+    {
+        magma_thread_budget budget( nworker );
+        std::vector< budget_arg > args( budget.workers() );
+        for( magma_int_t i=0; i < budget.workers(); ++i ) {
+            args[i].expect = budget.blas();
+            args[i].errors = &errors;
+        }
+        magma_threadpool_run( budget.workers(), budget_func, &args[0], sizeof(budget_arg) );
+        errors += (budget.workers() != nworker);
+        errors += (budget.workers() * budget.blas() > ncores);
+    }
+    errors += (magma_get_worker_budget() != 0);
+    
+    magma_int_t old = magma_set_thread_budget( 1 );
+    errors += (old != 0);
+    errors += (magma_get_parallel_numthreads() != 1);
+    errors += (magma_get_thread_budget() != 1);
+    magma_set_thread_budget( old );
+    errors += (magma_get_parallel_numthreads() != ncores);
+    return errors;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing magma_thread_queue: compares throughput (tasks/sec) of the
+      central queue and work-stealing modes from 1 thread up to all cores.
+      Also checks magma_threadpool_run, and compares its rate (sections/sec)
+      with creating and joining threads for each section.
+      Also checks magma_thread_budget and magma_set_thread_budget.
+      Usage: testing_thread_queue [ntask [grain [niter]]]
+      ntask is number of root tasks per iteration (each spawns 6 more),
+      grain is work per task (loop iterations).
+*/
+int main( int argc, char** argv)
+{
+    magma_init();
+    
+    magma_int_t ntask  = (argc > 1 ? atoi( argv[1] ) : 10000);
+    magma_int_t grain  = (argc > 2 ? atoi( argv[2] ) : 1000);
+    magma_int_t niter  = (argc > 3 ? atoi( argv[3] ) : 3);
+    magma_int_t depth  = 2;
+    magma_int_t ncores = magma_get_parallel_numthreads();
+    magma_int_t failures = 0;
+    
+    printf( "%% ntask %lld, grain %lld, niter %lld, depth %lld, ncores %lld\n",
+            (long long) ntask, (long long) grain, (long long) niter,
+            (long long) depth, (long long) ncores );
+    printf( "%% nthread   central (task/s)   stealing (task/s)   speedup\n" );
+    printf( "%%=========================================================\n" );
+    // 1, 2, 4, ..., ncores
+    for( magma_int_t nthread = 1; nthread <= ncores; nthread *= 2 ) {
+        bool okay = true;
+        double central  = bench_queue( MagmaThreadCentral,      nthread, ntask, grain, depth, niter, okay );
+        double stealing = bench_queue( MagmaThreadWorkStealing, nthread, ntask, grain, depth, niter, okay );
+        printf( "%8lld   %16.0f   %17.0f   %7.2f   %s\n",
+                (long long) nthread, central, stealing, stealing / central,
+                (okay ? "ok" : "failed"));
+        failures += ! okay;
+        
+        if ( nthread < ncores && nthread*2 > ncores ) {
+            nthread = ncores / 2;  // so last test is all cores
+        }
+    }
+    
+    printf( "\n%% dependencies: nthread   central   stealing\n" );
+    for( magma_int_t nthread = 1; nthread <= ncores; nthread *= 2 ) {
+        magma_int_t err1 = test_dependencies( MagmaThreadCentral,      nthread );
+        magma_int_t err2 = test_dependencies( MagmaThreadWorkStealing, nthread );
+        printf( "%24lld   %7s   %8s\n", (long long) nthread,
+                (err1 == 0 ? "ok" : "failed"), (err2 == 0 ? "ok" : "failed") );
+        failures += (err1 != 0) + (err2 != 0);
+    }
+    
+    printf( "\n%% threadpool: nthread   pool (section/s)   create/join (section/s)   speedup\n" );
+    for( magma_int_t nthread = 2; nthread <= max( 2, ncores ); nthread *= 2 ) {
+        bool okay = true;
+        double pool, spawn;
+        bench_threadpool( nthread, 1000, pool, spawn, okay );
+        printf( "%24lld   %16.0f   %23.0f   %7.2f   %s\n",
+                (long long) nthread, pool, spawn, pool / spawn,
+                (okay ? "ok" : "failed"));
+        failures += ! okay;
+    }
+    
+    magma_int_t err = test_budget( ncores );
+    printf( "\n%% thread budget: %s\n", (err == 0 ? "ok" : "failed") );
+    failures += (err != 0);
+    
+    if ( failures > 0 ) {
+        printf( "\n*** %lld tests failed.\n", (long long) failures );
+    }
+    else {
+        printf( "\nAll tests passed.\n" );
+    }
+    
+    magma_finalize();
+    return (failures > 0);
+}
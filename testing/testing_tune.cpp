@@ -0,0 +1,330 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+// includes, project
+#include "testings.h"
+
+// uses internal routine magma_get_parallel_numthreads
+#include "../control/magma_internal.h"  // internal header
+
+
+/******************************************************************************/
+// Data shared by benchmarks. Each benchmark factors or reduces a copy of the
+// same random matrix, and checks against a reference computed with the
+// default parameter, returning -1 if the result differs.
+// The matrix and reference are set up when the size n changes.
+struct tune_data {
+    magma_int_t n = 0;
+    double tol;
+    std::vector< double > A, Aref, work, ref;
+};
+
+static magma_int_t ione     = 1;
+static magma_int_t ISEED[4] = {0,0,0,1};
+
+// relative difference between x and ref, both of length len
+static double rel_diff( magma_int_t len, const double* x, const double* ref )
+{
+    double nref = 0, ndiff = 0;
+    for( magma_int_t i=0; i < len; ++i ) {
+        nref  = max( nref,  fabs( ref[i] ));
+        ndiff = max( ndiff, fabs( x[i] - ref[i] ));
+    }
+    return ndiff / max( nref, 1.0 );
+}
+
+
+/******************************************************************************/
+// dsytrf_nopiv_cpu with inner-block ib, on diagonally dominant n x n matrix.
+static void setup_sytrf( tune_data& d )
+{
+    magma_int_t n = d.n, nn = n*n;
+    d.Aref.resize( nn );
+    d.A.resize( nn );
+    lapackf77_dlarnv( &ione, ISEED, &nn, &d.Aref[0] );
+    for( magma_int_t i=0; i < n; ++i ) {
+        d.Aref[ i + i*n ] += n;
+    }
+    d.ref = d.Aref;
+    magma_int_t info;
+    magma_dsytrf_nopiv_cpu( MagmaLower, n, min( 32, n ), &d.ref[0], n, &info );
+}
+
+static double bench_sytrf( magma_int_t ib, magma_int_t n, void* arg )
+{
+    tune_data& d = *(tune_data*) arg;
+    if ( ib > n )
+        return -1;
+    if ( d.n != n ) {
+        d.n = n;
+        setup_sytrf( d );
+    }
+    d.A = d.Aref;
+    magma_int_t info;
+    double time = magma_wtime();
+    magma_dsytrf_nopiv_cpu( MagmaLower, n, ib, &d.A[0], n, &info );
+    time = magma_wtime() - time;
+    if ( info != 0 || rel_diff( n*n, &d.A[0], &d.ref[0] ) > d.tol )
+        return -1;
+    return time;
+}
+
+
+/******************************************************************************/
+// dtrevc3_mt with block size nb, set via lwork, on random upper triangular T.
+// lwork holds two sets of vectors, as dtrevc3_mt uses for optimal performance.
+static void setup_trevc( tune_data& d )
+{
+    magma_int_t n = d.n, nn = n*n;
+    d.Aref.resize( nn );
+    lapackf77_dlarnv( &ione, ISEED, &nn, &d.Aref[0] );
+    for( magma_int_t j=0; j < n; ++j ) {
+        for( magma_int_t i=j+1; i < n; ++i ) {
+            d.Aref[ i + j*n ] = 0;
+        }
+    }
+    d.A.resize( nn );
+    d.ref.resize( nn );
+    d.work.resize( n + 2*n*16 );
+    magma_int_t m, info;
+    magma_dtrevc3_mt( MagmaRight, MagmaAllVec, NULL, n,
+                      &d.Aref[0], n, NULL, 1, &d.ref[0], n, n, &m,
+                      &d.work[0], d.work.size(), &info );
+}
+
+static double bench_trevc( magma_int_t nb, magma_int_t n, void* arg )
+{
+    tune_data& d = *(tune_data*) arg;
+    if ( d.n != n ) {
+        d.n = n;
+        setup_trevc( d );
+    }
+    magma_int_t lwork = 2*(n + 2*n*nb), m, info;
+    d.work.resize( lwork );
+    double time = magma_wtime();
+    magma_dtrevc3_mt( MagmaRight, MagmaAllVec, NULL, n,
+                      &d.Aref[0], n, NULL, 1, &d.A[0], n, n, &m,
+                      &d.work[0], lwork, &info );
+    time = magma_wtime() - time;
+    if ( info != 0 || rel_diff( n*n, &d.A[0], &d.ref[0] ) > d.tol )
+        return -1;
+    return time;
+}
+
+
+/******************************************************************************/
+// dsytrd_sb2st on random symmetric band matrix with bandwidth nb, in band
+// storage, with the given Vblksiz or grsiz. Compares eigenvalues of the
+// tridiagonal, via d and |e|, to the default.
+struct sb2st_data: public tune_data {
+    magma_int_t nb, lda2, wantz;
+    std::vector< double > d, e, V, TAU, T;
+};
+
+static magma_int_t run_sb2st( sb2st_data& s, magma_int_t Vblksiz )
+{
+    magma_int_t n = s.n, nb = s.nb;
+    magma_int_t ldv = nb + Vblksiz, ldt = Vblksiz;
+    magma_int_t blkcnt, sizTAU2, sizT2, sizV2;
+    magma_dbulge_getstg2size( n, nb, s.wantz, Vblksiz, ldv, ldt,
+                              &blkcnt, &sizTAU2, &sizT2, &sizV2 );
+    s.V.resize( sizV2 );
+    s.TAU.resize( sizTAU2 );
+    s.T.resize( max( sizT2, 1 ));
+    s.A = s.Aref;
+    s.d.resize( n );
+    s.e.resize( n );
+    return magma_dsytrd_sb2st( MagmaLower, n, nb, Vblksiz, &s.A[0], s.lda2,
+                               &s.d[0], &s.e[0], &s.V[0], ldv, &s.TAU[0],
+                               s.wantz, &s.T[0], ldt );
+}
+
+static void setup_sb2st( sb2st_data& s )
+{
+    magma_int_t n = s.n;
+    s.nb = magma_get_dbulge_nb( n, magma_get_parallel_numthreads() );
+    magma_bulge_getlwstg1( n, s.nb, &s.lda2 );
+    magma_int_t len = s.lda2*n;
+    s.Aref.resize( len );
+    lapackf77_dlarnv( &ione, ISEED, &len, &s.Aref[0] );
+    // zero outside band; column j holds A(j:j+nb, j)
+    for( magma_int_t j=0; j < n; ++j ) {
+        for( magma_int_t i=0; i < s.lda2; ++i ) {
+            if ( i > s.nb || i + j >= n )
+                s.Aref[ i + j*s.lda2 ] = 0;
+        }
+    }
+    run_sb2st( s, min( 32, s.nb ));
+    s.ref = s.d;
+    s.ref.insert( s.ref.end(), s.e.begin(), s.e.end() );
+}
+
+static double bench_sb2st( magma_int_t Vblksiz, sb2st_data& s )
+{
+    double time = magma_wtime();
+    run_sb2st( s, Vblksiz );
+    time = magma_wtime() - time;
+    std::vector< double > x( s.d );
+    for( magma_int_t i=0; i < s.n; ++i ) {
+        x.push_back( s.e[i] * (s.e[i]*s.ref[ s.n+i ] < 0 ? -1 : 1) );
+    }
+    if ( rel_diff( 2*s.n, &x[0], &s.ref[0] ) > s.tol )
+        return -1;
+    return time;
+}
+
+static double bench_vblksiz( magma_int_t Vblksiz, magma_int_t n, void* arg )
+{
+    sb2st_data& s = *(sb2st_data*) arg;
+    if ( s.n != n ) {
+        s.n = n;
+        setup_sb2st( s );
+    }
+    if ( Vblksiz > s.nb )
+        return -1;
+    return bench_sb2st( Vblksiz, s );
+}
+
+static double bench_grsiz( magma_int_t grsiz, magma_int_t n, void* arg )
+{
+    sb2st_data& s = *(sb2st_data*) arg;
+    magma_tune_set( "dsytrd_sb2st_grsiz", n, n, grsiz );
+    if ( s.n != n ) {
+        s.n = n;
+        setup_sb2st( s );
+    }
+    return bench_sb2st( min( 32, s.nb ), s );
+}
+
+
+/******************************************************************************/
+// Tunes routine for all sizes, printing the winners. Returns number of failures.
+static magma_int_t tune(
+    const char* routine, magma_tune_bench_t bench, void* arg,
+    const std::vector< magma_int_t >& sizes,
+    const std::vector< magma_int_t >& candidates, magma_int_t ntrial )
+{
+    std::vector< magma_int_t > best( sizes.size() );
+    magma_int_t info = magma_tune_run( routine, sizes.size(), &sizes[0],
+                                       candidates.size(), &candidates[0],
+                                       bench, arg, ntrial, &best[0] );
+    magma_int_t failures = (info != 0);
+    for( size_t i=0; i < sizes.size(); ++i ) {
+        printf( "%-22s %6lld   %6lld   %s\n", routine, (long long) sizes[i],
+                (long long) best[i], (info == 0 && best[i] > 0 ? "ok" : "failed"));
+        failures += (best[i] <= 0);
+    }
+    return failures;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing magma_tune_run: tunes CPU-side block sizes on this host:
+      dsytrf_nopiv_cpu inner-block, dtrevc3_mt block size, and dsytrd_sb2st
+      Vblksiz and group size. Each candidate's result is checked against
+      the default parameter. Then calibrates the performance model used by
+      magma_get_xgetrf_nb (magma_perfmodel_calibrate).
+      If $MAGMA_TUNE_FILE is set, saves the results there, to be used by
+      later runs of MAGMA on this host.
+      Usage: testing_tune [ntrial [n1 n2 ...]]
+*/
+int main( int argc, char** argv)
+{
+    magma_init();
+
+    magma_int_t ntrial = (argc > 1 ? atoi( argv[1] ) : 3);
+    std::vector< magma_int_t > sizes;
+    for( int i=2; i < argc; ++i ) {
+        sizes.push_back( atoi( argv[i] ));
+    }
+    if ( sizes.empty() ) {
+        sizes.push_back( 500 );
+        sizes.push_back( 1000 );
+        sizes.push_back( 2000 );
+    }
+    magma_int_t failures = 0;
+
+    printf( "%% host: %s\n", magma_tune_host() );
+    printf( "%% ntrial %lld\n", (long long) ntrial );
+    printf( "%% routine                   n     best\n" );
+    printf( "%%=====================================\n" );
+
+    double tol = 1e3 * lapackf77_dlamch("E");
+    tune_data sytrf;
+    sytrf.tol = tol;
+    std::vector< magma_int_t > ibs = { 8, 16, 24, 32, 48, 64 };
+    failures += tune( "dsytrf_nopiv_ib", bench_sytrf, &sytrf,
+                      sizes, ibs, ntrial );
+
+    tune_data trevc;
+    trevc.tol = tol;
+    std::vector< magma_int_t > nbs = { 16, 32, 64, 128, 256 };
+    failures += tune( "dtrevc3_mt_nb", bench_trevc, &trevc,
+                      sizes, nbs, ntrial );
+
+    sb2st_data vblk;
+    vblk.tol   = tol;
+    vblk.wantz = 1;
+    std::vector< magma_int_t > vblks = { 8, 16, 24, 32, 48, 64 };
+    failures += tune( "dbulge_vblksiz", bench_vblksiz, &vblk,
+                      sizes, vblks, ntrial );
+
+    sb2st_data grsiz;
+    grsiz.tol   = tol;
+    grsiz.wantz = 0;
+    std::vector< magma_int_t > grsizs = { 1, 2, 4, 8 };
+    failures += tune( "dsytrd_sb2st_grsiz", bench_grsiz, &grsiz,
+                      sizes, grsizs, ntrial );
+
+    // performance model; print modeled times for a few shapes
+    magma_queue_t queue;
+    magma_device_t cdev;
+    magma_getdevice( &cdev );
+    magma_queue_create( cdev, &queue );
+    magma_int_t info = magma_perfmodel_calibrate( queue );
+    magma_queue_destroy( queue );
+    printf( "\n%% perfmodel: %s\n", (info == 0 ? "ok" : "failed"));
+    printf( "%%     m      n   sgetrf cpu (Gflop/s)   hgemmx (Tflop/s)   host<->device (GB/s)\n" );
+    printf( "%%=================================================================================\n" );
+    double bandwidth = 0;
+    magma_perfmodel_h2d_bandwidth( &bandwidth );
+    for( magma_int_t m = 2048; m <= 8192; m *= 2 ) {
+        for( magma_int_t n = 128; n <= 512; n *= 2 ) {
+            double getrf_rate = 0, gemm_rate = 0;
+            magma_perfmodel_sgetrf_cpu_rate( m, n, &getrf_rate );
+            magma_perfmodel_hgemmx_rate( m, n, &gemm_rate );
+            printf( "%7lld %6lld   %20.1f   %16.1f   %20.1f\n",
+                    (long long) m, (long long) n,
+                    getrf_rate / 1e9, gemm_rate / 1e12, bandwidth / 1e9 );
+        }
+    }
+    failures += (info != 0);
+
+    if ( getenv( "MAGMA_TUNE_FILE" ) != NULL ) {
+        info = magma_tune_save( NULL );
+        printf( "\n%% saved to %s: %s\n", getenv( "MAGMA_TUNE_FILE" ),
+                (info == 0 ? "ok" : "failed"));
+        failures += (info != 0);
+    }
+
+    if ( failures > 0 ) {
+        printf( "\n*** %lld tests failed.\n", (long long) failures );
+    }
+    else {
+        printf( "\nAll tests passed.\n" );
+    }
+
+    magma_finalize();
+    return (failures > 0);
+}
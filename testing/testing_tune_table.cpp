@@ -0,0 +1,149 @@
+/*
+    -- MAGMA (version 2.0) --
+       Univ. of Tennessee, Knoxville
+       Univ. of California, Berkeley
+       Univ. of Colorado, Denver
+       @date
+*/
+// includes, system
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// includes, project
+#include "magma_v2.h"
+
+
+/******************************************************************************/
+// Returns 1 and prints the check if value != expect, else 0.
+static magma_int_t check(
+    const char* what, const char* routine, magma_int_t n,
+    magma_int_t value, magma_int_t expect )
+{
+    bool okay = (value == expect);
+    printf( "%-10s %-20s %6lld   %6lld   %6lld   %s\n",
+            what, routine, (long long) n, (long long) value, (long long) expect,
+            (okay ? "ok" : "failed"));
+    return ! okay;
+}
+
+
+/* ////////////////////////////////////////////////////////////////////////////
+   -- Testing tuning table, on the host only (no GPU needed):
+      magma_tune_set validation and splitting of overlapping entries,
+      and a magma_tune_save / magma_tune_load round trip, with entries for
+      another host and malformed lines that load must ignore.
+      Uses a temporary file; the table is cleared at the end.
+      Usage: testing_tune_table
+*/
+int main( int argc, char** argv)
+{
+    magma_init();
+
+    magma_int_t failures = 0;
+    const magma_int_t none = -1;
+
+    char filename[] = "/tmp/magma_tune_XXXXXX";
+    int fd = mkstemp( filename );
+    if ( fd < 0 ) {
+        printf( "cannot create temporary file\n" );
+        return 1;
+    }
+    close( fd );
+
+    // start from an empty table
+    FILE* file = fopen( filename, "w" );
+    fclose( file );
+    failures += (magma_tune_load( filename ) != MAGMA_SUCCESS);
+
+    printf( "%% host: %s\n", magma_tune_host() );
+    printf( "%% check      routine                   n    value   expect\n" );
+    printf( "%%=========================================================\n" );
+
+    // ----- magma_tune_set rejects invalid entries, leaving table unchanged
+    failures += check( "set", "test_nb", 0,
+                       magma_tune_set( "test_nb", 0, 99, 32 ), MAGMA_SUCCESS );
+    failures += check( "set", "test_nb", 0,
+                       magma_tune_set( "test_nb", 50, 10, 64 ), MAGMA_ERR_ILLEGAL_VALUE );
+    failures += check( "set", "test_nb", 0,
+                       magma_tune_set( "test_nb", 0, 99, 0 ), MAGMA_ERR_ILLEGAL_VALUE );
+    failures += check( "set", "test_nb", 0,
+                       magma_tune_set( "test_nb", 0, 99, -8 ), MAGMA_ERR_ILLEGAL_VALUE );
+    failures += check( "set", "test_nb", 0,
+                       magma_tune_set( "test_nb", -5, 99, 8 ), MAGMA_ERR_ILLEGAL_VALUE );
+    failures += check( "get", "test_nb", 10, magma_tune_get( "test_nb", 10, none ), 32 );
+
+    // overlapping entry splits [0, 99] into [0, 39], [40, 59], [60, 99]
+    magma_tune_set( "test_nb", 40, 59, 48 );
+    failures += check( "get", "test_nb",  39, magma_tune_get( "test_nb",  39, none ), 32 );
+    failures += check( "get", "test_nb",  40, magma_tune_get( "test_nb",  40, none ), 48 );
+    failures += check( "get", "test_nb",  59, magma_tune_get( "test_nb",  59, none ), 48 );
+    failures += check( "get", "test_nb",  60, magma_tune_get( "test_nb",  60, none ), 32 );
+    failures += check( "get", "test_nb",  99, magma_tune_get( "test_nb",  99, none ), 32 );
+    failures += check( "get", "test_nb", 100, magma_tune_get( "test_nb", 100, none ), none );
+    failures += check( "get", "test_ib",  10, magma_tune_get( "test_ib",  10, none ), none );
+
+    // ----- save, then append other hosts' lines and malformed lines
+    failures += check( "save", "", 0, magma_tune_save( filename ), MAGMA_SUCCESS );
+
+    const char* host = magma_tune_host();
+    file = fopen( filename, "a" );
+    fprintf( file, "other host\ttest_nb\t0\t99\t16\n" );
+    fprintf( file, "%s\tgood_nb\t0\t1000\t64\n", host );
+    fprintf( file, "%s\tbad_text\t0\t1000\tabc\n", host );
+    fprintf( file, "%s\tbad_suffix\t0\t1000\t64x\n", host );
+    fprintf( file, "%s\tbad_empty\t0\t\t64\n", host );
+    fprintf( file, "%s\tbad_zero\t0\t1000\t0\n", host );
+    fprintf( file, "%s\tbad_negative\t0\t1000\t-32\n", host );
+    fprintf( file, "%s\tbad_nmin\t-1\t1000\t32\n", host );
+    fprintf( file, "%s\tbad_range\t500\t100\t32\n", host );
+    fprintf( file, "%s\tbad_fields\t0\t1000\n", host );
+    fprintf( file, "%s\tbad_overflow\t0\t1000\t99999999999999999999999\n", host );
+    fclose( file );
+
+    // ----- change table, then load, which replaces it;
+    // valid entries return, malformed lines are ignored
+    magma_tune_set( "test_nb", 0, 1000, 8 );
+    printf( "%% expect warnings for bad_* lines:\n" );
+    failures += check( "load", "", 0, magma_tune_load( filename ), MAGMA_SUCCESS );
+
+    failures += check( "get", "test_nb",   10, magma_tune_get( "test_nb",   10, none ), 32 );
+    failures += check( "get", "test_nb",   50, magma_tune_get( "test_nb",   50, none ), 48 );
+    failures += check( "get", "test_nb",   70, magma_tune_get( "test_nb",   70, none ), 32 );
+    failures += check( "get", "test_nb",  500, magma_tune_get( "test_nb",  500, none ), none );
+    failures += check( "get", "good_nb",  500, magma_tune_get( "good_nb",  500, none ), 64 );
+    const char* bad[] = { "bad_text", "bad_suffix", "bad_empty", "bad_zero",
+                          "bad_negative", "bad_nmin", "bad_range", "bad_fields",
+                          "bad_overflow" };
+    for( size_t i=0; i < sizeof(bad)/sizeof(bad[0]); ++i ) {
+        failures += check( "get", bad[i], 200, magma_tune_get( bad[i], 200, none ), none );
+    }
+
+    // ----- save again; other host's line is kept, malformed lines dropped
+    failures += check( "save", "", 0, magma_tune_save( filename ), MAGMA_SUCCESS );
+    magma_int_t other = 0, malformed = 0;
+    char line[ 1024 ];
+    file = fopen( filename, "r" );
+    while ( fgets( line, sizeof(line), file ) != NULL ) {
+        other     += (strncmp( line, "other host\t", 11 ) == 0);
+        malformed += (strstr( line, "\tbad_" ) != NULL);
+    }
+    fclose( file );
+    failures += check( "file", "other host", 0, other, 1 );
+    failures += check( "file", "bad_*", 0, malformed, 0 );
+
+    // leave an empty table
+    file = fopen( filename, "w" );
+    fclose( file );
+    magma_tune_load( filename );
+    remove( filename );
+
+    if ( failures == 0 )
+        printf( "\nAll tests passed.\n" );
+    else
+        printf( "\n%lld tests failed.\n", (long long) failures );
+
+    magma_finalize();
+    return int(failures);
+}